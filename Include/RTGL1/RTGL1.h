@@ -59,11 +59,13 @@ typedef uint32_t RgBool32;
 RG_DEFINE_NON_DISPATCHABLE_HANDLE(RgInstance)
 typedef uint32_t RgMaterial;
 typedef uint32_t RgCubemap;
+typedef uint32_t RgMesh;
 typedef uint32_t RgFlags;
 
 #define RG_NULL_HANDLE      0
 #define RG_NO_MATERIAL      0
 #define RG_EMPTY_CUBEMAP    0
+#define RG_NO_MESH          0
 #define RG_FALSE            0
 #define RG_TRUE             1
 
@@ -139,14 +141,25 @@ typedef struct RgInstanceCreateInfo
 {
     const char                  *pName;
 
-    // Exactly one of these surface create infos must be not null.
+    // Exactly one of these surface create infos must be not null,
+    // if useNullDevice is false.
     RgWin32SurfaceCreateInfo    *pWin32SurfaceInfo;
     RgMetalSurfaceCreateInfo    *pMetalSurfaceCreateInfo;
     RgWaylandSurfaceCreateInfo  *pWaylandSurfaceCreateInfo;
     RgXcbSurfaceCreateInfo      *pXcbSurfaceCreateInfo;
     RgXlibSurfaceCreateInfo     *pXlibSurfaceCreateInfo;
+    // If true, GPU and window are not required: Vulkan calls are handled by
+    // a CPU stand-in, and the surface infos must be null. The library must be
+    // built with RG_WITH_NULL_DEVICE option. Useful for measuring CPU time and
+    // memory that the library consumes, e.g. on machines without ray tracing support.
+    RgBool32                    useNullDevice;
 
     RgBool32                    enableValidationLayer;
+    // If not null, every successful API call and its data (vertex arrays, textures, frame params)
+    // are written to this file. The file can be replayed with RgTraceReplay tool.
+    // Note: pfnOpenFile is not captured, so the files that are loaded through it
+    // must be accessible with standard methods on replay.
+    const char                  *pCaptureFilePath;
     // Optional function to print messages from the library.
     PFN_rgPrint                 pfnPrint;
     // Custom user data that is passed to pfnUserPrint.
@@ -215,9 +228,80 @@ typedef struct RgInstanceCreateInfo
     // Each attribute has its own stride for ability to describe vertices 
     // that are represented as separated arrays of attribute values (i.e. Positions[], Normals[], ...)
     // or packed into array of structs (i.e. Vertex[] where Vertex={Position, Normal, ...}).
-    // Note: array of structs will cause a lot of unused memory as RTGL1 uses separated arrays
+    // RTGL1 uses separated arrays, so attribute values are gathered from the strided input
+    // on upload, and the padding between them is not copied.
     RgBool32                    vertexArrayOfStructs;
 
+    // Amount of contexts for recording dynamic geometry from several threads,
+    // see rgRecordDynamicGeometry. Must be <=64. If 0, only rgUploadGeometry can be used.
+    uint32_t                    dynamicRecordingContextCount;
+
+    // How many frames can be recorded on CPU while GPU is processing the previous ones.
+    // Higher values reduce stalls in rgStartFrame, but increase latency and memory usage.
+    // Must be in [2..4]. If 0, 2 will be used.
+    uint32_t                    framesInFlightCount;
+
+    // If true, GPU timestamps are written at the beginning and the end
+    // of each internal pass, see rgGetGpuTimings.
+    RgBool32                    enableGpuProfiling;
+
+    // If not null, CPU stages and API calls are streamed to this file
+    // in Chrome Trace Event JSON format, it can be opened in chrome://tracing
+    // or ui.perfetto.dev. GPU passes are added, if enableGpuProfiling is true.
+    const char                  *pTraceFilePath;
+
+    // If >1, static non-movable geometries of each type are split into at most
+    // this amount of spatially compact BLAS-es, each with its own TLAS instance.
+    // It can improve ray tracing performance on large maps. Must be <=16. If 0 or 1, disabled.
+    uint32_t                    maxStaticGeometryClusterCount;
+
+    // If true, normals are stored octahedral-encoded in 2x16 bits and tex coords
+    // as half floats in the vertex buffers. It reduces vertex data memory by ~40%
+    // and the amount of data copied each frame, but lowers the precision.
+    // Input arrays are still in floats with the strides that are specified above.
+    RgBool32                    compactVertexData;
+
+    // Initial capacities of the vertex and index buffers for static and dynamic geometry.
+    // The buffers are grown on demand, so these values only allow to avoid reallocations,
+    // e.g. on the first static scene submission. If 0, a small default capacity is used.
+    // Note: dynamic geometry that doesn't fit is skipped in the current frame,
+    // and the dynamic buffers are grown on the next frame start.
+    // Note: rgAddStaticGeometry grows the buffers of the already submitted scene,
+    // the old ones are released when the frames in flight are finished.
+    uint32_t                    staticVertexCapacity;
+    uint32_t                    staticIndexCapacity;
+    uint32_t                    dynamicVertexCapacity;
+    uint32_t                    dynamicIndexCapacity;
+
+    // If not 0, static materials that are loaded from files (i.e. pRelativePath is not null
+    // and disableOverride is false) are created asynchronously: rgCreateStaticMaterial and
+    // rgCreateAnimatedMaterial return the material immediately, the files are read and parsed
+    // on this amount of worker threads, and the images are uploaded on one of the next
+    // rgStartFrame calls. Until then, the material is drawn with the empty texture.
+    // Such material reserves the texture slots for all of its textures, even if some files
+    // don't exist. Must be <=16. If 0, materials are created synchronously.
+    // Note: if not 0, pfnOpenFile and pfnCloseFile must be thread-safe.
+    uint32_t                    textureLoadThreadCount;
+
+    // If not 0, the textures of static materials that are loaded from files are evicted
+    // from the device memory, when all textures take more than this amount of bytes,
+    // or when the device memory heap is over its budget. Materials that weren't drawn
+    // for the longest time are evicted first. An evicted material is drawn with the empty
+    // texture until it's reloaded from the files, which is done when it's drawn again.
+    // Materials that have textures from RgTextureData::pData are never evicted.
+    uint64_t                    textureMemoryBudget;
+
+    // If not 0, static textures from files with pregenerated mipmaps (e.g. KTX2) are streamed:
+    // on creation, only the smallest mip levels are uploaded, and the larger ones are uploaded
+    // in next rgStartFrame calls, at most this amount of bytes per frame, but at least one level.
+    // Until a level is uploaded, the texture is sampled with the lower detail.
+    uint32_t                    textureStreamingBytesPerFrame;
+
+    // Amount of threads that inflate the levels of zstd supercompressed KTX2 textures,
+    // each level is a separate job. The loading thread takes the jobs too, so if 0,
+    // the levels are inflated only on the loading thread. Must be <=16.
+    uint32_t                    textureDecodeThreadCount;
+
 } RgInstanceCreateInfo;
 
 RgResult rgCreateInstance(
@@ -372,6 +456,76 @@ RgResult rgUploadGeometry(
     RgInstance                              rgInstance,
     const RgGeometryUploadInfo              *pUploadInfo);
 
+// Upload "count" geometries at once. Each of them is handled in the same way as
+// in rgUploadGeometry, but the per-call overhead is paid once for the whole batch.
+// Geometries in a batch must be either all dynamic or all static.
+// If any of the infos is incorrect, none of the geometries are uploaded.
+RgResult rgUploadGeometries(
+    RgInstance                              rgInstance,
+    uint32_t                                count,
+    const RgGeometryUploadInfo              *pUploadInfos);
+
+// Upload dynamic geometry through the recording context with index "contextIndex",
+// which must be less than RgInstanceCreateInfo::dynamicRecordingContextCount.
+// Different contexts can be used from different threads simultaneously,
+// but one context must not be used by several threads at the same time.
+// The function must be called between rgStartFrame and rgDrawFrame, and not between
+// rgStartNewScene and rgSubmitStaticGeometries; all the recording threads must finish
+// before rgDrawFrame. Recorded geometries are added in the order of context indices,
+// after the geometries uploaded with rgUploadGeometry.
+// Note: uniqueID is not checked for duplicates, as it would require synchronization
+// between the contexts, so the user must guarantee its uniqueness.
+RgResult rgRecordDynamicGeometry(
+    RgInstance                              rgInstance,
+    uint32_t                                contextIndex,
+    const RgGeometryUploadInfo              *pUploadInfo);
+
+typedef struct RgMappedGeometry
+{
+    // Pointers to the reserved ranges, the data must be written there before rgCommitMappedGeometry.
+    // If there was no space for the geometry in the current frame, all of them are null,
+    // and the geometry must not be committed.
+    // Positions: 3 floats in each "vertexStride" bytes. Strides are not the ones from
+    // RgInstanceCreateInfo, as the mapped arrays are tightly packed.
+    void            *pVertexData;
+    // Null, if normals are generated.
+    // If RgInstanceCreateInfo::compactVertexData is set, each normal is packed into uint32_t:
+    // octahedral encoding, 2 snorm16 values, x in the low 16 bits. Otherwise, 3 floats.
+    void            *pNormalData;
+    // Null, if the geometry doesn't have texture coordinates. Dynamic geometry has only one layer.
+    // If RgInstanceCreateInfo::compactVertexData is set, each texture coordinate
+    // is packed into uint32_t: 2 halfs, u in the low 16 bits. Otherwise, 2 floats.
+    void            *pTexCoordData;
+    // Null, if the geometry is not indexed, or if indices were provided on mapping.
+    uint32_t        *pIndexData;
+    uint32_t        vertexStride;
+    uint32_t        normalStride;
+    uint32_t        texCoordStride;
+} RgMappedGeometry;
+
+// Reserve space for dynamic geometry in the current frame and get pointers
+// to it, so the geometry data can be written there without extra copies.
+// Vertex data pointers in "pUploadInfo" are not read, they're only checked for null
+// to determine which streams are used: if pNormalData is null, normals are generated;
+// if pTexCoordLayerData[0] is null, the geometry doesn't have texture coordinates.
+// If indexCount is not 0, the geometry is indexed; if pIndexData is not null, indices
+// are copied from it, otherwise they must be written to RgMappedGeometry::pIndexData.
+// Providing indices allows to refit BLAS of the geometry, if its topology didn't change;
+// written indices are read back from the mapped memory on commit to check that.
+// Other members of "pUploadInfo" are handled as in rgUploadGeometry.
+// The function must be called from the main thread between rgStartFrame and rgDrawFrame,
+// and not between rgStartNewScene and rgSubmitStaticGeometries.
+RgResult rgMapGeometry(
+    RgInstance                              rgInstance,
+    const RgGeometryUploadInfo              *pUploadInfo,
+    RgMappedGeometry                        *pResult);
+
+// Add the mapped geometry with "uniqueID" to the current frame, its data must be already written.
+// Mapped geometries that weren't committed until rgDrawFrame are dropped.
+RgResult rgCommitMappedGeometry(
+    RgInstance                              rgInstance,
+    uint64_t                                uniqueID);
+
 // Updating transform is available only for movable static geometry.
 // Other geometry types don't need it because they are either fully static
 // or uploaded every frame, so transforms are always as they are intended.
@@ -385,21 +539,107 @@ RgResult rgUpdateGeometryTexCoords(
 
 
 
-// Clear current scene from all static geometries and make it available for recording new geometries.
-// New scene can be visible only after the submission using rgSubmitStaticGeometries.
+typedef struct RgMeshCreateInfo
+{
+    RgGeometryUploadFlags           flags;
+
+    uint32_t                        vertexCount;
+    // 3 first floats will be used
+    const void                      *pVertexData;
+    // 3 first floats will be used
+    // If null, then the normals will be generated.
+    // If null and RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT is set,
+    // generated normals will be inverted.
+    const void                      *pNormalData;
+    // 2 first floats will be used
+    const void                      *pTexCoordLayerData[3];
+
+    // Can be null, if indices are not used.
+    uint32_t                        indexCount;
+    const void                      *pIndexData;
+} RgMeshCreateInfo;
+
+typedef struct RgMeshInstanceUploadInfo
+{
+    // Used for matching instances between frames, e.g. for motion vectors.
+    uint64_t                        uniqueID;
+    RgMesh                          mesh;
+    RgGeometryUploadFlags           flags;
+
+    RgGeometryPassThroughType       passThroughType;
+    RgGeometryPrimaryVisibilityType visibilityType;
+
+    RgFloat4D                       layerColors[3];
+    RgGeometryMaterialBlendType     layerBlendingTypes[3];
+    float                           defaultRoughness;
+    float                           defaultMetallicity;
+    float                           defaultEmission;
+
+    RgLayeredMaterial               geomMaterial;
+    RgTransform                     transform;
+} RgMeshInstanceUploadInfo;
+
+// Create a mesh which vertex data and acceleration structure are stored on GPU once,
+// and then can be placed many times using rgUploadMeshInstance.
+// Meshes are a part of the static scene: they can be created only between
+// rgStartNewScene and rgSubmitStaticGeometries, and they are destroyed by the next rgStartNewScene.
+RgResult rgCreateMesh(
+    RgInstance                              rgInstance,
+    const RgMeshCreateInfo                  *pCreateInfo,
+    RgMesh                                  *pResult);
+
+// Place an instance of a mesh. Only transform and material data is uploaded per instance.
+// Like dynamic geometry, instances are visible only in the current frame, so they
+// must be uploaded each frame between rgStartFrame and rgDrawFrame.
+RgResult rgUploadMeshInstance(
+    RgInstance                              rgInstance,
+    const RgMeshInstanceUploadInfo          *pUploadInfo);
+
+
+
+// Add static or movable static geometry to the already submitted static scene
+// without rebuilding the whole scene: only acceleration structures of the affected
+// geometry types are rebuilt. Changes become visible from the next rgStartFrame.
+// Space of removed geometries is reused, when the frames in flight that could access them are finished.
+// Normals are generated on CPU, if "pNormalData" is null.
+// Must not be called between rgStartNewScene and rgSubmitStaticGeometries.
+RgResult rgAddStaticGeometry(
+    RgInstance                              rgInstance,
+    const RgGeometryUploadInfo              *pUploadInfo);
+
+// Remove static geometry that was uploaded with rgUploadGeometry or added with rgAddStaticGeometry.
+// Same as for rgAddStaticGeometry, the change becomes visible from the next rgStartFrame.
+RgResult rgRemoveStaticGeometry(
+    RgInstance                              rgInstance,
+    uint64_t                                uniqueID);
+
+
+
+// Start recording a new static scene. The current one is still rendered
+// until the new one is submitted using rgSubmitStaticGeometries and built.
 RgResult rgStartNewScene(
     RgInstance                          rgInstance);
 
 // After uploading all static geometry, scene must be submitted before rendering.
 // Note that movable static geometry can be still moved using rgUpdateGeometryTransform.
 // If the static scene geometry should be changed, it must be cleared using rgStartNewScene
-// and new static geometries must be uploaded.
+// and new static geometries must be uploaded, or rgAddStaticGeometry / rgRemoveStaticGeometry
+// can be used for small edits.
 // To clear static scene, call rgStartNewScene and then rgSubmitStaticGeometries
 // without uploading any geometry.
 // rgStartNewScene and rgSubmitStaticGeometries can be called outside of rgStartFrame-rgDrawFrame.
+// Submission doesn't wait for GPU: the new scene is built in the background, while the previous
+// one is rendered, and it replaces the previous one on the first rgStartFrame after the building
+// is finished. Meshes that were created for the new scene can be instanced only after that.
 RgResult rgSubmitStaticGeometries(
     RgInstance                          rgInstance);
 
+// Check if the submitted static scene is still being built, so the previous one is rendered.
+// rgAddStaticGeometry and rgRemoveStaticGeometry must not be called in that case.
+RgResult rgIsStaticSceneSwapPending(
+    RgInstance                          rgInstance,
+    RgBool32                            *pResult);
+
 
 
 typedef enum RgBlendFactor
@@ -916,6 +1156,89 @@ RgResult rgDrawFrame(
     RgInstance                          rgInstance,
     const RgDrawFrameInfo               *pDrawInfo);
 
+
+
+// CPU-side statistics of one frame. Times are in milliseconds.
+typedef struct RgFrameStatistics
+{
+    // Incremented on each rgDrawFrame call.
+    uint64_t    frameId;
+
+    // rgStartFrame: waiting for the GPU to finish the frame that used the same resources.
+    double      fenceWaitTime;
+    // rgStartFrame: acquiring the next swapchain image.
+    double      swapchainAcquireTime;
+    // rgDrawFrame: submitting scene data, includes geomInfoCopyTime, tlasPrepareTime and tlasBuildTime.
+    double      sceneSubmitTime;
+    // rgDrawFrame: updating texture and cubemap descriptor sets.
+    double      textureDescriptorsSubmitTime;
+    // rgDrawFrame: recording copies of geometry instance infos from staging buffers.
+    double      geomInfoCopyTime;
+    // rgDrawFrame: filling TLAS instances.
+    double      tlasPrepareTime;
+    // rgDrawFrame: recording TLAS build.
+    double      tlasBuildTime;
+    // rgDrawFrame: recording all rasterization passes.
+    double      rasterizerTime;
+    // rgDrawFrame: submitting the frame command buffer to the queue.
+    double      submitTime;
+    // rgDrawFrame: presenting the swapchain image.
+    double      presentTime;
+
+    // Counters of the data that were passed to the library
+    // since the previous rgDrawFrame call.
+    uint32_t    geometryCount;
+    uint32_t    vertexCount;
+    uint32_t    indexCount;
+    uint32_t    lightCount;
+    // Amount of draw calls recorded by the rasterizer in this frame.
+    uint32_t    rasterizedDrawCallCount;
+    // Amount of bytes that were copied from staging buffers to device-local ones in this frame.
+    uint64_t    stagingCopiedBytes;
+    // Amount of bytes that were freed by compacting BLAS-es of the current static scene.
+    uint64_t    staticBlasCompactionSavedBytes;
+} RgFrameStatistics;
+
+// Get statistics of the last frames, the most recent one first.
+// "pResults" must have space for at least "count" elements.
+// Only the last 64 frames are stored, so less than "count" frames can be returned,
+// the actual amount is written to "pResultCount".
+RgResult rgGetFrameStatistics(
+    RgInstance                          rgInstance,
+    uint32_t                            count,
+    RgFrameStatistics                   *pResults,
+    uint32_t                            *pResultCount);
+
+
+
+#define RG_GPU_TIMING_NO_PARENT UINT32_MAX
+
+typedef struct RgGpuTimingScope
+{
+    // Name of the pass. Valid until the next rgStartFrame call.
+    const char  *pName;
+    // Index of the enclosing scope in the result array, or RG_GPU_TIMING_NO_PARENT.
+    uint32_t    parentIndex;
+    // Nesting level, 0 for the root scopes.
+    uint32_t    depth;
+    // GPU time in milliseconds.
+    double      time;
+} RgGpuTimingScope;
+
+// Get GPU times of the passes of the last frame that was finished by the GPU,
+// i.e. the results are delayed by the amount of frames in flight.
+// Scopes are in the order of their beginning, so a parent precedes its children.
+// If "pScopes" is null, the amount of scopes is written to "pScopeCount".
+// Otherwise, "pScopeCount" must contain the capacity of "pScopes",
+// and the amount of written scopes is returned in it.
+// "pFrameId" is optional, the frame's ID is the same as in RgFrameStatistics.
+// RgInstanceCreateInfo::enableGpuProfiling must be true.
+RgResult rgGetGpuTimings(
+    RgInstance                          rgInstance,
+    uint64_t                            *pFrameId,
+    uint32_t                            *pScopeCount,
+    RgGpuTimingScope                    *pScopes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,7 +38,7 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
     uint32_t geometryCount, 
     const VkAccelerationStructureGeometryKHR *pGeometries,
     const uint32_t *pMaxPrimitiveCount, 
-    bool fastTrace) const
+    VkBuildAccelerationStructureFlagsKHR flags) const
 {
     assert(geometryCount > 0);
 
@@ -48,9 +48,8 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
     VkAccelerationStructureBuildGeometryInfoKHR buildInfo = {};
     buildInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
     buildInfo.type = type;
-    buildInfo.flags = fastTrace ?
-        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR :
-        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+    // AS size depends on the flags, so they must be the same as in the build
+    buildInfo.flags = flags;
     buildInfo.geometryCount = geometryCount;
     buildInfo.pGeometries = pGeometries;
     buildInfo.ppGeometries = nullptr;
@@ -65,13 +64,33 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
     return sizeInfo;
 }
 
+VkBuildAccelerationStructureFlagsKHR ASBuilder::GetBottomBuildFlags(bool fastTrace, bool isBLASUpdateable, bool allowCompaction)
+{
+    VkBuildAccelerationStructureFlagsKHR flags = fastTrace ?
+        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR :
+        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+
+    if (isBLASUpdateable)
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    }
+
+    if (allowCompaction)
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+
+    return flags;
+}
+
 VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBottomBuildSizes(
     uint32_t geometryCount,
-    const VkAccelerationStructureGeometryKHR *pGeometries, const uint32_t *pMaxPrimitiveCount, bool fastTrace) const
+    const VkAccelerationStructureGeometryKHR *pGeometries, const uint32_t *pMaxPrimitiveCount,
+    bool fastTrace, bool isBLASUpdateable, bool allowCompaction) const
 {
     return GetBuildSizes(
         VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, geometryCount,
-        pGeometries, pMaxPrimitiveCount, fastTrace);
+        pGeometries, pMaxPrimitiveCount, GetBottomBuildFlags(fastTrace, isBLASUpdateable, allowCompaction));
 }
 
 VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetTopBuildSizes(
@@ -79,7 +98,10 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetTopBuildSizes(
 {
     return GetBuildSizes(
         VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, 1,
-        pGeometry, &maxPrimitiveCount, fastTrace);
+        pGeometry, &maxPrimitiveCount,
+        fastTrace ?
+            VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR :
+            VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR);
 }
 
 void ASBuilder::AddBLAS(
@@ -87,7 +109,7 @@ void ASBuilder::AddBLAS(
     const VkAccelerationStructureGeometryKHR* pGeometries,
     const VkAccelerationStructureBuildRangeInfoKHR *pRangeInfos,
     const VkAccelerationStructureBuildSizesInfoKHR &buildSizes,
-    bool fastTrace, bool update, bool isBLASUpdateable)
+    bool fastTrace, bool update, bool isBLASUpdateable, bool allowCompaction)
 {
     // while building bottom level, top level must be not
     assert(topLBuildInfo.geomInfos.empty() && topLBuildInfo.rangeInfos.empty());
@@ -96,14 +118,10 @@ void ASBuilder::AddBLAS(
 
     VkDeviceSize scratchSize = std::max(buildSizes.updateScratchSize, buildSizes.buildScratchSize);
 
-    VkBuildAccelerationStructureFlagsKHR flags = fastTrace ?
-        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR :
-        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+    // updating is allowed only for BLAS that was built as updateable
+    assert(!update || isBLASUpdateable);
 
-    if (isBLASUpdateable || update)
-    {
-        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
-    }
+    VkBuildAccelerationStructureFlagsKHR flags = GetBottomBuildFlags(fastTrace, isBLASUpdateable, allowCompaction);
 
     VkAccelerationStructureBuildGeometryInfoKHR buildInfo = {};
     buildInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
@@ -42,13 +42,14 @@ public:
 
     // pGeometries is a pointer to an array of size "geometryCount",
     // pRangeInfos is an array of size "geometryCount".
-    // All pointers must be valid until BuildBottomLevel is called
+    // All pointers must be valid until BuildBottomLevel is called.
+    // If "allowCompaction" is true, BLAS can be compacted after the build.
     void AddBLAS(
         VkAccelerationStructureKHR as, uint32_t geometryCount,
         const VkAccelerationStructureGeometryKHR *pGeometries,
         const VkAccelerationStructureBuildRangeInfoKHR *pRangeInfos,
         const VkAccelerationStructureBuildSizesInfoKHR &buildSizes,
-        bool fastTrace, bool update, bool isBLASUpdateable);
+        bool fastTrace, bool update, bool isBLASUpdateable, bool allowCompaction);
 
     void BuildBottomLevel(VkCommandBuffer cmd);
 
@@ -69,13 +70,13 @@ public:
     VkAccelerationStructureBuildSizesInfoKHR GetBuildSizes(
         VkAccelerationStructureTypeKHR type, uint32_t geometryCount,
         const VkAccelerationStructureGeometryKHR *pGeometries,
-        const uint32_t *pMaxPrimitiveCount, bool fastTrace) const;
+        const uint32_t *pMaxPrimitiveCount, VkBuildAccelerationStructureFlagsKHR flags) const;
 
-    // GetBuildSizes(..) for BLAS
+    // GetBuildSizes(..) for BLAS, flags must be the same as in AddBLAS(..)
     VkAccelerationStructureBuildSizesInfoKHR GetBottomBuildSizes(
         uint32_t geometryCount,
         const VkAccelerationStructureGeometryKHR *pGeometries,
-        const uint32_t *pMaxPrimitiveCount, bool fastTrace) const;
+        const uint32_t *pMaxPrimitiveCount, bool fastTrace, bool isBLASUpdateable, bool allowCompaction) const;
     // GetBuildSizes(..) for TLAS
     VkAccelerationStructureBuildSizesInfoKHR GetTopBuildSizes(
         const VkAccelerationStructureGeometryKHR *pGeometry,
@@ -83,6 +84,9 @@ public:
 
     bool IsEmpty() const;
 
+private:
+    static VkBuildAccelerationStructureFlagsKHR GetBottomBuildFlags(bool fastTrace, bool isBLASUpdateable, bool allowCompaction);
+
 private:
     VkDevice device;
     std::shared_ptr<ScratchBuffer> scratchBuffer;
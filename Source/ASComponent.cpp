@@ -31,7 +31,8 @@ RTGL1::BLASComponent::BLASComponent(VkDevice _device, VertexCollectorFilterTypeF
 :
     ASComponent(_device, VertexCollectorFilterTypeFlags_GetNameForBLAS(filter)),
     filter(_filter),
-    geomCount(0)
+    geomCount(0),
+    updateCount(0)
 {}
 
 RTGL1::TLASComponent::TLASComponent(VkDevice _device, const char *_debugName)
@@ -130,6 +131,11 @@ VkDeviceAddress RTGL1::ASComponent::GetASAddress() const
     return GetASAddress(as);
 }
 
+VkDeviceSize RTGL1::ASComponent::GetSize() const
+{
+    return buffer.IsInitted() ? buffer.GetSize() : 0;
+}
+
 VkDeviceAddress RTGL1::ASComponent::GetASAddress(VkAccelerationStructureKHR as) const
 {
     assert(device != VK_NULL_HANDLE);
@@ -170,4 +176,24 @@ bool RTGL1::BLASComponent::IsEmpty() const
 uint32_t RTGL1::BLASComponent::GetGeomCount() const
 {
     return geomCount;
-}
\ No newline at end of file
+}
+void RTGL1::BLASComponent::OnBuild(const std::vector<GeometryTopology> &topology)
+{
+    builtTopology = topology;
+    updateCount = 0;
+}
+
+void RTGL1::BLASComponent::OnUpdate()
+{
+    updateCount++;
+}
+
+bool RTGL1::BLASComponent::IsTopologySame(const std::vector<GeometryTopology> &topology) const
+{
+    return as != VK_NULL_HANDLE && !builtTopology.empty() && builtTopology == topology;
+}
+
+uint32_t RTGL1::BLASComponent::GetUpdateCount() const
+{
+    return updateCount;
+}
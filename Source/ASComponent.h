@@ -24,6 +24,7 @@
 
 #include "Common.h"
 #include "Buffer.h"
+#include "VertexCollectorFilter.h"
 #include "VertexCollectorFilterType.h"
 
 namespace RTGL1
@@ -48,6 +49,8 @@ public:
 
     VkAccelerationStructureKHR GetAS() const;
     VkDeviceAddress GetASAddress() const;
+    // Size of the buffer that stores AS
+    VkDeviceSize GetSize() const;
 
     bool IsValid(const VkAccelerationStructureBuildSizesInfoKHR &buildSizes) const;
 
@@ -83,6 +86,14 @@ public:
     bool IsEmpty() const;
     uint32_t GetGeomCount() const;
 
+    // Save topology of geometries that BLAS is built with from scratch
+    void OnBuild(const std::vector<GeometryTopology> &topology);
+    void OnUpdate();
+    // Can BLAS be refitted with geometries of such topology
+    bool IsTopologySame(const std::vector<GeometryTopology> &topology) const;
+    // Count of refits since the last build
+    uint32_t GetUpdateCount() const;
+
 protected:
     void CreateAS(VkDeviceSize size) override;
     const char *GetBufferDebugName() const override;
@@ -90,6 +101,9 @@ protected:
 private:
     VertexCollectorFilterTypeFlags filter;
     uint32_t geomCount;
+
+    std::vector<GeometryTopology> builtTopology;
+    uint32_t updateCount;
 };
 
 
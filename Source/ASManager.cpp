@@ -20,6 +20,7 @@
 
 #include "ASManager.h"
 
+#include <algorithm>
 #include <array>
 
 #include "Utils.h"
@@ -28,24 +29,42 @@
 
 using namespace RTGL1;
 
+// Dynamic BLAS with the same topology is refitted this many times in a row,
+// then it's fully rebuilt to restore BVH quality
+constexpr uint32_t DYNAMIC_BLAS_MAX_UPDATE_COUNT = 30;
+
 ASManager::ASManager(
     VkDevice _device,
     std::shared_ptr<MemoryAllocator> _allocator,
     std::shared_ptr<CommandBufferManager> _cmdManager,
     std::shared_ptr<TextureManager> _textureManager,
     std::shared_ptr<GeomInfoManager> _geomInfoManager,
-    const VertexBufferProperties &_properties)
+    const VertexBufferProperties &_properties,
+    uint32_t _framesInFlight,
+    uint32_t _dynamicRecordingContextCount,
+    uint32_t _maxStaticClusterCount)
 :
     device(_device),
     allocator(std::move(_allocator)),
     staticCopyFence(VK_NULL_HANDLE),
+    isStaticSwapPending(false),
+    isStaticBuildSubmitted(false),
+    buffersDescDirty{},
+    previousDynamicVertexCapacity(0),
+    previousDynamicIndexCapacity(0),
+    compactionQueryPool(VK_NULL_HANDLE),
+    compactionQueryPoolSize(0),
+    staticCompactionSavedBytes(0),
     cmdManager(std::move(_cmdManager)),
     textureMgr(std::move(_textureManager)),
     geomInfoMgr(std::move(_geomInfoManager)),
     descPool(VK_NULL_HANDLE),
     buffersDescSetLayout(VK_NULL_HANDLE),
     asDescSetLayout(VK_NULL_HANDLE),
-    properties(_properties)
+    properties(_properties),
+    framesInFlight(_framesInFlight),
+    maxStaticClusterCount(_maxStaticClusterCount),
+    staticClusterizer(_maxStaticClusterCount, STATIC_GEOMETRY_CLUSTER_MIN_SIZE)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     typedef VertexCollectorFilterTypeFlagBits FT;
@@ -56,18 +75,20 @@ ASManager::ASManager(
     {
         if (filter & FT::CF_DYNAMIC)
         {
-            for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+            for (uint32_t i = 0; i < framesInFlight; i++)
             {
                 allDynamicBlas[i].emplace_back(std::make_unique<BLASComponent>(device, filter));
             }
         }
-        else
+        // movable geometries don't share a BLAS, each of them has its own
+        else if (!(filter & FT::CF_STATIC_MOVABLE))
         {
-            allStaticBlas.emplace_back(std::make_unique<BLASComponent>(device, filter));
+            curStatic.blas.emplace_back(std::make_unique<BLASComponent>(device, filter));
+            pendingStatic.blas.emplace_back(std::make_unique<BLASComponent>(device, filter));
         }
     });
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         tlas[i] = std::make_unique<TLASComponent>(device, "TLAS main");
     }
@@ -77,55 +98,57 @@ ASManager::ASManager(
     asBuilder = std::make_shared<ASBuilder>(device, scratchBuffer);
 
 
-    // static and movable static vertices share the same buffer as their data won't be changing
-    collectorStatic = std::make_shared<VertexCollector>(
-        device, allocator, geomInfoMgr,
-        sizeof(ShVertexBufferStatic), properties,
-        FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE | 
-        FT::MASK_PASS_THROUGH_GROUP | 
-        FT::MASK_PRIMARY_VISIBILITY_GROUP);
-
-    // subscribe to texture manager only static collector,
-    // as static geometries aren't updating its material info (in ShGeometryInstance)
-    // every frame unlike dynamic ones
-    textureMgr->Subscribe(collectorStatic);
+    // static and movable static vertices share the same buffer as their data won't be changing;
+    // each static scene has its own buffers, so a new one can be built while the current is in use
+    for (StaticScene *scene : { &curStatic, &pendingStatic })
+    {
+        scene->collector = std::make_shared<VertexCollector>(
+            device, allocator, geomInfoMgr, properties,
+            FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE | 
+            FT::MASK_PASS_THROUGH_GROUP | 
+            FT::MASK_PRIMARY_VISIBILITY_GROUP);
+
+        // subscribe to texture manager only static collectors,
+        // as static geometries aren't updating its material info (in ShGeometryInstance)
+        // every frame unlike dynamic ones
+        textureMgr->Subscribe(scene->collector);
+    }
 
 
     // dynamic vertices
     collectorDynamic[0] = std::make_shared<VertexCollector>(
-        device, allocator, geomInfoMgr,
-        sizeof(ShVertexBufferDynamic), properties,
+        device, allocator, geomInfoMgr, properties,
         FT::CF_DYNAMIC | 
         FT::MASK_PASS_THROUGH_GROUP | 
         FT::MASK_PRIMARY_VISIBILITY_GROUP);
 
-    // other dynamic vertex collectors should share the same device local buffers as the first one
-    for (uint32_t i = 1; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // other dynamic vertex collectors should share the same device local buffers as the first one,
+    // unless they write directly to device local memory: then each has its own buffers
+    for (uint32_t i = 1; i < framesInFlight; i++)
     {
         collectorDynamic[i] = std::make_shared<VertexCollector>(collectorDynamic[0], allocator);
     }
 
-    previousDynamicPositions.Init(
-        allocator, sizeof(ShVertexBufferDynamic::positions),
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's vertex data");
-    previousDynamicIndices.Init(
-        allocator, sizeof(ShVertexBufferDynamic::positions),
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's index data");
+    for (uint32_t i = 0; i < _dynamicRecordingContextCount; i++)
+    {
+        dynamicRecordingContexts.emplace_back(std::make_unique<DynamicRecordingContext>());
+    }
+
+    InitPreviousDynamicBuffers(collectorDynamic[0]->GetVertexCapacity(), collectorDynamic[0]->GetIndexCapacity());
 
 
     // instance buffer for TLAS
     instanceBuffer = std::make_unique<AutoBuffer>(device, allocator, "TLAS instance buffer staging", "TLAS instance buffer");
 
-    VkDeviceSize instanceBufferSize = MAX_TOP_LEVEL_INSTANCE_COUNT * sizeof(VkAccelerationStructureInstanceKHR);
-    instanceBuffer->Create(instanceBufferSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+    VkDeviceSize instanceBufferSize = (MAX_TOP_LEVEL_INSTANCE_COUNT + GetMaxObjectInstanceCount()) * sizeof(VkAccelerationStructureInstanceKHR);
+    // instances are fully rewritten each frame
+    instanceBuffer->Create(instanceBufferSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, framesInFlight, true);
 
 
     CreateDescriptors();
 
-    // buffers won't be changing, update once
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // buffers are changed only on the static scene swap or on growing
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         UpdateBufferDescriptors(i);
     }
@@ -221,16 +244,16 @@ void ASManager::CreateDescriptors()
     std::array<VkDescriptorPoolSize, 2> poolSizes{};
 
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSizes[0].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+    poolSizes[0].descriptorCount = framesInFlight;
 
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-    poolSizes[1].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+    poolSizes[1].descriptorCount = framesInFlight;
 
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = poolSizes.size();
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT * 2;
+    poolInfo.maxSets = framesInFlight * 2;
 
     r = vkCreateDescriptorPool(device, &poolInfo, nullptr, &descPool);
     VK_CHECKERROR(r);
@@ -245,7 +268,7 @@ void ASManager::CreateDescriptors()
     SET_DEBUG_NAME(device, buffersDescSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Vertex data Desc set layout");
     SET_DEBUG_NAME(device, asDescSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "TLAS Desc set layout");
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         descSetInfo.pSetLayouts = &buffersDescSetLayout;
         r = vkAllocateDescriptorSets(device, &descSetInfo, &buffersDescSets[i]);
@@ -269,7 +292,7 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
 
     // buffer infos
     VkDescriptorBufferInfo &stVertsBufInfo = bufferInfos[BINDING_VERTEX_BUFFER_STATIC];
-    stVertsBufInfo.buffer = collectorStatic->GetVertexBuffer();
+    stVertsBufInfo.buffer = curStatic.collector->GetVertexBuffer();
     stVertsBufInfo.offset = 0;
     stVertsBufInfo.range = VK_WHOLE_SIZE;
 
@@ -279,7 +302,7 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
     dnVertsBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &stIndexBufInfo = bufferInfos[BINDING_INDEX_BUFFER_STATIC];
-    stIndexBufInfo.buffer = collectorStatic->GetIndexBuffer();
+    stIndexBufInfo.buffer = curStatic.collector->GetIndexBuffer();
     stIndexBufInfo.offset = 0;
     stIndexBufInfo.range = VK_WHOLE_SIZE;
 
@@ -299,12 +322,12 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
     gpBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &ppBufInfo = bufferInfos[BINDING_PREV_POSITIONS_BUFFER_DYNAMIC];
-    ppBufInfo.buffer = previousDynamicPositions.GetBuffer();
+    ppBufInfo.buffer = previousDynamicPositions->GetBuffer();
     ppBufInfo.offset = 0;
     ppBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &piBufInfo = bufferInfos[BINDING_PREV_INDEX_BUFFER_DYNAMIC];
-    piBufInfo.buffer = previousDynamicIndices.GetBuffer();
+    piBufInfo.buffer = previousDynamicIndices->GetBuffer();
     piBufInfo.offset = 0;
     piBufInfo.range = VK_WHOLE_SIZE;
 
@@ -411,12 +434,18 @@ void ASManager::UpdateASDescriptors(uint32_t frameIndex)
 
 ASManager::~ASManager()
 {
-    for (auto &as : allStaticBlas)
+    for (StaticScene *scene : { &curStatic, &pendingStatic })
     {
-        as->Destroy();
+        for (auto &as : scene->blas)
+        {
+            as->Destroy();
+        }
+
+        scene->meshes.clear();
+        scene->movableGeoms.clear();
     }
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         for (auto &as : allDynamicBlas[i])
         {
@@ -426,13 +455,23 @@ ASManager::~ASManager()
         tlas[i]->Destroy();
     }
 
+    for (auto &retired : retiredStaticBlas)
+    {
+        retired.clear();
+    }
+
+    if (compactionQueryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device, compactionQueryPool, nullptr);
+    }
+
     vkDestroyDescriptorPool(device, descPool, nullptr);
     vkDestroyDescriptorSetLayout(device, buffersDescSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(device, asDescSetLayout, nullptr);
     vkDestroyFence(device, staticCopyFence, nullptr);
 }
 
-bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector)
+bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector, bool allowCompaction)
 {
     auto filter = blas.GetFilter();
     const std::vector<VkAccelerationStructureGeometryKHR> &geoms = vertCollector->GetASGeometries(filter);
@@ -446,58 +485,44 @@ bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexColle
 
     const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &ranges = vertCollector->GetASBuildRangeInfos(filter);
     const std::vector<uint32_t> &primCounts = vertCollector->GetPrimitiveCounts(filter);
+    const std::vector<GeometryTopology> &topology = vertCollector->GetGeometryTopologies(filter);
 
     const bool fastTrace = !IsFastBuild(filter);
-    const bool update = false;
-
-    // get AS size and create buffer for AS
-    const auto buildSizes = asBuilder->GetBottomBuildSizes(geoms.size(), geoms.data(), primCounts.data(), fastTrace);
-
-    // if no buffer, or it was created, but its size is too small for current AS
-    blas.RecreateIfNotValid(buildSizes, allocator);
-
-    assert(blas.GetAS() != VK_NULL_HANDLE);
-
-    // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
-    asBuilder->AddBLAS(blas.GetAS(), geoms.size(),
-                       geoms.data(), ranges.data(),
-                       buildSizes,
-                       fastTrace, update, blas.GetFilter() & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE);
 
-    return true;
-}
+    // only dynamic BLAS is refitted, static is built once
+    const bool isUpdateable = filter & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
 
-void ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector)
-{
-    auto filter = blas.GetFilter();
-    const std::vector<VkAccelerationStructureGeometryKHR> &geoms = vertCollector->GetASGeometries(filter);
+    // get AS size and create buffer for AS
+    const auto buildSizes = asBuilder->GetBottomBuildSizes(geoms.size(), geoms.data(), primCounts.data(), fastTrace, isUpdateable, allowCompaction);
 
-    blas.SetGeometryCount((uint32_t)geoms.size());
+    // refit, if geometries have the same topology as on the last build of this BLAS,
+    // but rebuild periodically, as BVH quality decays with each refit
+    const bool update =
+        isUpdateable &&
+        blas.IsValid(buildSizes) &&
+        blas.GetUpdateCount() < DYNAMIC_BLAS_MAX_UPDATE_COUNT &&
+        blas.IsTopologySame(topology);
 
-    if (blas.IsEmpty())
+    if (update)
     {
-        return;
+        blas.OnUpdate();
+    }
+    else
+    {
+        // if no buffer, or it was created, but its size is too small for current AS
+        blas.RecreateIfNotValid(buildSizes, allocator);
+        blas.OnBuild(topology);
     }
 
-    const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &ranges = vertCollector->GetASBuildRangeInfos(filter);
-    const std::vector<uint32_t> &primCounts = vertCollector->GetPrimitiveCounts(filter);
-
-    const bool fastTrace = !IsFastBuild(filter);
-
-    // must be just updated
-    const bool update = true;
-
-    const auto buildSizes = asBuilder->GetBottomBuildSizes(
-        geoms.size(), geoms.data(), primCounts.data(), fastTrace);
-
-    assert(blas.IsValid(buildSizes));
     assert(blas.GetAS() != VK_NULL_HANDLE);
 
     // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
     asBuilder->AddBLAS(blas.GetAS(), geoms.size(),
                        geoms.data(), ranges.data(),
                        buildSizes,
-                       fastTrace, update, blas.GetFilter() & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE);
+                       fastTrace, update, isUpdateable, allowCompaction);
+
+    return true;
 }
 
 // separate functions to make adding between Begin..Geometry() and Submit..Geometry() a bit clearer
@@ -513,7 +538,14 @@ uint32_t ASManager::AddStaticGeometry(uint32_t frameIndex, const RgGeometryUploa
             textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[2])
         };
 
-        return collectorStatic->AddGeometry(frameIndex, info, materials);
+        uint32_t simpleIndex = pendingStatic.collector->AddGeometry(frameIndex, info, materials);
+
+        if (info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE && simpleIndex != UINT32_MAX)
+        {
+            AddMovableGeometry(pendingStatic, simpleIndex, VertexCollectorFilterTypeFlags_GetForGeometry(info), info.transform);
+        }
+
+        return simpleIndex;
     }
 
     assert(0);
@@ -538,247 +570,1140 @@ uint32_t ASManager::AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUplo
     return UINT32_MAX;
 }
 
-void ASManager::ResetStaticGeometry()
+void ASManager::AddStaticGeometries(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos, uint32_t *outSimpleIndices)
 {
-    collectorStatic->Reset();
-    geomInfoMgr->ResetWithStatic();
+    GetBatchMaterials(count, pInfos);
+    pendingStatic.collector->AddGeometries(frameIndex, count, pInfos, batchMaterials.data(), outSimpleIndices);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (pInfos[i].geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE && outSimpleIndices[i] != UINT32_MAX)
+        {
+            AddMovableGeometry(pendingStatic, outSimpleIndices[i], VertexCollectorFilterTypeFlags_GetForGeometry(pInfos[i]), pInfos[i].transform);
+        }
+    }
 }
 
-void ASManager::BeginStaticGeometry()
+void ASManager::AddDynamicGeometries(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos, uint32_t *outSimpleIndices)
 {
-    // the whole static vertex data must be recreated, clear previous data
-    collectorStatic->Reset();
-    geomInfoMgr->ResetWithStatic();
-
-    collectorStatic->BeginCollecting(true);
+    GetBatchMaterials(count, pInfos);
+    collectorDynamic[frameIndex]->AddGeometries(frameIndex, count, pInfos, batchMaterials.data(), outSimpleIndices);
 }
 
-void ASManager::SubmitStaticGeometry()
+bool ASManager::RecordDynamicGeometry(uint32_t frameIndex, uint32_t contextIndex, const RgGeometryUploadInfo &info)
 {
-    collectorStatic->EndCollecting();
-
-    // static geometry submission happens very infrequently, e.g. on level load
-    vkDeviceWaitIdle(device);
+    assert(info.geomType == RG_GEOMETRY_TYPE_DYNAMIC);
+    assert(contextIndex < dynamicRecordingContexts.size());
 
-    typedef VertexCollectorFilterTypeFlagBits FT;
+    auto &geometries = dynamicRecordingContexts[contextIndex]->geometries;
 
-    auto staticFlags = FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE;
+    geometries.emplace_back();
 
-    // destroy previous static
-    for (auto &staticBlas : allStaticBlas)
+    if (!collectorDynamic[frameIndex]->RecordDynamicGeometry(info, geometries.back()))
     {
-        assert(!(staticBlas->GetFilter() & FT::CF_DYNAMIC));
-
-        // if flags have any of static bits
-        if (staticBlas->GetFilter() & staticFlags)
-        {
-            staticBlas->Destroy();
-            staticBlas->SetGeometryCount(0);
-        }
+        geometries.pop_back();
+        return false;
     }
 
-    assert(asBuilder->IsEmpty());
+    return true;
+}
 
-    // skip if all static geometries are empty
-    if (collectorStatic->AreGeometriesEmpty(staticFlags))
-    {
-        return;
-    }
+uint32_t ASManager::GetDynamicRecordingContextCount() const
+{
+    return static_cast<uint32_t>(dynamicRecordingContexts.size());
+}
 
-    VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+bool ASManager::MapDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, RgGeometryUploadInfo &outMappedInfo)
+{
+    assert(info.geomType == RG_GEOMETRY_TYPE_DYNAMIC);
+    assert(!IsDynamicGeometryMapped(info.uniqueID));
 
-    // copy from staging with barrier
-    collectorStatic->CopyFromStaging(cmd, true);
+    MappedDynamicGeometry mapped = {};
 
-    // setup static blas
-    for (auto &staticBlas : allStaticBlas)
+    if (!collectorDynamic[frameIndex]->MapDynamicGeometry(info, mapped.recorded, mapped.mappedInfo))
     {
-        // if flags have any of static bits
-        if (staticBlas->GetFilter() & staticFlags)
-        {
-            SetupBLAS(*staticBlas, collectorStatic);
-        }
+        return false;
     }
-    
-    // build AS
-    asBuilder->BuildBottomLevel(cmd);
 
-    // submit geom info, in case if rgStartNewScene and rgSubmitStaticGeometries 
-    // were out of rgStartFrame - rgDrawFrame, so static geominfo-s won't be
-    // erased on GeomInfoManager::PrepareForFrame
-    geomInfoMgr->CopyFromStaging(cmd, 0, false);
+    mapped.indicesAreMapped = info.indexCount != 0 && info.pIndexData == nullptr;
 
-    // submit and wait
-    cmdManager->Submit(cmd, staticCopyFence);
-    Utils::WaitAndResetFence(device, staticCopyFence);
+    outMappedInfo = mapped.mappedInfo;
+    mappedDynamicGeometries.emplace(info.uniqueID, mapped);
+
+    return true;
 }
 
-void ASManager::BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
+bool ASManager::IsDynamicGeometryMapped(uint64_t uniqueID) const
 {
-    scratchBuffer->Reset();
+    return mappedDynamicGeometries.find(uniqueID) != mappedDynamicGeometries.end();
+}
 
-    static_assert(MAX_FRAMES_IN_FLIGHT == 2, "");
-    uint32_t prevFrameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+uint32_t ASManager::CommitMappedDynamicGeometry(uint32_t frameIndex, uint64_t uniqueID, RgGeometryUploadInfo &outMappedInfo)
+{
+    auto it = mappedDynamicGeometries.find(uniqueID);
+    assert(it != mappedDynamicGeometries.end());
 
-    // store data of current frame to use it in the next one
-    CopyDynamicDataToPrevBuffers(cmd, prevFrameIndex);
+    MappedDynamicGeometry &mapped = it->second;
 
-    // dynamic AS must be recreated
-    collectorDynamic[frameIndex]->Reset();
-    collectorDynamic[frameIndex]->BeginCollecting(false);
-}
+    if (mapped.indicesAreMapped)
+    {
+        VertexCollector::UpdateMappedTopology(mapped.mappedInfo, mapped.recorded);
+    }
 
-void ASManager::SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
-{
-    typedef VertexCollectorFilterTypeFlagBits FT;
+    MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT];
 
-    CmdLabel label(cmd, "Building dynamic BLAS");
+    for (uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++)
+    {
+        materials[layer] = textureMgr->GetMaterialTextures(mapped.recorded.geomMaterial.layerMaterials[layer]);
+    }
 
-    const auto &colDyn = collectorDynamic[frameIndex];
+    const uint32_t simpleIndex = collectorDynamic[frameIndex]->AddRecordedDynamicGeometry(frameIndex, mapped.recorded, materials);
 
-    colDyn->EndCollecting();
-    colDyn->CopyFromStaging(cmd, false);
+    outMappedInfo = mapped.mappedInfo;
+    mappedDynamicGeometries.erase(it);
 
-    assert(asBuilder->IsEmpty());
+    return simpleIndex;
+}
 
-    bool toBuild = false;
+void ASManager::MergeDynamicRecordingContexts(uint32_t frameIndex)
+{
+    const auto &colDyn = collectorDynamic[frameIndex];
 
-    // recreate dynamic blas
-    for (auto &dynamicBlas : allDynamicBlas[frameIndex])
+    for (auto &context : dynamicRecordingContexts)
     {
-        // must be dynamic
-        assert(dynamicBlas->GetFilter() & FT::CF_DYNAMIC);
+        for (auto &g : context->geometries)
+        {
+            MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT];
 
-        toBuild |= SetupBLAS(*dynamicBlas, colDyn);
-    }
-    
-    if (!toBuild)
-    {
-        return;
-    }
+            for (uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++)
+            {
+                materials[layer] = textureMgr->GetMaterialTextures(g.geomMaterial.layerMaterials[layer]);
+            }
 
-    // build BLAS
-    asBuilder->BuildBottomLevel(cmd);
+            colDyn->AddRecordedDynamicGeometry(frameIndex, g, materials);
+        }
 
-    // sync AS access
-    Utils::ASBuildMemoryBarrier(cmd);
+        context->geometries.clear();
+    }
 }
 
-void ASManager::UpdateStaticMovableTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo)
+void ASManager::GetBatchMaterials(uint32_t count, const RgGeometryUploadInfo *pInfos)
 {
-    collectorStatic->UpdateTransform(simpleIndex, updateInfo);
+    batchMaterials.resize((size_t)count * MATERIALS_MAX_LAYER_COUNT);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++)
+        {
+            batchMaterials[i * MATERIALS_MAX_LAYER_COUNT + layer] = textureMgr->GetMaterialTextures(pInfos[i].geomMaterial.layerMaterials[layer]);
+        }
+    }
 }
 
-void RTGL1::ASManager::UpdateStaticTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo)
+void ASManager::ResetStaticGeometry()
 {
-    collectorStatic->UpdateTexCoords(simpleIndex, texCoordsInfo);
+    ResetPendingStaticScene();
 }
 
-void RTGL1::ASManager::ResubmitStaticTexCoords(VkCommandBuffer cmd)
+void ASManager::ResetPendingStaticScene()
 {
-    typedef VertexCollectorFilterTypeFlagBits FT;
+    if (isStaticBuildSubmitted)
+    {
+        // the pending scene is not swapped yet, but its building must be finished
+        Utils::WaitAndResetFence(device, staticCopyFence);
+        isStaticBuildSubmitted = false;
+    }
 
-    if (collectorStatic->AreGeometriesEmpty(FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE))
+    isStaticSwapPending = false;
+
+    // pending scene is never used in TLAS, so its BLAS-es can be destroyed right away
+    for (auto &staticBlas : pendingStatic.blas)
     {
-        return;
+        staticBlas->Destroy();
+        staticBlas->SetGeometryCount(0);
     }
 
-    CmdLabel label(cmd, "Recopying static tex coords");
+    pendingBlasToCompact.clear();
+
+    pendingStatic.clusters.clear();
+    pendingStatic.meshes.clear();
+    pendingStatic.movableGeoms.clear();
+    pendingStatic.simpleIndexToMovable.clear();
 
-    collectorStatic->RecopyTexCoordsFromStaging(cmd);
+    pendingStatic.collector->Reset();
 }
 
-void ASManager::ResubmitStaticMovable(VkCommandBuffer cmd)
+void ASManager::BeginStaticGeometry()
+{
+    // edits of the current static scene are discarded, as it's going to be replaced
+    for (const RecordedStaticGeometry &g : recordedStaticGeoms)
+    {
+        curStatic.collector->CancelRecordedStaticGeometry(g);
+    }
+    recordedStaticGeoms.clear();
+    staticGeomsToRemove.clear();
+
+    // the whole static vertex data must be recreated, clear previous data
+    ResetPendingStaticScene();
+
+    pendingStatic.collector->BeginCollecting(true);
+}
+
+void ASManager::SubmitStaticGeometry()
 {
     typedef VertexCollectorFilterTypeFlagBits FT;
 
-    if (collectorStatic->AreGeometriesEmpty(FT::CF_STATIC_MOVABLE))
+    const auto &collector = pendingStatic.collector;
+
+    collector->EndCollecting();
+
+    // static buffers could be grown while collecting; AS geometries
+    // of the filters are rebased by the collector, meshes have their own
+    if (collector->ResizeDeviceBuffers())
     {
-        return;
+        for (auto &m : pendingStatic.meshes)
+        {
+            collector->RebaseASGeometry(m.geom.asGeometry);
+        }
     }
 
+    assert(!isStaticBuildSubmitted);
+    isStaticSwapPending = true;
+
     assert(asBuilder->IsEmpty());
 
-    // update movable blas
-    for (auto &blas : allStaticBlas)
+    // skip if all static geometries are empty, the scene is swapped with an empty one
+    if (collector->AreGeometriesEmpty(FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE) && pendingStatic.meshes.empty())
     {
-        assert(!(blas->GetFilter() & FT::CF_DYNAMIC));
+        return;
+    }
+
+    // static geometry submission happens very infrequently, e.g. on level load,
+    // but it's built without waiting, the current static scene is used until then;
+    // cmd is not bound to the frame, as building can take several frames
+    VkCommandBuffer cmd = cmdManager->StartStandaloneGraphicsCmd();
+
+    CmdLabel label(cmd, "Building static BLAS");
+
+    // device-local buffers of the pending scene could be used by the previously submitted frames,
+    // if it was the current one; also, AS build scratch memory could be in use
+    {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+        barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    // copy from staging with barrier
+    collector->CopyFromStaging(cmd, true);
+
+    // setup static blas, they're never updated, so all of them can be compacted
+    assert(pendingBlasToCompact.empty());
+
+    for (auto &staticBlas : pendingStatic.blas)
+    {
+        assert(!(staticBlas->GetFilter() & FT::CF_DYNAMIC));
+
+        // if geometries are split into clusters, the filter's BLAS is not used
+        if (SetupStaticClusters(pendingStatic, staticBlas->GetFilter()))
+        {
+            staticBlas->SetGeometryCount(0);
+            continue;
+        }
 
-        if (blas->GetFilter() & FT::CF_STATIC_MOVABLE)
+        if (SetupBLAS(*staticBlas, collector, true))
         {
-            UpdateBLAS(*blas, collectorStatic);
+            pendingBlasToCompact.push_back(&staticBlas);
         }
     }
 
-    CmdLabel label(cmd, "Building static movable BLAS");
+    // clusters are not added anymore, so the pointers are valid
+    for (auto &c : pendingStatic.clusters)
+    {
+        pendingBlasToCompact.push_back(&c.blas);
+    }
 
-    // copy transforms to device-local memory
-    collectorStatic->RecopyTransformsFromStaging(cmd);
+    for (auto &m : pendingStatic.meshes)
+    {
+        SetupMeshBLAS(*m.blas, m.geom);
+        pendingBlasToCompact.push_back(&m.blas);
+    }
 
+    for (auto &m : pendingStatic.movableGeoms)
+    {
+        SetupMovableBLAS(*m.blas, *collector, m.filter, m.localGeomIndex, true);
+        pendingBlasToCompact.push_back(&m.blas);
+    }
+    
+    // build AS
     asBuilder->BuildBottomLevel(cmd);
-}
 
-bool ASManager::SetupTLASInstanceFromBLAS(const BLASComponent &blas, uint32_t rayCullMaskWorld, VkAccelerationStructureInstanceKHR &instance)
-{
-    typedef VertexCollectorFilterTypeFlagBits FT;
+    WriteStaticCompactedSizes(cmd);
 
-    if (blas.GetAS() == VK_NULL_HANDLE || blas.IsEmpty())
+    // sync AS access with the frames that will be submitted after,
+    // including the builds that reuse the scratch memory
     {
-        return false;
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+        barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
     }
 
-    auto filter = blas.GetFilter();
+    // submit, but don't wait, the fence is checked on each frame start
+    cmdManager->Submit(cmd, staticCopyFence);
+    isStaticBuildSubmitted = true;
+}
 
-    instance.accelerationStructureReference = blas.GetASAddress();
+void ASManager::WriteStaticCompactedSizes(VkCommandBuffer cmd)
+{
+    if (pendingBlasToCompact.empty())
+    {
+        return;
+    }
 
-    instance.transform = 
+    const uint32_t count = static_cast<uint32_t>(pendingBlasToCompact.size());
+
+    // the previous pending scene is not being built, so the pool is not in use
+    if (compactionQueryPoolSize < count)
     {
-        1.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, 1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f
-    };
+        if (compactionQueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, compactionQueryPool, nullptr);
+        }
 
-    instance.instanceCustomIndex = 0;
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+        poolInfo.queryCount = count;
 
+        VkResult r = vkCreateQueryPool(device, &poolInfo, nullptr, &compactionQueryPool);
+        VK_CHECKERROR(r);
 
-    if (filter & FT::CF_DYNAMIC)
-    {
-        // for choosing buffers with dynamic data
-        instance.instanceCustomIndex = INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC;
+        SET_DEBUG_NAME(device, compactionQueryPool, VK_OBJECT_TYPE_QUERY_POOL, "Static BLAS compaction query pool");
+
+        compactionQueryPoolSize = count;
     }
 
+    std::vector<VkAccelerationStructureKHR> blasHandles(count);
 
-    if (filter & FT::PV_FIRST_PERSON)
+    for (uint32_t i = 0; i < count; i++)
     {
-        instance.mask = INSTANCE_MASK_FIRST_PERSON;
-        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON;
+        blasHandles[i] = (*pendingBlasToCompact[i])->GetAS();
     }
-    else if (filter & FT::PV_FIRST_PERSON_VIEWER)
+
+    // compacted size can be queried only after the building is finished
     {
-        instance.mask = INSTANCE_MASK_FIRST_PERSON_VIEWER;
-        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER;
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+        barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
     }
-    else
-    {
-        // also check rayCullMaskWorld, if world part is not included in the cull mask,
-        // then don't add it to BLAS at all, it helps culling PT_REFLECT if it was a world part
 
-        if (filter & FT::PV_WORLD_0)
-        {
-            instance.mask = INSTANCE_MASK_WORLD_0;
+    vkCmdResetQueryPool(cmd, compactionQueryPool, 0, count);
 
-            if (!(rayCullMaskWorld & (1 << 0)))
-            {
-                instance = {};
-                return false;
-            }
-        }
-        else if (filter & FT::PV_WORLD_1)
-        {
-            instance.mask = INSTANCE_MASK_WORLD_1;
+    svkCmdWriteAccelerationStructuresPropertiesKHR(
+        cmd, count, blasHandles.data(),
+        VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, compactionQueryPool, 0);
+}
 
-            if (!(rayCullMaskWorld & (1 << 1)))
-            {
+void ASManager::CompactPendingStaticBLAS(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    staticCompactionSavedBytes = 0;
+
+    if (pendingBlasToCompact.empty())
+    {
+        return;
+    }
+
+    const uint32_t count = static_cast<uint32_t>(pendingBlasToCompact.size());
+
+    // the building fence was signaled, so no VK_QUERY_RESULT_WAIT_BIT
+    std::vector<VkDeviceSize> compactedSizes(count);
+
+    VkResult r = vkGetQueryPoolResults(
+        device, compactionQueryPool, 0, count,
+        count * sizeof(VkDeviceSize), compactedSizes.data(), sizeof(VkDeviceSize),
+        VK_QUERY_RESULT_64_BIT);
+
+    if (r != VK_SUCCESS)
+    {
+        // keep uncompacted BLAS-es
+        pendingBlasToCompact.clear();
+        return;
+    }
+
+    CmdLabel label(cmd, "Compacting static BLAS");
+
+    bool toCopy = false;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::unique_ptr<BLASComponent> &original = *pendingBlasToCompact[i];
+        const VkDeviceSize originalSize = original->GetSize();
+
+        if (compactedSizes[i] == 0 || compactedSizes[i] >= originalSize)
+        {
+            continue;
+        }
+
+        VkAccelerationStructureBuildSizesInfoKHR compactedSizeInfo = {};
+        compactedSizeInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
+        compactedSizeInfo.accelerationStructureSize = compactedSizes[i];
+
+        auto compacted = std::make_unique<BLASComponent>(device, original->GetFilter());
+        compacted->SetGeometryCount(original->GetGeomCount());
+        compacted->RecreateIfNotValid(compactedSizeInfo, allocator);
+
+        VkCopyAccelerationStructureInfoKHR copyInfo = {};
+        copyInfo.sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR;
+        copyInfo.src = original->GetAS();
+        copyInfo.dst = compacted->GetAS();
+        copyInfo.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+
+        svkCmdCopyAccelerationStructureKHR(cmd, &copyInfo);
+
+        staticCompactionSavedBytes += originalSize - compactedSizes[i];
+
+        // original is read by the copy in this frame
+        retiredStaticBlas[frameIndex].push_back(std::move(original));
+        original = std::move(compacted);
+
+        toCopy = true;
+    }
+
+    pendingBlasToCompact.clear();
+
+    if (toCopy)
+    {
+        // sync AS access
+        Utils::ASBuildMemoryBarrier(cmd);
+    }
+}
+
+bool ASManager::TrySwapStaticScene(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!isStaticSwapPending)
+    {
+        return false;
+    }
+
+    if (isStaticBuildSubmitted)
+    {
+        if (vkGetFenceStatus(device, staticCopyFence) != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        VkResult r = vkResetFences(device, 1, &staticCopyFence);
+        VK_CHECKERROR(r);
+
+        isStaticBuildSubmitted = false;
+    }
+
+    isStaticSwapPending = false;
+
+    // replace with compacted copies before the scene is used in TLAS
+    CompactPendingStaticBLAS(cmd, frameIndex);
+
+    std::swap(curStatic, pendingStatic);
+
+    // BLAS-es of the previous scene can be in use by frames in flight
+    for (auto &staticBlas : pendingStatic.blas)
+    {
+        const VertexCollectorFilterTypeFlags filter = staticBlas->GetFilter();
+        retiredStaticBlas[frameIndex].push_back(std::move(staticBlas));
+        staticBlas = std::make_unique<BLASComponent>(device, filter);
+    }
+
+    for (auto &m : pendingStatic.meshes)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(m.blas));
+    }
+
+    for (auto &m : pendingStatic.movableGeoms)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(m.blas));
+    }
+
+    for (auto &c : pendingStatic.clusters)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(c.blas));
+    }
+
+    pendingStatic.clusters.clear();
+    pendingStatic.meshes.clear();
+    pendingStatic.movableGeoms.clear();
+    pendingStatic.simpleIndexToMovable.clear();
+
+    // edits were recorded for the previous scene
+    for (const RecordedStaticGeometry &g : recordedStaticGeoms)
+    {
+        pendingStatic.collector->CancelRecordedStaticGeometry(g);
+    }
+    recordedStaticGeoms.clear();
+    staticGeomsToRemove.clear();
+
+    // mesh instances refer to the meshes of the previous scene
+    for (auto &instances : meshInstances)
+    {
+        instances.clear();
+    }
+
+    // dynamic geometry is not added yet in this frame, so geom infos can be rewritten
+    geomInfoMgr->ResetWithStatic();
+    curStatic.collector->FlushStaticGeomInfos(frameIndex);
+
+    // descriptor sets of other frames can be in use, they're updated on their frame start
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        buffersDescDirty[i] = true;
+    }
+
+    UpdateBufferDescriptors(frameIndex);
+    buffersDescDirty[frameIndex] = false;
+
+    return true;
+}
+
+bool ASManager::IsStaticSceneSwapPending() const
+{
+    return isStaticSwapPending;
+}
+
+VkDeviceSize ASManager::GetStaticCompactionSavedBytes() const
+{
+    return staticCompactionSavedBytes;
+}
+
+bool ASManager::RecordStaticGeometry(const RgGeometryUploadInfo &info)
+{
+    assert(info.geomType == RG_GEOMETRY_TYPE_STATIC || info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE);
+
+    recordedStaticGeoms.emplace_back();
+
+    if (!curStatic.collector->RecordStaticGeometry(info, recordedStaticGeoms.back()))
+    {
+        recordedStaticGeoms.pop_back();
+        return false;
+    }
+
+    return true;
+}
+
+void ASManager::CancelRecordedStaticGeometry(uint64_t uniqueID)
+{
+    for (auto it = recordedStaticGeoms.begin(); it != recordedStaticGeoms.end(); ++it)
+    {
+        if (it->uniqueID == uniqueID)
+        {
+            curStatic.collector->CancelRecordedStaticGeometry(*it);
+            recordedStaticGeoms.erase(it);
+            return;
+        }
+    }
+
+    assert(0);
+}
+
+void ASManager::RemoveStaticGeometry(uint32_t simpleIndex)
+{
+    staticGeomsToRemove.push_back(simpleIndex);
+}
+
+void ASManager::SubmitStaticGeometryEdits(VkCommandBuffer cmd, uint32_t frameIndex, std::vector<AddedStaticGeometry> &outAdded)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    outAdded.clear();
+
+    if (recordedStaticGeoms.empty() && staticGeomsToRemove.empty())
+    {
+        return;
+    }
+
+    CmdLabel label(cmd, "Editing static geometry");
+
+    // bit for each filter ID, which BLAS must be rebuilt
+    static_assert(MAX_TOP_LEVEL_INSTANCE_COUNT <= 64, "Filter IDs must fit 64-bit mask");
+    uint64_t toRebuild = 0;
+
+    // remove first, so their slots are not reused in the same frame,
+    // as the slots are released only when this frame is finished
+    for (uint32_t simpleIndex : staticGeomsToRemove)
+    {
+        const VertexCollectorFilterTypeFlags filter = curStatic.collector->RemoveStaticGeometry(frameIndex, simpleIndex);
+
+        if (filter & FT::CF_STATIC_MOVABLE)
+        {
+            RemoveMovableGeometry(frameIndex, simpleIndex);
+        }
+        else if (filter != 0)
+        {
+            toRebuild |= 1ull << VertexCollectorFilterTypeFlags_GetID(filter);
+        }
+    }
+
+    const size_t firstNewMovable = curStatic.movableGeoms.size();
+
+    for (RecordedStaticGeometry &g : recordedStaticGeoms)
+    {
+        MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT];
+
+        for (uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++)
+        {
+            materials[layer] = textureMgr->GetMaterialTextures(g.geomMaterial.layerMaterials[layer]);
+        }
+
+        const uint32_t simpleIndex = curStatic.collector->AddRecordedStaticGeometry(g, materials);
+        const bool isMovable = g.geomFlags & FT::CF_STATIC_MOVABLE;
+
+        if (simpleIndex != UINT32_MAX)
+        {
+            if (isMovable)
+            {
+                AddMovableGeometry(curStatic, simpleIndex, g.geomFlags, g.transform);
+            }
+            else
+            {
+                toRebuild |= 1ull << VertexCollectorFilterTypeFlags_GetID(g.geomFlags);
+            }
+        }
+
+        outAdded.push_back({ g.uniqueID, simpleIndex, isMovable });
+    }
+
+    recordedStaticGeoms.clear();
+    staticGeomsToRemove.clear();
+
+    // recorded geometries could grow the staging buffers; AS geometries
+    // of the filters are rebased by the collector, meshes have their own
+    if (curStatic.collector->GrowSubmittedDeviceBuffers(cmd))
+    {
+        for (auto &m : curStatic.meshes)
+        {
+            curStatic.collector->RebaseASGeometry(m.geom.asGeometry);
+        }
+
+        // descriptor sets of other frames can be in use, they're updated on their frame start
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            buffersDescDirty[i] = true;
+        }
+
+        UpdateBufferDescriptors(frameIndex);
+        buffersDescDirty[frameIndex] = false;
+    }
+
+    curStatic.collector->CopyAddedStaticGeometriesFromStaging(cmd);
+
+    assert(asBuilder->IsEmpty());
+
+    bool toBuild = false;
+
+    for (auto &staticBlas : curStatic.blas)
+    {
+        if (!(toRebuild & (1ull << VertexCollectorFilterTypeFlags_GetID(staticBlas->GetFilter()))))
+        {
+            continue;
+        }
+
+        // previous BLAS can be in use by frames in flight, so build a new one
+        const VertexCollectorFilterTypeFlags filter = staticBlas->GetFilter();
+        retiredStaticBlas[frameIndex].push_back(std::move(staticBlas));
+        staticBlas = std::make_unique<BLASComponent>(device, filter);
+
+        // clusters are not rebuilt, the whole filter is in its BLAS again
+        RemoveStaticClusters(frameIndex, filter);
+
+        toBuild |= SetupBLAS(*staticBlas, curStatic.collector, false);
+    }
+
+    for (size_t i = firstNewMovable; i < curStatic.movableGeoms.size(); i++)
+    {
+        MovableGeometry &m = curStatic.movableGeoms[i];
+        SetupMovableBLAS(*m.blas, *curStatic.collector, m.filter, m.localGeomIndex, false);
+
+        toBuild = true;
+    }
+
+    if (!toBuild)
+    {
+        return;
+    }
+
+    asBuilder->BuildBottomLevel(cmd);
+
+    // sync AS access
+    Utils::ASBuildMemoryBarrier(cmd);
+}
+
+void ASManager::BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    scratchBuffer->Reset();
+
+    // the frame with this index is finished, so resources that were
+    // retired by static geometry edits or by growing the buffers are not in use
+    retiredStaticBlas[frameIndex].clear();
+    retiredBuffers[frameIndex].clear();
+    curStatic.collector->ReleaseRemovedStaticGeometries(frameIndex);
+
+    GrowDynamicBuffers(frameIndex);
+
+    uint32_t prevFrameIndex = (frameIndex + framesInFlight - 1) % framesInFlight;
+
+    // store data of current frame to use it in the next one,
+    // it must be done before resizing the device local buffers
+    CopyDynamicDataToPrevBuffers(cmd, prevFrameIndex);
+
+    // dynamic AS must be recreated
+    collectorDynamic[frameIndex]->Reset();
+    collectorDynamic[frameIndex]->BeginCollecting(false);
+
+    ResizeDynamicDeviceBuffers();
+
+    // buffers that were retired since the previous frame start can be in use
+    // by the submitted frames, they'll be finished before the current one
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        collectorDynamic[i]->TakeRetiredBuffers(retiredBuffers[frameIndex]);
+    }
+
+    for (StaticScene *scene : { &curStatic, &pendingStatic })
+    {
+        scene->collector->TakeRetiredBuffers(retiredBuffers[frameIndex]);
+    }
+
+    // the frame with this index is finished, so its descriptor set is not in use
+    if (buffersDescDirty[frameIndex])
+    {
+        UpdateBufferDescriptors(frameIndex);
+        buffersDescDirty[frameIndex] = false;
+    }
+
+    // geometries could be left, if the previous frame wasn't rendered
+    for (auto &context : dynamicRecordingContexts)
+    {
+        context->geometries.clear();
+    }
+
+    // geometries that weren't committed in the previous frame are dropped
+    mappedDynamicGeometries.clear();
+
+    meshInstances[frameIndex].clear();
+}
+
+void ASManager::SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    CmdLabel label(cmd, "Building dynamic BLAS");
+
+    const auto &colDyn = collectorDynamic[frameIndex];
+
+    MergeDynamicRecordingContexts(frameIndex);
+
+    colDyn->EndCollecting();
+    colDyn->CopyFromStaging(cmd, false);
+
+    assert(asBuilder->IsEmpty());
+
+    bool toBuild = false;
+
+    // recreate dynamic blas
+    for (auto &dynamicBlas : allDynamicBlas[frameIndex])
+    {
+        // must be dynamic
+        assert(dynamicBlas->GetFilter() & FT::CF_DYNAMIC);
+
+        toBuild |= SetupBLAS(*dynamicBlas, colDyn, false);
+    }
+    
+    if (!toBuild)
+    {
+        return;
+    }
+
+    // build BLAS
+    asBuilder->BuildBottomLevel(cmd);
+
+    // sync AS access
+    Utils::ASBuildMemoryBarrier(cmd);
+}
+
+uint32_t ASManager::AddMesh(const RgMeshCreateInfo &info)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    Mesh m = {};
+
+    if (!pendingStatic.collector->AddMesh(info, m.geom))
+    {
+        assert(0);
+        return UINT32_MAX;
+    }
+
+    // filter is used only for the debug name
+    m.blas = std::make_unique<BLASComponent>(device, FT::CF_STATIC_NON_MOVABLE | FT::PT_ALPHA_TESTED | FT::PV_WORLD_0);
+
+    pendingStatic.meshes.push_back(std::move(m));
+    return static_cast<uint32_t>(pendingStatic.meshes.size() - 1);
+}
+
+uint32_t ASManager::GetMeshCount() const
+{
+    return static_cast<uint32_t>(curStatic.meshes.size());
+}
+
+bool ASManager::AddMeshInstance(uint32_t frameIndex, uint32_t meshIndex, const RgMeshInstanceUploadInfo &info)
+{
+    assert(meshIndex < curStatic.meshes.size());
+
+    MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT];
+
+    for (uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++)
+    {
+        materials[layer] = textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[layer]);
+    }
+
+    ShGeometryInstance geomInfo;
+    VertexCollector::PrepareMeshInstanceGeomInfo(curStatic.meshes[meshIndex].geom, info, materials, geomInfo);
+
+    const uint32_t globalGeomIndex = geomInfoMgr->WriteMeshInstanceGeomInfo(frameIndex, info.uniqueID, geomInfo);
+
+    if (globalGeomIndex == UINT32_MAX)
+    {
+        return false;
+    }
+
+    MeshInstance inst = {};
+    inst.meshIndex = meshIndex;
+    inst.globalGeomIndex = globalGeomIndex;
+    inst.filter = VertexCollectorFilterTypeFlags_Get(RG_GEOMETRY_TYPE_STATIC_MOVABLE, info.passThroughType, info.visibilityType);
+    inst.transform = info.transform;
+
+    meshInstances[frameIndex].push_back(inst);
+    return true;
+}
+
+void ASManager::SetupMeshBLAS(BLASComponent &blas, const MeshGeometry &mesh)
+{
+    blas.SetGeometryCount(1);
+
+    // meshes are not changing, so fast trace
+    const bool fastTrace = true;
+    const bool update = false;
+
+    const auto buildSizes = asBuilder->GetBottomBuildSizes(1, &mesh.asGeometry, &mesh.primitiveCount, fastTrace, false, true);
+
+    blas.RecreateIfNotValid(buildSizes, allocator);
+    assert(blas.GetAS() != VK_NULL_HANDLE);
+
+    // meshes are built only on static submission, so they're always compacted
+    asBuilder->AddBLAS(blas.GetAS(), 1, &mesh.asGeometry, &mesh.range, buildSizes, fastTrace, update, false, true);
+}
+
+bool ASManager::SetupStaticClusters(StaticScene &scene, VertexCollectorFilterTypeFlags filter)
+{
+    if (maxStaticClusterCount <= 1)
+    {
+        return false;
+    }
+
+    const VertexCollector &collector = *scene.collector;
+
+    const auto &geoms = collector.GetASGeometries(filter);
+    const auto &ranges = collector.GetASBuildRangeInfos(filter);
+    const auto &primCounts = collector.GetPrimitiveCounts(filter);
+
+    if (geoms.empty())
+    {
+        return false;
+    }
+
+    collector.GetStaticGeometryBounds(filter, clusterBounds);
+    staticClusterizer.Clusterize(clusterBounds.data(), static_cast<uint32_t>(clusterBounds.size()), clusterIndices);
+
+    if (clusterIndices.size() <= 1)
+    {
+        return false;
+    }
+
+    const bool fastTrace = !IsFastBuild(filter);
+
+    for (const auto &indices : clusterIndices)
+    {
+        assert(!indices.empty());
+
+        const auto minmax = std::minmax_element(indices.begin(), indices.end());
+        const uint32_t first = *minmax.first;
+        const uint32_t count = *minmax.second - first + 1;
+
+        StaticCluster c = {};
+        c.filter = filter;
+        c.firstLocalGeomIndex = first;
+        c.ranges.resize(count, VkAccelerationStructureBuildRangeInfoKHR{});
+        c.primCounts.resize(count, 0);
+
+        for (uint32_t localIndex : indices)
+        {
+            c.ranges[localIndex - first] = ranges[localIndex];
+            c.primCounts[localIndex - first] = primCounts[localIndex];
+        }
+
+        c.blas = std::make_unique<BLASComponent>(device, filter);
+        c.blas->SetGeometryCount(count);
+
+        const auto buildSizes = asBuilder->GetBottomBuildSizes(count, &geoms[first], c.primCounts.data(), fastTrace, false, true);
+
+        c.blas->RecreateIfNotValid(buildSizes, allocator);
+        assert(c.blas->GetAS() != VK_NULL_HANDLE);
+
+        // moving the cluster doesn't reallocate its ranges, so they're valid until BuildBottomLevel() call
+        asBuilder->AddBLAS(c.blas->GetAS(), count, &geoms[first], c.ranges.data(), buildSizes, fastTrace, false, false, true);
+
+        scene.clusters.push_back(std::move(c));
+    }
+
+    return true;
+}
+
+void ASManager::RemoveStaticClusters(uint32_t frameIndex, VertexCollectorFilterTypeFlags filter)
+{
+    auto &clusters = curStatic.clusters;
+
+    for (auto &c : clusters)
+    {
+        if (c.filter == filter)
+        {
+            // BLAS can be in use by frames in flight
+            retiredStaticBlas[frameIndex].push_back(std::move(c.blas));
+        }
+    }
+
+    clusters.erase(
+        std::remove_if(clusters.begin(), clusters.end(), [filter] (const StaticCluster &c) { return c.filter == filter; }),
+        clusters.end());
+}
+
+void ASManager::AddMovableGeometry(StaticScene &scene, uint32_t simpleIndex, VertexCollectorFilterTypeFlags filter, const RgTransform &transform)
+{
+    assert(filter & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE);
+
+    MovableGeometry m = {};
+    m.filter = filter;
+    m.simpleIndex = simpleIndex;
+    // geom info of the pending scene is not in the geom info manager yet
+    m.localGeomIndex = scene.collector->GetStaticGeomLocalIndex(simpleIndex);
+    m.globalGeomIndex = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(m.filter) + m.localGeomIndex;
+    m.transform = transform;
+    m.blas = std::make_unique<BLASComponent>(device, m.filter);
+
+    scene.simpleIndexToMovable[simpleIndex] = static_cast<uint32_t>(scene.movableGeoms.size());
+    scene.movableGeoms.push_back(std::move(m));
+}
+
+void ASManager::RemoveMovableGeometry(uint32_t frameIndex, uint32_t simpleIndex)
+{
+    auto &movableGeoms = curStatic.movableGeoms;
+    auto &simpleIndexToMovable = curStatic.simpleIndexToMovable;
+
+    auto f = simpleIndexToMovable.find(simpleIndex);
+
+    if (f == simpleIndexToMovable.end())
+    {
+        assert(0);
+        return;
+    }
+
+    const uint32_t index = f->second;
+    simpleIndexToMovable.erase(f);
+
+    // BLAS can be in use by frames in flight
+    retiredStaticBlas[frameIndex].push_back(std::move(movableGeoms[index].blas));
+
+    // swap with the last one, to not shift the indices
+    if (index != movableGeoms.size() - 1)
+    {
+        movableGeoms[index] = std::move(movableGeoms.back());
+        simpleIndexToMovable[movableGeoms[index].simpleIndex] = index;
+    }
+
+    movableGeoms.pop_back();
+}
+
+void ASManager::SetupMovableBLAS(BLASComponent &blas, const VertexCollector &collector, VertexCollectorFilterTypeFlags filter, uint32_t localGeomIndex, bool allowCompaction)
+{
+    const auto &geoms = collector.GetASGeometries(filter);
+    const auto &ranges = collector.GetASBuildRangeInfos(filter);
+    const auto &primCounts = collector.GetPrimitiveCounts(filter);
+
+    assert(localGeomIndex < geoms.size());
+
+    blas.SetGeometryCount(1);
+
+    // geometry is not changing, only its TLAS instance transform, so fast trace
+    const bool fastTrace = true;
+    const bool update = false;
+
+    const auto buildSizes = asBuilder->GetBottomBuildSizes(1, &geoms[localGeomIndex], &primCounts[localGeomIndex], fastTrace, false, allowCompaction);
+
+    blas.RecreateIfNotValid(buildSizes, allocator);
+    assert(blas.GetAS() != VK_NULL_HANDLE);
+
+    asBuilder->AddBLAS(blas.GetAS(), 1, &geoms[localGeomIndex], &ranges[localGeomIndex], buildSizes, fastTrace, update, false, allowCompaction);
+}
+
+uint32_t ASManager::GetMaxObjectInstanceCount()
+{
+    typedef VertexCollectorFilterTypeFlags FL;
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    uint32_t maxMovableCount = 0;
+
+    VertexCollectorFilterTypeFlags_IterateOverFlags([&maxMovableCount] (FL filter)
+    {
+        if (filter & FT::CF_STATIC_MOVABLE)
+        {
+            maxMovableCount += VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(filter);
+        }
+    });
+
+    // each static filter can be split into clusters
+    const uint32_t maxClusterCount = MAX_TOP_LEVEL_INSTANCE_COUNT * STATIC_GEOMETRY_CLUSTER_COUNT_MAX;
+
+    return MAX_MESH_INSTANCE_COUNT + maxMovableCount + maxClusterCount;
+}
+
+void ASManager::UpdateStaticMovableTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo)
+{
+    auto f = curStatic.simpleIndexToMovable.find(simpleIndex);
+
+    if (f == curStatic.simpleIndexToMovable.end())
+    {
+        assert(0);
+        return;
+    }
+
+    // new transform will be used on the next TLAS build
+    curStatic.movableGeoms[f->second].transform = updateInfo.transform;
+
+    geomInfoMgr->WriteStaticGeomInfoTransform(simpleIndex, updateInfo.movableStaticUniqueID, updateInfo.transform);
+}
+
+void RTGL1::ASManager::UpdateStaticTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo)
+{
+    curStatic.collector->UpdateTexCoords(simpleIndex, texCoordsInfo);
+}
+
+void RTGL1::ASManager::ResubmitStaticTexCoords(VkCommandBuffer cmd)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    if (curStatic.collector->AreGeometriesEmpty(FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE))
+    {
+        return;
+    }
+
+    CmdLabel label(cmd, "Recopying static tex coords");
+
+    curStatic.collector->RecopyTexCoordsFromStaging(cmd);
+}
+
+bool ASManager::SetupTLASInstanceFromBLAS(const BLASComponent &blas, uint32_t rayCullMaskWorld, VkAccelerationStructureInstanceKHR &instance)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    if (blas.GetAS() == VK_NULL_HANDLE || blas.IsEmpty())
+    {
+        return false;
+    }
+
+    auto filter = blas.GetFilter();
+
+    instance.accelerationStructureReference = blas.GetASAddress();
+
+    instance.transform = 
+    {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    return SetupTLASInstanceFlags(filter, rayCullMaskWorld, instance);
+}
+
+bool ASManager::SetupTLASInstanceFlags(VertexCollectorFilterTypeFlags filter, uint32_t rayCullMaskWorld, VkAccelerationStructureInstanceKHR &instance)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    instance.instanceCustomIndex = 0;
+
+
+    if (filter & FT::CF_DYNAMIC)
+    {
+        // for choosing buffers with dynamic data
+        instance.instanceCustomIndex = INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC;
+    }
+
+
+    if (filter & FT::PV_FIRST_PERSON)
+    {
+        instance.mask = INSTANCE_MASK_FIRST_PERSON;
+        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON;
+    }
+    else if (filter & FT::PV_FIRST_PERSON_VIEWER)
+    {
+        instance.mask = INSTANCE_MASK_FIRST_PERSON_VIEWER;
+        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER;
+    }
+    else
+    {
+        // also check rayCullMaskWorld, if world part is not included in the cull mask,
+        // then don't add it to BLAS at all, it helps culling PT_REFLECT if it was a world part
+
+        if (filter & FT::PV_WORLD_0)
+        {
+            instance.mask = INSTANCE_MASK_WORLD_0;
+
+            if (!(rayCullMaskWorld & (1 << 0)))
+            {
+                instance = {};
+                return false;
+            }
+        }
+        else if (filter & FT::PV_WORLD_1)
+        {
+            instance.mask = INSTANCE_MASK_WORLD_1;
+
+            if (!(rayCullMaskWorld & (1 << 1)))
+            {
                 instance = {};
                 return false;
             }
@@ -843,12 +1768,12 @@ bool ASManager::SetupTLASInstanceFromBLAS(const BLASComponent &blas, uint32_t ra
     return true;
 }
 
-static void WriteInstanceGeomInfo(int32_t *instanceGeomInfoOffset, int32_t *instanceGeomCount, uint32_t index, const BLASComponent &blas)
+static void WriteInstanceGeomInfo(int32_t *instanceGeomInfoOffset, int32_t *instanceGeomCount, uint32_t index, VertexCollectorFilterTypeFlags filter, uint32_t filterGeomCount)
 {
     assert(index < MAX_TOP_LEVEL_INSTANCE_COUNT);
 
-    int32_t arrayOffset = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(blas.GetFilter());
-    int32_t geomCount = blas.GetGeomCount();
+    int32_t arrayOffset = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(filter);
+    int32_t geomCount = static_cast<int32_t>(filterGeomCount);
 
     // BLAS must not be empty, if it's added to TLAS
     assert(geomCount > 0 && geomCount < MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT);
@@ -861,7 +1786,7 @@ void ASManager::PrepareForBuildingTLAS(
     uint32_t frameIndex,
     ShGlobalUniform &uniformData,
     ShVertPreprocessing *outPush,
-    TLASPrepareResult *outResult) const
+    TLASPrepareResult *outResult)
 {
     typedef VertexCollectorFilterTypeFlagBits FT;
 
@@ -875,6 +1800,11 @@ void ASManager::PrepareForBuildingTLAS(
     auto &r = *outResult;
 
 
+    // offsets of the vertex attribute arrays depend on the capacities of the buffers
+    curStatic.collector->WriteVertexStreamOffsets(uniformData);
+    collectorDynamic[frameIndex]->WriteVertexStreamOffsets(uniformData);
+
+
     // write geometry offsets to uniform to access geomInfos
     // with instance ID and local (in terms of BLAS) geometry index in shaders;
     // Note: std140 requires elements to be aligned by sizeof(vec4)
@@ -885,7 +1815,7 @@ void ASManager::PrepareForBuildingTLAS(
 
     const std::vector<std::unique_ptr<BLASComponent>> *blasArrays[] =
     {
-        &allStaticBlas,
+        &curStatic.blas,
         &allDynamicBlas[frameIndex],
     };
 
@@ -906,22 +1836,127 @@ void ASManager::PrepareForBuildingTLAS(
                     outPush->tlasInstanceIsDynamicBits[r.instanceCount / MAX_TOP_LEVEL_INSTANCE_COUNT] |= 1 << (r.instanceCount % MAX_TOP_LEVEL_INSTANCE_COUNT);
                 }
 
-                WriteInstanceGeomInfo(instanceGeomInfoOffset, instanceGeomCount, r.instanceCount, *blas);
+                WriteInstanceGeomInfo(instanceGeomInfoOffset, instanceGeomCount, r.instanceCount, blas->GetFilter(), blas->GetGeomCount());
                 r.instanceCount++;
             }
         }
     }
 
-    outPush->tlasInstanceCount = r.instanceCount;
+    // only filter instances are processed in vertex preprocessing;
+    // clustered filters don't have a filter instance, so they're appended after
+    // the TLAS ones, their clusters are in the object instances
+    uint32_t preprocessCount = r.instanceCount;
+    VertexCollectorFilterTypeFlags prevClusterFilter = 0;
+
+    for (const StaticCluster &c : curStatic.clusters)
+    {
+        if (c.filter == prevClusterFilter)
+        {
+            continue;
+        }
+        prevClusterFilter = c.filter;
+
+        const uint32_t filterGeomCount = static_cast<uint32_t>(curStatic.collector->GetASGeometries(c.filter).size());
+
+        WriteInstanceGeomInfo(instanceGeomInfoOffset, instanceGeomCount, preprocessCount, c.filter, filterGeomCount);
+        preprocessCount++;
+    }
+
+    outPush->tlasInstanceCount = preprocessCount;
+
+
+    // each mesh instance, movable geometry and static cluster has its own TLAS instance,
+    // global geometry index is passed through the custom index
+    objectTLASInstances.clear();
+
+    for (const MeshInstance &mi : meshInstances[frameIndex])
+    {
+        const BLASComponent &blas = *curStatic.meshes[mi.meshIndex].blas;
+
+        if (blas.GetAS() == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        VkAccelerationStructureInstanceKHR instance = {};
+
+        if (!SetupTLASInstanceFlags(mi.filter, uniformData.rayCullMaskWorld, instance))
+        {
+            continue;
+        }
+
+        static_assert(sizeof(RgTransform) == sizeof(VkTransformMatrixKHR), "RgTransform and VkTransformMatrixKHR must have the same structure");
+        memcpy(&instance.transform, &mi.transform, sizeof(VkTransformMatrixKHR));
+
+        instance.accelerationStructureReference = blas.GetASAddress();
+        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_OBJECT | (mi.globalGeomIndex << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET);
+
+        objectTLASInstances.push_back(instance);
+    }
+
+    for (const MovableGeometry &m : curStatic.movableGeoms)
+    {
+        if (m.blas->GetAS() == VK_NULL_HANDLE || m.blas->IsEmpty())
+        {
+            continue;
+        }
+
+        VkAccelerationStructureInstanceKHR instance = {};
+
+        if (!SetupTLASInstanceFlags(m.filter, uniformData.rayCullMaskWorld, instance))
+        {
+            continue;
+        }
+
+        memcpy(&instance.transform, &m.transform, sizeof(VkTransformMatrixKHR));
+
+        instance.accelerationStructureReference = m.blas->GetASAddress();
+        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_OBJECT | (m.globalGeomIndex << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET);
+
+        objectTLASInstances.push_back(instance);
+    }
+
+    for (const StaticCluster &c : curStatic.clusters)
+    {
+        if (c.blas->GetAS() == VK_NULL_HANDLE || c.blas->IsEmpty())
+        {
+            continue;
+        }
+
+        VkAccelerationStructureInstanceKHR instance = {};
+
+        if (!SetupTLASInstanceFlags(c.filter, uniformData.rayCullMaskWorld, instance))
+        {
+            continue;
+        }
+
+        instance.transform = 
+        {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f
+        };
+
+        const uint32_t globalGeomIndex = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(c.filter) + c.firstLocalGeomIndex;
+
+        instance.accelerationStructureReference = c.blas->GetASAddress();
+        instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_OBJECT | (globalGeomIndex << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET);
+
+        objectTLASInstances.push_back(instance);
+    }
+
+    r.objectInstanceCount = static_cast<uint32_t>(objectTLASInstances.size());
 }
 
 bool ASManager::TryBuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLASPrepareResult &r)
 {
-    if (r.instanceCount == 0)
+    if (r.instanceCount == 0 && r.objectInstanceCount == 0)
     {
         return false;
     }
 
+    assert(r.objectInstanceCount == objectTLASInstances.size());
+
 
     CmdLabel label(cmd, "Building TLAS");
 
@@ -930,12 +1965,13 @@ bool ASManager::TryBuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLA
     auto *mapped = (VkAccelerationStructureInstanceKHR*)instanceBuffer->GetMapped(frameIndex);
 
     memcpy(mapped, r.instances, r.instanceCount * sizeof(VkAccelerationStructureInstanceKHR));
-
-    instanceBuffer->CopyFromStaging(cmd, frameIndex);
-
+    memcpy(mapped + r.instanceCount, objectTLASInstances.data(), r.objectInstanceCount * sizeof(VkAccelerationStructureInstanceKHR));
 
     TLASComponent *pCurrentTLAS = tlas[frameIndex].get();
-    uint32_t instanceCount = r.instanceCount;
+    uint32_t instanceCount = r.instanceCount + r.objectInstanceCount;
+
+    // copy only used part, as the buffer is big because of object instances
+    instanceBuffer->CopyFromStaging(cmd, frameIndex, instanceCount * sizeof(VkAccelerationStructureInstanceKHR));
 
 
     VkAccelerationStructureGeometryKHR instGeom = {};
@@ -945,7 +1981,7 @@ bool ASManager::TryBuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLA
     auto &instData = instGeom.geometry.instances;
     instData.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
     instData.arrayOfPointers = VK_FALSE;
-    instData.data.deviceAddress = instanceBuffer->GetDeviceAddress();
+    instData.data.deviceAddress = instanceBuffer->GetDeviceAddress(frameIndex);
 
     // get AS size and create buffer for AS
     VkAccelerationStructureBuildSizesInfoKHR buildSizes = asBuilder->GetTopBuildSizes(&instGeom, instanceCount, false);
@@ -977,6 +2013,95 @@ bool ASManager::TryBuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLA
     return true;
 }
 
+void ASManager::InitPreviousDynamicBuffers(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    previousDynamicPositions = std::make_shared<Buffer>();
+    previousDynamicPositions->Init(
+        allocator, (VkDeviceSize)vertexCapacity * VERTEX_POSITION_STRIDE,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's vertex data");
+
+    previousDynamicIndices = std::make_shared<Buffer>();
+    previousDynamicIndices->Init(
+        allocator, (VkDeviceSize)indexCapacity * sizeof(uint32_t),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's index data");
+
+    previousDynamicVertexCapacity = vertexCapacity;
+    previousDynamicIndexCapacity = indexCapacity;
+}
+
+void ASManager::GrowDynamicBuffers(uint32_t frameIndex)
+{
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        vertexCount = std::max(vertexCount, collectorDynamic[i]->GetRequestedVertexCount());
+        indexCount = std::max(indexCount, collectorDynamic[i]->GetRequestedIndexCount());
+    }
+
+    // dynamic collectors share device local buffers, so their capacities must be the same;
+    // staging buffers of other frames can be in use, the old ones are retired
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        collectorDynamic[i]->ReserveCapacity(vertexCount, indexCount);
+    }
+
+    const uint32_t vertexCapacity = collectorDynamic[frameIndex]->GetVertexCapacity();
+    const uint32_t indexCapacity = collectorDynamic[frameIndex]->GetIndexCapacity();
+
+    if (vertexCapacity == previousDynamicVertexCapacity && indexCapacity == previousDynamicIndexCapacity)
+    {
+        return;
+    }
+
+    // previous frame's data is copied right after, so old buffers are not copied
+    retiredBuffers[frameIndex].push_back(std::move(previousDynamicPositions));
+    retiredBuffers[frameIndex].push_back(std::move(previousDynamicIndices));
+
+    InitPreviousDynamicBuffers(vertexCapacity, indexCapacity);
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        buffersDescDirty[i] = true;
+    }
+}
+
+void ASManager::ResizeDynamicDeviceBuffers()
+{
+    bool resized = false;
+
+    if (collectorDynamic[0]->IsDirectWrite())
+    {
+        // the buffers of the previous frame were already copied to the previous frame's buffers
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            resized = collectorDynamic[i]->ResizeDeviceBuffers() || resized;
+        }
+    }
+    else if (collectorDynamic[0]->ResizeDeviceBuffers())
+    {
+        for (uint32_t i = 1; i < framesInFlight; i++)
+        {
+            collectorDynamic[i]->ShareDeviceBuffers(*collectorDynamic[0]);
+        }
+
+        resized = true;
+    }
+
+    if (!resized)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        buffersDescDirty[i] = true;
+    }
+}
+
 void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frameIndex)
 {
     uint32_t vertCount = collectorDynamic[frameIndex]->GetCurrentVertexCount();
@@ -987,12 +2112,12 @@ void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frame
         VkBufferCopy vertRegion = {};
         vertRegion.srcOffset = 0;
         vertRegion.dstOffset = 0;
-        vertRegion.size = (uint64_t)vertCount * properties.positionStride;
+        vertRegion.size = (uint64_t)vertCount * VERTEX_POSITION_STRIDE;
 
         vkCmdCopyBuffer(
             cmd, 
             collectorDynamic[frameIndex]->GetVertexBuffer(), 
-            previousDynamicPositions.GetBuffer(),
+            previousDynamicPositions->GetBuffer(),
             1, &vertRegion);
     }
 
@@ -1006,7 +2131,7 @@ void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frame
         vkCmdCopyBuffer(
             cmd, 
             collectorDynamic[frameIndex]->GetIndexBuffer(), 
-            previousDynamicIndices.GetBuffer(),
+            previousDynamicIndices->GetBuffer(),
             1, &indexRegion);
     }
 }
@@ -1015,7 +2140,7 @@ void ASManager::OnVertexPreprocessingBegin(VkCommandBuffer cmd, uint32_t frameIn
 {
     if (!onlyDynamic)
     {
-        collectorStatic->InsertVertexPreprocessBeginBarrier(cmd);
+        curStatic.collector->InsertVertexPreprocessBeginBarrier(cmd);
     }
 
     collectorDynamic[frameIndex]->InsertVertexPreprocessBeginBarrier(cmd);
@@ -1025,7 +2150,7 @@ void ASManager::OnVertexPreprocessingFinish(VkCommandBuffer cmd, uint32_t frameI
 {
     if (!onlyDynamic)
     {
-        collectorStatic->InsertVertexPreprocessFinishBarrier(cmd);
+        curStatic.collector->InsertVertexPreprocessFinishBarrier(cmd);
     }
 
     collectorDynamic[frameIndex]->InsertVertexPreprocessFinishBarrier(cmd);
@@ -41,6 +41,18 @@ public:
     {
         VkAccelerationStructureInstanceKHR instances[45];
         uint32_t instanceCount;
+        // instances of single objects (mesh instances and static movable geometries)
+        // are stored in ASManager, as there can be a lot of them
+        uint32_t objectInstanceCount;
+    };
+
+    // Static geometry that was added by SubmitStaticGeometryEdits
+    struct AddedStaticGeometry
+    {
+        uint64_t uniqueID;
+        // UINT32_MAX, if geometry wasn't added
+        uint32_t simpleIndex;
+        bool isMovable;
     };
 
 public:
@@ -49,7 +61,10 @@ public:
               std::shared_ptr<CommandBufferManager> cmdManager,
               std::shared_ptr<TextureManager> textureManager,
               std::shared_ptr<GeomInfoManager> geomInfoManager,
-              const VertexBufferProperties &properties);
+              const VertexBufferProperties &properties,
+              uint32_t framesInFlight,
+              uint32_t dynamicRecordingContextCount,
+              uint32_t maxStaticClusterCount);
     ~ASManager();
 
     ASManager(const ASManager& other) = delete;
@@ -58,23 +73,69 @@ public:
     ASManager& operator=(ASManager&& other) noexcept = delete;
 
 
+    // Static geometry is collected to the pending static scene, the current one
+    // is used for rendering until the pending one is built and swapped with it.
     void BeginStaticGeometry();
     uint32_t AddStaticGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info);
-    // Submitting static geometry to the building is a heavy operation
-    // with waiting for it to complete.
+    // Start building the pending static scene on GPU, without waiting for it to complete.
     void SubmitStaticGeometry();
     // If all the added geometries must be removed, call this function before submitting
     void ResetStaticGeometry();
+    // If the pending static scene is built, compact its BLAS-es and make it current.
+    // The previous one is retired, as it can be in use by frames in flight.
+    // Should be called after BeginDynamicGeometry. Returns true, if the scenes were swapped.
+    bool TrySwapStaticScene(VkCommandBuffer cmd, uint32_t frameIndex);
+    bool IsStaticSceneSwapPending() const;
+    // Amount of memory that was freed by compacting BLAS-es of the current static scene
+    VkDeviceSize GetStaticCompactionSavedBytes() const;
+
+    // Edit already submitted static geometry. Geometry data is copied to the staging
+    // buffers immediately, but the changes are applied in SubmitStaticGeometryEdits,
+    // so only BLAS-es of the affected filters are rebuilt, without waiting for the device.
+    // Clusters of the affected filter are replaced with one BLAS until the next submission.
+    // Returns false, if there's no space for the geometry.
+    bool RecordStaticGeometry(const RgGeometryUploadInfo &info);
+    void CancelRecordedStaticGeometry(uint64_t uniqueID);
+    void RemoveStaticGeometry(uint32_t simpleIndex);
+    // Apply recorded additions and removals of static geometry.
+    // Should be called after BeginDynamicGeometry, as the frame with "frameIndex"
+    // is finished and the resources that were retired by it can be reused.
+    void SubmitStaticGeometryEdits(VkCommandBuffer cmd, uint32_t frameIndex, std::vector<AddedStaticGeometry> &outAdded);
 
     void BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex);
     uint32_t AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info);
+
+    // Batched versions of AddStaticGeometry / AddDynamicGeometry.
+    // UINT32_MAX is written to "outSimpleIndices" for geometries that weren't added.
+    void AddStaticGeometries(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos, uint32_t *outSimpleIndices);
+    void AddDynamicGeometries(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos, uint32_t *outSimpleIndices);
+    // Record dynamic geometry to the context. Can be called from several threads simultaneously,
+    // if each of them uses its own context. Recorded geometries are merged in SubmitDynamicGeometry.
+    // Returns false, if there's no space for the geometry.
+    bool RecordDynamicGeometry(uint32_t frameIndex, uint32_t contextIndex, const RgGeometryUploadInfo &info);
+    uint32_t GetDynamicRecordingContextCount() const;
+    // Reserve ranges for dynamic geometry, which data is written by the user
+    // directly to the staging buffers. "outMappedInfo" has data pointers to these ranges.
+    // Returns false, if there's no space for the geometry.
+    bool MapDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, RgGeometryUploadInfo &outMappedInfo);
+    bool IsDynamicGeometryMapped(uint64_t uniqueID) const;
+    // Add mapped geometry to the current frame, its data must be already written.
+    // Returns simple index, or UINT32_MAX if it wasn't added.
+    uint32_t CommitMappedDynamicGeometry(uint32_t frameIndex, uint64_t uniqueID, RgGeometryUploadInfo &outMappedInfo);
     void SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex);
 
 
-    // Update transform for static movable geometry
+    // Add mesh to the pending static scene, its BLAS is built in SubmitStaticGeometry.
+    // Returns mesh index, or UINT32_MAX if there's no space.
+    uint32_t AddMesh(const RgMeshCreateInfo &info);
+    uint32_t GetMeshCount() const;
+    // Add instance of a mesh to the current frame. Returns false, if there's no space.
+    bool AddMeshInstance(uint32_t frameIndex, uint32_t meshIndex, const RgMeshInstanceUploadInfo &info);
+
+
+    // Update transform for static movable geometry. Each movable geometry
+    // has its own TLAS instance, so only that instance is changed, BLAS is not rebuilt.
     void UpdateStaticMovableTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo);
-    // After updating transforms, acceleration structures should be rebuilt
-    void ResubmitStaticMovable(VkCommandBuffer cmd);
 
     // Update texture coordinates for static geometry, it 
     // doesn't require AS rebuilding, but only copying from staging to device-local 
@@ -88,7 +149,7 @@ public:
         uint32_t frameIndex,
         ShGlobalUniform &uniformData,
         ShVertPreprocessing *outPush,
-        TLASPrepareResult *outResult) const;
+        TLASPrepareResult *outResult);
     bool TryBuildTLAS(
         VkCommandBuffer cmd, uint32_t frameIndex, 
         const TLASPrepareResult &info);
@@ -116,31 +177,144 @@ private:
 
     bool SetupBLAS(
         BLASComponent &as,
-        const std::shared_ptr<VertexCollector> &vertCollector);
-
-    void UpdateBLAS(
-        BLASComponent &as,
-        const std::shared_ptr<VertexCollector> &vertCollector);
+        const std::shared_ptr<VertexCollector> &vertCollector,
+        bool allowCompaction);
 
     static bool SetupTLASInstanceFromBLAS(
         const BLASComponent &as,
         uint32_t rayCullMaskWorld,
         VkAccelerationStructureInstanceKHR &instance);
+    // Set mask, flags, SBT offset and custom index flags by filter.
+    // Returns false, if instance is culled by "rayCullMaskWorld".
+    static bool SetupTLASInstanceFlags(
+        VertexCollectorFilterTypeFlags filter,
+        uint32_t rayCullMaskWorld,
+        VkAccelerationStructureInstanceKHR &instance);
 
     static bool IsFastBuild(VertexCollectorFilterTypeFlags filter);
 
+    // Fill "batchMaterials" with material textures of each layer of each geometry
+    void GetBatchMaterials(uint32_t count, const RgGeometryUploadInfo *pInfos);
+
+    // Add geometries from all recording contexts to the dynamic vertex collector
+    void MergeDynamicRecordingContexts(uint32_t frameIndex);
+
+    void SetupMeshBLAS(BLASComponent &blas, const MeshGeometry &mesh);
+
+    struct StaticScene;
+
+    // Split static geometries of the filter into spatially compact clusters, each with its own BLAS.
+    // Returns false, if clustering is disabled or geometries weren't split.
+    bool SetupStaticClusters(StaticScene &scene, VertexCollectorFilterTypeFlags filter);
+    // Move BLAS-es of the filter's clusters of the current static scene to the retired list of the frame
+    void RemoveStaticClusters(uint32_t frameIndex, VertexCollectorFilterTypeFlags filter);
+
+    // Register static movable geometry that was added to the collector of the scene
+    void AddMovableGeometry(StaticScene &scene, uint32_t simpleIndex, VertexCollectorFilterTypeFlags filter, const RgTransform &transform);
+    // Move BLAS of the movable geometry to the retired list of the frame
+    void RemoveMovableGeometry(uint32_t frameIndex, uint32_t simpleIndex);
+    void SetupMovableBLAS(BLASComponent &blas, const VertexCollector &collector, VertexCollectorFilterTypeFlags filter, uint32_t localGeomIndex, bool allowCompaction);
+    // Destroy data of the pending static scene, it must not be in use
+    void ResetPendingStaticScene();
+    // Write compacted sizes of "pendingBlasToCompact" to the query pool
+    void WriteStaticCompactedSizes(VkCommandBuffer cmd);
+    // Replace BLAS-es of the pending static scene with their compacted copies,
+    // the building must be finished
+    void CompactPendingStaticBLAS(VkCommandBuffer cmd, uint32_t frameIndex);
+    // Get TLAS instance count of mesh instances and movable geometries
+    static uint32_t GetMaxObjectInstanceCount();
+    void InitPreviousDynamicBuffers(uint32_t vertexCapacity, uint32_t indexCapacity);
+    // Grow staging buffers of all dynamic collectors, if dynamic geometries didn't fit
+    // in the previous frames, and the buffers for the previous frame's data
+    void GrowDynamicBuffers(uint32_t frameIndex);
+    // Recreate the shared device local buffers of the dynamic collectors to match their staging buffers
+    void ResizeDynamicDeviceBuffers();
+
+private:
+    struct Mesh
+    {
+        std::unique_ptr<BLASComponent> blas;
+        MeshGeometry geom;
+    };
+
+    struct MeshInstance
+    {
+        uint32_t meshIndex;
+        uint32_t globalGeomIndex;
+        VertexCollectorFilterTypeFlags filter;
+        RgTransform transform;
+    };
+
+    // Static movable geometry with its own BLAS, its vertices
+    // are in the static collector and transform is set in TLAS instance
+    struct MovableGeometry
+    {
+        std::unique_ptr<BLASComponent> blas;
+        VertexCollectorFilterTypeFlags filter;
+        uint32_t simpleIndex;
+        uint32_t localGeomIndex;
+        uint32_t globalGeomIndex;
+        RgTransform transform;
+    };
+
+    // Spatially compact part of static geometries of a filter. Its BLAS contains
+    // the filter's geometries in [firstLocalGeomIndex, firstLocalGeomIndex + ranges.size()),
+    // so geometry index in the BLAS maps to the global one as in the filter's BLAS;
+    // geometries that are not in the cluster are empty.
+    struct StaticCluster
+    {
+        std::unique_ptr<BLASComponent> blas;
+        VertexCollectorFilterTypeFlags filter;
+        uint32_t firstLocalGeomIndex;
+        std::vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
+        std::vector<uint32_t> primCounts;
+    };
+
+    // Static geometry with its vertex data, BLAS-es and meshes
+    struct StaticScene
+    {
+        std::shared_ptr<VertexCollector> collector;
+        // BLAS for each filter, it's empty if the filter is split into clusters
+        std::vector<std::unique_ptr<BLASComponent>> blas;
+        // clusters of the same filter are adjacent
+        std::vector<StaticCluster> clusters;
+        std::vector<Mesh> meshes;
+        std::vector<MovableGeometry> movableGeoms;
+        std::map<uint32_t, uint32_t> simpleIndexToMovable;
+    };
+
 private:
     VkDevice device;
     std::shared_ptr<MemoryAllocator> allocator;
 
     VkFence staticCopyFence;
+    // pending static scene was submitted and it's waiting to be swapped
+    bool isStaticSwapPending;
+    // GPU building of the pending static scene was submitted with "staticCopyFence"
+    bool isStaticBuildSubmitted;
+
+    // static scene that is used for rendering, and the one that is being collected or built;
+    // they have separate device-local buffers, so the current one can be used while building
+    StaticScene curStatic;
+    StaticScene pendingStatic;
+    // buffer descriptor sets of frames that weren't updated after
+    // the static scene swap or after the dynamic buffers were grown
+    bool buffersDescDirty[MAX_FRAMES_IN_FLIGHT];
+
+    // compacted sizes of "pendingBlasToCompact" are written to the query pool
+    // in the static scene building, and compacted copies are created on the swap
+    VkQueryPool compactionQueryPool;
+    uint32_t compactionQueryPoolSize;
+    std::vector<std::unique_ptr<BLASComponent> *> pendingBlasToCompact;
+    VkDeviceSize staticCompactionSavedBytes;
 
     // for filling buffers
-    std::shared_ptr<VertexCollector> collectorStatic;
     std::shared_ptr<VertexCollector> collectorDynamic[MAX_FRAMES_IN_FLIGHT];
     // device-local buffer for storing previous info
-    Buffer previousDynamicPositions;
-    Buffer previousDynamicIndices;
+    std::shared_ptr<Buffer> previousDynamicPositions;
+    std::shared_ptr<Buffer> previousDynamicIndices;
+    uint32_t previousDynamicVertexCapacity;
+    uint32_t previousDynamicIndexCapacity;
 
     // building
     std::shared_ptr<ScratchBuffer> scratchBuffer;
@@ -150,9 +324,22 @@ private:
     std::shared_ptr<TextureManager> textureMgr;
     std::shared_ptr<GeomInfoManager> geomInfoMgr;
 
-    std::vector<std::unique_ptr<BLASComponent>> allStaticBlas;
     std::vector<std::unique_ptr<BLASComponent>> allDynamicBlas[MAX_FRAMES_IN_FLIGHT];
 
+    std::vector<MeshInstance> meshInstances[MAX_FRAMES_IN_FLIGHT];
+
+    // static geometries that are added or removed on the next frame start
+    std::vector<RecordedStaticGeometry> recordedStaticGeoms;
+    std::vector<uint32_t> staticGeomsToRemove;
+    // BLAS-es that were replaced by static geometry edits or by the static scene swap,
+    // they're destroyed when the frame that replaced them is finished
+    std::vector<std::unique_ptr<BLASComponent>> retiredStaticBlas[MAX_FRAMES_IN_FLIGHT];
+    // vertex and index buffers that were replaced by the grown ones
+    std::vector<std::shared_ptr<Buffer>> retiredBuffers[MAX_FRAMES_IN_FLIGHT];
+
+    // TLAS instances of mesh instances and movable geometries
+    std::vector<VkAccelerationStructureInstanceKHR> objectTLASInstances;
+
     // top level AS
     std::unique_ptr<AutoBuffer> instanceBuffer;
     std::unique_ptr<TLASComponent> tlas[MAX_FRAMES_IN_FLIGHT];
@@ -167,6 +354,22 @@ private:
     VkDescriptorSet asDescSets[MAX_FRAMES_IN_FLIGHT];
 
     VertexBufferProperties properties;
+    uint32_t framesInFlight;
+
+    // if >1, static geometries are split into clusters
+    uint32_t maxStaticClusterCount;
+    GeometryClusterizer staticClusterizer;
+    // temporary storage for clustering
+    std::vector<GeometryBounds> clusterBounds;
+    std::vector<std::vector<uint32_t>> clusterIndices;
+
+    // temporary storage for batched geometry upload
+    std::vector<MaterialTextures> batchMaterials;
+
+    // separate allocations, so contexts don't share cache lines
+    std::vector<std::unique_ptr<DynamicRecordingContext>> dynamicRecordingContexts;
+    // dynamic geometries that are mapped, but not committed yet
+    std::map<uint64_t, MappedDynamicGeometry> mappedDynamicGeometries;
 };
 
 }
\ No newline at end of file
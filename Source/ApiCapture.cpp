@@ -0,0 +1,432 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ApiCapture.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "RgException.h"
+
+using namespace RTGL1;
+
+// Byte count that the library reads from a strided array of "count" elements
+static uint64_t GetStridedArraySize(uint32_t count, uint32_t stride)
+{
+    return (uint64_t)count * stride;
+}
+
+// Byte count, if elements of the array are read one by one
+static uint64_t GetStridedArraySize(uint32_t count, uint32_t stride, uint32_t elementSize)
+{
+    return count > 0 ? (uint64_t)(count - 1) * stride + elementSize : 0;
+}
+
+static uint64_t GetTextureDataSize(const RgExtent2D &size)
+{
+    return (uint64_t)size.width * size.height * 4;
+}
+
+ApiCapture::ApiCapture(const char *pFilePath) :
+    file(nullptr),
+    positionStride(0),
+    normalStride(0),
+    texCoordStride(0)
+{
+    file = fopen(pFilePath, "wb");
+
+    if (file == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, std::string("Can't open API capture file: ") + pFilePath);
+    }
+
+    ApiCaptureFileHeader header = {};
+    header.magic = API_CAPTURE_MAGIC;
+    header.version = API_CAPTURE_VERSION;
+    header.pointerSize = sizeof(void *);
+    header.geometryUploadInfoSize = sizeof(RgGeometryUploadInfo);
+    header.drawFrameInfoSize = sizeof(RgDrawFrameInfo);
+
+    fwrite(&header, sizeof(header), 1, file);
+}
+
+ApiCapture::~ApiCapture()
+{
+    fclose(file);
+}
+
+std::unique_lock<std::mutex> ApiCapture::BeginRecord(ApiCallType call)
+{
+    // released when the caller's scope is left, even if an exception was thrown
+    std::unique_lock<std::mutex> lock(recordMutex);
+
+    record.clear();
+
+    ApiCaptureRecordHeader header = {};
+    header.call = call;
+
+    WriteStruct(header);
+
+    return lock;
+}
+
+void ApiCapture::EndRecord()
+{
+    assert(record.size() >= sizeof(ApiCaptureRecordHeader));
+
+    auto *pHeader = reinterpret_cast<ApiCaptureRecordHeader *>(record.data());
+    pHeader->payloadSize = record.size() - sizeof(ApiCaptureRecordHeader);
+
+    fwrite(record.data(), 1, record.size(), file);
+}
+
+void ApiCapture::WriteRaw(const void *pData, uint64_t size)
+{
+    const uint64_t alignedSize = (size + API_CAPTURE_ALIGNMENT - 1) & ~(API_CAPTURE_ALIGNMENT - 1);
+
+    const size_t offset = record.size();
+    record.resize(offset + alignedSize, 0);
+
+    if (size > 0)
+    {
+        memcpy(record.data() + offset, pData, size);
+    }
+}
+
+void ApiCapture::WriteArray(const void *pData, uint64_t size)
+{
+    const uint64_t byteCount = pData != nullptr ? size : API_CAPTURE_NULL_ARRAY;
+    WriteRaw(&byteCount, sizeof(byteCount));
+
+    if (pData != nullptr)
+    {
+        WriteRaw(pData, size);
+    }
+}
+
+void ApiCapture::WriteString(const char *pStr)
+{
+    WriteArray(pStr, pStr != nullptr ? strlen(pStr) + 1 : 0);
+}
+
+void ApiCapture::WriteTextureSet(const RgTextureSet &textures, const RgExtent2D &size)
+{
+    const uint64_t dataSize = GetTextureDataSize(size);
+
+    WriteArray(textures.albedoAlpha.pData, dataSize);
+    WriteArray(textures.roughnessMetallicEmission.pData, dataSize);
+    WriteArray(textures.normal.pData, dataSize);
+}
+
+void ApiCapture::WriteStaticMaterialPayload(const RgStaticMaterialCreateInfo &info)
+{
+    WriteStruct(info);
+    WriteTextureSet(info.textures, info.size);
+    WriteString(info.pRelativePath);
+}
+
+void ApiCapture::CreateInstance(const RgInstanceCreateInfo &info)
+{
+    positionStride = info.vertexPositionStride;
+    normalStride = info.vertexNormalStride;
+    texCoordStride = info.vertexTexCoordStride;
+
+    auto lock = BeginRecord(ApiCallType::CreateInstance);
+    WriteStruct(info);
+    WriteString(info.pName);
+    WriteString(info.pShaderFolderPath);
+    WriteString(info.pBlueNoiseFilePath);
+    WriteString(info.pOverridenTexturesFolderPath);
+    WriteString(info.pOverridenAlbedoAlphaTexturePostfix);
+    WriteString(info.pOverridenRoughnessMetallicEmissionTexturePostfix);
+    WriteString(info.pOverridenNormalTexturePostfix);
+    WriteString(info.pWaterNormalTexturePath);
+    EndRecord();
+}
+
+void ApiCapture::DestroyInstance()
+{
+    auto lock = BeginRecord(ApiCallType::DestroyInstance);
+    EndRecord();
+
+    fflush(file);
+}
+
+void ApiCapture::WriteGeometryPayload(const RgGeometryUploadInfo &info)
+{
+    // dynamic geometry uses only the first layer
+    const uint32_t texCoordLayerCount = info.geomType == RG_GEOMETRY_TYPE_DYNAMIC ? 1 : 3;
+
+    WriteStruct(info);
+    WriteArray(info.pVertexData, GetStridedArraySize(info.vertexCount, positionStride));
+    WriteArray(info.pNormalData, GetStridedArraySize(info.vertexCount, normalStride));
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        WriteArray(i < texCoordLayerCount ? info.pTexCoordLayerData[i] : nullptr,
+                   GetStridedArraySize(info.vertexCount, texCoordStride));
+    }
+
+    WriteArray(info.pIndexData, (uint64_t)info.indexCount * sizeof(uint32_t));
+}
+
+void ApiCapture::UploadGeometry(const RgGeometryUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UploadGeometry);
+    WriteGeometryPayload(info);
+    EndRecord();
+}
+
+void ApiCapture::UploadGeometries(uint32_t count, const RgGeometryUploadInfo *pInfos)
+{
+    auto lock = BeginRecord(ApiCallType::UploadGeometries);
+    WriteStruct(count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        WriteGeometryPayload(pInfos[i]);
+    }
+
+    EndRecord();
+}
+
+void ApiCapture::UpdateGeometryTransform(const RgUpdateTransformInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UpdateGeometryTransform);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UpdateGeometryTexCoords);
+    WriteStruct(info);
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        WriteArray(info.pTexCoordLayerData[i], GetStridedArraySize(info.vertexCount, texCoordStride));
+    }
+
+    EndRecord();
+}
+
+void ApiCapture::CreateMesh(const RgMeshCreateInfo &info, RgMesh result)
+{
+    auto lock = BeginRecord(ApiCallType::CreateMesh);
+    WriteStruct(result);
+    WriteStruct(info);
+    WriteArray(info.pVertexData, GetStridedArraySize(info.vertexCount, positionStride));
+    WriteArray(info.pNormalData, GetStridedArraySize(info.vertexCount, normalStride));
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        WriteArray(info.pTexCoordLayerData[i], GetStridedArraySize(info.vertexCount, texCoordStride));
+    }
+
+    WriteArray(info.pIndexData, (uint64_t)info.indexCount * sizeof(uint32_t));
+    EndRecord();
+}
+
+void ApiCapture::UploadMeshInstance(const RgMeshInstanceUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UploadMeshInstance);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::AddStaticGeometry(const RgGeometryUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::AddStaticGeometry);
+    WriteGeometryPayload(info);
+    EndRecord();
+}
+
+void ApiCapture::RemoveStaticGeometry(uint64_t uniqueID)
+{
+    auto lock = BeginRecord(ApiCallType::RemoveStaticGeometry);
+    WriteStruct(uniqueID);
+    EndRecord();
+}
+
+void ApiCapture::UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo &info, const float *pViewProjection, const RgViewport *pViewport)
+{
+    auto lock = BeginRecord(ApiCallType::UploadRasterizedGeometry);
+    WriteStruct(info);
+
+    WriteOptionalStruct(info.pArrays);
+    if (info.pArrays != nullptr)
+    {
+        const RgRasterizedGeometryVertexArrays &arrs = *info.pArrays;
+
+        WriteArray(arrs.pVertexData, GetStridedArraySize(info.vertexCount, arrs.vertexStride, 3 * sizeof(float)));
+        WriteArray(arrs.pTexCoordData, GetStridedArraySize(info.vertexCount, arrs.texCoordStride, 2 * sizeof(float)));
+        WriteArray(arrs.pColorData, GetStridedArraySize(info.vertexCount, arrs.colorStride, sizeof(uint32_t)));
+    }
+
+    WriteArray(info.pStructs, (uint64_t)info.vertexCount * sizeof(RgRasterizedGeometryVertexStruct));
+    WriteArray(info.pIndexData, (uint64_t)info.indexCount * sizeof(uint32_t));
+
+    WriteArray(pViewProjection, 16 * sizeof(float));
+    WriteOptionalStruct(pViewport);
+    EndRecord();
+}
+
+void ApiCapture::SubmitStaticGeometries()
+{
+    auto lock = BeginRecord(ApiCallType::SubmitStaticGeometries);
+    EndRecord();
+}
+
+void ApiCapture::StartNewScene()
+{
+    auto lock = BeginRecord(ApiCallType::StartNewScene);
+    EndRecord();
+}
+
+void ApiCapture::UploadLight(const RgDirectionalLightUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UploadDirectionalLight);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::UploadLight(const RgSphericalLightUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UploadSphericalLight);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::UploadLight(const RgSpotlightUploadInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::UploadSpotlightLight);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::CreateStaticMaterial(const RgStaticMaterialCreateInfo &info, RgMaterial result)
+{
+    auto lock = BeginRecord(ApiCallType::CreateStaticMaterial);
+    WriteStruct(result);
+    WriteStaticMaterialPayload(info);
+    EndRecord();
+}
+
+void ApiCapture::CreateAnimatedMaterial(const RgAnimatedMaterialCreateInfo &info, RgMaterial result)
+{
+    auto lock = BeginRecord(ApiCallType::CreateAnimatedMaterial);
+    WriteStruct(result);
+    WriteStruct(info);
+
+    for (uint32_t i = 0; i < info.frameCount; i++)
+    {
+        WriteStaticMaterialPayload(info.pFrames[i]);
+    }
+
+    EndRecord();
+}
+
+void ApiCapture::ChangeAnimatedMaterialFrame(RgMaterial animatedMaterial, uint32_t frameIndex)
+{
+    auto lock = BeginRecord(ApiCallType::ChangeAnimatedMaterialFrame);
+    WriteStruct(animatedMaterial);
+    WriteStruct(frameIndex);
+    EndRecord();
+}
+
+void ApiCapture::CreateDynamicMaterial(const RgDynamicMaterialCreateInfo &info, RgMaterial result)
+{
+    dynamicMaterialSizes[result] = info.size;
+
+    auto lock = BeginRecord(ApiCallType::CreateDynamicMaterial);
+    WriteStruct(result);
+    WriteStruct(info);
+    WriteTextureSet(info.textures, info.size);
+    EndRecord();
+}
+
+void ApiCapture::UpdateDynamicMaterial(const RgDynamicMaterialUpdateInfo &info)
+{
+    auto it = dynamicMaterialSizes.find(info.dynamicMaterial);
+    const RgExtent2D size = it != dynamicMaterialSizes.end() ? it->second : RgExtent2D{ 0, 0 };
+
+    auto lock = BeginRecord(ApiCallType::UpdateDynamicMaterial);
+    WriteStruct(info);
+    WriteTextureSet(info.textures, size);
+    EndRecord();
+}
+
+void ApiCapture::DestroyMaterial(RgMaterial material)
+{
+    dynamicMaterialSizes.erase(material);
+
+    auto lock = BeginRecord(ApiCallType::DestroyMaterial);
+    WriteStruct(material);
+    EndRecord();
+}
+
+void ApiCapture::CreateCubemap(const RgCubemapCreateInfo &info, RgCubemap result)
+{
+    const uint64_t faceSize = GetTextureDataSize({ info.sideSize, info.sideSize });
+
+    auto lock = BeginRecord(ApiCallType::CreateCubemap);
+    WriteStruct(result);
+    WriteStruct(info);
+
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        WriteArray(info.pData[i], faceSize);
+    }
+
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        WriteString(info.pRelativePaths[i]);
+    }
+
+    EndRecord();
+}
+
+void ApiCapture::DestroyCubemap(RgCubemap cubemap)
+{
+    auto lock = BeginRecord(ApiCallType::DestroyCubemap);
+    WriteStruct(cubemap);
+    EndRecord();
+}
+
+void ApiCapture::StartFrame(const RgStartFrameInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::StartFrame);
+    WriteStruct(info);
+    EndRecord();
+}
+
+void ApiCapture::DrawFrame(const RgDrawFrameInfo &info)
+{
+    auto lock = BeginRecord(ApiCallType::DrawFrame);
+    WriteStruct(info);
+    WriteOptionalStruct(info.pShadowParams);
+    WriteOptionalStruct(info.pTonemappingParams);
+    WriteOptionalStruct(info.pBloomParams);
+    WriteOptionalStruct(info.pReflectRefractParams);
+    WriteOptionalStruct(info.pSkyParams);
+    WriteOptionalStruct(info.pOverridenTexturesParams);
+    WriteOptionalStruct(info.pDebugParams);
+    EndRecord();
+}
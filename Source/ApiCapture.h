@@ -0,0 +1,185 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RTGL1/RTGL1.h"
+
+namespace RTGL1
+{
+
+// Capture stream format.
+// File begins with ApiCaptureFileHeader, then a sequence of records follows.
+// Each record is ApiCaptureRecordHeader and a payload of "payloadSize" bytes.
+// Payload consists of chunks, each chunk is padded to API_CAPTURE_ALIGNMENT:
+//  - struct chunk: raw bytes of an API struct, pointer members are not valid
+//  - array chunk:  uint64_t byte count and the data, byte count is
+//                  API_CAPTURE_NULL_ARRAY if the pointer was null
+// Arrays are written in the same order as pointer members are declared
+// in the struct. Raw structs are used, so captured file can be replayed
+// only by the library that has the same public header (see API_CAPTURE_VERSION)
+// on a platform with the same ABI.
+
+constexpr uint32_t API_CAPTURE_MAGIC = 0x43544752; // "RGTC"
+constexpr uint32_t API_CAPTURE_VERSION = 1;
+constexpr uint64_t API_CAPTURE_ALIGNMENT = 8;
+constexpr uint64_t API_CAPTURE_NULL_ARRAY = UINT64_MAX;
+
+enum class ApiCallType : uint32_t
+{
+    CreateInstance,
+    DestroyInstance,
+    UploadGeometry,
+    UpdateGeometryTransform,
+    UpdateGeometryTexCoords,
+    UploadRasterizedGeometry,
+    SubmitStaticGeometries,
+    StartNewScene,
+    UploadDirectionalLight,
+    UploadSphericalLight,
+    UploadSpotlightLight,
+    CreateStaticMaterial,
+    CreateAnimatedMaterial,
+    ChangeAnimatedMaterialFrame,
+    CreateDynamicMaterial,
+    UpdateDynamicMaterial,
+    DestroyMaterial,
+    CreateCubemap,
+    DestroyCubemap,
+    StartFrame,
+    DrawFrame,
+    UploadGeometries,
+    CreateMesh,
+    UploadMeshInstance,
+    AddStaticGeometry,
+    RemoveStaticGeometry,
+};
+
+struct ApiCaptureFileHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    // Sizes of pointer and of some API structs to detect ABI mismatch.
+    uint32_t    pointerSize;
+    uint32_t    geometryUploadInfoSize;
+    uint32_t    drawFrameInfoSize;
+    uint32_t    reserved;
+};
+
+struct ApiCaptureRecordHeader
+{
+    ApiCallType call;
+    uint32_t    reserved;
+    uint64_t    payloadSize;
+};
+
+// Writes every successful API call with its payload into a file.
+// Calls must be registered after their execution, so
+// the out parameters (e.g. created material) are known.
+// Records can be written from several threads, as dynamic geometry
+// can be recorded from them (see rgRecordDynamicGeometry).
+class ApiCapture
+{
+public:
+    explicit ApiCapture(const char *pFilePath);
+    ~ApiCapture();
+
+    ApiCapture(const ApiCapture &other) = delete;
+    ApiCapture(ApiCapture &&other) noexcept = delete;
+    ApiCapture &operator=(const ApiCapture &other) = delete;
+    ApiCapture &operator=(ApiCapture &&other) noexcept = delete;
+
+    void CreateInstance(const RgInstanceCreateInfo &info);
+    void DestroyInstance();
+
+    void UploadGeometry(const RgGeometryUploadInfo &info);
+    void UploadGeometries(uint32_t count, const RgGeometryUploadInfo *pInfos);
+    void UpdateGeometryTransform(const RgUpdateTransformInfo &info);
+    void UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo &info);
+    void CreateMesh(const RgMeshCreateInfo &info, RgMesh result);
+    void UploadMeshInstance(const RgMeshInstanceUploadInfo &info);
+    void AddStaticGeometry(const RgGeometryUploadInfo &info);
+    void RemoveStaticGeometry(uint64_t uniqueID);
+    void UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo &info, const float *pViewProjection, const RgViewport *pViewport);
+    void SubmitStaticGeometries();
+    void StartNewScene();
+
+    void UploadLight(const RgDirectionalLightUploadInfo &info);
+    void UploadLight(const RgSphericalLightUploadInfo &info);
+    void UploadLight(const RgSpotlightUploadInfo &info);
+
+    void CreateStaticMaterial(const RgStaticMaterialCreateInfo &info, RgMaterial result);
+    void CreateAnimatedMaterial(const RgAnimatedMaterialCreateInfo &info, RgMaterial result);
+    void ChangeAnimatedMaterialFrame(RgMaterial animatedMaterial, uint32_t frameIndex);
+    void CreateDynamicMaterial(const RgDynamicMaterialCreateInfo &info, RgMaterial result);
+    void UpdateDynamicMaterial(const RgDynamicMaterialUpdateInfo &info);
+    void DestroyMaterial(RgMaterial material);
+
+    void CreateCubemap(const RgCubemapCreateInfo &info, RgCubemap result);
+    void DestroyCubemap(RgCubemap cubemap);
+
+    void StartFrame(const RgStartFrameInfo &info);
+    void DrawFrame(const RgDrawFrameInfo &info);
+
+private:
+    // The returned lock must be held until EndRecord is called.
+    std::unique_lock<std::mutex> BeginRecord(ApiCallType call);
+    void EndRecord();
+
+    void WriteRaw(const void *pData, uint64_t size);
+    void WriteArray(const void *pData, uint64_t size);
+    void WriteString(const char *pStr);
+    template <typename T>
+    void WriteStruct(const T &s)
+    {
+        WriteRaw(&s, sizeof(T));
+    }
+    template <typename T>
+    void WriteOptionalStruct(const T *pS)
+    {
+        WriteArray(pS, sizeof(T));
+    }
+
+    void WriteTextureSet(const RgTextureSet &textures, const RgExtent2D &size);
+    void WriteStaticMaterialPayload(const RgStaticMaterialCreateInfo &info);
+    void WriteGeometryPayload(const RgGeometryUploadInfo &info);
+
+private:
+    FILE *file;
+    std::vector<uint8_t> record;
+    // locked while "record" is being filled and written
+    std::mutex recordMutex;
+
+    // vertex strides are needed to know the sizes of vertex arrays
+    uint32_t positionStride;
+    uint32_t normalStride;
+    uint32_t texCoordStride;
+
+    // dynamic material update info doesn't have the size of the textures
+    std::unordered_map<RgMaterial, RgExtent2D> dynamicMaterialSizes;
+};
+
+}
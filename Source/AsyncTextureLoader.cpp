@@ -0,0 +1,157 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AsyncTextureLoader.h"
+
+#include <algorithm>
+
+using namespace RTGL1;
+
+AsyncTextureLoader::AsyncTextureLoader(
+    std::shared_ptr<UserFileLoad> _userFileLoad,
+    std::shared_ptr<TextureDecoder> _decoder,
+    uint32_t _threadCount,
+    const TextureOverrides::OverrideInfo &_overrideInfo)
+:
+    userFileLoad(std::move(_userFileLoad)),
+    decoder(std::move(_decoder)),
+    overrideInfo(_overrideInfo),
+    stop(false)
+{
+    assert(_threadCount > 0);
+
+    texturesPath = _overrideInfo.texturesPath != nullptr ? _overrideInfo.texturesPath : "";
+    overrideInfo.texturesPath = texturesPath.c_str();
+
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+    {
+        postfixes[i] = _overrideInfo.postfixes[i] != nullptr ? _overrideInfo.postfixes[i] : "";
+        overrideInfo.postfixes[i] = postfixes[i].c_str();
+    }
+
+    for (uint32_t i = 0; i < _threadCount; i++)
+    {
+        workers.emplace_back(&AsyncTextureLoader::WorkerLoop, this);
+    }
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stop = true;
+    }
+    queueCondition.notify_all();
+
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+}
+
+void AsyncTextureLoader::Push(std::unique_ptr<Request> request)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(request));
+    }
+    queueCondition.notify_one();
+}
+
+void AsyncTextureLoader::Cancel(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [id] (const std::unique_ptr<Request> &r)
+    {
+        return r->id == id;
+    }), queue.end());
+}
+
+void AsyncTextureLoader::TakeFinished(std::vector<Result> &outResults)
+{
+    std::lock_guard<std::mutex> lock(finishedMutex);
+
+    for (auto &r : finished)
+    {
+        outResults.push_back(std::move(r));
+    }
+    finished.clear();
+}
+
+void AsyncTextureLoader::WorkerLoop()
+{
+    while (true)
+    {
+        std::unique_ptr<Request> request;
+
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stop || !queue.empty(); });
+
+            // pending requests are dropped on destruction
+            if (stop)
+            {
+                return;
+            }
+
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        Result result = Load(std::move(request));
+
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            finished.push_back(std::move(result));
+        }
+    }
+}
+
+AsyncTextureLoader::Result AsyncTextureLoader::Load(std::unique_ptr<Request> request) const
+{
+    Result result = {};
+    result.id = request->id;
+    // image loader is not thread-safe, so each request has its own;
+    // the decoder is shared, as it's thread-safe
+    result.imageLoader = std::make_shared<ImageLoader>(userFileLoad, decoder);
+
+    RgTextureSet defaultTextures = {};
+    RgTextureData *tds[TEXTURES_PER_MATERIAL_COUNT] =
+    {
+        &defaultTextures.albedoAlpha,
+        &defaultTextures.roughnessMetallicEmission,
+        &defaultTextures.normal,
+    };
+
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+    {
+        tds[i]->pData = !request->defaultData[i].empty() ? request->defaultData[i].data() : nullptr;
+        tds[i]->isSRGB = request->defaultIsSRGB[i];
+    }
+
+    result.overrides = std::make_unique<TextureOverrides>(
+        request->relativePath.c_str(), defaultTextures, request->defaultSize, overrideInfo, result.imageLoader);
+
+    // results point to the default data, so keep it
+    result.request = std::move(request);
+
+    return result;
+}
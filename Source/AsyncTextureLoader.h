@@ -0,0 +1,107 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+#include "ImageLoader.h"
+#include "TextureOverrides.h"
+
+namespace RTGL1
+{
+
+// Reads and parses texture files of static materials on worker threads.
+// Uploading is done by TextureManager on the main thread, so the loaded
+// data is kept in the result until it's taken and destroyed.
+class AsyncTextureLoader
+{
+public:
+    struct Request
+    {
+        uint64_t                id;
+        std::string             relativePath;
+        // copies of the user's data, they're used if a file is not found
+        std::vector<uint8_t>    defaultData[TEXTURES_PER_MATERIAL_COUNT];
+        bool                    defaultIsSRGB[TEXTURES_PER_MATERIAL_COUNT];
+        RgExtent2D              defaultSize;
+    };
+
+    struct Result
+    {
+        uint64_t                            id;
+        // destruction order is important: overrides free
+        // the loaded data using the image loader
+        std::shared_ptr<ImageLoader>        imageLoader;
+        std::unique_ptr<Request>            request;
+        std::unique_ptr<TextureOverrides>   overrides;
+    };
+
+public:
+    explicit AsyncTextureLoader(
+        std::shared_ptr<UserFileLoad> userFileLoad,
+        std::shared_ptr<TextureDecoder> decoder,
+        uint32_t threadCount,
+        const TextureOverrides::OverrideInfo &overrideInfo);
+    ~AsyncTextureLoader();
+
+    AsyncTextureLoader(const AsyncTextureLoader &other) = delete;
+    AsyncTextureLoader(AsyncTextureLoader &&other) noexcept = delete;
+    AsyncTextureLoader &operator=(const AsyncTextureLoader &other) = delete;
+    AsyncTextureLoader &operator=(AsyncTextureLoader &&other) noexcept = delete;
+
+    void Push(std::unique_ptr<Request> request);
+    // Remove the request, if it wasn't started yet.
+    // If it was, its result will still be returned by TakeFinished.
+    void Cancel(uint64_t id);
+    // Move the results that were finished since the last call to outResults.
+    void TakeFinished(std::vector<Result> &outResults);
+
+private:
+    void WorkerLoop();
+    Result Load(std::unique_ptr<Request> request) const;
+
+private:
+    std::shared_ptr<UserFileLoad> userFileLoad;
+    std::shared_ptr<TextureDecoder> decoder;
+
+    // OverrideInfo contains pointers, so the strings are stored here
+    std::string texturesPath;
+    std::string postfixes[TEXTURES_PER_MATERIAL_COUNT];
+    TextureOverrides::OverrideInfo overrideInfo;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<std::unique_ptr<Request>> queue;
+    bool stop;
+
+    std::mutex finishedMutex;
+    std::vector<Result> finished;
+
+    std::vector<std::thread> workers;
+};
+
+}
@@ -28,6 +28,8 @@ RTGL1::AutoBuffer::AutoBuffer(
 :
     device(_device),
     allocator(std::move(_allocator)),
+    frameCount(0),
+    isDirect(false),
     mapped{},
     debugNameStaging(_debugNameStaging),
     debugName(_debugName)
@@ -38,9 +40,29 @@ RTGL1::AutoBuffer::~AutoBuffer()
     Destroy();
 }
 
-void RTGL1::AutoBuffer::Create(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t frameCount)
+void RTGL1::AutoBuffer::Create(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t _frameCount, bool allowDirectWrite)
 {
-    assert(frameCount <= MAX_FRAMES_IN_FLIGHT);
+    assert(_frameCount > 0 && _frameCount <= MAX_FRAMES_IN_FLIGHT);
+    frameCount = _frameCount;
+    isDirect = allowDirectWrite && allocator->IsDirectWriteAvailable();
+
+    if (isDirect)
+    {
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            assert(!staging[i].IsInitted());
+
+            staging[i].Init(
+                allocator, size,
+                usage,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                debugName);
+
+            mapped[i] = staging[i].Map();
+        }
+
+        return;
+    }
 
     for (uint32_t i = 0; i < frameCount; i++)
     {
@@ -85,6 +107,11 @@ void RTGL1::AutoBuffer::Destroy()
 
 void RTGL1::AutoBuffer::CopyFromStaging(VkCommandBuffer cmd, uint32_t frameIndex, VkDeviceSize size, VkDeviceSize offset)
 {
+    if (isDirect)
+    {
+        return;
+    }
+
     assert(staging[frameIndex].GetSize() == deviceLocal.GetSize());
 
     if (size == VK_WHOLE_SIZE)
@@ -111,18 +138,30 @@ void RTGL1::AutoBuffer::CopyFromStaging(VkCommandBuffer cmd, uint32_t frameIndex
         cmd,
         staging[frameIndex].GetBuffer(), deviceLocal.GetBuffer(),
         1, &info);
+
+    allocator->RegisterStagingCopy(size);
 }
 
 void RTGL1::AutoBuffer::CopyFromStaging(
     VkCommandBuffer cmd, uint32_t frameIndex, 
     const VkBufferCopy *copyInfos, uint32_t copyInfosCount)
 {
+    if (isDirect)
+    {
+        return;
+    }
+
     assert(staging[frameIndex].GetSize() == deviceLocal.GetSize());
 
     vkCmdCopyBuffer(
         cmd,
         staging[frameIndex].GetBuffer(), deviceLocal.GetBuffer(),
         copyInfosCount, copyInfos);
+
+    for (uint32_t i = 0; i < copyInfosCount; i++)
+    {
+        allocator->RegisterStagingCopy(copyInfos[i].size);
+    }
 }
 
 void *RTGL1::AutoBuffer::GetMapped(uint32_t frameIndex)
@@ -139,18 +178,46 @@ VkBuffer RTGL1::AutoBuffer::GetStaging(uint32_t frameIndex)
 
 VkBuffer RTGL1::AutoBuffer::GetDeviceLocal()
 {
+    assert(!isDirect);
     assert(deviceLocal.IsInitted());
     return deviceLocal.GetBuffer();
 }
 
 VkDeviceAddress RTGL1::AutoBuffer::GetDeviceAddress()
 {
+    assert(!isDirect);
     return deviceLocal.GetAddress();
 }
 
+VkBuffer RTGL1::AutoBuffer::GetDeviceLocal(uint32_t frameIndex)
+{
+    if (isDirect)
+    {
+        assert(staging[frameIndex].IsInitted());
+        return staging[frameIndex].GetBuffer();
+    }
+
+    return GetDeviceLocal();
+}
+
+VkDeviceAddress RTGL1::AutoBuffer::GetDeviceAddress(uint32_t frameIndex)
+{
+    return isDirect ? staging[frameIndex].GetAddress() : GetDeviceAddress();
+}
+
+bool RTGL1::AutoBuffer::IsDirect() const
+{
+    return isDirect;
+}
+
 VkDeviceSize RTGL1::AutoBuffer::GetSize() const
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    if (isDirect)
+    {
+        return staging[0].GetSize();
+    }
+
+    for (uint32_t i = 0; i < frameCount; i++)
     {
         assert(deviceLocal.GetSize() == staging[i].GetSize());
     }
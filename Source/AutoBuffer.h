@@ -28,6 +28,9 @@ namespace RTGL1
 
 // This class encapsulate staging buffers for each frame in flight 
 // and one device local buffer to copy in.
+// If direct write is allowed and there is a large device-local host-visible memory,
+// there are no staging buffers: each frame has its own mapped device local buffer,
+// so the data must be fully rewritten each frame and copying is a no-op.
 class AutoBuffer
 {
 public:
@@ -43,7 +46,9 @@ public:
     AutoBuffer &operator=(const AutoBuffer &other) = delete;
     AutoBuffer &operator=(AutoBuffer &&other) noexcept = delete;
 
-    void Create(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t frameCount = MAX_FRAMES_IN_FLIGHT);
+    // Staging buffers are created for each of "frameCount" frames,
+    // it must be not greater than MAX_FRAMES_IN_FLIGHT
+    void Create(VkDeviceSize size, VkBufferUsageFlags usage, uint32_t frameCount, bool allowDirectWrite = false);
     void Destroy();
 
     void CopyFromStaging(VkCommandBuffer cmd, uint32_t frameIndex, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -52,8 +57,16 @@ public:
     VkBuffer GetStaging(uint32_t frameIndex);
     void *GetMapped(uint32_t frameIndex);
 
+    // Only if the buffer is not direct
     VkBuffer GetDeviceLocal();
     VkDeviceAddress GetDeviceAddress();
+    // Buffer that is read by the device in the frame with "frameIndex"
+    VkBuffer GetDeviceLocal(uint32_t frameIndex);
+    VkDeviceAddress GetDeviceAddress(uint32_t frameIndex);
+
+    // If true, the mapped memory is read by the device directly,
+    // so no copies and transfer barriers are needed
+    bool IsDirect() const;
 
     VkDeviceSize GetSize() const;
 
@@ -63,6 +76,8 @@ private:
 
     Buffer staging[MAX_FRAMES_IN_FLIGHT];
     Buffer deviceLocal;
+    uint32_t frameCount;
+    bool isDirect;
 
     void *mapped[MAX_FRAMES_IN_FLIGHT];
 
@@ -23,8 +23,9 @@
 
 using namespace RTGL1;
 
-CommandBufferManager::CommandBufferManager(VkDevice device, std::shared_ptr<Queues> queues) :
-    currentFrameIndex(MAX_FRAMES_IN_FLIGHT - 1)
+CommandBufferManager::CommandBufferManager(VkDevice device, std::shared_ptr<Queues> queues, uint32_t _framesInFlight) :
+    framesInFlight(_framesInFlight),
+    currentFrameIndex(_framesInFlight - 1)
 {
     this->device = device;
     this->queues = queues;
@@ -33,7 +34,7 @@ CommandBufferManager::CommandBufferManager(VkDevice device, std::shared_ptr<Queu
     cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmdPoolInfo.flags = 0;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         VkResult r;
 
@@ -49,11 +50,15 @@ CommandBufferManager::CommandBufferManager(VkDevice device, std::shared_ptr<Queu
         r = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transferCmds[i].pool);
         VK_CHECKERROR(r);
     }
+
+    cmdPoolInfo.queueFamilyIndex = queues->GetIndexGraphics();
+    VkResult r = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &standaloneGraphicsCmds.pool);
+    VK_CHECKERROR(r);
 }
 
 CommandBufferManager::~CommandBufferManager()
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         assert(cmdQueues[i].empty());
 
@@ -61,6 +66,8 @@ CommandBufferManager::~CommandBufferManager()
         vkDestroyCommandPool(device, computeCmds[i].pool, nullptr);
         vkDestroyCommandPool(device, transferCmds[i].pool, nullptr);
     }
+
+    vkDestroyCommandPool(device, standaloneGraphicsCmds.pool, nullptr);
 }
 
 void CommandBufferManager::PrepareForFrame(uint32_t frameIndex)
@@ -144,6 +151,21 @@ VkCommandBuffer CommandBufferManager::StartTransferCmd()
     return StartCmd(currentFrameIndex, transferCmds[currentFrameIndex], queues.lock()->GetTransfer());
 }
 
+VkCommandBuffer CommandBufferManager::StartStandaloneGraphicsCmd()
+{
+    if (queues.expired())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    // previous standalone cmd is completed, so the pool can be reset
+    vkResetCommandPool(device, standaloneGraphicsCmds.pool, 0);
+    standaloneGraphicsCmds.curCount = 0;
+
+    // submitted with the cmds of the current frame index
+    return StartCmd(currentFrameIndex, standaloneGraphicsCmds, queues.lock()->GetGraphics());
+}
+
 void CommandBufferManager::Submit(VkCommandBuffer cmd, VkFence fence)
 {
     VkResult r = vkEndCommandBuffer(cmd);
@@ -32,7 +32,7 @@ namespace RTGL1
 class CommandBufferManager
 {
 public:
-    explicit CommandBufferManager(VkDevice device, std::shared_ptr<Queues> queues);
+    explicit CommandBufferManager(VkDevice device, std::shared_ptr<Queues> queues, uint32_t framesInFlight);
     ~CommandBufferManager();
 
     CommandBufferManager(const CommandBufferManager& other) = delete;
@@ -48,6 +48,10 @@ public:
     VkCommandBuffer StartComputeCmd();
     // Start transfer command buffer for current frame index
     VkCommandBuffer StartTransferCmd();
+    // Start graphics command buffer that doesn't belong to any frame,
+    // so it can be in use while several frames are processed.
+    // Previously started standalone cmd must be completed before this call.
+    VkCommandBuffer StartStandaloneGraphicsCmd();
 
     void Submit(VkCommandBuffer cmd, VkFence fence = VK_NULL_HANDLE);
     void Submit(VkCommandBuffer cmd, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStages, VkSemaphore signalSemaphore, VkFence fence);
@@ -72,6 +76,7 @@ private:
 private:
     VkDevice device;
 
+    uint32_t framesInFlight;
     uint32_t currentFrameIndex;
 
     const uint32_t cmdAllocStep = 16;
@@ -80,6 +85,7 @@ private:
     AllocatedCmds graphicsCmds[MAX_FRAMES_IN_FLIGHT];
     AllocatedCmds computeCmds[MAX_FRAMES_IN_FLIGHT];
     AllocatedCmds transferCmds[MAX_FRAMES_IN_FLIGHT];
+    AllocatedCmds standaloneGraphicsCmds;
 
     std::weak_ptr<Queues> queues;
     std::map<VkCommandBuffer, VkQueue> cmdQueues[MAX_FRAMES_IN_FLIGHT];
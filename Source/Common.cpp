@@ -19,6 +19,7 @@
 // SOFTWARE.
 
 #include "Common.h"
+#include "GpuProfiler.h"
 
 
 namespace RTGL1
@@ -80,6 +81,8 @@ void RTGL1::AddDebugName(VkDevice device, uint64_t obj, VkObjectType type, const
 
 void RTGL1::BeginCmdLabel(VkCommandBuffer cmd, const char *pName, const float pColor[4])
 {
+    GpuProfiler::OnCmdLabelBegin(cmd, pName);
+
     if (svkCmdBeginDebugUtilsLabelEXT == nullptr || pName == nullptr)
     {
         return;
@@ -99,6 +102,8 @@ void RTGL1::BeginCmdLabel(VkCommandBuffer cmd, const char *pName, const float pC
 
 void RTGL1::EndCmdLabel(VkCommandBuffer cmd)
 {
+    GpuProfiler::OnCmdLabelEnd(cmd);
+
     if (svkCmdEndDebugUtilsLabelEXT == nullptr)
     {
         return;
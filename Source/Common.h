@@ -27,7 +27,11 @@
 namespace RTGL1
 {
 
-constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+// Bounds for RgInstanceCreateInfo::framesInFlightCount.
+// Per-frame arrays are sized by the max value, but only
+// the actual frames in flight count of their elements is used
+constexpr uint32_t MIN_FRAMES_IN_FLIGHT = 2;
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
 
 #pragma region extension functions
 
@@ -44,6 +48,8 @@ constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 	VK_EXTENSION_FUNCTION(vkGetAccelerationStructureDeviceAddressKHR) \
 	VK_EXTENSION_FUNCTION(vkGetAccelerationStructureBuildSizesKHR) \
 	VK_EXTENSION_FUNCTION(vkCmdBuildAccelerationStructuresKHR) \
+	VK_EXTENSION_FUNCTION(vkCmdWriteAccelerationStructuresPropertiesKHR) \
+	VK_EXTENSION_FUNCTION(vkCmdCopyAccelerationStructureKHR) \
 	VK_EXTENSION_FUNCTION(vkCmdTraceRaysKHR)
 
 #define VK_DEVICE_DEBUG_UTILS_FUNCTION_LIST \
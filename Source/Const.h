@@ -41,4 +41,38 @@ constexpr const char    *DEFAULT_TEXTURES_POSTFIXES[TEXTURES_PER_MATERIAL_COUNT]
 
 constexpr uint32_t      MAX_PREGENERATED_MIPMAP_LEVELS          = 20;
 
+constexpr uint32_t      TEXTURE_LOAD_THREAD_COUNT_MAX           = 16;
+constexpr uint32_t      TEXTURE_DECODE_THREAD_COUNT_MAX         = 16;
+// textures that were sampled recently are not evicted even if over the budget,
+// to not reload them each frame
+constexpr uint32_t      TEXTURE_EVICTION_MIN_UNUSED_FRAMES      = 30;
+// streamed textures upload at once only the levels that are not larger than this size,
+// larger levels are uploaded in next frames
+constexpr uint32_t      TEXTURE_STREAMING_INITIAL_LEVEL_SIZE    = 64;
+// offset of a level data in a staging buffer must be a multiple of 4 and of the texel
+// block size, which is 1, 2, 3, 4, 6, 8, 12, 16, 24 or 32 bytes for VkFormat-s
+constexpr uint32_t      TEXTURE_LEVEL_DATA_ALIGNMENT            = 96;
+
+constexpr uint32_t      DYNAMIC_RECORDING_CONTEXT_COUNT_MAX     = 64;
+
+constexpr uint32_t      STATIC_GEOMETRY_CLUSTER_COUNT_MAX       = 16;
+constexpr uint32_t      STATIC_GEOMETRY_CLUSTER_MIN_SIZE        = 4;
+
+constexpr uint32_t      DEFAULT_STATIC_VERTEX_CAPACITY          = 1 << 16;
+constexpr uint32_t      DEFAULT_STATIC_INDEX_CAPACITY           = 1 << 17;
+constexpr uint32_t      DEFAULT_DYNAMIC_VERTEX_CAPACITY         = 1 << 15;
+constexpr uint32_t      DEFAULT_DYNAMIC_INDEX_CAPACITY          = 1 << 16;
+
+// attribute arrays in the vertex buffers are tightly packed, independently of the user's strides
+constexpr uint32_t      VERTEX_POSITION_STRIDE                  = 3 * sizeof(float);
+constexpr uint32_t      VERTEX_NORMAL_STRIDE                    = 3 * sizeof(float);
+constexpr uint32_t      VERTEX_TEXCOORD_STRIDE                  = 2 * sizeof(float);
+
+// smaller device-local host-visible heaps are a PCI BAR window, not the whole VRAM
+constexpr uint64_t      DIRECT_WRITE_MIN_HEAP_SIZE              = 256ull * 1024 * 1024;
+
+constexpr uint32_t      FRAME_STATISTICS_HISTORY_LENGTH         = 64;
+constexpr uint32_t      GPU_PROFILER_MAX_SCOPE_COUNT            = 256;
+constexpr uint32_t      TRACE_WRITER_RING_BUFFER_SIZE           = 16384;
+
 }
\ No newline at end of file
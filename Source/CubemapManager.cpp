@@ -37,6 +37,7 @@ RTGL1::CubemapManager::CubemapManager(
     std::shared_ptr<SamplerManager> _samplerManager,
     const std::shared_ptr<CommandBufferManager> &_cmdManager,
     std::shared_ptr<UserFileLoad> _userFileLoad,
+    uint32_t _framesInFlight,
     const char *_defaultTexturesPath,
     const char *_overridenTexturePostfix)
 :
@@ -50,7 +51,7 @@ RTGL1::CubemapManager::CubemapManager(
     overridenTexturePostfix = _overridenTexturePostfix != nullptr ? _overridenTexturePostfix : DEFAULT_TEXTURES_POSTFIXES[MATERIAL_COLOR_TEXTURE_INDEX];
 
     imageLoader = std::make_shared<ImageLoader>(std::move(_userFileLoad));
-    cubemapDesc = std::make_shared<TextureDescriptors>(device, MAX_CUBEMAP_COUNT, BINDING_CUBEMAPS);
+    cubemapDesc = std::make_shared<TextureDescriptors>(device, MAX_CUBEMAP_COUNT, BINDING_CUBEMAPS, _framesInFlight);
     cubemapUploader = std::make_shared<CubemapUploader>(device, allocator);
 
     VkCommandBuffer cmd = _cmdManager->StartGraphicsCmd();
@@ -45,6 +45,7 @@ public:
         std::shared_ptr<SamplerManager> samplerManager,
         const std::shared_ptr<CommandBufferManager> &cmdManager,
         std::shared_ptr<UserFileLoad> userFileLoad,
+        uint32_t framesInFlight,
         const char *defaultTexturesPath,
         const char *albedoAlphaPostfix);
     ~CubemapManager();
@@ -29,9 +29,11 @@ RTGL1::DepthCopying::DepthCopying(
     VkDevice _device,
     VkFormat _depthFormat,
     const std::shared_ptr<ShaderManager> &_shaderManager, 
-    const std::shared_ptr<Framebuffers> &_storageFramebuffers)
+    const std::shared_ptr<Framebuffers> &_storageFramebuffers,
+    uint32_t _framesInFlight)
 :
     device(_device),
+    framesInFlight(_framesInFlight),
     renderPass(VK_NULL_HANDLE),
     framebuffers{},
     pipelineLayout(VK_NULL_HANDLE),
@@ -168,7 +170,7 @@ void RTGL1::DepthCopying::CreateFramebuffers(VkImageView pDepthAttchViews[MAX_FR
 {
     assert(renderPass);
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         assert(framebuffers[i] == VK_NULL_HANDLE);
 
@@ -188,7 +190,7 @@ void RTGL1::DepthCopying::CreateFramebuffers(VkImageView pDepthAttchViews[MAX_FR
 
 void RTGL1::DepthCopying::DestroyFramebuffers()
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         if (framebuffers[i] != VK_NULL_HANDLE)
         {
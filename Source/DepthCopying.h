@@ -34,7 +34,8 @@ public:
     DepthCopying(VkDevice device,
                  VkFormat depthFormat,
                  const std::shared_ptr<ShaderManager> &shaderManager,
-                 const std::shared_ptr<Framebuffers> &storageFramebuffers);
+                 const std::shared_ptr<Framebuffers> &storageFramebuffers,
+                 uint32_t framesInFlight);
     ~DepthCopying();
 
     DepthCopying(const DepthCopying &other) = delete;
@@ -61,6 +62,7 @@ private:
 
 private:
     VkDevice device;
+    uint32_t framesInFlight;
 
     VkRenderPass renderPass;
     VkFramebuffer framebuffers[MAX_FRAMES_IN_FLIGHT];
@@ -0,0 +1,69 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+#include "Const.h"
+#include "VertexCollectorFilter.h"
+#include "VertexCollectorFilterType.h"
+#include "Generated/ShaderCommonC.h"
+#include "RTGL1/RTGL1.h"
+
+namespace RTGL1
+{
+
+// Dynamic geometry which data is already in the staging buffers,
+// but it's not added to the vertex collector's filters yet.
+struct RecordedDynamicGeometry
+{
+    uint64_t                            uniqueID;
+    VertexCollectorFilterTypeFlags      geomFlags;
+    VkAccelerationStructureGeometryKHR  asGeometry;
+    uint32_t                            primitiveCount;
+    GeometryTopology                    topology;
+    // material indices are filled on merging, as texture manager can't be accessed from other threads
+    ShGeometryInstance                  geomInfo;
+    RgLayeredMaterial                   geomMaterial;
+    RgGeometryMaterialBlendType         layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT];
+    RgFloat4D                           layerColors[MATERIALS_MAX_LAYER_COUNT];
+};
+
+// Dynamic geometry which ranges in the staging buffers are reserved,
+// and its data is being written there by the user, see rgMapGeometry.
+struct MappedDynamicGeometry
+{
+    RecordedDynamicGeometry             recorded;
+    // geometry info with data pointers to the mapped ranges
+    RgGeometryUploadInfo                mappedInfo;
+    // if true, indices are written by the user, so topology is known only on commit
+    bool                                indicesAreMapped;
+};
+
+// List of dynamic geometries that were recorded by one thread.
+// Contexts are merged in the order of their indices, on dynamic geometry submission.
+struct DynamicRecordingContext
+{
+    std::vector<RecordedDynamicGeometry> geometries;
+};
+
+}
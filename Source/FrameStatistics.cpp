@@ -0,0 +1,129 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FrameStatistics.h"
+
+#include <algorithm>
+
+using namespace RTGL1;
+
+FrameStatistics::FrameStatistics() :
+    stageTimes{},
+    geometryCount(0),
+    vertexCount(0),
+    indexCount(0),
+    lightCount(0),
+    history{},
+    historyNext(0),
+    historyCount(0)
+{}
+
+void FrameStatistics::AddStage(Stage stage, Clock::time_point begin, Clock::time_point end)
+{
+    assert(stage < Stage::Count);
+    stageTimes[static_cast<uint32_t>(stage)] += std::chrono::duration<double, std::milli>(end - begin).count();
+
+    if (traceWriter)
+    {
+        traceWriter->AddCpuScope(GetStageName(stage), begin, end);
+    }
+}
+
+void FrameStatistics::AddGeometries(uint32_t _geometryCount, uint32_t _vertexCount, uint32_t _indexCount)
+{
+    geometryCount += _geometryCount;
+    vertexCount += _vertexCount;
+    indexCount += _indexCount;
+}
+
+void FrameStatistics::AddLight()
+{
+    lightCount++;
+}
+
+void FrameStatistics::OnFrameEnd(uint64_t frameId, uint32_t rasterizedDrawCallCount, uint64_t stagingCopiedBytes, uint64_t staticBlasCompactionSavedBytes)
+{
+    RgFrameStatistics &s = history[historyNext];
+
+    s.frameId                       = frameId;
+    s.fenceWaitTime                 = stageTimes[static_cast<uint32_t>(Stage::FenceWait)];
+    s.swapchainAcquireTime          = stageTimes[static_cast<uint32_t>(Stage::SwapchainAcquire)];
+    s.sceneSubmitTime               = stageTimes[static_cast<uint32_t>(Stage::SceneSubmit)];
+    s.textureDescriptorsSubmitTime  = stageTimes[static_cast<uint32_t>(Stage::TextureDescriptorsSubmit)];
+    s.geomInfoCopyTime              = stageTimes[static_cast<uint32_t>(Stage::GeomInfoCopy)];
+    s.tlasPrepareTime               = stageTimes[static_cast<uint32_t>(Stage::TLASPrepare)];
+    s.tlasBuildTime                 = stageTimes[static_cast<uint32_t>(Stage::TLASBuild)];
+    s.rasterizerTime                = stageTimes[static_cast<uint32_t>(Stage::Rasterizer)];
+    s.submitTime                    = stageTimes[static_cast<uint32_t>(Stage::Submit)];
+    s.presentTime                   = stageTimes[static_cast<uint32_t>(Stage::Present)];
+
+    s.geometryCount                 = geometryCount.exchange(0);
+    s.vertexCount                   = vertexCount.exchange(0);
+    s.indexCount                    = indexCount.exchange(0);
+    s.lightCount                    = lightCount;
+    s.rasterizedDrawCallCount       = rasterizedDrawCallCount;
+    s.stagingCopiedBytes            = stagingCopiedBytes;
+    s.staticBlasCompactionSavedBytes = staticBlasCompactionSavedBytes;
+
+    for (double &t : stageTimes)
+    {
+        t = 0.0;
+    }
+    lightCount = 0;
+
+    historyNext = (historyNext + 1) % FRAME_STATISTICS_HISTORY_LENGTH;
+    historyCount = std::min(historyCount + 1, FRAME_STATISTICS_HISTORY_LENGTH);
+}
+
+uint32_t FrameStatistics::GetLast(uint32_t count, RgFrameStatistics *pResults) const
+{
+    count = std::min(count, historyCount);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t index = (historyNext + FRAME_STATISTICS_HISTORY_LENGTH - 1 - i) % FRAME_STATISTICS_HISTORY_LENGTH;
+        pResults[i] = history[index];
+    }
+
+    return count;
+}
+
+void FrameStatistics::SetTraceWriter(std::shared_ptr<TraceWriter> writer)
+{
+    traceWriter = std::move(writer);
+}
+
+const char *FrameStatistics::GetStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::FenceWait:                  return "Fence wait";
+        case Stage::SwapchainAcquire:           return "Swapchain acquire";
+        case Stage::SceneSubmit:                return "Scene submit";
+        case Stage::TextureDescriptorsSubmit:   return "Texture descriptors submit";
+        case Stage::GeomInfoCopy:               return "Geometry infos copy";
+        case Stage::TLASPrepare:                return "TLAS prepare";
+        case Stage::TLASBuild:                  return "TLAS build";
+        case Stage::Rasterizer:                 return "Rasterizer";
+        case Stage::Submit:                     return "Queue submit";
+        case Stage::Present:                    return "Present";
+        default: assert(0);                     return "";
+    }
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "Common.h"
+#include "Const.h"
+#include "RTGL1/RTGL1.h"
+#include "TraceWriter.h"
+
+namespace RTGL1
+{
+
+// Collects CPU times of the internal stages and counters of uploaded data
+// for each frame, and keeps the history of the last frames.
+class FrameStatistics
+{
+public:
+    enum class Stage
+    {
+        FenceWait,
+        SwapchainAcquire,
+        SceneSubmit,
+        TextureDescriptorsSubmit,
+        GeomInfoCopy,
+        TLASPrepare,
+        TLASBuild,
+        Rasterizer,
+        Submit,
+        Present,
+        Count
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    // Measures the CPU time between its construction and destruction
+    class ScopedStage
+    {
+    public:
+        explicit ScopedStage(FrameStatistics &_stats, Stage _stage) :
+            stats(_stats), stage(_stage), start(Clock::now())
+        {}
+
+        ~ScopedStage()
+        {
+            stats.AddStage(stage, start, Clock::now());
+        }
+
+        ScopedStage(const ScopedStage &other) = delete;
+        ScopedStage(ScopedStage &&other) noexcept = delete;
+        ScopedStage &operator=(const ScopedStage &other) = delete;
+        ScopedStage &operator=(ScopedStage &&other) noexcept = delete;
+
+    private:
+        FrameStatistics &stats;
+        Stage stage;
+        Clock::time_point start;
+    };
+
+public:
+    FrameStatistics();
+    ~FrameStatistics() = default;
+
+    FrameStatistics(const FrameStatistics &other) = delete;
+    FrameStatistics(FrameStatistics &&other) noexcept = delete;
+    FrameStatistics &operator=(const FrameStatistics &other) = delete;
+    FrameStatistics &operator=(FrameStatistics &&other) noexcept = delete;
+
+    // Stage can be added several times per frame, its times are summed up
+    void AddStage(Stage stage, Clock::time_point begin, Clock::time_point end);
+
+    // Can be called from several threads simultaneously
+    void AddGeometries(uint32_t geometryCount, uint32_t vertexCount, uint32_t indexCount);
+    void AddLight();
+
+    // Store the statistics of the current frame to the history and start a new one
+    void OnFrameEnd(uint64_t frameId, uint32_t rasterizedDrawCallCount, uint64_t stagingCopiedBytes, uint64_t staticBlasCompactionSavedBytes);
+
+    // Write the last "count" frames to "pResults", the most recent one first.
+    // Returns the amount of written elements.
+    uint32_t GetLast(uint32_t count, RgFrameStatistics *pResults) const;
+
+    // If set, each stage is also written to the trace
+    void SetTraceWriter(std::shared_ptr<TraceWriter> writer);
+
+private:
+    static const char *GetStageName(Stage stage);
+
+private:
+    double stageTimes[static_cast<uint32_t>(Stage::Count)];
+
+    std::atomic<uint32_t> geometryCount;
+    std::atomic<uint32_t> vertexCount;
+    std::atomic<uint32_t> indexCount;
+    uint32_t lightCount;
+
+    // ring buffer, "historyNext" is the index to write the next frame to
+    RgFrameStatistics history[FRAME_STATISTICS_HISTORY_LENGTH];
+    uint32_t historyNext;
+    uint32_t historyCount;
+
+    std::shared_ptr<TraceWriter> traceWriter;
+};
+
+}
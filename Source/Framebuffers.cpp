@@ -26,18 +26,16 @@ using namespace RTGL1;
 #include "Utils.h"
 #include "CmdLabel.h"
 
-static_assert(MAX_FRAMES_IN_FLIGHT == FRAMEBUFFERS_HISTORY_LENGTH, "Framebuffers class logic must be changed if history length is not equal to max frames in flight");
-
-FramebufferImageIndex Framebuffers::FrameIndexToFBIndex(FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex)
+FramebufferImageIndex Framebuffers::FrameIndexToFBIndex(FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex) const
 {
-    assert(frameIndex < FRAMEBUFFERS_HISTORY_LENGTH);
+    assert(frameIndex < MAX_FRAMES_IN_FLIGHT);
     assert(framebufferImageIndex >= 0 && framebufferImageIndex < ShFramebuffers_Count);
 
     // if framubuffer with given index can be swapped,
     // use one that is currently in use
     if (ShFramebuffers_Bindings[framebufferImageIndex] != ShFramebuffers_BindingsSwapped[framebufferImageIndex])
     {
-        return (FramebufferImageIndex)(framebufferImageIndex + frameIndex);
+        return (FramebufferImageIndex)(framebufferImageIndex + frameHistoryIndices[frameIndex]);
     }
 
     return framebufferImageIndex;
@@ -56,7 +54,9 @@ Framebuffers::Framebuffers(
     currentSize{},
     descSetLayout(VK_NULL_HANDLE),
     descPool(VK_NULL_HANDLE),
-    descSets{}
+    descSets{},
+    frameHistoryIndices{},
+    lastHistoryIndex(FRAMEBUFFERS_HISTORY_LENGTH - 1)
 {
     images.resize(ShFramebuffers_Count);
     imageMemories.resize(ShFramebuffers_Count);
@@ -172,6 +172,16 @@ bool RTGL1::Framebuffers::PrepareForSize(uint32_t width, uint32_t height)
     return true;
 }
 
+void RTGL1::Framebuffers::PrepareForFrame(uint32_t frameIndex)
+{
+    assert(frameIndex < MAX_FRAMES_IN_FLIGHT);
+
+    // frame index can't be used as a history index directly,
+    // as frames in flight count can be greater than history length
+    lastHistoryIndex = (lastHistoryIndex + 1) % FRAMEBUFFERS_HISTORY_LENGTH;
+    frameHistoryIndices[frameIndex] = lastHistoryIndex;
+}
+
 void RTGL1::Framebuffers::BarrierOne(VkCommandBuffer cmd, uint32_t frameIndex, FramebufferImageIndex framebufferImageIndex)
 {
     FramebufferImageIndex fs[] = { framebufferImageIndex };
@@ -196,7 +206,8 @@ void Framebuffers::PresentToSwapchain(
 
 VkDescriptorSet Framebuffers::GetDescSet(uint32_t frameIndex) const
 {
-    return descSets[frameIndex];
+    assert(frameIndex < MAX_FRAMES_IN_FLIGHT);
+    return descSets[frameHistoryIndices[frameIndex]];
 }
 
 VkDescriptorSetLayout Framebuffers::GetDescSetLayout() const
@@ -53,6 +53,9 @@ public:
     Framebuffers &operator=(Framebuffers &&other) noexcept = delete;
 
     bool PrepareForSize(uint32_t width, uint32_t height);
+    // Must be called at the beginning of each frame.
+    // History images are swapped every frame, regardless of frames in flight count
+    void PrepareForFrame(uint32_t frameIndex);
 
     void BarrierOne(VkCommandBuffer cmd,
                     uint32_t frameIndex,
@@ -82,7 +85,7 @@ public:
     void Unsubscribe(const IFramebuffersDependency *subscriber);
 
 private:
-    static FramebufferImageIndex FrameIndexToFBIndex(FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex);
+    FramebufferImageIndex FrameIndexToFBIndex(FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex) const;
 
     void CreateDescriptors();
 
@@ -112,6 +115,10 @@ private:
     VkDescriptorPool descPool;
     VkDescriptorSet descSets[FRAMEBUFFERS_HISTORY_LENGTH];
 
+    // history index that was chosen for each frame index
+    uint32_t frameHistoryIndices[MAX_FRAMES_IN_FLIGHT];
+    uint32_t lastHistoryIndex;
+
     std::list<std::weak_ptr<IFramebuffersDependency>> subscribers;
 };
 
@@ -209,10 +209,6 @@ CONST_TO_EVALUATE = "CONST VALUE MUST BE EVALUATED"
 # --------------------------------------------------------------------------------------------- #
 
 CONST = {
-    "MAX_STATIC_VERTEX_COUNT"               : 1 << 20,
-    "MAX_DYNAMIC_VERTEX_COUNT"              : 1 << 21,
-    "MAX_INDEXED_PRIMITIVE_COUNT"           : 1 << 20,
-   
     "MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT"     : 1 << 12,
     "MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT_POW" : CONST_TO_EVALUATE,
     "MAX_GEOMETRY_PRIMITIVE_COUNT"          : CONST_TO_EVALUATE,
@@ -221,6 +217,8 @@ CONST = {
     "LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT"   : 1 << 8,
     
     "MAX_TOP_LEVEL_INSTANCE_COUNT"          : 45,
+    # instances of meshes that are created with rgCreateMesh
+    "MAX_MESH_INSTANCE_COUNT"               : 1 << 14,
     
     "BINDING_VERTEX_BUFFER_STATIC"          : 0,
     "BINDING_VERTEX_BUFFER_DYNAMIC"         : 1,
@@ -233,6 +231,8 @@ CONST = {
     "BINDING_GLOBAL_UNIFORM"                : 0,
     "BINDING_ACCELERATION_STRUCTURE_MAIN"   : 0,
     "BINDING_TEXTURES"                      : 0,
+    "BINDING_TEXTURE_USAGE"                 : 1,
+    "CONSTANT_ID_TEXTURE_USAGE_TRACKING"    : 1,
     "BINDING_CUBEMAPS"                      : 0,
     "BINDING_RENDER_CUBEMAP"                : 0,
     "BINDING_BLUE_NOISE"                    : 0,
@@ -246,6 +246,11 @@ CONST = {
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON"           : "1 << 1",
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER"    : "1 << 2",
     "INSTANCE_CUSTOM_INDEX_FLAG_REFLECT_REFRACT"        : "1 << 3",
+    # if set, instance is a single object (mesh instance or static movable geometry),
+    # its global geometry index is stored in the custom index bits
+    # starting from INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET
+    "INSTANCE_CUSTOM_INDEX_FLAG_OBJECT"                 : "1 << 4",
+    "INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET"           : 5,
 
     "INSTANCE_MASK_ALL"                     : "0xFF",
     "INSTANCE_MASK_WORLD_MIN"               : "0",
@@ -381,20 +386,6 @@ def evalConst():
 # If count > 1 and dimensions is 2, 3 or 4 (matrices are not supported)
 # then it'll be represented as an array with size (count*dimensions).
 
-STATIC_BUFFER_STRUCT = [
-    (TYPE_FLOAT32,      3,     "positions",             CONST["MAX_STATIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      3,     "normals",               CONST["MAX_STATIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      2,     "texCoords",             CONST["MAX_STATIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      2,     "texCoordsLayer1",       CONST["MAX_STATIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      2,     "texCoordsLayer2",       CONST["MAX_STATIC_VERTEX_COUNT"]),
-]
-
-DYNAMIC_BUFFER_STRUCT = [
-    (TYPE_FLOAT32,      3,     "positions",             CONST["MAX_DYNAMIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      3,     "normals",               CONST["MAX_DYNAMIC_VERTEX_COUNT"]),
-    (TYPE_FLOAT32,      2,     "texCoords",             CONST["MAX_DYNAMIC_VERTEX_COUNT"]),
-]
-
 # Must be careful with std140 offsets! They are set manually.
 # Other structs are using std430 and padding is done automatically.
 GLOBAL_UNIFORM_STRUCT = [
@@ -494,10 +485,22 @@ GLOBAL_UNIFORM_STRUCT = [
     (TYPE_FLOAT32,      1,      "cameraRayConeSpreadAngle",         1),
     (TYPE_FLOAT32,      1,      "waterTextureAreaScale",            1),
     (TYPE_UINT32,       1,      "useSqrtRoughnessForIndirect",      1),
-    (TYPE_FLOAT32,      1,      "_pad3",                            1),
+    (TYPE_UINT32,       1,      "vertexDataCompact",                1),
 
     (TYPE_FLOAT32,      4,      "worldUpVector",                    1),
 
+    # offsets of the vertex streams in the vertex buffers, in 4-byte elements;
+    # positions are always at the beginning
+    (TYPE_UINT32,       1,      "staticNormalsOffset",              1),
+    (TYPE_UINT32,       1,      "staticTexCoordsOffset",            1),
+    (TYPE_UINT32,       1,      "staticTexCoordsLayer1Offset",      1),
+    (TYPE_UINT32,       1,      "staticTexCoordsLayer2Offset",      1),
+
+    (TYPE_UINT32,       1,      "dynamicNormalsOffset",             1),
+    (TYPE_UINT32,       1,      "dynamicTexCoordsOffset",           1),
+    (TYPE_UINT32,       1,      "_pad0",                            1),
+    (TYPE_UINT32,       1,      "_pad1",                            1),
+
     #(TYPE_FLOAT32,      1,      "_pad0",                        1),
     #(TYPE_FLOAT32,      1,      "_pad1",                        1),
     #(TYPE_FLOAT32,      1,      "_pad2",                        1),
@@ -573,8 +576,6 @@ STRUCT_BREAK_TYPE_ONLY_C    = 2
 # breakType         -- if member's type is not primitive and its count>0 then
 #                      it'll be represented as an array of primitive types
 STRUCTS = {
-    "ShVertexBufferStatic":     (STATIC_BUFFER_STRUCT,      False,  0,                          STRUCT_BREAK_TYPE_COMPLEX),
-    "ShVertexBufferDynamic":    (DYNAMIC_BUFFER_STRUCT,     False,  0,                          STRUCT_BREAK_TYPE_COMPLEX),
     "ShGlobalUniform":          (GLOBAL_UNIFORM_STRUCT,     False,  STRUCT_ALIGNMENT_STD140,    STRUCT_BREAK_TYPE_ONLY_C),
     "ShGeometryInstance":       (GEOM_INSTANCE_STRUCT,      False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShTonemapping":            (TONEMAPPING_STRUCT,        False,  0,                          0),
@@ -587,10 +588,10 @@ STRUCTS = {
 # User defined buffers: uniform, storage buffer
 # --------------------------------------------------------------------------------------------- #
 
+# vertex buffers are accessed with the functions from VertexData.inl,
+# as the offsets of their streams depend on the buffer capacities
 GETTERS = {
     # (struct type): (member to access with)
-    "ShVertexBufferStatic": "staticVertices",
-    "ShVertexBufferDynamic": "dynamicVertices",
 }
 
 
@@ -7,15 +7,13 @@ namespace RTGL1
 
 #include <stdint.h>
 
-#define MAX_STATIC_VERTEX_COUNT (1048576)
-#define MAX_DYNAMIC_VERTEX_COUNT (2097152)
-#define MAX_INDEXED_PRIMITIVE_COUNT (1048576)
 #define MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT (4096)
 #define MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT_POW (12)
 #define MAX_GEOMETRY_PRIMITIVE_COUNT (1048576)
 #define MAX_GEOMETRY_PRIMITIVE_COUNT_POW (20)
 #define LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT (256)
 #define MAX_TOP_LEVEL_INSTANCE_COUNT (45)
+#define MAX_MESH_INSTANCE_COUNT (16384)
 #define BINDING_VERTEX_BUFFER_STATIC (0)
 #define BINDING_VERTEX_BUFFER_DYNAMIC (1)
 #define BINDING_INDEX_BUFFER_STATIC (2)
@@ -27,6 +25,8 @@ namespace RTGL1
 #define BINDING_GLOBAL_UNIFORM (0)
 #define BINDING_ACCELERATION_STRUCTURE_MAIN (0)
 #define BINDING_TEXTURES (0)
+#define BINDING_TEXTURE_USAGE (1)
+#define CONSTANT_ID_TEXTURE_USAGE_TRACKING (1)
 #define BINDING_CUBEMAPS (0)
 #define BINDING_RENDER_CUBEMAP (0)
 #define BINDING_BLUE_NOISE (0)
@@ -39,6 +39,8 @@ namespace RTGL1
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON (1 << 1)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER (1 << 2)
 #define INSTANCE_CUSTOM_INDEX_FLAG_REFLECT_REFRACT (1 << 3)
+#define INSTANCE_CUSTOM_INDEX_FLAG_OBJECT (1 << 4)
+#define INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET (5)
 #define INSTANCE_MASK_ALL (0xFF)
 #define INSTANCE_MASK_WORLD_MIN (0)
 #define INSTANCE_MASK_WORLD_ALL (7)
@@ -115,22 +117,6 @@ namespace RTGL1
 #define MEDIA_TYPE_GLASS (2)
 #define MEDIA_TYPE_COUNT (3)
 
-struct ShVertexBufferStatic
-{
-    float positions[3145728];
-    float normals[3145728];
-    float texCoords[2097152];
-    float texCoordsLayer1[2097152];
-    float texCoordsLayer2[2097152];
-};
-
-struct ShVertexBufferDynamic
-{
-    float positions[6291456];
-    float normals[6291456];
-    float texCoords[4194304];
-};
-
 struct ShGlobalUniform
 {
     float view[16];
@@ -206,8 +192,16 @@ struct ShGlobalUniform
     float cameraRayConeSpreadAngle;
     float waterTextureAreaScale;
     uint32_t useSqrtRoughnessForIndirect;
-    float _pad3;
+    uint32_t vertexDataCompact;
     float worldUpVector[4];
+    uint32_t staticNormalsOffset;
+    uint32_t staticTexCoordsOffset;
+    uint32_t staticTexCoordsLayer1Offset;
+    uint32_t staticTexCoordsLayer2Offset;
+    uint32_t dynamicNormalsOffset;
+    uint32_t dynamicTexCoordsOffset;
+    uint32_t _pad0;
+    uint32_t _pad1;
     int32_t instanceGeomInfoOffset[48];
     int32_t instanceGeomInfoOffsetPrev[48];
     int32_t instanceGeomCount[48];
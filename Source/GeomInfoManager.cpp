@@ -29,25 +29,37 @@
 
 static_assert(sizeof(RTGL1::ShGeometryInstance) % 16 == 0, "Std430 structs must be aligned by 16 bytes");
 
-RTGL1::GeomInfoManager::GeomInfoManager(VkDevice _device, std::shared_ptr<MemoryAllocator> &_allocator)
+// index of copy region for mesh instances, it's after the regions of filters
+constexpr uint32_t MESH_INSTANCES_COPY_REGION = MAX_TOP_LEVEL_INSTANCE_COUNT;
+
+RTGL1::GeomInfoManager::GeomInfoManager(VkDevice _device, std::shared_ptr<MemoryAllocator> &_allocator, uint32_t _framesInFlight)
 :
     device(_device),
+    framesInFlight(_framesInFlight),
     staticGeomCount(0),
-    dynamicGeomCount(0)
+    dynamicGeomCount(0),
+    meshInstanceCount(0),
+    meshInstanceMatchPrevCount(0)
 {
     buffer = std::make_shared<AutoBuffer>(device, _allocator, "Geometry info staging buffer", "Geometry info buffer");
     matchPrev = std::make_shared<AutoBuffer>(device, _allocator, "Match previous Geometry infos staging buffer", "Match previous Geometry infos buffer");
 
-    const uint32_t allBottomLevelGeomsCount = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
+    // mesh instances are placed after all bottom level geometries
+    const uint32_t allGeomsCount = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount() + MAX_MESH_INSTANCE_COUNT;
+
+    buffer->Create(allGeomsCount * sizeof(RTGL1::ShGeometryInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight);
+    matchPrev->Create(allGeomsCount * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight);
+    matchPrevShadow = std::make_unique<int32_t[]>(allGeomsCount);
 
-    buffer->Create(allBottomLevelGeomsCount * sizeof(RTGL1::ShGeometryInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-    matchPrev->Create(allBottomLevelGeomsCount * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-    matchPrevShadow = std::make_unique<int32_t[]>(allBottomLevelGeomsCount);
+    // mesh instances without a match must have -1, only the written entries are reset
+    std::fill(matchPrevShadow.get() + VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount(),
+              matchPrevShadow.get() + allGeomsCount, -1);
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // additional copy region for mesh instances
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
-        copyRegionLowerBounds[i].resize(MAX_TOP_LEVEL_INSTANCE_COUNT, UINT32_MAX);
-        copyRegionUpperBounds[i].resize(MAX_TOP_LEVEL_INSTANCE_COUNT, 0);
+        copyRegionLowerBounds[i].resize(MESH_INSTANCES_COPY_REGION + 1, UINT32_MAX);
+        copyRegionUpperBounds[i].resize(MESH_INSTANCES_COPY_REGION + 1, 0);
     }
 }
 
@@ -60,8 +72,8 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
     CmdLabel label(cmd, "Copying geom infos");
 
     {
-        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT];
-        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT];
+        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
+        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
 
         uint32_t infoCount = 0;
 
@@ -124,6 +136,33 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
             }
         }
 
+        if (matchPrevCopyInfo.maxMeshInstanceCount > 0)
+        {
+            const uint64_t offset = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount() * sizeof(int32_t);
+            const uint64_t size = matchPrevCopyInfo.maxMeshInstanceCount * sizeof(int32_t);
+
+            memcpy((uint8_t *)matchPrev->GetMapped(frameIndex) + offset, (uint8_t *)matchPrevShadow.get() + offset, size);
+
+            copyInfos[infoCount] = {};
+            copyInfos[infoCount].srcOffset = offset;
+            copyInfos[infoCount].dstOffset = offset;
+            copyInfos[infoCount].size = size;
+
+            VkBufferMemoryBarrier &b = barriers[infoCount];
+
+            b = {};
+            b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            b.buffer = matchPrev->GetDeviceLocal();
+            b.offset = offset;
+            b.size = size;
+
+            infoCount++;
+        }
+
         if (infoCount > 0)
         {
             matchPrev->CopyFromStaging(cmd, frameIndex, copyInfos, infoCount);
@@ -143,8 +182,8 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
 
 
     {
-        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT];
-        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT];
+        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
+        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
 
         uint32_t infoCount = 0;
 
@@ -196,6 +235,38 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
             }
         }
 
+        {
+            const uint32_t lower = copyRegionLowerBounds[frameIndex][MESH_INSTANCES_COPY_REGION];
+            const uint32_t upper = copyRegionUpperBounds[frameIndex][MESH_INSTANCES_COPY_REGION];
+
+            if (lower < upper)
+            {
+                const uint32_t offsetInArray = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
+
+                const uint64_t offset = sizeof(ShGeometryInstance) * (offsetInArray + lower);
+                const uint64_t size = sizeof(ShGeometryInstance) * (upper - lower);
+
+                copyInfos[infoCount] = {};
+                copyInfos[infoCount].srcOffset = offset;
+                copyInfos[infoCount].dstOffset = offset;
+                copyInfos[infoCount].size = size;
+
+                VkBufferMemoryBarrier &b = barriers[infoCount];
+
+                b = {};
+                b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                b.buffer = buffer->GetDeviceLocal();
+                b.offset = offset;
+                b.size = size;
+
+                infoCount++;
+            }
+        }
+
         if (infoCount == 0)
         {
             return false;
@@ -267,6 +338,16 @@ void RTGL1::GeomInfoManager::ResetOnlyDynamic(uint32_t frameIndex)
         dynamicGeomCount = 0;
     }
 
+    if (meshInstanceMatchPrevCount > 0)
+    {
+        int32_t *toReset = matchPrevShadow.get() + VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
+        memset(toReset, 0xFF, meshInstanceMatchPrevCount * sizeof(int32_t));
+
+        meshInstanceMatchPrevCount = 0;
+    }
+
+    meshInstanceCount = 0;
+
     for (uint32_t type = 0; type < MAX_TOP_LEVEL_INSTANCE_COUNT; type++)
     {
         std::fill(copyRegionLowerBounds[frameIndex].begin(), copyRegionLowerBounds[frameIndex].end(), UINT32_MAX);
@@ -278,7 +359,13 @@ void RTGL1::GeomInfoManager::ResetWithStatic()
 {
     movableIDToGeomFrameInfo.clear();
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // meshes are destroyed with static geometry, so their instances can't be matched
+    for (auto &m : meshInstanceIDToGeomFrameInfo)
+    {
+        m.clear();
+    }
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         // reset each group
         for (auto cf : VertexCollectorFilterGroup_ChangeFrequency)
@@ -298,8 +385,9 @@ void RTGL1::GeomInfoManager::ResetWithStatic()
 
     geomType.clear();
     simpleToLocalIndex.clear();
+    freeStaticSimpleIndices.clear();
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         ResetOnlyDynamic(i);
     }
@@ -334,11 +422,19 @@ void RTGL1::GeomInfoManager::PrepareForFrame(uint32_t frameIndex)
     // save counts before resetting
     matchPrevCopyInfo.maxDynamicGeomCount = dynamicGeomCount;
     matchPrevCopyInfo.maxStaticGeomCount = staticGeomCount;
+    matchPrevCopyInfo.maxMeshInstanceCount = meshInstanceCount;
 
     dynamicIDToGeomFrameInfo[frameIndex].clear();
+    meshInstanceIDToGeomFrameInfo[frameIndex].clear();
     ResetOnlyDynamic(frameIndex);
 }
 
+void RTGL1::GeomInfoManager::Reserve(uint32_t additionalCount)
+{
+    geomType.reserve(geomType.size() + additionalCount);
+    simpleToLocalIndex.reserve(simpleToLocalIndex.size() + additionalCount);
+}
+
 uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
     uint32_t frameIndex,
     uint64_t geomUniqueID,
@@ -375,7 +471,7 @@ uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
 
         // copy to all staging buffers
         frameBegin = 0;
-        frameEnd = MAX_FRAMES_IN_FLIGHT;
+        frameEnd = framesInFlight;
     }
     else
     {
@@ -405,9 +501,158 @@ uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
     return simpleIndex;
 }
 
+bool RTGL1::GeomInfoManager::CanAddStaticGeomInfo() const
+{
+    return !freeStaticSimpleIndices.empty() || (staticGeomCount + 1) < MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT;
+}
+
+uint32_t RTGL1::GeomInfoManager::AddStaticGeomInfo(
+    uint64_t geomUniqueID,
+    uint32_t localGeomIndex,
+    VertexCollectorFilterTypeFlags flags,
+    ShGeometryInstance &src)
+{
+    assert(!(flags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC));
+    assert(src.baseVertexIndex % 3 == 0);
+    assert(src.baseIndexIndex % 3 == 0);
+
+    // dynamic simple indices are after static ones
+    assert(dynamicGeomCount == 0);
+    assert(geomType.size() == staticGeomCount);
+    assert(geomType.size() == simpleToLocalIndex.size());
+
+    uint32_t simpleIndex;
+
+    if (!freeStaticSimpleIndices.empty())
+    {
+        simpleIndex = freeStaticSimpleIndices.back();
+        freeStaticSimpleIndices.pop_back();
+
+        geomType[simpleIndex] = flags;
+        simpleToLocalIndex[simpleIndex] = localGeomIndex;
+    }
+    else
+    {
+        simpleIndex = staticGeomCount;
+        staticGeomCount++;
+
+        geomType.push_back(flags);
+        simpleToLocalIndex.push_back(localGeomIndex);
+    }
+
+    const uint32_t globalGeomIndex = GetGlobalGeomIndex(localGeomIndex, flags);
+    const uint32_t flagsId = VertexCollectorFilterTypeFlags_GetID(flags);
+
+    // copy to all staging buffers
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        FillWithPrevFrameData(flags, geomUniqueID, globalGeomIndex, src, i);
+
+        ShGeometryInstance *dst = GetGeomInfoAddressByGlobalIndex(i, globalGeomIndex);
+        memcpy(dst, &src, sizeof(ShGeometryInstance));
+
+        MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+    }
+
+    WriteInfoForNextUsage(flags, geomUniqueID, globalGeomIndex, src);
+
+    return simpleIndex;
+}
+
+void RTGL1::GeomInfoManager::RemoveStaticGeomInfo(uint32_t simpleIndex, uint64_t geomUniqueID)
+{
+    if (simpleIndex >= staticGeomCount)
+    {
+        assert(0);
+        return;
+    }
+
+    const VertexCollectorFilterTypeFlags flags = geomType[simpleIndex];
+    const uint32_t localGeomIndex = simpleToLocalIndex[simpleIndex];
+    const uint32_t globalGeomIndex = GetGlobalGeomIndex(localGeomIndex, flags);
+    const uint32_t flagsId = VertexCollectorFilterTypeFlags_GetID(flags);
+
+    // geometry has 0 primitives in BLAS, but its info
+    // still must not point to the data that will be reused
+    ShGeometryInstance empty = {};
+    empty.baseVertexIndex = 0;
+    empty.baseIndexIndex = UINT32_MAX;
+    empty.vertexCount = 0;
+    empty.indexCount = 0;
+    MarkNoPrevInfo(empty);
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        memcpy(GetGeomInfoAddressByGlobalIndex(i, globalGeomIndex), &empty, sizeof(ShGeometryInstance));
+        MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+    }
+
+    matchPrevShadow[globalGeomIndex] = -1;
+    movableIDToGeomFrameInfo.erase(geomUniqueID);
+}
+
+void RTGL1::GeomInfoManager::ReleaseStaticSimpleIndex(uint32_t simpleIndex)
+{
+    assert(simpleIndex < staticGeomCount);
+
+    freeStaticSimpleIndices.push_back(simpleIndex);
+}
+
+uint32_t RTGL1::GeomInfoManager::WriteMeshInstanceGeomInfo(uint32_t frameIndex, uint64_t instanceUniqueID, ShGeometryInstance &src)
+{
+    if (meshInstanceCount >= MAX_MESH_INSTANCE_COUNT)
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t localIndex = meshInstanceCount;
+    const uint32_t globalGeomIndex = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount() + localIndex;
+
+    meshInstanceCount++;
+
+    // mesh vertices are constant, so only model matrix of the previous frame is needed
+    const uint32_t prevFrame = (frameIndex + framesInFlight - 1) % framesInFlight;
+    const auto &prevIdToInfo = meshInstanceIDToGeomFrameInfo[prevFrame];
+    const auto prev = prevIdToInfo.find(instanceUniqueID);
+
+    if (prev != prevIdToInfo.end() && prev->second.baseVertexIndex == src.baseVertexIndex)
+    {
+        MarkMovableHasPrevInfo(src);
+        src.prevBaseIndexIndex = src.baseIndexIndex;
+        memcpy(src.prevModel, prev->second.model, sizeof(float) * 16);
+
+        matchPrevShadow[prev->second.prevGlobalGeomIndex] = (int32_t)globalGeomIndex;
+
+        const uint32_t prevLocalIndex = prev->second.prevGlobalGeomIndex - VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
+        meshInstanceMatchPrevCount = std::max(meshInstanceMatchPrevCount, prevLocalIndex + 1);
+    }
+    else
+    {
+        MarkNoPrevInfo(src);
+    }
+
+    memcpy(GetGeomInfoAddressByGlobalIndex(frameIndex, globalGeomIndex), &src, sizeof(ShGeometryInstance));
+    MarkGeomInfoIndexToCopy(frameIndex, localIndex, MESH_INSTANCES_COPY_REGION);
+
+    // IDs must be unique
+    assert(meshInstanceIDToGeomFrameInfo[frameIndex].find(instanceUniqueID) == meshInstanceIDToGeomFrameInfo[frameIndex].end());
+
+    GeomFrameInfo f = {};
+    memcpy(f.model, src.model, sizeof(float) * 16);
+    f.baseVertexIndex = src.baseVertexIndex;
+    f.baseIndexIndex = src.baseIndexIndex;
+    f.vertexCount = src.vertexCount;
+    f.indexCount = src.indexCount;
+    f.prevGlobalGeomIndex = globalGeomIndex;
+
+    meshInstanceIDToGeomFrameInfo[frameIndex][instanceUniqueID] = f;
+
+    return globalGeomIndex;
+}
+
 void RTGL1::GeomInfoManager::MarkGeomInfoIndexToCopy(uint32_t frameIndex, uint32_t localGeomIndex, uint32_t flagsId)
 {
-    assert(flagsId < MAX_TOP_LEVEL_INSTANCE_COUNT);
+    assert(flagsId <= MESH_INSTANCES_COPY_REGION);
 
     copyRegionLowerBounds[frameIndex][flagsId] = std::min(localGeomIndex,     copyRegionLowerBounds[frameIndex][flagsId]);
     copyRegionUpperBounds[frameIndex][flagsId] = std::max(localGeomIndex + 1, copyRegionUpperBounds[frameIndex][flagsId]);
@@ -427,8 +672,7 @@ void RTGL1::GeomInfoManager::FillWithPrevFrameData(
     // fill prev info, but only for movable and dynamic geoms
     if (isDynamic)
     {
-        static_assert(MAX_FRAMES_IN_FLIGHT == 2, "Assuming MAX_FRAMES_IN_FLIGHT==2");
-        uint32_t prevFrame = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+        uint32_t prevFrame = (frameIndex + framesInFlight - 1) % framesInFlight;
 
         prevIdToInfo = &dynamicIDToGeomFrameInfo[prevFrame];
     }
@@ -534,8 +778,8 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoMaterials(uint32_t simpleIndex,
     const uint32_t flagsId = VertexCollectorFilterTypeFlags_GetID(geomType[simpleIndex]);
     const uint32_t globalIndex = ConvertSimpleIndexToGlobal(simpleIndex);
 
-    // need to write to both staging buffers for static geometry
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // need to write to all staging buffers for static geometry
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         ShGeometryInstance *dst = GetGeomInfoAddressByGlobalIndex(i, globalIndex);
 
@@ -589,8 +833,8 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoTransform(uint32_t simpleIndex,
     const uint32_t localGeomIndex = simpleToLocalIndex[simpleIndex];
     const uint32_t globalIndex = GetGlobalGeomIndex(localGeomIndex, flags);
 
-    // need to write to both staging buffers for static geometry
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // need to write to all staging buffers for static geometry
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         ShGeometryInstance *dst = GetGeomInfoAddressByGlobalIndex(i, globalIndex);
 
@@ -636,6 +880,11 @@ VkBuffer RTGL1::GeomInfoManager::GetMatchPrevBuffer() const
 
 uint32_t RTGL1::GeomInfoManager::GetStaticGeomBaseVertexIndex(uint32_t simpleIndex)
 {
-    // just use frame 0, as infos have same values in both staging buffers
+    // just use frame 0, as infos have same values in all staging buffers
     return GetGeomInfoAddressByGlobalIndex(0, ConvertSimpleIndexToGlobal(simpleIndex))->baseVertexIndex;
 }
+
+uint32_t RTGL1::GeomInfoManager::GetStaticGeomGlobalIndex(uint32_t simpleIndex) const
+{
+    return ConvertSimpleIndexToGlobal(simpleIndex);
+}
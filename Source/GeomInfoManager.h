@@ -41,7 +41,8 @@ class GeomInfoManager
 public:
     explicit GeomInfoManager(
         VkDevice device,
-        std::shared_ptr<MemoryAllocator> &allocator);
+        std::shared_ptr<MemoryAllocator> &allocator,
+        uint32_t framesInFlight);
     ~GeomInfoManager();
 
     GeomInfoManager(const GeomInfoManager &other) = delete;
@@ -54,6 +55,9 @@ public:
     void ResetWithStatic();
 
 
+    // Reserve memory for "additionalCount" WriteGeomInfo calls.
+    void Reserve(uint32_t additionalCount);
+
     // Save instance for copying into buffer and fill previous frame's data.
     // For dynamic geometry it should be called every frame,
     // and for static geometry -- only when whole static scene was changed.
@@ -66,6 +70,28 @@ public:
         ShGeometryInstance &src);
 
 
+    // Add static geometry instance when the static scene is already submitted.
+    // A simple index of a removed geometry is reused, if there is one.
+    // Must be called before any dynamic geometry is added in the current frame.
+    // Returns simple index.
+    uint32_t AddStaticGeomInfo(
+        uint64_t geomUniqueID,
+        uint32_t localGeomIndex,
+        VertexCollectorFilterTypeFlags flags,
+        ShGeometryInstance &src);
+    bool CanAddStaticGeomInfo() const;
+    // Make static geometry instance empty, so it's not accessed by shaders anymore.
+    // Its simple index can be reused only after ReleaseStaticSimpleIndex call.
+    void RemoveStaticGeomInfo(uint32_t simpleIndex, uint64_t geomUniqueID);
+    void ReleaseStaticSimpleIndex(uint32_t simpleIndex);
+
+
+    // Save geometry instance of a mesh instance, its data is in the region after all
+    // bottom level geometries. Mesh instances must be written every frame, like dynamic geometry.
+    // Returns global geometry index, or UINT32_MAX if there's no space.
+    uint32_t WriteMeshInstanceGeomInfo(uint32_t frameIndex, uint64_t instanceUniqueID, ShGeometryInstance &src);
+
+
     void WriteStaticGeomInfoMaterials(uint32_t simpleIndex, uint32_t layer, const MaterialTextures &src);
     void WriteStaticGeomInfoTransform(uint32_t simpleIndex, uint64_t geomUniqueID, const RgTransform &src);
 
@@ -79,6 +105,7 @@ public:
     VkBuffer GetBuffer() const;
     VkBuffer GetMatchPrevBuffer() const;
     uint32_t GetStaticGeomBaseVertexIndex(uint32_t simpleIndex);
+    uint32_t GetStaticGeomGlobalIndex(uint32_t simpleIndex) const;
     
 private:
     struct GeomFrameInfo
@@ -95,6 +122,7 @@ private:
     {
         uint32_t maxStaticGeomCount = 0;
         uint32_t maxDynamicGeomCount = 0;
+        uint32_t maxMeshInstanceCount = 0;
     };
 
 private:
@@ -126,6 +154,7 @@ private:
 
 private:
     VkDevice device;
+    uint32_t framesInFlight;
 
     // Dynamic geoms must be added only after static ones
     // so the variable "staticGeomCount" is used to "protect" static geoms
@@ -133,6 +162,10 @@ private:
     // but static ones are added very infrequently, e.g. on level load
     uint32_t staticGeomCount;
     uint32_t dynamicGeomCount;
+    uint32_t meshInstanceCount;
+    // mesh instance entries in matchPrevShadow that were written since the last reset,
+    // they're indexed by the previous frame's instances, so there can be more than meshInstanceCount
+    uint32_t meshInstanceMatchPrevCount;
 
     // buffer for getting info for geometry in BLAS
     std::shared_ptr<AutoBuffer> buffer;
@@ -149,10 +182,14 @@ private:
 
     std::vector<uint32_t> simpleToLocalIndex;
 
+    // simple indices of removed static geometries, that can be reused
+    std::vector<uint32_t> freeStaticSimpleIndices;
+
     // geometry's uniqueID to geom frame info,
     // used for getting info from previous frame
     std::map<uint64_t, GeomFrameInfo> dynamicIDToGeomFrameInfo[MAX_FRAMES_IN_FLIGHT];
     std::map<uint64_t, GeomFrameInfo> movableIDToGeomFrameInfo;
+    std::map<uint64_t, GeomFrameInfo> meshInstanceIDToGeomFrameInfo[MAX_FRAMES_IN_FLIGHT];
 };
 
 }
@@ -0,0 +1,284 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "GeometryClusterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+using namespace RTGL1;
+
+// Amount of bins along each axis for finding SAH split plane
+constexpr uint32_t CLUSTERIZER_BIN_COUNT = 16;
+
+GeometryBounds GeometryBounds::Empty()
+{
+    return
+    {
+        {  FLT_MAX,  FLT_MAX,  FLT_MAX },
+        { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+    };
+}
+
+bool GeometryBounds::IsValid() const
+{
+    return min[0] <= max[0] && min[1] <= max[1] && min[2] <= max[2];
+}
+
+void GeometryBounds::Extend(const float point[3])
+{
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        min[i] = std::min(min[i], point[i]);
+        max[i] = std::max(max[i], point[i]);
+    }
+}
+
+void GeometryBounds::Extend(const GeometryBounds &other)
+{
+    // corners of empty bounds are infinite, don't extend by them
+    if (!other.IsValid())
+    {
+        return;
+    }
+
+    Extend(other.min);
+    Extend(other.max);
+}
+
+float GeometryBounds::GetSurfaceArea() const
+{
+    if (!IsValid())
+    {
+        return 0.0f;
+    }
+
+    const float x = max[0] - min[0];
+    const float y = max[1] - min[1];
+    const float z = max[2] - min[2];
+
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+GeometryClusterizer::GeometryClusterizer(uint32_t _maxClusterCount, uint32_t _minClusterSize) :
+    maxClusterCount(std::max(_maxClusterCount, 1u)),
+    minClusterSize(std::max(_minClusterSize, 1u))
+{}
+
+void GeometryClusterizer::Clusterize(const GeometryBounds *pBounds, uint32_t count, std::vector<std::vector<uint32_t>> &outClusters) const
+{
+    outClusters.clear();
+
+    std::vector<Cluster> clusters(1);
+    Cluster &root = clusters[0];
+
+    root.bounds = GeometryBounds::Empty();
+    root.isLeaf = false;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (pBounds[i].IsValid())
+        {
+            root.indices.push_back(i);
+            root.bounds.Extend(pBounds[i]);
+        }
+    }
+
+    if (root.indices.empty())
+    {
+        return;
+    }
+
+    while (clusters.size() < maxClusterCount)
+    {
+        // split the most expensive one first
+        Cluster *toSplit = nullptr;
+        float maxCost = -1.0f;
+
+        for (Cluster &c : clusters)
+        {
+            const float cost = c.bounds.GetSurfaceArea() * (float)c.indices.size();
+
+            if (!c.isLeaf && cost > maxCost)
+            {
+                toSplit = &c;
+                maxCost = cost;
+            }
+        }
+
+        if (toSplit == nullptr)
+        {
+            break;
+        }
+
+        Cluster left = {}, right = {};
+
+        if (!TrySplit(pBounds, *toSplit, left, right))
+        {
+            toSplit->isLeaf = true;
+            continue;
+        }
+
+        *toSplit = std::move(left);
+        clusters.push_back(std::move(right));
+    }
+
+    outClusters.reserve(clusters.size());
+
+    for (Cluster &c : clusters)
+    {
+        outClusters.push_back(std::move(c.indices));
+    }
+}
+
+static void GetCentroid(const GeometryBounds &b, float outCentroid[3])
+{
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        outCentroid[i] = (b.min[i] + b.max[i]) * 0.5f;
+    }
+}
+
+bool GeometryClusterizer::TrySplit(const GeometryBounds *pBounds, Cluster &src, Cluster &outLeft, Cluster &outRight) const
+{
+    const uint32_t count = static_cast<uint32_t>(src.indices.size());
+
+    if (count < minClusterSize * 2)
+    {
+        return false;
+    }
+
+    GeometryBounds centroidBounds = GeometryBounds::Empty();
+
+    for (uint32_t index : src.indices)
+    {
+        float c[3];
+        GetCentroid(pBounds[index], c);
+
+        centroidBounds.Extend(c);
+    }
+
+    // splitting is worth it, only if the cost is lower than the current one
+    float bestCost = src.bounds.GetSurfaceArea() * (float)count;
+    uint32_t bestAxis = UINT32_MAX;
+    uint32_t bestBin = 0;
+
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        const float axisMin = centroidBounds.min[axis];
+        const float extent = centroidBounds.max[axis] - axisMin;
+
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        GeometryBounds binBounds[CLUSTERIZER_BIN_COUNT];
+        uint32_t binCounts[CLUSTERIZER_BIN_COUNT] = {};
+
+        for (auto &b : binBounds)
+        {
+            b = GeometryBounds::Empty();
+        }
+
+        for (uint32_t index : src.indices)
+        {
+            float c[3];
+            GetCentroid(pBounds[index], c);
+
+            const uint32_t bin = std::min(CLUSTERIZER_BIN_COUNT - 1, (uint32_t)((c[axis] - axisMin) / extent * CLUSTERIZER_BIN_COUNT));
+
+            binBounds[bin].Extend(pBounds[index]);
+            binCounts[bin]++;
+        }
+
+        // sweep from the right to get the cost of the right side of each plane
+        float rightAreas[CLUSTERIZER_BIN_COUNT] = {};
+        uint32_t rightCounts[CLUSTERIZER_BIN_COUNT] = {};
+
+        {
+            GeometryBounds b = GeometryBounds::Empty();
+            uint32_t n = 0;
+
+            for (uint32_t i = CLUSTERIZER_BIN_COUNT - 1; i > 0; i--)
+            {
+                b.Extend(binBounds[i]);
+                n += binCounts[i];
+
+                rightAreas[i] = b.GetSurfaceArea();
+                rightCounts[i] = n;
+            }
+        }
+
+        // plane "i" is between bins "i-1" and "i"
+        GeometryBounds leftBounds = GeometryBounds::Empty();
+        uint32_t leftCount = 0;
+
+        for (uint32_t i = 1; i < CLUSTERIZER_BIN_COUNT; i++)
+        {
+            leftBounds.Extend(binBounds[i - 1]);
+            leftCount += binCounts[i - 1];
+
+            if (leftCount < minClusterSize || rightCounts[i] < minClusterSize)
+            {
+                continue;
+            }
+
+            const float cost = leftBounds.GetSurfaceArea() * (float)leftCount + rightAreas[i] * (float)rightCounts[i];
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = i;
+            }
+        }
+    }
+
+    if (bestAxis == UINT32_MAX)
+    {
+        return false;
+    }
+
+    const float axisMin = centroidBounds.min[bestAxis];
+    const float extent = centroidBounds.max[bestAxis] - axisMin;
+
+    outLeft.bounds = GeometryBounds::Empty();
+    outRight.bounds = GeometryBounds::Empty();
+    outLeft.isLeaf = false;
+    outRight.isLeaf = false;
+
+    for (uint32_t index : src.indices)
+    {
+        float c[3];
+        GetCentroid(pBounds[index], c);
+
+        const uint32_t bin = std::min(CLUSTERIZER_BIN_COUNT - 1, (uint32_t)((c[bestAxis] - axisMin) / extent * CLUSTERIZER_BIN_COUNT));
+
+        Cluster &dst = bin < bestBin ? outLeft : outRight;
+
+        dst.indices.push_back(index);
+        dst.bounds.Extend(pBounds[index]);
+    }
+
+    assert(outLeft.indices.size() >= minClusterSize && outRight.indices.size() >= minClusterSize);
+    return true;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Axis-aligned bounding box of a geometry
+struct GeometryBounds
+{
+    float min[3];
+    float max[3];
+
+    // Bounds that contain nothing, extending them with a point makes them valid
+    static GeometryBounds Empty();
+    bool IsValid() const;
+    void Extend(const float point[3]);
+    void Extend(const GeometryBounds &other);
+    float GetSurfaceArea() const;
+};
+
+// Splits geometries into spatially compact clusters by their bounds.
+// Top-down: the cluster with the highest SAH cost is split at the best
+// binned SAH plane, until there are "maxClusterCount" clusters,
+// or none of them can be split with a lower cost.
+class GeometryClusterizer
+{
+public:
+    // Each cluster has at least "minClusterSize" geometries, if it's not the only one
+    explicit GeometryClusterizer(uint32_t maxClusterCount, uint32_t minClusterSize);
+
+    GeometryClusterizer(const GeometryClusterizer &other) = delete;
+    GeometryClusterizer(GeometryClusterizer &&other) noexcept = delete;
+    GeometryClusterizer &operator=(const GeometryClusterizer &other) = delete;
+    GeometryClusterizer &operator=(GeometryClusterizer &&other) noexcept = delete;
+
+    // Write indices of "pBounds" of each cluster to "outClusters".
+    // Invalid bounds are not included in any cluster.
+    void Clusterize(const GeometryBounds *pBounds, uint32_t count, std::vector<std::vector<uint32_t>> &outClusters) const;
+
+private:
+    struct Cluster
+    {
+        std::vector<uint32_t> indices;
+        GeometryBounds bounds;
+        // SAH split was not found
+        bool isLeaf;
+    };
+
+    // Returns false, if the cluster can't be split with a lower cost
+    bool TrySplit(const GeometryBounds *pBounds, Cluster &src, Cluster &outLeft, Cluster &outRight) const;
+
+private:
+    uint32_t maxClusterCount;
+    uint32_t minClusterSize;
+};
+
+}
@@ -25,7 +25,7 @@
 
 using namespace RTGL1;
 
-GlobalUniform::GlobalUniform(VkDevice _device, std::shared_ptr<MemoryAllocator> &_allocator)
+GlobalUniform::GlobalUniform(VkDevice _device, std::shared_ptr<MemoryAllocator> &_allocator, uint32_t framesInFlight)
 :
     device(_device),
     descPool(VK_NULL_HANDLE),
@@ -35,7 +35,7 @@ GlobalUniform::GlobalUniform(VkDevice _device, std::shared_ptr<MemoryAllocator>
     uniformData = std::make_shared<ShGlobalUniform>();
 
     uniformBuffer = std::make_shared<AutoBuffer>(_device, _allocator, "Uniform buffer staging", "Uniform buffer");
-    uniformBuffer->Create(sizeof(ShGlobalUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    uniformBuffer->Create(sizeof(ShGlobalUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, framesInFlight);
 
     CreateDescriptors();
 }
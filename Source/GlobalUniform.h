@@ -30,7 +30,7 @@ struct ShGlobalUniform;
 class GlobalUniform
 {
 public:
-    explicit GlobalUniform(VkDevice device, std::shared_ptr<MemoryAllocator> &allocator);
+    explicit GlobalUniform(VkDevice device, std::shared_ptr<MemoryAllocator> &allocator, uint32_t framesInFlight);
     ~GlobalUniform();
 
     GlobalUniform(const GlobalUniform &other) = delete;
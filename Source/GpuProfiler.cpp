@@ -0,0 +1,321 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "Const.h"
+#include "RgException.h"
+
+using namespace RTGL1;
+
+namespace
+{
+
+// Profilers that currently record timestamps, by their frame command buffers.
+// Labels are recorded by free functions, so the profiler is found by the command buffer.
+std::mutex G_ACTIVE_PROFILERS_MUTEX;
+std::unordered_map<VkCommandBuffer, GpuProfiler *> G_ACTIVE_PROFILERS;
+// Size of G_ACTIVE_PROFILERS, so labels don't lock the mutex if profiling is disabled
+std::atomic<uint32_t> G_ACTIVE_PROFILER_COUNT(0);
+
+GpuProfiler *FindActiveProfiler(VkCommandBuffer cmd)
+{
+    if (G_ACTIVE_PROFILER_COUNT.load(std::memory_order_relaxed) == 0)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(G_ACTIVE_PROFILERS_MUTEX);
+
+    auto it = G_ACTIVE_PROFILERS.find(cmd);
+    return it != G_ACTIVE_PROFILERS.end() ? it->second : nullptr;
+}
+
+}
+
+GpuProfiler::GpuProfiler(VkDevice _device, VkPhysicalDevice _physDevice, uint32_t _queueFamilyIndex, uint32_t _framesInFlight)
+:
+    device(_device),
+    framesInFlight(_framesInFlight),
+    timestampPeriod(1.0),
+    timestampMask(UINT64_MAX),
+    frames{},
+    currentCmd(VK_NULL_HANDLE),
+    currentFrameIndex(0),
+    resolvedFrameId(0)
+{
+    VkPhysicalDeviceProperties props = {};
+    vkGetPhysicalDeviceProperties(_physDevice, &props);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(_physDevice, &familyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(_physDevice, &familyCount, families.data());
+
+    assert(_queueFamilyIndex < familyCount);
+    const uint32_t validBits = families[_queueFamilyIndex].timestampValidBits;
+
+    if (validBits == 0 || props.limits.timestampPeriod <= 0.0f)
+    {
+        throw RgException(RG_GRAPHICS_API_ERROR, "GPU profiling is enabled, but graphics queue doesn't support timestamps");
+    }
+
+    timestampPeriod = props.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = GPU_PROFILER_MAX_SCOPE_COUNT * 2;
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        VkResult r = vkCreateQueryPool(device, &poolInfo, nullptr, &frames[i].pool);
+        VK_CHECKERROR(r);
+
+        SET_DEBUG_NAME(device, frames[i].pool, VK_OBJECT_TYPE_QUERY_POOL, "GPU profiler query pool");
+    }
+
+    timestamps.resize(GPU_PROFILER_MAX_SCOPE_COUNT * 2);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    EndFrame();
+
+    for (auto &f : frames)
+    {
+        if (f.pool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, f.pool, nullptr);
+        }
+    }
+}
+
+bool GpuProfiler::ResolveFrame(uint32_t frameIndex)
+{
+    FrameQueries &f = frames[frameIndex];
+
+    if (!f.toResolve)
+    {
+        return false;
+    }
+
+    f.toResolve = false;
+
+    if (f.queryCount > 0)
+    {
+        // the frame's fence was waited, so no VK_QUERY_RESULT_WAIT_BIT
+        VkResult r = vkGetQueryPoolResults(
+            device, f.pool, 0, f.queryCount,
+            f.queryCount * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+
+        if (r != VK_SUCCESS)
+        {
+            // keep the previous results
+            return false;
+        }
+    }
+
+    resolvedFrameId = f.frameId;
+    resolvedRecordEndTime = f.recordEndTime;
+    resolvedScopes.swap(f.scopes);
+    f.scopes.clear();
+
+    resolvedResults.resize(resolvedScopes.size());
+    resolvedBeginOffsets.resize(resolvedScopes.size());
+
+    for (size_t i = 0; i < resolvedScopes.size(); i++)
+    {
+        const Scope &s = resolvedScopes[i];
+        RgGpuTimingScope &dst = resolvedResults[i];
+
+        const uint64_t ticks = (timestamps[s.endQuery] - timestamps[s.beginQuery]) & timestampMask;
+
+        dst.pName = s.name.c_str();
+        dst.parentIndex = s.parentIndex;
+        dst.depth = s.depth;
+        dst.time = (double)ticks * timestampPeriod / 1000000.0;
+
+        const uint64_t offsetTicks = (timestamps[s.beginQuery] - timestamps[resolvedScopes[0].beginQuery]) & timestampMask;
+        resolvedBeginOffsets[i] = (double)offsetTicks * timestampPeriod / 1000000.0;
+    }
+
+    return true;
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex, uint64_t frameId)
+{
+    assert(currentCmd == VK_NULL_HANDLE);
+    assert(frameIndex < framesInFlight);
+
+    FrameQueries &f = frames[frameIndex];
+    assert(!f.toResolve);
+
+    f.scopes.clear();
+    f.queryCount = 0;
+    f.frameId = frameId;
+    f.toResolve = true;
+
+    vkCmdResetQueryPool(cmd, f.pool, 0, GPU_PROFILER_MAX_SCOPE_COUNT * 2);
+
+    currentCmd = cmd;
+    currentFrameIndex = frameIndex;
+    openScopes.clear();
+
+    std::lock_guard<std::mutex> lock(G_ACTIVE_PROFILERS_MUTEX);
+    G_ACTIVE_PROFILERS[cmd] = this;
+    G_ACTIVE_PROFILER_COUNT.store((uint32_t)G_ACTIVE_PROFILERS.size(), std::memory_order_relaxed);
+}
+
+void GpuProfiler::EndFrame()
+{
+    if (currentCmd == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    while (!openScopes.empty())
+    {
+        EndScope();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(G_ACTIVE_PROFILERS_MUTEX);
+        G_ACTIVE_PROFILERS.erase(currentCmd);
+        G_ACTIVE_PROFILER_COUNT.store((uint32_t)G_ACTIVE_PROFILERS.size(), std::memory_order_relaxed);
+    }
+
+    frames[currentFrameIndex].recordEndTime = TraceWriter::Clock::now();
+    currentCmd = VK_NULL_HANDLE;
+}
+
+void GpuProfiler::GetResults(uint64_t *pFrameId, uint32_t *pScopeCount, RgGpuTimingScope *pScopes) const
+{
+    if (pFrameId != nullptr)
+    {
+        *pFrameId = resolvedFrameId;
+    }
+
+    if (pScopes == nullptr)
+    {
+        *pScopeCount = (uint32_t)resolvedResults.size();
+        return;
+    }
+
+    *pScopeCount = std::min(*pScopeCount, (uint32_t)resolvedResults.size());
+
+    for (uint32_t i = 0; i < *pScopeCount; i++)
+    {
+        pScopes[i] = resolvedResults[i];
+    }
+}
+
+void GpuProfiler::WriteResultsToTrace(TraceWriter &writer) const
+{
+    for (size_t i = 0; i < resolvedResults.size(); i++)
+    {
+        auto begin = resolvedRecordEndTime + std::chrono::duration_cast<TraceWriter::Clock::duration>(
+            std::chrono::duration<double, std::milli>(resolvedBeginOffsets[i]));
+
+        writer.AddGpuScope(resolvedResults[i].pName, begin, resolvedResults[i].time);
+    }
+}
+
+void GpuProfiler::BeginScope(const char *pName)
+{
+    FrameQueries &f = frames[currentFrameIndex];
+
+    if (f.queryCount + 2 > GPU_PROFILER_MAX_SCOPE_COUNT * 2)
+    {
+        openScopes.push_back(UINT32_MAX);
+        return;
+    }
+
+    // parent is the nearest open scope that wasn't skipped
+    uint32_t parentIndex = UINT32_MAX;
+
+    for (auto it = openScopes.rbegin(); it != openScopes.rend(); ++it)
+    {
+        if (*it != UINT32_MAX)
+        {
+            parentIndex = *it;
+            break;
+        }
+    }
+
+    Scope s = {};
+    s.name = pName != nullptr ? pName : "";
+    s.parentIndex = parentIndex;
+    s.depth = parentIndex != UINT32_MAX ? f.scopes[parentIndex].depth + 1 : 0;
+    s.beginQuery = f.queryCount;
+    s.endQuery = f.queryCount + 1;
+
+    f.queryCount += 2;
+
+    // wait for the previous commands, to not include their time
+    vkCmdWriteTimestamp(currentCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, f.pool, s.beginQuery);
+
+    openScopes.push_back((uint32_t)f.scopes.size());
+    f.scopes.push_back(std::move(s));
+}
+
+void GpuProfiler::EndScope()
+{
+    if (openScopes.empty())
+    {
+        // label was begun before the frame's command buffer was set
+        return;
+    }
+
+    const uint32_t scopeIndex = openScopes.back();
+    openScopes.pop_back();
+
+    if (scopeIndex == UINT32_MAX)
+    {
+        return;
+    }
+
+    FrameQueries &f = frames[currentFrameIndex];
+    vkCmdWriteTimestamp(currentCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, f.pool, f.scopes[scopeIndex].endQuery);
+}
+
+void GpuProfiler::OnCmdLabelBegin(VkCommandBuffer cmd, const char *pName)
+{
+    if (GpuProfiler *p = FindActiveProfiler(cmd))
+    {
+        p->BeginScope(pName);
+    }
+}
+
+void GpuProfiler::OnCmdLabelEnd(VkCommandBuffer cmd)
+{
+    if (GpuProfiler *p = FindActiveProfiler(cmd))
+    {
+        p->EndScope();
+    }
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "TraceWriter.h"
+#include "RTGL1/RTGL1.h"
+
+namespace RTGL1
+{
+
+// Writes GPU timestamps at the beginning and the end of each command buffer label
+// (see BeginCmdLabel / EndCmdLabel) that is recorded to the frame's command buffer.
+// Each frame in flight has its own query pool, so the results are read
+// after waiting for the frame's fence, without additional stalls.
+class GpuProfiler
+{
+public:
+    explicit GpuProfiler(VkDevice device, VkPhysicalDevice physDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler &other) = delete;
+    GpuProfiler(GpuProfiler &&other) noexcept = delete;
+    GpuProfiler &operator=(const GpuProfiler &other) = delete;
+    GpuProfiler &operator=(GpuProfiler &&other) noexcept = delete;
+
+    // Read the timestamps of the frame that was previously recorded with the same frame index.
+    // The frame's fence must be already signaled. Returns true, if the results were updated.
+    bool ResolveFrame(uint32_t frameIndex);
+
+    // Start writing timestamps for the labels that are recorded to "cmd"
+    void BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex, uint64_t frameId);
+    // Close the remaining scopes and stop writing timestamps to the frame's command buffer
+    void EndFrame();
+
+    // Scopes of the last resolved frame, in the order of their beginning.
+    // Names are valid until the next ResolveFrame call.
+    void GetResults(uint64_t *pFrameId, uint32_t *pScopeCount, RgGpuTimingScope *pScopes) const;
+
+    // Add scopes of the last resolved frame to the trace. GPU and CPU clocks are not
+    // calibrated, so the scopes are placed relative to the end of the frame's recording.
+    void WriteResultsToTrace(TraceWriter &writer) const;
+
+    // Called from BeginCmdLabel / EndCmdLabel
+    static void OnCmdLabelBegin(VkCommandBuffer cmd, const char *pName);
+    static void OnCmdLabelEnd(VkCommandBuffer cmd);
+
+private:
+    void BeginScope(const char *pName);
+    void EndScope();
+
+private:
+    struct Scope
+    {
+        std::string name;
+        uint32_t    parentIndex;
+        uint32_t    depth;
+        uint32_t    beginQuery;
+        uint32_t    endQuery;
+    };
+
+    struct FrameQueries
+    {
+        VkQueryPool         pool;
+        std::vector<Scope>  scopes;
+        uint32_t            queryCount;
+        uint64_t            frameId;
+        // true, if the queries were written and not yet resolved
+        bool                toResolve;
+        // CPU time when the frame's command buffer was finished
+        TraceWriter::Clock::time_point recordEndTime;
+    };
+
+private:
+    VkDevice device;
+    uint32_t framesInFlight;
+
+    // nanoseconds per timestamp tick
+    double timestampPeriod;
+    uint64_t timestampMask;
+
+    FrameQueries frames[MAX_FRAMES_IN_FLIGHT];
+
+    VkCommandBuffer currentCmd;
+    uint32_t currentFrameIndex;
+    // indices of the scopes that are not ended yet, UINT32_MAX if a scope was skipped
+    std::vector<uint32_t> openScopes;
+
+    uint64_t resolvedFrameId;
+    std::vector<Scope> resolvedScopes;
+    std::vector<RgGpuTimingScope> resolvedResults;
+    // in milliseconds, relative to the first scope's beginning
+    std::vector<double> resolvedBeginOffsets;
+    TraceWriter::Clock::time_point resolvedRecordEndTime;
+    std::vector<uint64_t> timestamps;
+};
+
+}
@@ -22,18 +22,210 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
 #include <ktx.h>
 #include <ktxvulkan.h>
 
 using namespace RTGL1;
 
-ImageLoader::ImageLoader(std::shared_ptr<UserFileLoad> _userFileLoad) : userFileLoad(std::move( _userFileLoad))
+namespace
+{
+
+// KTX 2.0 file layout, all values are little-endian
+constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct Ktx2Header
+{
+    uint8_t     identifier[12];
+    uint32_t    vkFormat;
+    uint32_t    typeSize;
+    uint32_t    pixelWidth;
+    uint32_t    pixelHeight;
+    uint32_t    pixelDepth;
+    uint32_t    layerCount;
+    uint32_t    faceCount;
+    uint32_t    levelCount;
+    uint32_t    supercompressionScheme;
+    uint32_t    dfdByteOffset;
+    uint32_t    dfdByteLength;
+    uint32_t    kvdByteOffset;
+    uint32_t    kvdByteLength;
+    uint64_t    sgdByteOffset;
+    uint64_t    sgdByteLength;
+};
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must be 80 bytes");
+
+struct Ktx2LevelIndex
+{
+    uint64_t    byteOffset;
+    uint64_t    byteLength;
+    uint64_t    uncompressedByteLength;
+};
+static_assert(sizeof(Ktx2LevelIndex) == 24, "KTX2 level index entry must be 24 bytes");
+
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZSTD = 2;
+
+struct FormatBlockInfo
+{
+    uint32_t    byteSize;
+    uint32_t    width;
+    uint32_t    height;
+};
+
+// Returns false, if the format is not known, then its data size can't be checked
+bool GetFormatBlockInfo(uint32_t vkFormat, FormatBlockInfo &outInfo)
+{
+    switch (vkFormat)
+    {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SNORM:
+        case VK_FORMAT_R8_UINT:
+        case VK_FORMAT_R8_SINT:
+        case VK_FORMAT_R8_SRGB:
+            outInfo = { 1, 1, 1 };
+            return true;
+
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SNORM:
+        case VK_FORMAT_R8G8_UINT:
+        case VK_FORMAT_R8G8_SINT:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R16_UNORM:
+        case VK_FORMAT_R16_SNORM:
+        case VK_FORMAT_R16_UINT:
+        case VK_FORMAT_R16_SINT:
+        case VK_FORMAT_R16_SFLOAT:
+            outInfo = { 2, 1, 1 };
+            return true;
+
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SNORM:
+        case VK_FORMAT_R8G8B8A8_UINT:
+        case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16_SNORM:
+        case VK_FORMAT_R16G16_UINT:
+        case VK_FORMAT_R16G16_SINT:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_UINT:
+        case VK_FORMAT_R32_SINT:
+        case VK_FORMAT_R32_SFLOAT:
+            outInfo = { 4, 1, 1 };
+            return true;
+
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_UINT:
+        case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_UINT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            outInfo = { 8, 1, 1 };
+            return true;
+
+        case VK_FORMAT_R32G32B32A32_UINT:
+        case VK_FORMAT_R32G32B32A32_SINT:
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            outInfo = { 16, 1, 1 };
+            return true;
+
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+            outInfo = { 8, 4, 4 };
+            return true;
+
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            outInfo = { 16, 4, 4 };
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Size of the level's data, if its images are tightly packed
+uint64_t GetLevelDataSize(const FormatBlockInfo &block, uint32_t baseWidth, uint32_t baseHeight, uint32_t level)
+{
+    const uint64_t width = std::max(baseWidth >> level, 1u);
+    const uint64_t height = std::max(baseHeight >> level, 1u);
+
+    return (width + block.width - 1) / block.width * 
+           ((height + block.height - 1) / block.height) * 
+           block.byteSize;
+}
+
+// Buffer offsets in vkCmdCopyBufferToImage must be multiples of the texel block size and 4,
+// KTX2 requires the same alignment for the levels that are not supercompressed
+uint64_t GetLevelOffsetAlignment(const FormatBlockInfo &block)
+{
+    uint64_t a = block.byteSize, b = 4;
+
+    while (b != 0)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    // lcm
+    return block.byteSize / a * 4;
+}
+
+}
+
+ImageLoader::ImageLoader(std::shared_ptr<UserFileLoad> _userFileLoad, std::shared_ptr<TextureDecoder> _decoder)
+    : userFileLoad(std::move( _userFileLoad)), decoder(std::move(_decoder))
 {}
 
 ImageLoader::~ImageLoader()
 {
     assert(loadedImages.empty());
+    assert(mappedFiles.empty());
+    assert(inflatedImages.empty());
+}
+
+bool ImageLoader::CreateKtxTexture(const uint8_t *pData, size_t dataSize, ktxTexture **ppTexture)
+{
+    KTX_error_code r = ktxTexture_CreateFromMemory(
+        pData, dataSize,
+        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+        ppTexture
+    );
+
+    return r == KTX_SUCCESS;
 }
 
 bool ImageLoader::LoadTextureFile(const char *pFilePath, ktxTexture **ppTexture)
@@ -49,11 +241,7 @@ bool ImageLoader::LoadTextureFile(const char *pFilePath, ktxTexture **ppTexture)
             return false;
         }
 
-        r = ktxTexture_CreateFromMemory(
-            static_cast<const uint8_t *>(fileHandle.pData), fileHandle.dataSize,
-            KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-            ppTexture
-        );
+        return CreateKtxTexture(static_cast<const uint8_t *>(fileHandle.pData), fileHandle.dataSize, ppTexture);
     }
     else
     {
@@ -67,6 +255,164 @@ bool ImageLoader::LoadTextureFile(const char *pFilePath, ktxTexture **ppTexture)
     return r == KTX_SUCCESS;
 }
 
+bool ImageLoader::ParseKtx2(const uint8_t *pFile, size_t fileSize, bool canReferenceFile, ResultInfo *pResultInfo)
+{
+    Ktx2Header header;
+
+    if (fileSize < sizeof(header))
+    {
+        return false;
+    }
+
+    // the file data is not required to be aligned for the header fields
+    memcpy(&header, pFile, sizeof(header));
+
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+    {
+        return false;
+    }
+
+    const bool isZstd = header.supercompressionScheme == KTX2_SUPERCOMPRESSION_ZSTD;
+
+    // only data that can be copied to VkImage as is, or after zstd inflation;
+    // Basis Universal images and other supercompression schemes are processed by libktx
+    if (header.vkFormat == VK_FORMAT_UNDEFINED || (header.supercompressionScheme != 0 && !isZstd))
+    {
+        return false;
+    }
+
+    // inflated levels are stored separately, so the file is not referenced
+    if ((!isZstd && !canReferenceFile) || (isZstd && !decoder))
+    {
+        return false;
+    }
+
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 ||
+        header.layerCount > 1 || header.faceCount != 1)
+    {
+        return false;
+    }
+
+    // level sizes are checked, as the data is copied to VkImage without libktx validation
+    FormatBlockInfo block;
+
+    if (!GetFormatBlockInfo(header.vkFormat, block))
+    {
+        return false;
+    }
+
+    // if 0, there's only the base level
+    const uint32_t levelCount = std::max(header.levelCount, 1u);
+
+    if (fileSize < sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndex))
+    {
+        return false;
+    }
+
+    pResultInfo->levelCount = std::min(levelCount, MAX_PREGENERATED_MIPMAP_LEVELS);
+
+    Ktx2LevelIndex indices[MAX_PREGENERATED_MIPMAP_LEVELS];
+
+    for (uint32_t level = 0; level < pResultInfo->levelCount; level++)
+    {
+        Ktx2LevelIndex &index = indices[level];
+        memcpy(&index, pFile + sizeof(Ktx2Header) + level * sizeof(Ktx2LevelIndex), sizeof(index));
+
+        // written this way to not overflow
+        if (index.byteLength == 0 || index.byteOffset > fileSize || index.byteLength > fileSize - index.byteOffset)
+        {
+            return false;
+        }
+
+        const uint64_t expectedSize = GetLevelDataSize(block, header.pixelWidth, header.pixelHeight, level);
+
+        if ((isZstd ? index.uncompressedByteLength : index.byteLength) != expectedSize)
+        {
+            return false;
+        }
+
+        // the file's offsets are used for copying as is, inflated levels are aligned on their own
+        if (!isZstd && index.byteOffset % GetLevelOffsetAlignment(block) != 0)
+        {
+            return false;
+        }
+    }
+
+    pResultInfo->baseSize = { header.pixelWidth, header.pixelHeight };
+    pResultInfo->format = static_cast<VkFormat>(header.vkFormat);
+    pResultInfo->isPregenerated = true;
+
+    if (!isZstd)
+    {
+        uint64_t dataEnd = 0;
+
+        for (uint32_t level = 0; level < pResultInfo->levelCount; level++)
+        {
+            // offsets are stored as 32-bit values
+            if (indices[level].byteOffset + indices[level].byteLength > UINT32_MAX)
+            {
+                return false;
+            }
+
+            pResultInfo->levelOffsets[level] = static_cast<uint32_t>(indices[level].byteOffset);
+            pResultInfo->levelSizes[level] = static_cast<uint32_t>(indices[level].byteLength);
+
+            dataEnd = std::max(dataEnd, indices[level].byteOffset + indices[level].byteLength);
+        }
+
+        // level offsets are relative to the file start,
+        // so the data includes the header, that's only a few bytes more to copy
+        pResultInfo->pData = pFile;
+        pResultInfo->dataSize = static_cast<uint32_t>(dataEnd);
+
+        return true;
+    }
+
+
+    // levels are inflated to one buffer, each level is a separate job for the decoder
+    uint64_t inflatedSize = 0;
+
+    for (uint32_t level = 0; level < pResultInfo->levelCount; level++)
+    {
+        // as they will be copied to staging with the same offsets
+        inflatedSize = (inflatedSize + TEXTURE_LEVEL_DATA_ALIGNMENT - 1) / TEXTURE_LEVEL_DATA_ALIGNMENT * TEXTURE_LEVEL_DATA_ALIGNMENT;
+
+        if (indices[level].uncompressedByteLength == 0 || inflatedSize + indices[level].uncompressedByteLength > UINT32_MAX)
+        {
+            return false;
+        }
+
+        pResultInfo->levelOffsets[level] = static_cast<uint32_t>(inflatedSize);
+        pResultInfo->levelSizes[level] = static_cast<uint32_t>(indices[level].uncompressedByteLength);
+
+        inflatedSize += indices[level].uncompressedByteLength;
+    }
+
+    std::vector<uint8_t> inflated(static_cast<size_t>(inflatedSize));
+    TextureDecoder::Job jobs[MAX_PREGENERATED_MIPMAP_LEVELS];
+
+    for (uint32_t level = 0; level < pResultInfo->levelCount; level++)
+    {
+        jobs[level].pSrc = pFile + indices[level].byteOffset;
+        jobs[level].srcSize = static_cast<size_t>(indices[level].byteLength);
+        jobs[level].pDst = inflated.data() + pResultInfo->levelOffsets[level];
+        jobs[level].dstSize = pResultInfo->levelSizes[level];
+    }
+
+    if (!decoder->InflateZstd(jobs, pResultInfo->levelCount))
+    {
+        return false;
+    }
+
+    pResultInfo->pData = inflated.data();
+    pResultInfo->dataSize = static_cast<uint32_t>(inflatedSize);
+
+    // moving doesn't change the pointer to the data
+    inflatedImages.push_back(std::move(inflated));
+
+    return true;
+}
+
 bool ImageLoader::Load(const char *pFilePath, ResultInfo *pResultInfo)
 {
     assert(pResultInfo != nullptr);
@@ -79,11 +425,61 @@ bool ImageLoader::Load(const char *pFilePath, ResultInfo *pResultInfo)
     }
 
     ktxTexture *pTexture = nullptr;
-    bool loaded = LoadTextureFile(pFilePath, &pTexture);
 
-    if (!loaded)
+    if (userFileLoad->Exists())
     {
-        return false;
+        auto fileHandle = userFileLoad->Open(pFilePath);
+
+        if (!fileHandle.Contains())
+        {
+            return false;
+        }
+
+        const auto *pFile = static_cast<const uint8_t *>(fileHandle.pData);
+
+        // user's data is valid only until the handle is closed,
+        // so only supercompressed files are parsed here, as they're inflated to separate buffers
+        if (ParseKtx2(pFile, fileHandle.dataSize, false, pResultInfo))
+        {
+            return true;
+        }
+
+        *pResultInfo = {};
+
+        if (!CreateKtxTexture(pFile, fileHandle.dataSize, &pTexture))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // if files are read by the library, map them to avoid
+        // copying the whole file to the heap before copying it to staging
+        auto mapped = std::make_unique<MappedFile>(pFilePath);
+
+        if (!mapped->IsMapped())
+        {
+            return false;
+        }
+
+        if (ParseKtx2(mapped->GetData(), mapped->GetSize(), true, pResultInfo))
+        {
+            // keep the mapping until FreeLoaded, if the data is referenced
+            if (pResultInfo->pData == mapped->GetData())
+            {
+                mappedFiles.push_back(std::move(mapped));
+            }
+
+            return true;
+        }
+
+        *pResultInfo = {};
+
+        // libktx copies the data, so the mapping is not needed after that
+        if (!CreateKtxTexture(mapped->GetData(), mapped->GetSize(), &pTexture))
+        {
+            return false;
+        }
     }
 
     assert(pTexture->numDimensions == 2);
@@ -181,4 +577,6 @@ void ImageLoader::FreeLoaded()
     }
 
     loadedImages.clear();
+    mappedFiles.clear();
+    inflatedImages.clear();
 }
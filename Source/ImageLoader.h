@@ -24,6 +24,8 @@
 
 #include "Common.h"
 #include "Const.h"
+#include "MappedFile.h"
+#include "TextureDecoder.h"
 #include "UserFunction.h"
 
 struct ktxTexture;
@@ -56,7 +58,8 @@ public:
     };
 
 public:
-    explicit ImageLoader(std::shared_ptr<UserFileLoad> userFileLoad);
+    // If decoder is null, supercompressed files are inflated by libktx on the calling thread.
+    explicit ImageLoader(std::shared_ptr<UserFileLoad> userFileLoad, std::shared_ptr<TextureDecoder> decoder = nullptr);
     ~ImageLoader();
 
     ImageLoader(const ImageLoader &other) = delete;
@@ -72,10 +75,19 @@ public:
 
 private:
     bool LoadTextureFile(const char *pFilePath, ktxTexture **ppTexture);
+    static bool CreateKtxTexture(const uint8_t *pData, size_t dataSize, ktxTexture **ppTexture);
+    // Parse KTX2 file in place. If canReferenceFile, the result's data can point to the file,
+    // otherwise only zstd supercompressed files are processed, as they're inflated to a separate buffer.
+    // Returns false, if the file must be processed by libktx.
+    bool ParseKtx2(const uint8_t *pFile, size_t fileSize, bool canReferenceFile, ResultInfo *pResultInfo);
 
 private:
     std::shared_ptr<UserFileLoad> userFileLoad;
     std::vector<void *> loadedImages;
+    std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+
+    std::shared_ptr<TextureDecoder> decoder;
+    std::vector<std::vector<uint8_t>> inflatedImages;
 };
 
 }
\ No newline at end of file
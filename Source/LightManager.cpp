@@ -42,9 +42,11 @@ constexpr uint32_t STEP_LIGHT_COUNT_DIRECTIONAL = 32;
 
 RTGL1::LightManager::LightManager(
     VkDevice _device, 
-    std::shared_ptr<MemoryAllocator> &_allocator)
+    std::shared_ptr<MemoryAllocator> &_allocator,
+    uint32_t _framesInFlight)
 :
     device(_device),
+    framesInFlight(_framesInFlight),
     sphLightCount(0),
     dirLightCount(0),
     sphLightCountPrev(0),
@@ -61,11 +63,13 @@ RTGL1::LightManager::LightManager(
     sphericalLightMatchPrev   = std::make_shared<AutoBuffer>(device, _allocator, "Match previous Lights spherical staging", "Match previous Lights spherical");
     directionalLightMatchPrev = std::make_shared<AutoBuffer>(device, _allocator, "Match previous Lights directional staging", "Match previous Lights directional");
 
-    sphericalLights->Create(sizeof(ShLightSpherical) * maxSphericalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-    directionalLights->Create(sizeof(ShLightDirectional) * maxDirectionalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    // lights are fully rewritten each frame, and descriptor sets are per frame,
+    // so they can be written directly to device local memory, if it's possible
+    sphericalLights->Create(sizeof(ShLightSpherical) * maxSphericalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight, true);
+    directionalLights->Create(sizeof(ShLightDirectional) * maxDirectionalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight, true);
 
-    sphericalLightMatchPrev->Create(sizeof(uint32_t) * maxSphericalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-    directionalLightMatchPrev->Create(sizeof(uint32_t) * maxDirectionalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    sphericalLightMatchPrev->Create(sizeof(uint32_t) * maxSphericalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight, true);
+    directionalLightMatchPrev->Create(sizeof(uint32_t) * maxDirectionalLightCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, framesInFlight, true);
 
     CreateDescriptors();
 }
@@ -94,7 +98,7 @@ void RTGL1::LightManager::PrepareForFrame(uint32_t frameIndex)
 
 void RTGL1::LightManager::Reset()
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         memset(sphericalLightMatchPrev->GetMapped(i), 0xFF, sizeof(uint32_t) * std::max(sphLightCount, dirLightCountPrev));
         memset(directionalLightMatchPrev->GetMapped(i), 0xFF, sizeof(uint32_t) *  std::max(sphLightCount, dirLightCountPrev));
@@ -264,7 +268,7 @@ void RTGL1::LightManager::FillMatchPrev(
     const std::shared_ptr<AutoBuffer> &matchPrev,
     uint32_t curFrameIndex, uint32_t curLightIndex, uint64_t uniqueID)
 {
-    uint32_t prevFrame = (curFrameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+    uint32_t prevFrame = (curFrameIndex + framesInFlight - 1) % framesInFlight;
 
     const std::map<uint64_t, uint32_t> &uniqueToPrevIndex = pUniqueToPrevIndex[prevFrame];
 
@@ -344,11 +348,11 @@ void RTGL1::LightManager::CreateDescriptors()
 
     VkDescriptorPoolSize poolSize = {};
     poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSize.descriptorCount = bindings.size() * MAX_FRAMES_IN_FLIGHT;
+    poolSize.descriptorCount = bindings.size() * framesInFlight;
 
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+    poolInfo.maxSets = framesInFlight;
     poolInfo.poolSizeCount = 1;
     poolInfo.pPoolSizes = &poolSize;
 
@@ -363,7 +367,7 @@ void RTGL1::LightManager::CreateDescriptors()
     allocInfo.descriptorSetCount = 1;
     allocInfo.pSetLayouts = &descSetLayout;
     
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         r = vkAllocateDescriptorSets(device, &allocInfo, &descSets[i]);
         VK_CHECKERROR(r);
@@ -371,7 +375,7 @@ void RTGL1::LightManager::CreateDescriptors()
         SET_DEBUG_NAME(device, descSets[i], VK_OBJECT_TYPE_DESCRIPTOR_SET, "Light buffers Desc set");
     }
     
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         UpdateDescriptors(i);
     }
@@ -380,22 +384,22 @@ void RTGL1::LightManager::CreateDescriptors()
 void RTGL1::LightManager::UpdateDescriptors(uint32_t frameIndex)
 {
     VkDescriptorBufferInfo bfSphInfo = {};
-    bfSphInfo.buffer = sphericalLights->GetDeviceLocal();
+    bfSphInfo.buffer = sphericalLights->GetDeviceLocal(frameIndex);
     bfSphInfo.offset = 0;
     bfSphInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo bfDirInfo = {};
-    bfDirInfo.buffer = directionalLights->GetDeviceLocal();
+    bfDirInfo.buffer = directionalLights->GetDeviceLocal(frameIndex);
     bfDirInfo.offset = 0;
     bfDirInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo bfMpSInfo = {};
-    bfMpSInfo.buffer = sphericalLightMatchPrev->GetDeviceLocal();
+    bfMpSInfo.buffer = sphericalLightMatchPrev->GetDeviceLocal(frameIndex);
     bfMpSInfo.offset = 0;
     bfMpSInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo bfMpDInfo = {};
-    bfMpDInfo.buffer = directionalLightMatchPrev->GetDeviceLocal();
+    bfMpDInfo.buffer = directionalLightMatchPrev->GetDeviceLocal(frameIndex);
     bfMpDInfo.offset = 0;
     bfMpDInfo.range = VK_WHOLE_SIZE;
 
@@ -439,5 +443,3 @@ void RTGL1::LightManager::UpdateDescriptors(uint32_t frameIndex)
 
     vkUpdateDescriptorSets(device, wrts.size(), wrts.data(), 0, nullptr);
 }
-
-static_assert(RTGL1::MAX_FRAMES_IN_FLIGHT == 2, "");
\ No newline at end of file
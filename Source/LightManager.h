@@ -34,7 +34,7 @@ struct ShLightDirectional;
 class LightManager
 {
 public:
-    LightManager(VkDevice device, std::shared_ptr<MemoryAllocator> &allocator);
+    LightManager(VkDevice device, std::shared_ptr<MemoryAllocator> &allocator, uint32_t framesInFlight);
     ~LightManager();
 
     LightManager(const LightManager &other) = delete;
@@ -74,6 +74,7 @@ private:
 
 private:
     VkDevice device;
+    uint32_t framesInFlight;
 
     std::shared_ptr<AutoBuffer> sphericalLights;
     std::shared_ptr<AutoBuffer> directionalLights;
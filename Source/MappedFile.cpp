@@ -0,0 +1,142 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace RTGL1;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char *pFilePath)
+    : pData(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+    fileHandle = CreateFileA(pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart <= 0)
+    {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr)
+    {
+        return;
+    }
+
+    void *pView = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (pView == nullptr)
+    {
+        return;
+    }
+
+    pData = static_cast<const uint8_t *>(pView);
+    size = static_cast<size_t>(fileSize.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+    if (pData != nullptr)
+    {
+        UnmapViewOfFile(pData);
+    }
+
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+    }
+
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const char *pFilePath)
+    : pData(nullptr), size(0)
+{
+    int fd = open(pFilePath, O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return;
+    }
+
+    void *pMapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+
+    if (pMapped == MAP_FAILED)
+    {
+        return;
+    }
+
+    pData = static_cast<const uint8_t *>(pMapped);
+    size = static_cast<size_t>(fileStat.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+    if (pData != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(pData), size);
+    }
+}
+
+#endif
+
+bool MappedFile::IsMapped() const
+{
+    return pData != nullptr;
+}
+
+const uint8_t *MappedFile::GetData() const
+{
+    return pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return size;
+}
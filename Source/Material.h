@@ -31,6 +31,9 @@ struct Texture
     VkImage             image;
     VkImageView         view;
     VkSampler           sampler;
+    // If true, the slot belongs to a material which textures are loaded
+    // asynchronously, and it must not be reused even if there's no image yet
+    bool                isReserved;
 };
 
 union MaterialTextures
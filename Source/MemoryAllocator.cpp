@@ -27,20 +27,24 @@ using namespace RTGL1;
 MemoryAllocator::MemoryAllocator(
     VkInstance _instance,
     VkDevice _device,
-    std::shared_ptr<PhysicalDevice> _physDevice)
+    std::shared_ptr<PhysicalDevice> _physDevice,
+    uint32_t _framesInFlight)
 :
     device(_device),
     physDevice(std::move(_physDevice)),
+    framesInFlight(_framesInFlight),
     allocator(VK_NULL_HANDLE),
     texturesStagingPool(VK_NULL_HANDLE),
-    texturesFinalPool(VK_NULL_HANDLE)
+    texturesFinalPool(VK_NULL_HANDLE),
+    texturesFinalHeapIndex(0),
+    stagingCopiedBytes(0)
 {
     VmaAllocatorCreateInfo allocatorInfo = {};
     allocatorInfo.instance = _instance;
     allocatorInfo.device = device;
     allocatorInfo.physicalDevice = physDevice->Get();
     allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
-    allocatorInfo.frameInUseCount = MAX_FRAMES_IN_FLIGHT;
+    allocatorInfo.frameInUseCount = framesInFlight;
 
     allocatorInfo.flags =
         // currently, the library uses only one thread
@@ -176,7 +180,7 @@ void MemoryAllocator::CreateTexturesStagingPool()
     VK_CHECKERROR(r);
 
     VmaPoolCreateInfo poolInfo = {};
-    poolInfo.frameInUseCount = MAX_FRAMES_IN_FLIGHT;
+    poolInfo.frameInUseCount = framesInFlight;
     poolInfo.memoryTypeIndex = memTypeIndex;
     poolInfo.blockSize = ALLOCATOR_BLOCK_SIZE_STAGING_TEXTURES;
     // buddy algorithm as textures has commonly a size of power of 2
@@ -212,8 +216,10 @@ void MemoryAllocator::CreateTexturesFinalPool()
     r = vmaFindMemoryTypeIndexForImageInfo(allocator, &imageInfo, &prototype, &memTypeIndex);
     VK_CHECKERROR(r);
 
+    texturesFinalHeapIndex = physDevice->GetMemoryProperties().memoryTypes[memTypeIndex].heapIndex;
+
     VmaPoolCreateInfo poolInfo = {};
-    poolInfo.frameInUseCount = MAX_FRAMES_IN_FLIGHT;
+    poolInfo.frameInUseCount = framesInFlight;
     poolInfo.memoryTypeIndex = memTypeIndex;
     poolInfo.blockSize = ALLOCATOR_BLOCK_SIZE_TEXTURES;
     // buddy algorithm as textures has commonly a size of power of 2
@@ -228,6 +234,30 @@ VkDevice MemoryAllocator::GetDevice()
     return device;
 }
 
+void MemoryAllocator::RegisterStagingCopy(VkDeviceSize size)
+{
+    stagingCopiedBytes += size;
+}
+
+VkDeviceSize MemoryAllocator::PopStagingCopiedBytes()
+{
+    return stagingCopiedBytes.exchange(0);
+}
+
+void MemoryAllocator::GetTextureHeapBudget(VkDeviceSize *pOutUsage, VkDeviceSize *pOutBudget) const
+{
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+    vmaGetBudget(allocator, budgets);
+
+    *pOutUsage = budgets[texturesFinalHeapIndex].usage;
+    *pOutBudget = budgets[texturesFinalHeapIndex].budget;
+}
+
+bool MemoryAllocator::IsDirectWriteAvailable() const
+{
+    return physDevice->IsDirectWriteMemoryAvailable();
+}
+
 VkDeviceMemory MemoryAllocator::AllocDedicated(const VkMemoryRequirements &memReqs, VkMemoryPropertyFlags properties,
                                                bool addressQuery) const
 {
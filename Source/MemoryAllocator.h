@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 
 #include "Common.h"
@@ -36,7 +37,8 @@ public:
     explicit MemoryAllocator(
         VkInstance instance,
         VkDevice device,
-        std::shared_ptr<PhysicalDevice> physDevice);
+        std::shared_ptr<PhysicalDevice> physDevice,
+        uint32_t framesInFlight);
     ~MemoryAllocator();
 
     MemoryAllocator(const MemoryAllocator &other) = delete;
@@ -52,6 +54,10 @@ public:
     VkDeviceMemory AllocDedicated(const VkMemoryRequirements2 &memReqs2, VkMemoryPropertyFlags properties, bool addressQuery = false) const;
     void FreeDedicated(VkDeviceMemory memory) const;
 
+    // If true, buffers with per-frame data can be allocated in memory that is
+    // device-local and host-visible at once, and written without staging copies
+    bool IsDirectWriteAvailable() const;
+
     
     VkBuffer CreateStagingSrcTextureBuffer(
         const VkBufferCreateInfo *info, 
@@ -63,6 +69,16 @@ public:
     void DestroyStagingSrcTextureBuffer(VkBuffer buffer);
     void DestroyTextureImage(VkImage image);
 
+    // Get current usage and budget of the memory heap that textures are allocated
+    // from. If VK_EXT_memory_budget is not enabled, the values are estimated by VMA.
+    void GetTextureHeapBudget(VkDeviceSize *pOutUsage, VkDeviceSize *pOutBudget) const;
+
+    // Accumulate the size of data that was copied from
+    // staging buffers to device-local ones, for frame statistics
+    void RegisterStagingCopy(VkDeviceSize size);
+    // Get the accumulated size and reset it
+    VkDeviceSize PopStagingCopiedBytes();
+
 private:
     void CreateTexturesStagingPool();
     void CreateTexturesFinalPool();
@@ -70,6 +86,7 @@ private:
 private:
     VkDevice device;
     std::shared_ptr<PhysicalDevice> physDevice;
+    uint32_t framesInFlight;
 
     VmaAllocator allocator;
 
@@ -78,10 +95,13 @@ private:
     // pool for images, GPU_ONLY
     // texture data will be copied from staging to this memory
     VmaPool texturesFinalPool;
+    uint32_t texturesFinalHeapIndex;
 
     // maps for freeing corresponding allocations
     std::map<VkBuffer, VmaAllocation> bufAllocs;
     std::map<VkImage, VmaAllocation> imgAllocs;
+
+    std::atomic<VkDeviceSize> stagingCopiedBytes;
 };
 
 }
\ No newline at end of file
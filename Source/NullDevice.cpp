@@ -0,0 +1,1234 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Null device: a CPU stand-in for the Vulkan entry points that the library uses.
+// It's compiled instead of linking the Vulkan loader, if RG_WITH_NULL_DEVICE is ON.
+// All the library's code (scene, AS manager, vertex collectors, texture manager, etc)
+// is executed as usual, but the GPU work is not. Host-visible memory is allocated
+// from the heap, so the staging buffers are real; device-local memory is not backed,
+// only its size is accounted. Commands are "executed" at record time, so fences
+// and semaphores are always signaled.
+
+#ifdef RG_USE_NULL_DEVICE
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+static_assert(sizeof(void *) == 8, "Null device requires 64-bit target, as Vulkan handles are treated as pointers");
+
+
+#pragma region objects
+
+struct VkPhysicalDevice_T
+{};
+
+struct VkInstance_T
+{
+    VkPhysicalDevice_T physDevice;
+};
+
+struct VkQueue_T
+{};
+
+struct VkDevice_T
+{
+    VkQueue_T queue;
+};
+
+struct VkCommandBuffer_T
+{
+    bool isRecording = false;
+};
+
+struct VkCommandPool_T
+{
+    std::vector<std::unique_ptr<VkCommandBuffer_T>> cmds;
+};
+
+struct VkDeviceMemory_T
+{
+    VkDeviceSize                size = 0;
+    uint32_t                    memoryTypeIndex = 0;
+    // only for host-visible memory
+    std::unique_ptr<uint8_t[]>  data;
+    // device-local memory has no backing, so fake addresses are used
+    VkDeviceAddress             baseAddress = 0;
+};
+
+struct VkBuffer_T
+{
+    VkDeviceSize        size = 0;
+    VkDeviceMemory_T    *memory = nullptr;
+    VkDeviceSize        memoryOffset = 0;
+};
+
+struct VkImage_T
+{
+    VkDeviceSize        size = 0;
+    VkDeviceMemory_T    *memory = nullptr;
+};
+
+struct VkAccelerationStructureKHR_T
+{
+    VkBuffer_T          *buffer = nullptr;
+    VkDeviceSize        offset = 0;
+};
+
+struct VkSwapchainKHR_T
+{
+    std::vector<std::unique_ptr<VkImage_T>> images;
+    uint32_t            currentImage = 0;
+};
+
+struct VkDescriptorSet_T
+{};
+
+struct VkDescriptorPool_T
+{
+    std::vector<std::unique_ptr<VkDescriptorSet_T>> sets;
+};
+
+// objects that don't have any state
+struct VkSurfaceKHR_T {};
+struct VkImageView_T {};
+struct VkSampler_T {};
+struct VkFence_T {};
+struct VkSemaphore_T {};
+struct VkShaderModule_T {};
+struct VkPipeline_T {};
+struct VkPipelineLayout_T {};
+struct VkPipelineCache_T {};
+struct VkDescriptorSetLayout_T {};
+struct VkRenderPass_T {};
+struct VkFramebuffer_T {};
+struct VkQueryPool_T {};
+struct VkDebugUtilsMessengerEXT_T {};
+
+#pragma endregion
+
+
+namespace
+{
+
+enum NullMemoryType : uint32_t
+{
+    NULL_MEMORY_TYPE_DEVICE_LOCAL,
+    NULL_MEMORY_TYPE_HOST_COHERENT,
+    NULL_MEMORY_TYPE_HOST_CACHED,
+    NULL_MEMORY_TYPE_COUNT
+};
+
+constexpr uint32_t      NULL_MEMORY_TYPE_BITS_ALL   = (1u << NULL_MEMORY_TYPE_COUNT) - 1;
+constexpr VkDeviceSize  NULL_MEMORY_ALIGNMENT       = 256;
+constexpr VkDeviceSize  NULL_DEVICE_LOCAL_HEAP_SIZE = 8ull * 1024 * 1024 * 1024;
+constexpr VkDeviceSize  NULL_HOST_HEAP_SIZE         = 16ull * 1024 * 1024 * 1024;
+constexpr uint32_t      NULL_SHADER_GROUP_HANDLE_SIZE = 32;
+
+// far from any heap pointer, to distinguish fake device addresses while debugging
+VkDeviceAddress G_NEXT_FAKE_ADDRESS = 0x0100000000000000ull;
+
+bool IsHostVisible(uint32_t memoryTypeIndex)
+{
+    return memoryTypeIndex != NULL_MEMORY_TYPE_DEVICE_LOCAL;
+}
+
+VkDeviceSize Align(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename Handle>
+Handle CreateObject()
+{
+    using T = typename std::remove_pointer<Handle>::type;
+    return new T();
+}
+
+template <typename Handle>
+void DestroyObject(Handle h)
+{
+    delete h;
+}
+
+VkDeviceAddress GetAddress(const VkBuffer_T *b)
+{
+    if (b == nullptr || b->memory == nullptr)
+    {
+        return 0;
+    }
+
+    if (b->memory->data)
+    {
+        return reinterpret_cast<VkDeviceAddress>(b->memory->data.get()) + b->memoryOffset;
+    }
+
+    return b->memory->baseAddress + b->memoryOffset;
+}
+
+uint8_t *GetHostPointer(const VkBuffer_T *b)
+{
+    if (b == nullptr || b->memory == nullptr || !b->memory->data)
+    {
+        return nullptr;
+    }
+
+    return b->memory->data.get() + b->memoryOffset;
+}
+
+void FillMemoryRequirements(VkDeviceSize size, VkMemoryRequirements *pRequirements)
+{
+    pRequirements->size = Align(std::max<VkDeviceSize>(size, 1), NULL_MEMORY_ALIGNMENT);
+    pRequirements->alignment = NULL_MEMORY_ALIGNMENT;
+    pRequirements->memoryTypeBits = NULL_MEMORY_TYPE_BITS_ALL;
+}
+
+void FillDedicatedRequirements(void *pNext)
+{
+    for (auto *s = static_cast<VkBaseOutStructure *>(pNext); s != nullptr; s = s->pNext)
+    {
+        if (s->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS)
+        {
+            auto *d = reinterpret_cast<VkMemoryDedicatedRequirements *>(s);
+            d->prefersDedicatedAllocation = VK_FALSE;
+            d->requiresDedicatedAllocation = VK_FALSE;
+        }
+    }
+}
+
+VkDeviceSize GetImageSize(const VkImageCreateInfo *pInfo)
+{
+    // assume 8 bytes per texel, it's enough for accounting
+    VkDeviceSize size =
+        (VkDeviceSize)pInfo->extent.width * pInfo->extent.height * pInfo->extent.depth *
+        pInfo->arrayLayers * 8;
+
+    // mip chain is less than 1/3 of the base level
+    if (pInfo->mipLevels > 1)
+    {
+        size += size / 3;
+    }
+
+    return size;
+}
+
+void FillMemoryProperties(VkPhysicalDeviceMemoryProperties *pProperties)
+{
+    *pProperties = {};
+
+    pProperties->memoryHeapCount = 2;
+    pProperties->memoryHeaps[0].size = NULL_DEVICE_LOCAL_HEAP_SIZE;
+    pProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    pProperties->memoryHeaps[1].size = NULL_HOST_HEAP_SIZE;
+    pProperties->memoryHeaps[1].flags = 0;
+
+    pProperties->memoryTypeCount = NULL_MEMORY_TYPE_COUNT;
+
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_DEVICE_LOCAL].heapIndex = 0;
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_DEVICE_LOCAL].propertyFlags =
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_HOST_COHERENT].heapIndex = 1;
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_HOST_COHERENT].propertyFlags =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_HOST_CACHED].heapIndex = 1;
+    pProperties->memoryTypes[NULL_MEMORY_TYPE_HOST_CACHED].propertyFlags =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+}
+
+void FillProperties(VkPhysicalDeviceProperties *pProperties)
+{
+    *pProperties = {};
+
+    pProperties->apiVersion = VK_API_VERSION_1_2;
+    pProperties->driverVersion = 1;
+    pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    strncpy(pProperties->deviceName, "RTGL1 Null Device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+
+    VkPhysicalDeviceLimits &l = pProperties->limits;
+    l.maxImageDimension1D = 16384;
+    l.maxImageDimension2D = 16384;
+    l.maxImageDimension3D = 2048;
+    l.maxImageDimensionCube = 16384;
+    l.maxImageArrayLayers = 2048;
+    l.maxUniformBufferRange = 65536;
+    l.maxStorageBufferRange = UINT32_MAX;
+    l.maxPushConstantsSize = 256;
+    l.maxMemoryAllocationCount = 4096;
+    l.maxSamplerAllocationCount = 4000;
+    l.bufferImageGranularity = 1;
+    l.maxBoundDescriptorSets = 32;
+    l.maxComputeWorkGroupCount[0] = l.maxComputeWorkGroupCount[1] = l.maxComputeWorkGroupCount[2] = 65535;
+    l.maxComputeWorkGroupInvocations = 1024;
+    l.maxComputeWorkGroupSize[0] = l.maxComputeWorkGroupSize[1] = 1024;
+    l.maxComputeWorkGroupSize[2] = 64;
+    l.maxViewports = 16;
+    l.maxViewportDimensions[0] = l.maxViewportDimensions[1] = 16384;
+    l.maxFramebufferWidth = l.maxFramebufferHeight = 16384;
+    l.maxFramebufferLayers = 2048;
+    l.maxColorAttachments = 8;
+    l.maxSamplerAnisotropy = 16.0f;
+    l.minMemoryMapAlignment = 64;
+    l.minTexelBufferOffsetAlignment = 16;
+    l.minUniformBufferOffsetAlignment = 256;
+    l.minStorageBufferOffsetAlignment = 64;
+    l.timestampComputeAndGraphics = VK_TRUE;
+    l.timestampPeriod = 1.0f;
+    l.optimalBufferCopyOffsetAlignment = 1;
+    l.optimalBufferCopyRowPitchAlignment = 1;
+    l.nonCoherentAtomSize = 64;
+}
+
+VkDeviceSize GetASSize(const VkAccelerationStructureBuildGeometryInfoKHR *pBuildInfo, const uint32_t *pMaxPrimitiveCounts, VkDeviceSize bytesPerPrimitive)
+{
+    VkDeviceSize size = NULL_MEMORY_ALIGNMENT;
+
+    for (uint32_t i = 0; i < pBuildInfo->geometryCount; i++)
+    {
+        size += (VkDeviceSize)pMaxPrimitiveCounts[i] * bytesPerPrimitive;
+    }
+
+    return Align(size, NULL_MEMORY_ALIGNMENT);
+}
+
+}
+
+
+extern "C"
+{
+
+#pragma region instance
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkInstance *pInstance)
+{
+    *pInstance = CreateObject<VkInstance>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(instance);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance instance, uint32_t *pPhysicalDeviceCount, VkPhysicalDevice *pPhysicalDevices)
+{
+    if (pPhysicalDevices == nullptr)
+    {
+        *pPhysicalDeviceCount = 1;
+        return VK_SUCCESS;
+    }
+
+    if (*pPhysicalDeviceCount < 1)
+    {
+        return VK_INCOMPLETE;
+    }
+
+    *pPhysicalDeviceCount = 1;
+    pPhysicalDevices[0] = &instance->physDevice;
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2 *pFeatures)
+{
+    // everything is supported, as nothing is executed
+    VkBool32 *f = &pFeatures->features.robustBufferAccess;
+    for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); i++)
+    {
+        f[i] = VK_TRUE;
+    }
+
+    for (auto *s = static_cast<VkBaseOutStructure *>(pFeatures->pNext); s != nullptr; s = s->pNext)
+    {
+        switch (s->sType)
+        {
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR:
+                reinterpret_cast<VkPhysicalDeviceRayTracingPipelineFeaturesKHR *>(s)->rayTracingPipeline = VK_TRUE;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR:
+                reinterpret_cast<VkPhysicalDeviceAccelerationStructureFeaturesKHR *>(s)->accelerationStructure = VK_TRUE;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES:
+                reinterpret_cast<VkPhysicalDeviceBufferDeviceAddressFeatures *>(s)->bufferDeviceAddress = VK_TRUE;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES:
+            {
+                auto *d = reinterpret_cast<VkPhysicalDeviceDescriptorIndexingFeatures *>(s);
+                d->runtimeDescriptorArray = VK_TRUE;
+                d->shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                d->shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+    FillProperties(pProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2 *pProperties)
+{
+    FillProperties(&pProperties->properties);
+
+    for (auto *s = static_cast<VkBaseOutStructure *>(pProperties->pNext); s != nullptr; s = s->pNext)
+    {
+        switch (s->sType)
+        {
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR:
+            {
+                auto *p = reinterpret_cast<VkPhysicalDeviceRayTracingPipelinePropertiesKHR *>(s);
+                p->shaderGroupHandleSize = NULL_SHADER_GROUP_HANDLE_SIZE;
+                p->maxRayRecursionDepth = 31;
+                p->maxShaderGroupStride = 4096;
+                p->shaderGroupBaseAlignment = 64;
+                p->shaderGroupHandleCaptureReplaySize = NULL_SHADER_GROUP_HANDLE_SIZE;
+                p->maxRayDispatchInvocationCount = 1 << 30;
+                p->shaderGroupHandleAlignment = NULL_SHADER_GROUP_HANDLE_SIZE;
+                p->maxRayHitAttributeSize = 32;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR:
+            {
+                auto *p = reinterpret_cast<VkPhysicalDeviceAccelerationStructurePropertiesKHR *>(s);
+                p->maxGeometryCount = 1 << 24;
+                p->maxInstanceCount = 1 << 24;
+                p->maxPrimitiveCount = 1 << 29;
+                p->maxPerStageDescriptorAccelerationStructures = 16;
+                p->maxDescriptorSetAccelerationStructures = 16;
+                p->minAccelerationStructureScratchOffsetAlignment = 128;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+{
+    FillMemoryProperties(pMemoryProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2 *pMemoryProperties)
+{
+    FillMemoryProperties(&pMemoryProperties->memoryProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties *pFormatProperties)
+{
+    const VkFormatFeatureFlags all =
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT |
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT |
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+        VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+        VK_FORMAT_FEATURE_TRANSFER_SRC_BIT |
+        VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+    pFormatProperties->linearTilingFeatures = all;
+    pFormatProperties->optimalTilingFeatures = all;
+    pFormatProperties->bufferFeatures = VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT | VK_FORMAT_FEATURE_ACCELERATION_STRUCTURE_VERTEX_BUFFER_BIT_KHR;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+{
+    if (pQueueFamilyProperties == nullptr)
+    {
+        *pQueueFamilyPropertyCount = 1;
+        return;
+    }
+
+    if (*pQueueFamilyPropertyCount < 1)
+    {
+        return;
+    }
+
+    *pQueueFamilyPropertyCount = 1;
+
+    pQueueFamilyProperties[0] = {};
+    pQueueFamilyProperties[0].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+    pQueueFamilyProperties[0].queueCount = 1;
+    pQueueFamilyProperties[0].timestampValidBits = 64;
+    pQueueFamilyProperties[0].minImageTransferGranularity = { 1, 1, 1 };
+}
+
+#pragma endregion
+
+
+
+#pragma region surface
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(VkInstance instance, const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSurfaceKHR *pSurface)
+{
+    *pSurface = CreateObject<VkSurfaceKHR>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySurfaceKHR(VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(surface);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR surface, VkBool32 *pSupported)
+{
+    *pSupported = VK_TRUE;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR *pSurfaceCapabilities)
+{
+    *pSurfaceCapabilities = {};
+
+    // headless surface: extent is determined by the swapchain
+    pSurfaceCapabilities->currentExtent = { UINT32_MAX, UINT32_MAX };
+    pSurfaceCapabilities->minImageExtent = { 1, 1 };
+    pSurfaceCapabilities->maxImageExtent = { 16384, 16384 };
+    pSurfaceCapabilities->minImageCount = 2;
+    pSurfaceCapabilities->maxImageCount = 8;
+    pSurfaceCapabilities->maxImageArrayLayers = 1;
+    pSurfaceCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    pSurfaceCapabilities->supportedUsageFlags =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pSurfaceFormatCount, VkSurfaceFormatKHR *pSurfaceFormats)
+{
+    const VkSurfaceFormatKHR formats[] =
+    {
+        { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+        { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    };
+    const uint32_t count = sizeof(formats) / sizeof(formats[0]);
+
+    if (pSurfaceFormats == nullptr)
+    {
+        *pSurfaceFormatCount = count;
+        return VK_SUCCESS;
+    }
+
+    *pSurfaceFormatCount = std::min(*pSurfaceFormatCount, count);
+    memcpy(pSurfaceFormats, formats, *pSurfaceFormatCount * sizeof(VkSurfaceFormatKHR));
+
+    return *pSurfaceFormatCount < count ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pPresentModeCount, VkPresentModeKHR *pPresentModes)
+{
+    const VkPresentModeKHR modes[] =
+    {
+        VK_PRESENT_MODE_FIFO_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+    };
+    const uint32_t count = sizeof(modes) / sizeof(modes[0]);
+
+    if (pPresentModes == nullptr)
+    {
+        *pPresentModeCount = count;
+        return VK_SUCCESS;
+    }
+
+    *pPresentModeCount = std::min(*pPresentModeCount, count);
+    memcpy(pPresentModes, modes, *pPresentModeCount * sizeof(VkPresentModeKHR));
+
+    return *pPresentModeCount < count ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSwapchainKHR *pSwapchain)
+{
+    VkSwapchainKHR s = CreateObject<VkSwapchainKHR>();
+
+    for (uint32_t i = 0; i < pCreateInfo->minImageCount; i++)
+    {
+        s->images.emplace_back(new VkImage_T());
+    }
+
+    *pSwapchain = s;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(swapchain);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t *pSwapchainImageCount, VkImage *pSwapchainImages)
+{
+    const uint32_t count = static_cast<uint32_t>(swapchain->images.size());
+
+    if (pSwapchainImages == nullptr)
+    {
+        *pSwapchainImageCount = count;
+        return VK_SUCCESS;
+    }
+
+    *pSwapchainImageCount = std::min(*pSwapchainImageCount, count);
+
+    for (uint32_t i = 0; i < *pSwapchainImageCount; i++)
+    {
+        pSwapchainImages[i] = swapchain->images[i].get();
+    }
+
+    return *pSwapchainImageCount < count ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t *pImageIndex)
+{
+    swapchain->currentImage = (swapchain->currentImage + 1) % static_cast<uint32_t>(swapchain->images.size());
+
+    *pImageIndex = swapchain->currentImage;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *pPresentInfo)
+{
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+
+
+#pragma region device
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDevice *pDevice)
+{
+    *pDevice = CreateObject<VkDevice>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(device);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue *pQueue)
+{
+    // single queue for everything
+    *pQueue = &device->queue;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice device)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueWaitIdle(VkQueue queue)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits, VkFence fence)
+{
+    // commands were already "executed" at record time
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFence(VkDevice device, const VkFenceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkFence *pFence)
+{
+    *pFence = CreateObject<VkFence>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(fence);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetFenceStatus(VkDevice device, VkFence fence)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences, VkBool32 waitAll, uint64_t timeout)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSemaphore *pSemaphore)
+{
+    *pSemaphore = CreateObject<VkSemaphore>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(semaphore);
+}
+
+#pragma endregion
+
+
+
+#pragma region memory
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo *pAllocateInfo, const VkAllocationCallbacks *pAllocator, VkDeviceMemory *pMemory)
+{
+    if (pAllocateInfo->memoryTypeIndex >= NULL_MEMORY_TYPE_COUNT)
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    VkDeviceMemory m = CreateObject<VkDeviceMemory>();
+    m->size = pAllocateInfo->allocationSize;
+    m->memoryTypeIndex = pAllocateInfo->memoryTypeIndex;
+
+    if (IsHostVisible(m->memoryTypeIndex))
+    {
+        // not initialized, so untouched pages don't contribute to RSS
+        m->data.reset(new (std::nothrow) uint8_t[m->size]);
+
+        if (!m->data)
+        {
+            DestroyObject(m);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+    else
+    {
+        m->baseAddress = G_NEXT_FAKE_ADDRESS;
+        G_NEXT_FAKE_ADDRESS += Align(m->size, NULL_MEMORY_ALIGNMENT);
+    }
+
+    *pMemory = m;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(memory);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void **ppData)
+{
+    if (!memory->data)
+    {
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+
+    *ppData = memory->data.get() + offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(VkDevice device, const VkBufferCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkBuffer *pBuffer)
+{
+    VkBuffer b = CreateObject<VkBuffer>();
+    b->size = pCreateInfo->size;
+
+    *pBuffer = b;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(buffer);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(VkDevice device, const VkImageCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkImage *pImage)
+{
+    VkImage i = CreateObject<VkImage>();
+    i->size = GetImageSize(pCreateInfo);
+
+    *pImage = i;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(image);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)
+{
+    FillMemoryRequirements(buffer->size, pMemoryRequirements);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)
+{
+    FillMemoryRequirements(image->size, pMemoryRequirements);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(VkDevice device, const VkBufferMemoryRequirementsInfo2 *pInfo, VkMemoryRequirements2 *pMemoryRequirements)
+{
+    FillMemoryRequirements(pInfo->buffer->size, &pMemoryRequirements->memoryRequirements);
+    FillDedicatedRequirements(pMemoryRequirements->pNext);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(VkDevice device, const VkImageMemoryRequirementsInfo2 *pInfo, VkMemoryRequirements2 *pMemoryRequirements)
+{
+    FillMemoryRequirements(pInfo->image->size, &pMemoryRequirements->memoryRequirements);
+    FillDedicatedRequirements(pMemoryRequirements->pNext);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    buffer->memory = memory;
+    buffer->memoryOffset = memoryOffset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    image->memory = memory;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory2(VkDevice device, uint32_t bindInfoCount, const VkBindBufferMemoryInfo *pBindInfos)
+{
+    for (uint32_t i = 0; i < bindInfoCount; i++)
+    {
+        vkBindBufferMemory(device, pBindInfos[i].buffer, pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory2(VkDevice device, uint32_t bindInfoCount, const VkBindImageMemoryInfo *pBindInfos)
+{
+    for (uint32_t i = 0; i < bindInfoCount; i++)
+    {
+        vkBindImageMemory(device, pBindInfos[i].image, pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkDeviceAddress VKAPI_CALL vkGetBufferDeviceAddress(VkDevice device, const VkBufferDeviceAddressInfo *pInfo)
+{
+    return GetAddress(pInfo->buffer);
+}
+
+#pragma endregion
+
+
+
+#pragma region objects without state
+
+#define NULL_DEVICE_SIMPLE_OBJECT(Type, CreateInfoType)                                         \
+    VKAPI_ATTR VkResult VKAPI_CALL vkCreate##Type(VkDevice device, const CreateInfoType *pCreateInfo, \
+                                                  const VkAllocationCallbacks *pAllocator, Vk##Type *pObject) \
+    {                                                                                           \
+        *pObject = CreateObject<Vk##Type>();                                                    \
+        return VK_SUCCESS;                                                                      \
+    }                                                                                           \
+    VKAPI_ATTR void VKAPI_CALL vkDestroy##Type(VkDevice device, Vk##Type object,                \
+                                               const VkAllocationCallbacks *pAllocator)         \
+    {                                                                                           \
+        DestroyObject(object);                                                                  \
+    }
+
+NULL_DEVICE_SIMPLE_OBJECT(ImageView,            VkImageViewCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(Sampler,              VkSamplerCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(ShaderModule,         VkShaderModuleCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(PipelineLayout,       VkPipelineLayoutCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(PipelineCache,        VkPipelineCacheCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(DescriptorSetLayout,  VkDescriptorSetLayoutCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(RenderPass,           VkRenderPassCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(Framebuffer,          VkFramebufferCreateInfo)
+NULL_DEVICE_SIMPLE_OBJECT(QueryPool,            VkQueryPoolCreateInfo)
+
+#undef NULL_DEVICE_SIMPLE_OBJECT
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    for (uint32_t i = 0; i < createInfoCount; i++)
+    {
+        pPipelines[i] = CreateObject<VkPipeline>();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    for (uint32_t i = 0; i < createInfoCount; i++)
+    {
+        pPipelines[i] = CreateObject<VkPipeline>();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(pipeline);
+}
+
+#pragma endregion
+
+
+
+#pragma region descriptors
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorPool *pDescriptorPool)
+{
+    *pDescriptorPool = CreateObject<VkDescriptorPool>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks *pAllocator)
+{
+    // sets are destroyed with the pool
+    DestroyObject(descriptorPool);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo *pAllocateInfo, VkDescriptorSet *pDescriptorSets)
+{
+    VkDescriptorPool pool = pAllocateInfo->descriptorPool;
+
+    for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++)
+    {
+        pool->sets.emplace_back(new VkDescriptorSet_T());
+        pDescriptorSets[i] = pool->sets.back().get();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)
+{}
+
+#pragma endregion
+
+
+
+#pragma region command buffers
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkCommandPool *pCommandPool)
+{
+    *pCommandPool = CreateObject<VkCommandPool>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks *pAllocator)
+{
+    // cmd buffers are destroyed with the pool
+    DestroyObject(commandPool);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice device, VkCommandPool commandPool, VkCommandPoolResetFlags flags)
+{
+    for (auto &c : commandPool->cmds)
+    {
+        c->isRecording = false;
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo *pAllocateInfo, VkCommandBuffer *pCommandBuffers)
+{
+    VkCommandPool pool = pAllocateInfo->commandPool;
+
+    for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++)
+    {
+        pool->cmds.emplace_back(new VkCommandBuffer_T());
+        pCommandBuffers[i] = pool->cmds.back().get();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo *pBeginInfo)
+{
+    commandBuffer->isRecording = true;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    commandBuffer->isRecording = false;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *pRegions)
+{
+    uint8_t *src = GetHostPointer(srcBuffer);
+    uint8_t *dst = GetHostPointer(dstBuffer);
+
+    // device-local memory is not backed, so the copy is done only between host-visible buffers
+    if (src == nullptr || dst == nullptr)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < regionCount; i++)
+    {
+        memmove(dst + pRegions[i].dstOffset, src + pRegions[i].srcOffset, pRegions[i].size);
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageBlit *pRegions, VkFilter filter)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin, VkSubpassContents contents)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *pBuffers, const VkDeviceSize *pOffsets)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *pValues)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport *pViewports)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D *pScissors)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount, const VkClearAttachment *pAttachments, uint32_t rectCount, const VkClearRect *pRects)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void *pData, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+    // no GPU work is done, so all timestamps and compacted AS sizes are zero
+    memset(pData, 0, dataSize);
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+
+
+#pragma region extension functions
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateAccelerationStructureKHR(VkDevice device, const VkAccelerationStructureCreateInfoKHR *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkAccelerationStructureKHR *pAccelerationStructure)
+{
+    VkAccelerationStructureKHR as = CreateObject<VkAccelerationStructureKHR>();
+    as->buffer = pCreateInfo->buffer;
+    as->offset = pCreateInfo->offset;
+
+    *pAccelerationStructure = as;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyAccelerationStructureKHR(VkDevice device, VkAccelerationStructureKHR accelerationStructure, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(accelerationStructure);
+}
+
+VKAPI_ATTR VkDeviceAddress VKAPI_CALL vkGetAccelerationStructureDeviceAddressKHR(VkDevice device, const VkAccelerationStructureDeviceAddressInfoKHR *pInfo)
+{
+    return GetAddress(pInfo->accelerationStructure->buffer) + pInfo->accelerationStructure->offset;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetAccelerationStructureBuildSizesKHR(VkDevice device, VkAccelerationStructureBuildTypeKHR buildType, const VkAccelerationStructureBuildGeometryInfoKHR *pBuildInfo, const uint32_t *pMaxPrimitiveCounts, VkAccelerationStructureBuildSizesInfoKHR *pSizeInfo)
+{
+    // rough estimations of BVH node sizes
+    pSizeInfo->accelerationStructureSize = GetASSize(pBuildInfo, pMaxPrimitiveCounts, 128);
+    pSizeInfo->buildScratchSize = GetASSize(pBuildInfo, pMaxPrimitiveCounts, 64);
+    pSizeInfo->updateScratchSize = GetASSize(pBuildInfo, pMaxPrimitiveCounts, 32);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBuildAccelerationStructuresKHR(VkCommandBuffer commandBuffer, uint32_t infoCount, const VkAccelerationStructureBuildGeometryInfoKHR *pInfos, const VkAccelerationStructureBuildRangeInfoKHR *const *ppBuildRangeInfos)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteAccelerationStructuresPropertiesKHR(VkCommandBuffer commandBuffer, uint32_t accelerationStructureCount, const VkAccelerationStructureKHR *pAccelerationStructures, VkQueryType queryType, VkQueryPool queryPool, uint32_t firstQuery)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyAccelerationStructureKHR(VkCommandBuffer commandBuffer, const VkCopyAccelerationStructureInfoKHR *pInfo)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateRayTracingPipelinesKHR(VkDevice device, VkDeferredOperationKHR deferredOperation, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkRayTracingPipelineCreateInfoKHR *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    for (uint32_t i = 0; i < createInfoCount; i++)
+    {
+        pPipelines[i] = CreateObject<VkPipeline>();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetRayTracingShaderGroupHandlesKHR(VkDevice device, VkPipeline pipeline, uint32_t firstGroup, uint32_t groupCount, size_t dataSize, void *pData)
+{
+    memset(pData, 0, dataSize);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdTraceRaysKHR(VkCommandBuffer commandBuffer, const VkStridedDeviceAddressRegionKHR *pRaygenShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pMissShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pHitShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pCallableShaderBindingTable, uint32_t width, uint32_t height, uint32_t depth)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDebugUtilsMessengerEXT *pMessenger)
+{
+    *pMessenger = CreateObject<VkDebugUtilsMessengerEXT>();
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT messenger, const VkAllocationCallbacks *pAllocator)
+{
+    DestroyObject(messenger);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkSetDebugUtilsObjectNameEXT(VkDevice device, const VkDebugUtilsObjectNameInfoEXT *pNameInfo)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginDebugUtilsLabelEXT(VkCommandBuffer commandBuffer, const VkDebugUtilsLabelEXT *pLabelInfo)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndDebugUtilsLabelEXT(VkCommandBuffer commandBuffer)
+{}
+
+#pragma endregion
+
+
+
+#pragma region proc addresses
+
+static PFN_vkVoidFunction GetNullDeviceProcAddr(const char *pName)
+{
+    #define NULL_DEVICE_PROC(fname) { #fname, reinterpret_cast<PFN_vkVoidFunction>(fname) }
+
+    static const std::unordered_map<std::string, PFN_vkVoidFunction> procs =
+    {
+        NULL_DEVICE_PROC(vkCreateDebugUtilsMessengerEXT),
+        NULL_DEVICE_PROC(vkDestroyDebugUtilsMessengerEXT),
+        NULL_DEVICE_PROC(vkSetDebugUtilsObjectNameEXT),
+        NULL_DEVICE_PROC(vkCmdBeginDebugUtilsLabelEXT),
+        NULL_DEVICE_PROC(vkCmdEndDebugUtilsLabelEXT),
+        NULL_DEVICE_PROC(vkCreateAccelerationStructureKHR),
+        NULL_DEVICE_PROC(vkDestroyAccelerationStructureKHR),
+        NULL_DEVICE_PROC(vkGetRayTracingShaderGroupHandlesKHR),
+        NULL_DEVICE_PROC(vkCreateRayTracingPipelinesKHR),
+        NULL_DEVICE_PROC(vkGetAccelerationStructureDeviceAddressKHR),
+        NULL_DEVICE_PROC(vkGetAccelerationStructureBuildSizesKHR),
+        NULL_DEVICE_PROC(vkCmdBuildAccelerationStructuresKHR),
+        NULL_DEVICE_PROC(vkCmdWriteAccelerationStructuresPropertiesKHR),
+        NULL_DEVICE_PROC(vkCmdCopyAccelerationStructureKHR),
+        NULL_DEVICE_PROC(vkCmdTraceRaysKHR),
+        NULL_DEVICE_PROC(vkCreateHeadlessSurfaceEXT),
+        // Vma fetches these dynamically
+        NULL_DEVICE_PROC(vkGetPhysicalDeviceProperties),
+        NULL_DEVICE_PROC(vkGetPhysicalDeviceMemoryProperties),
+        NULL_DEVICE_PROC(vkGetPhysicalDeviceMemoryProperties2),
+        NULL_DEVICE_PROC(vkAllocateMemory),
+        NULL_DEVICE_PROC(vkFreeMemory),
+        NULL_DEVICE_PROC(vkMapMemory),
+        NULL_DEVICE_PROC(vkUnmapMemory),
+        NULL_DEVICE_PROC(vkFlushMappedMemoryRanges),
+        NULL_DEVICE_PROC(vkInvalidateMappedMemoryRanges),
+        NULL_DEVICE_PROC(vkBindBufferMemory),
+        NULL_DEVICE_PROC(vkBindImageMemory),
+        NULL_DEVICE_PROC(vkBindBufferMemory2),
+        NULL_DEVICE_PROC(vkBindImageMemory2),
+        NULL_DEVICE_PROC(vkGetBufferMemoryRequirements),
+        NULL_DEVICE_PROC(vkGetImageMemoryRequirements),
+        NULL_DEVICE_PROC(vkGetBufferMemoryRequirements2),
+        NULL_DEVICE_PROC(vkGetImageMemoryRequirements2),
+        NULL_DEVICE_PROC(vkCreateBuffer),
+        NULL_DEVICE_PROC(vkDestroyBuffer),
+        NULL_DEVICE_PROC(vkCreateImage),
+        NULL_DEVICE_PROC(vkDestroyImage),
+        NULL_DEVICE_PROC(vkCmdCopyBuffer),
+    };
+
+    #undef NULL_DEVICE_PROC
+
+    auto f = procs.find(pName);
+    return f != procs.end() ? f->second : nullptr;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char *pName)
+{
+    return GetNullDeviceProcAddr(pName);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char *pName)
+{
+    return GetNullDeviceProcAddr(pName);
+}
+
+#pragma endregion
+
+}
+
+#endif // RG_USE_NULL_DEVICE
@@ -23,12 +23,36 @@
 #include <string>
 #include <vector>
 
+#include "Const.h"
 #include "RgException.h"
 
 using namespace RTGL1;
 
+static bool HasDirectWriteMemory(const VkPhysicalDeviceMemoryProperties &memProps, VkPhysicalDeviceType deviceType)
+{
+    const VkMemoryPropertyFlags directFlags =
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; i++)
+    {
+        const VkMemoryType &t = memProps.memoryTypes[i];
+
+        if ((t.propertyFlags & directFlags) != directFlags)
+        {
+            continue;
+        }
+
+        // on discrete GPUs without resizable BAR, such heap is small
+        // and it's better to leave it for the driver
+        return deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+               memProps.memoryHeaps[t.heapIndex].size > DIRECT_WRITE_MIN_HEAP_SIZE;
+    }
+
+    return false;
+}
+
 PhysicalDevice::PhysicalDevice(VkInstance instance)
-    : physDevice(VK_NULL_HANDLE), memoryProperties{}, rtPipelineProperties{}
+    : physDevice(VK_NULL_HANDLE), memoryProperties{}, rtPipelineProperties{}, limits{}, directWriteMemoryAvailable(false)
 {
     VkResult r;
 
@@ -67,6 +91,9 @@ PhysicalDevice::PhysicalDevice(VkInstance instance)
             vkGetPhysicalDeviceProperties2(physDevice, &deviceProp2);
             vkGetPhysicalDeviceMemoryProperties(physDevice, &memoryProperties);
 
+            limits = deviceProp2.properties.limits;
+            directWriteMemoryAvailable = HasDirectWriteMemory(memoryProperties, deviceProp2.properties.deviceType);
+
             break;
         }
     }
@@ -84,19 +111,23 @@ VkPhysicalDevice PhysicalDevice::Get() const
 
 uint32_t PhysicalDevice::GetMemoryTypeIndex(uint32_t memoryTypeBits, VkFlags requirementsMask) const
 {
+    const bool deviceLocal = requirementsMask & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    const bool hostVisible = requirementsMask & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
     VkMemoryPropertyFlags flagsToIgnore = 0;
 
-    if (requirementsMask & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    if (deviceLocal && !hostVisible)
     {        
-        // device-local memory must not be host visible
+        // device-local memory should not be host visible
         flagsToIgnore = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
     }
-    else
+    else if (!deviceLocal)
     {
-        // host visible memory must not be device-local
+        // host visible memory should not be device-local
         flagsToIgnore = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     }
-    
+
+    uint32_t fallback = UINT32_MAX;
 
     // for each memory type available for this device
     for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
@@ -107,17 +138,28 @@ uint32_t PhysicalDevice::GetMemoryTypeIndex(uint32_t memoryTypeBits, VkFlags req
             VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
 
             bool isSuitable = (flags & requirementsMask) == requirementsMask;
-            bool isIgnored = (flags & flagsToIgnore) == flagsToIgnore;
+            bool isIgnored = (flags & flagsToIgnore) != 0;
             
             if (isSuitable && !isIgnored)
             {
                 return i;
             }
+
+            // on UMA, all memory types can be device-local
+            if (isSuitable && fallback == UINT32_MAX)
+            {
+                fallback = i;
+            }
         }
 
         memoryTypeBits >>= 1u;
     }
 
+    if (fallback != UINT32_MAX)
+    {
+        return fallback;
+    }
+
     throw RgException(RG_GRAPHICS_API_ERROR, "Can't find memory type for given memory property flags (" + std::to_string(requirementsMask) + ")");
     return 0;
 }
@@ -131,3 +173,13 @@ const VkPhysicalDeviceRayTracingPipelinePropertiesKHR &PhysicalDevice::GetRTPipe
 {
     return rtPipelineProperties;
 }
+
+const VkPhysicalDeviceLimits &PhysicalDevice::GetLimits() const
+{
+    return limits;
+}
+
+bool PhysicalDevice::IsDirectWriteMemoryAvailable() const
+{
+    return directWriteMemoryAvailable;
+}
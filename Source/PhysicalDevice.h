@@ -40,12 +40,18 @@ public:
     uint32_t GetMemoryTypeIndex(uint32_t memoryTypeBits, VkFlags requirementsMask) const;
     const VkPhysicalDeviceMemoryProperties &GetMemoryProperties() const;
     const VkPhysicalDeviceRayTracingPipelinePropertiesKHR &GetRTPipelineProperties() const;
+    const VkPhysicalDeviceLimits &GetLimits() const;
+    // Is there a large device-local host-visible memory type (UMA or resizable BAR),
+    // so the data that is rewritten each frame can be written without staging buffers
+    bool IsDirectWriteMemoryAvailable() const;
 
 private:
     // selected physical device
     VkPhysicalDevice physDevice;
     VkPhysicalDeviceMemoryProperties memoryProperties;
     VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtPipelineProperties;
+    VkPhysicalDeviceLimits limits;
+    bool directWriteMemoryAvailable;
 };
 
 }
\ No newline at end of file
@@ -22,6 +22,7 @@
 
 #include "VulkanDevice.h"
 #include "RgException.h"
+#include "ApiCapture.h"
 
 using namespace RTGL1;
 
@@ -40,6 +41,7 @@ using namespace RTGL1;
 
 constexpr uint32_t MAX_DEVICE_COUNT = 8;
 static std::unordered_map<RgInstance, std::unique_ptr<VulkanDevice>> G_DEVICES;
+static std::unordered_map<RgInstance, std::unique_ptr<ApiCapture>> G_CAPTURES;
 
 static RgInstance GetNextID()
 {
@@ -58,6 +60,13 @@ static const std::unique_ptr<VulkanDevice> &GetDevice(RgInstance rgInstance)
     return it->second;
 }
 
+// Returns null, if API calls of the instance are not captured
+static ApiCapture *GetCapture(RgInstance rgInstance)
+{
+    auto it = G_CAPTURES.find(rgInstance);
+    return it != G_CAPTURES.end() ? it->second.get() : nullptr;
+}
+
 static void TryPrintError(RgInstance rgInstance, const char *pMessage)
 {
     auto it = G_DEVICES.find(rgInstance);
@@ -85,8 +94,21 @@ RgResult rgCreateInstance(const RgInstanceCreateInfo *pInfo, RgInstance *pResult
 
     try
     {
+        std::unique_ptr<ApiCapture> capture;
+
+        if (pInfo->pCaptureFilePath != nullptr)
+        {
+            capture = std::make_unique<ApiCapture>(pInfo->pCaptureFilePath);
+        }
+
         G_DEVICES[rgInstance] = std::make_unique<VulkanDevice>(pInfo);
         *pResult = rgInstance;
+
+        if (capture)
+        {
+            capture->CreateInstance(*pInfo);
+            G_CAPTURES[rgInstance] = std::move(capture);
+        }
     }
     // TODO: VulkanDevice must clean all the resources if initialization failed!
     // So for now exceptions should not happen. But if they did, target application must be closed.
@@ -113,6 +135,12 @@ RgResult rgDestroyInstance(RgInstance rgInstance)
     try
     {
         G_DEVICES.erase(rgInstance);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->DestroyInstance();
+            G_CAPTURES.erase(rgInstance);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -122,6 +150,69 @@ RgResult rgUploadGeometry(RgInstance rgInstance, const RgGeometryUploadInfo *pUp
     try
     {
         GetDevice(rgInstance)->UploadGeometry(pUploadInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadGeometry(*pUploadInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgUploadGeometries(RgInstance rgInstance, uint32_t count, const RgGeometryUploadInfo *pUploadInfos)
+{
+    try
+    {
+        GetDevice(rgInstance)->UploadGeometries(count, pUploadInfos);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadGeometries(count, pUploadInfos);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgRecordDynamicGeometry(RgInstance rgInstance, uint32_t contextIndex, const RgGeometryUploadInfo *pUploadInfo)
+{
+    try
+    {
+        GetDevice(rgInstance)->RecordDynamicGeometry(contextIndex, pUploadInfo);
+
+        // captured as a regular upload, so replay is single-threaded
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadGeometry(*pUploadInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgMapGeometry(RgInstance rgInstance, const RgGeometryUploadInfo *pUploadInfo, RgMappedGeometry *pResult)
+{
+    try
+    {
+        GetDevice(rgInstance)->MapGeometry(pUploadInfo, pResult);
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgCommitMappedGeometry(RgInstance rgInstance, uint64_t uniqueID)
+{
+    try
+    {
+        RgGeometryUploadInfo committedInfo = {};
+        const bool isCapturable = GetDevice(rgInstance)->CommitMappedGeometry(uniqueID, committedInfo);
+
+        // captured as a regular upload with the written data;
+        // packed data of the compact vertex layout can't be replayed
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            if (isCapturable)
+            {
+                c->UploadGeometry(committedInfo);
+            }
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -131,6 +222,11 @@ RgResult rgUpdateGeometryTransform(RgInstance rgInstance, const RgUpdateTransfor
     try
     {
         GetDevice(rgInstance)->UpdateGeometryTransform(pUpdateInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UpdateGeometryTransform(*pUpdateInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -140,6 +236,67 @@ RgResult rgUpdateGeometryTexCoords(RgInstance rgInstance, const RgUpdateTexCoord
     try
     {
         GetDevice(rgInstance)->UpdateGeometryTexCoords(pUpdateInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UpdateGeometryTexCoords(*pUpdateInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgCreateMesh(RgInstance rgInstance, const RgMeshCreateInfo *pCreateInfo, RgMesh *pResult)
+{
+    try
+    {
+        GetDevice(rgInstance)->CreateMesh(pCreateInfo, pResult);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->CreateMesh(*pCreateInfo, *pResult);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgUploadMeshInstance(RgInstance rgInstance, const RgMeshInstanceUploadInfo *pUploadInfo)
+{
+    try
+    {
+        GetDevice(rgInstance)->UploadMeshInstance(pUploadInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadMeshInstance(*pUploadInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgAddStaticGeometry(RgInstance rgInstance, const RgGeometryUploadInfo *pUploadInfo)
+{
+    try
+    {
+        GetDevice(rgInstance)->AddStaticGeometry(pUploadInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->AddStaticGeometry(*pUploadInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgRemoveStaticGeometry(RgInstance rgInstance, uint64_t uniqueID)
+{
+    try
+    {
+        GetDevice(rgInstance)->RemoveStaticGeometry(uniqueID);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->RemoveStaticGeometry(uniqueID);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -150,6 +307,11 @@ RgResult rgUploadRasterizedGeometry(RgInstance rgInstance, const RgRasterizedGeo
     try
     {
         GetDevice(rgInstance)->UploadRasterizedGeometry(pUploadInfo, pViewProjection, pViewport);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadRasterizedGeometry(*pUploadInfo, pViewProjection, pViewport);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -159,6 +321,20 @@ RgResult rgSubmitStaticGeometries(RgInstance rgInstance)
     try
     {
         GetDevice(rgInstance)->SubmitStaticGeometries();
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->SubmitStaticGeometries();
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgIsStaticSceneSwapPending(RgInstance rgInstance, RgBool32 *pResult)
+{
+    try
+    {
+        GetDevice(rgInstance)->IsStaticSceneSwapPending(pResult);
     }
     CATCH_OR_RETURN;
 }
@@ -168,6 +344,11 @@ RgResult rgStartNewScene(RgInstance rgInstance)
     try
     {
         GetDevice(rgInstance)->StartNewStaticScene();
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->StartNewScene();
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -177,6 +358,11 @@ RgResult rgUploadDirectionalLight(RgInstance rgInstance, RgDirectionalLightUploa
     try
     {
         GetDevice(rgInstance)->UploadLight(pLightInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadLight(*pLightInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -186,6 +372,11 @@ RgResult rgUploadSphericalLight(RgInstance rgInstance, RgSphericalLightUploadInf
     try
     {
         GetDevice(rgInstance)->UploadLight(pLightInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadLight(*pLightInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -195,6 +386,11 @@ RgResult rgUploadSpotlightLight(RgInstance rgInstance, RgSpotlightUploadInfo *pL
     try
     {
         GetDevice(rgInstance)->UploadLight(pLightInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UploadLight(*pLightInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -205,6 +401,11 @@ RgResult rgCreateStaticMaterial(RgInstance rgInstance, const RgStaticMaterialCre
     try
     {
         GetDevice(rgInstance)->CreateStaticMaterial(pCreateInfo, pResult);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->CreateStaticMaterial(*pCreateInfo, *pResult);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -215,6 +416,11 @@ RgResult rgCreateAnimatedMaterial(RgInstance rgInstance, const RgAnimatedMateria
     try
     {
         GetDevice(rgInstance)->CreateAnimatedMaterial(pCreateInfo, pResult);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->CreateAnimatedMaterial(*pCreateInfo, *pResult);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -224,6 +430,11 @@ RgResult rgChangeAnimatedMaterialFrame(RgInstance rgInstance, RgMaterial animate
     try
     {
         GetDevice(rgInstance)->ChangeAnimatedMaterialFrame(animatedMaterial, frameIndex);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->ChangeAnimatedMaterialFrame(animatedMaterial, frameIndex);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -234,6 +445,11 @@ RgResult rgCreateDynamicMaterial(RgInstance rgInstance, const RgDynamicMaterialC
     try
     {
         GetDevice(rgInstance)->CreateDynamicMaterial(pCreateInfo, pResult);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->CreateDynamicMaterial(*pCreateInfo, *pResult);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -243,6 +459,11 @@ RgResult rgUpdateDynamicMaterial(RgInstance rgInstance, const RgDynamicMaterialU
     try
     {
         GetDevice(rgInstance)->UpdateDynamicMaterial(pUpdateInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->UpdateDynamicMaterial(*pUpdateInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -252,6 +473,11 @@ RgResult rgDestroyMaterial(RgInstance rgInstance, RgMaterial material)
     try
     {
         GetDevice(rgInstance)->DestroyMaterial(material);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->DestroyMaterial(material);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -261,6 +487,11 @@ RgResult rgCreateCubemap(RgInstance rgInstance, const RgCubemapCreateInfo *pCrea
     try
     {
         GetDevice(rgInstance)->CreateSkyboxCubemap(pCreateInfo, pResult);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->CreateCubemap(*pCreateInfo, *pResult);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -270,6 +501,11 @@ RgResult rgDestroyCubemap(RgInstance rgInstance, RgCubemap cubemap)
     try
     {
         GetDevice(rgInstance)->DestroyCubemap(cubemap);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->DestroyCubemap(cubemap);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -279,6 +515,11 @@ RgResult rgStartFrame(RgInstance rgInstance, const RgStartFrameInfo *pStartInfo)
     try
     {
         GetDevice(rgInstance)->StartFrame(pStartInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->StartFrame(*pStartInfo);
+        }
     }
     CATCH_OR_RETURN;
 }
@@ -288,6 +529,29 @@ RgResult rgDrawFrame(RgInstance rgInstance, const RgDrawFrameInfo *pDrawInfo)
     try
     {
         GetDevice(rgInstance)->DrawFrame(pDrawInfo);
+
+        if (ApiCapture *c = GetCapture(rgInstance))
+        {
+            c->DrawFrame(*pDrawInfo);
+        }
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgGetFrameStatistics(RgInstance rgInstance, uint32_t count, RgFrameStatistics *pResults, uint32_t *pResultCount)
+{
+    try
+    {
+        GetDevice(rgInstance)->GetFrameStatistics(count, pResults, pResultCount);
+    }
+    CATCH_OR_RETURN;
+}
+
+RgResult rgGetGpuTimings(RgInstance rgInstance, uint64_t *pFrameId, uint32_t *pScopeCount, RgGpuTimingScope *pScopes)
+{
+    try
+    {
+        GetDevice(rgInstance)->GetGpuTimings(pFrameId, pScopeCount, pScopes);
     }
     CATCH_OR_RETURN;
 }
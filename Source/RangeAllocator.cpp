@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RangeAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+using namespace RTGL1;
+
+RangeAllocator::RangeAllocator() : freeCount(0)
+{}
+
+bool RangeAllocator::Allocate(uint32_t count, uint32_t alignment, uint32_t *outFirst)
+{
+    assert(count > 0 && alignment > 0);
+
+    // first fit
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+    {
+        const uint32_t rangeFirst = it->first;
+        const uint32_t rangeEnd = it->first + it->second;
+
+        const uint32_t alignedFirst = (rangeFirst + alignment - 1) / alignment * alignment;
+
+        if ((uint64_t)alignedFirst + count > rangeEnd)
+        {
+            continue;
+        }
+
+        freeRanges.erase(it);
+
+        // return the parts that weren't used
+        if (alignedFirst > rangeFirst)
+        {
+            freeRanges[rangeFirst] = alignedFirst - rangeFirst;
+        }
+
+        if (alignedFirst + count < rangeEnd)
+        {
+            freeRanges[alignedFirst + count] = rangeEnd - (alignedFirst + count);
+        }
+
+        freeCount -= count;
+
+        *outFirst = alignedFirst;
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::Free(uint32_t first, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    freeCount += count;
+
+    auto next = freeRanges.lower_bound(first);
+
+    // must not intersect with other free ranges
+    assert(next == freeRanges.end() || first + count <= next->first);
+
+    // merge with the next one
+    if (next != freeRanges.end() && next->first == first + count)
+    {
+        count += next->second;
+        next = freeRanges.erase(next);
+    }
+
+    // merge with the previous one
+    if (next != freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= first);
+
+        if (prev->first + prev->second == first)
+        {
+            prev->second += count;
+            return;
+        }
+    }
+
+    freeRanges.emplace_hint(next, first, count);
+}
+
+void RangeAllocator::Reset()
+{
+    freeRanges.clear();
+    freeCount = 0;
+}
+
+uint32_t RangeAllocator::GetFreeCount() const
+{
+    return freeCount;
+}
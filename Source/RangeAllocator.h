@@ -0,0 +1,57 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+namespace RTGL1
+{
+
+// Free-list allocator of element ranges in a linear buffer.
+// It only tracks freed ranges, so the caller should fall back
+// to its own linear allocation, if there's no suitable free range.
+// Adjacent free ranges are merged.
+class RangeAllocator
+{
+public:
+    RangeAllocator();
+
+    RangeAllocator(const RangeAllocator &other) = delete;
+    RangeAllocator(RangeAllocator &&other) noexcept = delete;
+    RangeAllocator &operator=(const RangeAllocator &other) = delete;
+    RangeAllocator &operator=(RangeAllocator &&other) noexcept = delete;
+
+    // Find a free range of "count" elements, its first element is aligned by "alignment".
+    // Returns false, if there's no such range.
+    bool Allocate(uint32_t count, uint32_t alignment, uint32_t *outFirst);
+    void Free(uint32_t first, uint32_t count);
+    void Reset();
+
+    uint32_t GetFreeCount() const;
+
+private:
+    // first element of a free range to its element count
+    std::map<uint32_t, uint32_t> freeRanges;
+    uint32_t freeCount;
+};
+
+}
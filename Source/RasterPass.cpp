@@ -38,9 +38,11 @@ RTGL1::RasterPass::RasterPass(
     VkPipelineLayout _pipelineLayout,
     const std::shared_ptr<ShaderManager> &_shaderManager,
     const std::shared_ptr<Framebuffers> &_storageFramebuffers,
+    uint32_t _framesInFlight,
     const RgInstanceCreateInfo &_instanceInfo)
 :
     device(_device),
+    framesInFlight(_framesInFlight),
     rasterRenderPass(VK_NULL_HANDLE),
     rasterSkyRenderPass(VK_NULL_HANDLE),
     rasterWidth(0),
@@ -61,13 +63,13 @@ RTGL1::RasterPass::RasterPass(
 
     CreateRasterRenderPass(ShFramebuffers_Formats[FB_IMAGE_INDEX_FINAL], ShFramebuffers_Formats[FB_IMAGE_INDEX_ALBEDO], DEPTH_FORMAT);
 
-    rasterPipelines = std::make_shared<RasterizerPipelines>(device, _pipelineLayout, rasterRenderPass, _instanceInfo.rasterizedVertexColorGamma);
+    rasterPipelines = std::make_shared<RasterizerPipelines>(device, _pipelineLayout, rasterRenderPass, _instanceInfo.rasterizedVertexColorGamma, _instanceInfo.textureMemoryBudget > 0);
     rasterPipelines->SetShaders(_shaderManager.get(), VERT_SHADER, FRAG_SHADER);
 
-    rasterSkyPipelines= std::make_shared<RasterizerPipelines>(device, _pipelineLayout, rasterSkyRenderPass, _instanceInfo.rasterizedVertexColorGamma);
+    rasterSkyPipelines= std::make_shared<RasterizerPipelines>(device, _pipelineLayout, rasterSkyRenderPass, _instanceInfo.rasterizedVertexColorGamma, _instanceInfo.textureMemoryBudget > 0);
     rasterSkyPipelines->SetShaders(_shaderManager.get(), VERT_SHADER, FRAG_SHADER);
 
-    depthCopying = std::make_shared<DepthCopying>(device, DEPTH_FORMAT, _shaderManager, _storageFramebuffers);
+    depthCopying = std::make_shared<DepthCopying>(device, DEPTH_FORMAT, _shaderManager, _storageFramebuffers, framesInFlight);
 }
 
 RTGL1::RasterPass::~RasterPass()
@@ -97,7 +99,7 @@ void RTGL1::RasterPass::CreateFramebuffers(uint32_t renderWidth, uint32_t render
 {
     CreateDepthBuffers(renderWidth, renderHeight, allocator, cmdManager);
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         assert(rasterFramebuffers[i] == VK_NULL_HANDLE);
         assert(rasterSkyFramebuffers[i] == VK_NULL_HANDLE);
@@ -314,7 +316,7 @@ void RTGL1::RasterPass::CreateDepthBuffers(uint32_t width, uint32_t height,
                                            const std::shared_ptr<MemoryAllocator> &allocator, 
                                            const std::shared_ptr<CommandBufferManager> &cmdManager)
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         assert(depthImages[i] == VK_NULL_HANDLE);
         assert(depthViews[i] == VK_NULL_HANDLE);
@@ -408,7 +410,7 @@ void RTGL1::RasterPass::CreateDepthBuffers(uint32_t width, uint32_t height,
 
 void RTGL1::RasterPass::DestroyDepthBuffers()
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         assert((depthImages[i] && depthViews[i] && depthMemory[i]) 
                || (!depthImages[i] && !depthViews[i] && !depthMemory[i]));
@@ -36,6 +36,7 @@ public:
                VkPipelineLayout pipelineLayout,
                const std::shared_ptr<ShaderManager> &shaderManager,
                const std::shared_ptr<Framebuffers> &storageFramebuffers,
+               uint32_t framesInFlight,
                const RgInstanceCreateInfo &instanceInfo);
     ~RasterPass() override;
 
@@ -75,6 +76,7 @@ private:
 
 private:
     VkDevice device;
+    uint32_t framesInFlight;
 
     VkRenderPass rasterRenderPass;
     VkRenderPass rasterSkyRenderPass;
@@ -63,7 +63,8 @@ RasterizedDataCollector::RasterizedDataCollector(
     VkDevice _device,
     const std::shared_ptr<MemoryAllocator> &_allocator,
     std::shared_ptr<TextureManager> _textureMgr,
-    uint32_t _maxVertexCount, uint32_t _maxIndexCount)
+    uint32_t _maxVertexCount, uint32_t _maxIndexCount,
+    uint32_t _framesInFlight, bool _allowDirectWrite)
 :
     device(_device),
     textureMgr(_textureMgr),
@@ -76,8 +77,8 @@ RasterizedDataCollector::RasterizedDataCollector(
     _maxVertexCount = std::max(_maxVertexCount, 64u);
     _maxIndexCount = std::max(_maxIndexCount, 64u);
 
-    vertexBuffer->Create(_maxVertexCount * sizeof(RasterizerVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-    indexBuffer->Create(_maxIndexCount * sizeof(RasterizerVertex), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    vertexBuffer->Create(_maxVertexCount * sizeof(RasterizerVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, _framesInFlight, _allowDirectWrite);
+    indexBuffer->Create(_maxIndexCount * sizeof(RasterizerVertex), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, _framesInFlight, _allowDirectWrite);
 }
 
 RasterizedDataCollector::~RasterizedDataCollector()
@@ -279,23 +280,25 @@ void RasterizedDataCollector::CopyFromStaging(VkCommandBuffer cmd, uint32_t fram
     indexBuffer->CopyFromStaging(cmd, frameIndex, sizeof(uint32_t) * curIndexCount);
 }
 
-VkBuffer RasterizedDataCollector::GetVertexBuffer() const
+VkBuffer RasterizedDataCollector::GetVertexBuffer(uint32_t frameIndex) const
 {
-    return vertexBuffer->GetDeviceLocal();
+    return vertexBuffer->GetDeviceLocal(frameIndex);
 }
 
-VkBuffer RasterizedDataCollector::GetIndexBuffer() const
+VkBuffer RasterizedDataCollector::GetIndexBuffer(uint32_t frameIndex) const
 {
-    return indexBuffer->GetDeviceLocal();
+    return indexBuffer->GetDeviceLocal(frameIndex);
 }
 
 
 
 RasterizedDataCollectorGeneral::RasterizedDataCollectorGeneral(
     VkDevice device, const std::shared_ptr<MemoryAllocator> &allocator, 
-    const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount, uint32_t maxIndexCount)
+    const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount, uint32_t maxIndexCount,
+    uint32_t framesInFlight)
 :
-    RasterizedDataCollector(device, allocator, textureMgr, maxVertexCount, maxIndexCount) {}
+    // general geometry is uploaded each frame, so it can be written directly to device local memory
+    RasterizedDataCollector(device, allocator, textureMgr, maxVertexCount, maxIndexCount, framesInFlight, true) {}
 
 bool RasterizedDataCollectorGeneral::TryAddGeometry(uint32_t frameIndex, const RgRasterizedGeometryUploadInfo &info,
     const float *viewProjection, const RgViewport *viewport)
@@ -349,9 +352,11 @@ RasterizedDataCollector::DrawInfo *RasterizedDataCollectorGeneral::PushInfo(RgRa
 
 RasterizedDataCollectorSky::RasterizedDataCollectorSky(
     VkDevice device, const std::shared_ptr<MemoryAllocator> &allocator, 
-    const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount, uint32_t maxIndexCount)
+    const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount, uint32_t maxIndexCount,
+    uint32_t framesInFlight)
 :
-    RasterizedDataCollector(device, allocator, textureMgr, maxVertexCount, maxIndexCount) {}
+    // sky geometry can be reused in the next frames, so it's kept in one device local buffer
+    RasterizedDataCollector(device, allocator, textureMgr, maxVertexCount, maxIndexCount, framesInFlight, false) {}
 
 bool RasterizedDataCollectorSky::TryAddGeometry(uint32_t frameIndex, const RgRasterizedGeometryUploadInfo &info,
     const float *viewProjection, const RgViewport *viewport)
@@ -63,7 +63,8 @@ public:
         VkDevice device, 
         const std::shared_ptr<MemoryAllocator> &allocator,
         std::shared_ptr<TextureManager> textureMgr,
-        uint32_t maxVertexCount, uint32_t maxIndexCount);
+        uint32_t maxVertexCount, uint32_t maxIndexCount,
+        uint32_t framesInFlight, bool allowDirectWrite);
     virtual ~RasterizedDataCollector() = 0;
 
     RasterizedDataCollector(const RasterizedDataCollector& other) = delete;
@@ -78,8 +79,8 @@ public:
 
     void CopyFromStaging(VkCommandBuffer cmd, uint32_t frameIndex);
 
-    VkBuffer GetVertexBuffer() const;
-    VkBuffer GetIndexBuffer() const;
+    VkBuffer GetVertexBuffer(uint32_t frameIndex) const;
+    VkBuffer GetIndexBuffer(uint32_t frameIndex) const;
 
     static uint32_t GetVertexStride();
     static void GetVertexLayout(VkVertexInputAttributeDescription *outAttrs, uint32_t *outAttrsCount);
@@ -117,7 +118,7 @@ class RasterizedDataCollectorGeneral final : public RasterizedDataCollector
 public:
     RasterizedDataCollectorGeneral(VkDevice device, const std::shared_ptr<MemoryAllocator> &allocator,
                                    const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount,
-                                   uint32_t maxIndexCount);
+                                   uint32_t maxIndexCount, uint32_t framesInFlight);
 
     RasterizedDataCollectorGeneral(const RasterizedDataCollectorGeneral &other) = delete;
     RasterizedDataCollectorGeneral(RasterizedDataCollectorGeneral &&other) noexcept = delete;
@@ -149,7 +150,7 @@ class RasterizedDataCollectorSky final : public RasterizedDataCollector
 public:
     RasterizedDataCollectorSky(VkDevice device, const std::shared_ptr<MemoryAllocator> &allocator,
                                const std::shared_ptr<TextureManager> &textureMgr, uint32_t maxVertexCount,
-                               uint32_t maxIndexCount);
+                               uint32_t maxIndexCount, uint32_t framesInFlight);
 
     RasterizedDataCollectorSky(const RasterizedDataCollectorSky &other) = delete;
     RasterizedDataCollectorSky(RasterizedDataCollectorSky &&other) noexcept = delete;
@@ -73,6 +73,7 @@ Rasterizer::Rasterizer(
     std::shared_ptr<Framebuffers> _storageFramebuffers,
     std::shared_ptr<CommandBufferManager> _cmdManager,
     VkFormat _surfaceFormat,
+    uint32_t _framesInFlight,
     const RgInstanceCreateInfo &_instanceInfo)
 :
     device(_device),
@@ -80,14 +81,15 @@ Rasterizer::Rasterizer(
     allocator(std::move(_allocator)),
     cmdManager(std::move(_cmdManager)),
     storageFramebuffers(std::move(_storageFramebuffers)),
-    isCubemapOutdated(true)
+    isCubemapOutdated(true),
+    drawCallCount(0)
 {
-    collectorGeneral = std::make_shared<RasterizedDataCollectorGeneral>(device, allocator, _textureManager, _instanceInfo.rasterizedMaxVertexCount, _instanceInfo.rasterizedMaxIndexCount);
-    collectorSky = std::make_shared<RasterizedDataCollectorSky>(device, allocator, _textureManager, _instanceInfo.rasterizedSkyMaxVertexCount, _instanceInfo.rasterizedSkyMaxIndexCount);
+    collectorGeneral = std::make_shared<RasterizedDataCollectorGeneral>(device, allocator, _textureManager, _instanceInfo.rasterizedMaxVertexCount, _instanceInfo.rasterizedMaxIndexCount, _framesInFlight);
+    collectorSky = std::make_shared<RasterizedDataCollectorSky>(device, allocator, _textureManager, _instanceInfo.rasterizedSkyMaxVertexCount, _instanceInfo.rasterizedSkyMaxIndexCount, _framesInFlight);
 
     CreatePipelineLayout(_textureManager->GetDescSetLayout());
 
-    rasterPass = std::make_shared<RasterPass>(device, _physDevice, commonPipelineLayout, _shaderManager, storageFramebuffers, _instanceInfo);
+    rasterPass = std::make_shared<RasterPass>(device, _physDevice, commonPipelineLayout, _shaderManager, storageFramebuffers, _framesInFlight, _instanceInfo);
     swapchainPass = std::make_shared<SwapchainPass>(device, commonPipelineLayout, _surfaceFormat, _shaderManager, _instanceInfo);
     renderCubemap = std::make_shared<RenderCubemap>(device, allocator, _shaderManager, _textureManager, _uniform, _samplerManager, cmdManager, _instanceInfo);
 }
@@ -99,6 +101,8 @@ Rasterizer::~Rasterizer()
 
 void Rasterizer::PrepareForFrame(uint32_t frameIndex, bool requestRasterizedSkyGeometryReuse)
 {
+    drawCallCount = 0;
+
     collectorGeneral->Clear(frameIndex);
 
     if (!requestRasterizedSkyGeometryReuse)
@@ -142,6 +146,8 @@ void Rasterizer::DrawSkyToCubemap(VkCommandBuffer cmd, uint32_t frameIndex,
 
         renderCubemap->Draw(cmd, frameIndex, collectorSky, textureManager, uniform);
         isCubemapOutdated = false;        
+
+        drawCallCount += (uint32_t)collectorSky->GetSkyDrawInfos().size();
     }
 }
 
@@ -169,8 +175,8 @@ void Rasterizer::DrawSkyToAlbedo(VkCommandBuffer cmd, uint32_t frameIndex, const
         rasterPass->GetRasterWidth(),
         rasterPass->GetRasterHeight(),
         // sky geometry
-        collectorSky->GetVertexBuffer(),
-        collectorSky->GetIndexBuffer(),
+        collectorSky->GetVertexBuffer(frameIndex),
+        collectorSky->GetIndexBuffer(frameIndex),
         textureManager->GetDescSet(frameIndex),
         defaultSkyViewProj
     };
@@ -212,8 +218,8 @@ void Rasterizer::DrawToFinalImage(VkCommandBuffer cmd, uint32_t frameIndex,
         rasterPass->GetRasterWidth(),
         rasterPass->GetRasterHeight(),
         // ordinary geometry
-        collectorGeneral->GetVertexBuffer(),
-        collectorGeneral->GetIndexBuffer(),
+        collectorGeneral->GetVertexBuffer(frameIndex),
+        collectorGeneral->GetIndexBuffer(frameIndex),
         textureManager->GetDescSet(frameIndex),
         defaultViewProj
     };
@@ -236,8 +242,8 @@ void Rasterizer::DrawToSwapchain(VkCommandBuffer cmd, uint32_t frameIndex, uint3
         swapchainPass->GetSwapchainFramebuffer(swapchainIndex),
         swapchainPass->GetSwapchainWidth(),
         swapchainPass->GetSwapchainHeight(),
-        collectorGeneral->GetVertexBuffer(),
-        collectorGeneral->GetIndexBuffer(),
+        collectorGeneral->GetVertexBuffer(frameIndex),
+        collectorGeneral->GetIndexBuffer(frameIndex),
         textureManager->GetDescSet(frameIndex),
         defaultViewProj
     };
@@ -318,6 +324,8 @@ void Rasterizer::Draw(VkCommandBuffer cmd, const DrawParams &drawParams)
     }
 
     vkCmdEndRenderPass(cmd);
+
+    drawCallCount += (uint32_t)drawParams.drawInfos.size();
 }
 
 void Rasterizer::SetViewportIfNew(VkCommandBuffer cmd, const RasterizedDataCollector::DrawInfo &info, 
@@ -343,6 +351,11 @@ const std::shared_ptr<RenderCubemap> &Rasterizer::GetRenderCubemap() const
     return renderCubemap;
 }
 
+uint32_t Rasterizer::GetDrawCallCount() const
+{
+    return drawCallCount;
+}
+
 void Rasterizer::OnSwapchainCreate(const Swapchain *pSwapchain)
 {
     swapchainPass->CreateFramebuffers(
@@ -53,6 +53,7 @@ public:
         std::shared_ptr<Framebuffers> storageFramebuffers,
         std::shared_ptr<CommandBufferManager> cmdManager,
         VkFormat surfaceFormat,
+        uint32_t framesInFlight,
         const RgInstanceCreateInfo &instanceInfo);
     ~Rasterizer() override;
 
@@ -79,6 +80,8 @@ public:
     void OnFramebuffersSizeChange(uint32_t width, uint32_t height) override;
 
     const std::shared_ptr<RenderCubemap> &GetRenderCubemap() const;
+    // Amount of draw calls that were recorded since the last PrepareForFrame
+    uint32_t GetDrawCallCount() const;
 
 private:
     struct DrawParams
@@ -123,6 +126,8 @@ private:
 
     bool isCubemapOutdated;
     std::shared_ptr<RenderCubemap> renderCubemap;
+
+    uint32_t drawCallCount;
 };
 
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <set>
 
 #include "RasterizedDataCollector.h"
+#include "Generated/ShaderCommonC.h"
 
 constexpr uint32_t PIPELINE_STATE_MASK_BLEND_ENABLE                     = 1 << 0;
 constexpr uint32_t PIPELINE_STATE_MASK_DEPTH_TEST_ENABLE                = 1 << 1;
@@ -182,14 +183,16 @@ RTGL1::RasterizerPipelines::RasterizerPipelines(
     VkDevice _device,
     VkPipelineLayout _pipelineLayout, 
     VkRenderPass _renderPass,
-    bool _applyVertexColorGamma)
+    bool _applyVertexColorGamma,
+    bool _textureUsageTracking)
 :
     device(_device),
     pipelineLayout(_pipelineLayout),
     renderPass(_renderPass),
     shaderStages{},
     pipelineCache(VK_NULL_HANDLE),
-    applyVertexColorGamma(_applyVertexColorGamma)
+    applyVertexColorGamma(_applyVertexColorGamma),
+    textureUsageTracking(_textureUsageTracking)
 {
     assert(TestFlags());
 
@@ -280,6 +283,20 @@ VkPipeline RTGL1::RasterizerPipelines::CreatePipeline(bool blendEnable, RgBlendF
     shaderStages[0].pSpecializationInfo = &vertSpecInfo;
 
 
+    VkSpecializationMapEntry fragMapEntry = {};
+    fragMapEntry.constantID = CONSTANT_ID_TEXTURE_USAGE_TRACKING;
+    fragMapEntry.offset = 0;
+    fragMapEntry.size = sizeof(uint32_t);
+
+    VkSpecializationInfo fragSpecInfo = {};
+    fragSpecInfo.mapEntryCount = 1;
+    fragSpecInfo.pMapEntries = &fragMapEntry;
+    fragSpecInfo.dataSize = sizeof(uint32_t);
+    fragSpecInfo.pData = &textureUsageTracking;
+
+    shaderStages[1].pSpecializationInfo = &fragSpecInfo;
+
+
     VkDynamicState dynamicStates[2] =
     {
         VK_DYNAMIC_STATE_VIEWPORT,
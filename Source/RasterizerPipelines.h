@@ -36,7 +36,8 @@ public:
         VkDevice device,
         VkPipelineLayout pipelineLayout, 
         VkRenderPass renderPass,
-        bool applyVertexColorGamma);
+        bool applyVertexColorGamma,
+        bool textureUsageTracking);
 
     ~RasterizerPipelines();
 
@@ -79,6 +80,8 @@ private:
     } dynamicState;
 
     uint32_t applyVertexColorGamma;
+    // if 0, the fragment shader doesn't write the texture usage
+    uint32_t textureUsageTracking;
 };
 
 }
@@ -20,6 +20,8 @@
 
 #include "RayTracingPipeline.h"
 
+#include <cstddef>
+
 #include "Generated/ShaderCommonC.h"
 #include "Utils.h"
 
@@ -51,7 +53,8 @@ RayTracingPipeline::RayTracingPipeline(
     hitGroupCount(0),
     missShaderCount(0),
     primaryRaysMaxAlbedoLayers(_rgInfo.primaryRaysMaxAlbedoLayers),
-    indirectIlluminationMaxAlbedoLayers(_rgInfo.indirectIlluminationMaxAlbedoLayers)
+    indirectIlluminationMaxAlbedoLayers(_rgInfo.indirectIlluminationMaxAlbedoLayers),
+    textureUsageTracking(_rgInfo.textureMemoryBudget > 0 ? 1 : 0)
 {
     shaderBindingTable = std::make_shared<AutoBuffer>(device, std::move(_allocator), "SBT staging", "SBT");
 
@@ -154,30 +157,49 @@ void RayTracingPipeline::CreatePipeline(const ShaderManager *shaderManager)
 {
     std::vector<VkPipelineShaderStageCreateInfo> stages(shaderStageInfos.size());
 
-    // for optional specialization constants,
-    // pre-allocate whole vector to prevent wrong pointers in pSpecializationInfo
-    std::vector<VkSpecializationMapEntry> specEntries(shaderStageInfos.size());
+    struct SpecData
+    {
+        uint32_t specConst;
+        uint32_t textureUsageTracking;
+    };
+
+    // each stage has the texture usage tracking const, it's ignored by the ones that don't sample textures,
+    // and an optional one; pre-allocate whole vectors to prevent wrong pointers in pSpecializationInfo
+    std::vector<SpecData> specData(shaderStageInfos.size());
+    std::vector<VkSpecializationMapEntry> specEntries(shaderStageInfos.size() * 2);
     std::vector<VkSpecializationInfo> specInfos(shaderStageInfos.size());
 
     for (uint32_t i = 0; i < shaderStageInfos.size(); i++)
     {
         stages[i] = shaderManager->GetStageInfo(shaderStageInfos[i].pName);
 
+        VkSpecializationMapEntry *pEntries = &specEntries[i * 2];
+        uint32_t entryCount = 0;
+
+        specData[i].textureUsageTracking = textureUsageTracking;
+
+        VkSpecializationMapEntry &trackingEntry = pEntries[entryCount++];
+        trackingEntry.constantID = CONSTANT_ID_TEXTURE_USAGE_TRACKING;
+        trackingEntry.offset = offsetof(SpecData, textureUsageTracking);
+        trackingEntry.size = sizeof(uint32_t);
+
         if (shaderStageInfos[i].pSpecConst != nullptr)
         {
-            VkSpecializationMapEntry &specEntry = specEntries[i];
+            specData[i].specConst = *shaderStageInfos[i].pSpecConst;
+
+            VkSpecializationMapEntry &specEntry = pEntries[entryCount++];
             specEntry.constantID = 0;
-            specEntry.offset = 0;
+            specEntry.offset = offsetof(SpecData, specConst);
             specEntry.size = sizeof(uint32_t);
+        }
 
-            VkSpecializationInfo &specInfo = specInfos[i];
-            specInfo.mapEntryCount = 1;
-            specInfo.pMapEntries = &specEntry;
-            specInfo.dataSize = sizeof(*shaderStageInfos[i].pSpecConst);
-            specInfo.pData = shaderStageInfos[i].pSpecConst;
+        VkSpecializationInfo &specInfo = specInfos[i];
+        specInfo.mapEntryCount = entryCount;
+        specInfo.pMapEntries = pEntries;
+        specInfo.dataSize = sizeof(SpecData);
+        specInfo.pData = &specData[i];
 
-            stages[i].pSpecializationInfo = &specInfo;
-        }
+        stages[i].pSpecializationInfo = &specInfo;
     }
 
     VkPipelineLibraryCreateInfoKHR libInfo = {};
@@ -114,6 +114,8 @@ private:
 
     uint32_t primaryRaysMaxAlbedoLayers;
     uint32_t indirectIlluminationMaxAlbedoLayers;
+    // if 0, the shaders don't write the texture usage
+    uint32_t textureUsageTracking;
 };
 
 }
@@ -75,7 +75,7 @@ RTGL1::RenderCubemap::RenderCubemap(
 {
     CreatePipelineLayout(_textureManager->GetDescSetLayout(), _uniform->GetDescSetLayout());
     CreateRenderPass();
-    InitPipelines(_shaderManager, cubemapSize, _instanceInfo.rasterizedVertexColorGamma);
+    InitPipelines(_shaderManager, cubemapSize, _instanceInfo.rasterizedVertexColorGamma, _instanceInfo.textureMemoryBudget > 0);
 
     VkCommandBuffer cmd = _cmdManager->StartGraphicsCmd();
     CreateAttch(_allocator, cmd, cubemapSize, cubemap, false);
@@ -125,8 +125,8 @@ void RTGL1::RenderCubemap::Draw(VkCommandBuffer cmd, uint32_t frameIndex,
         return;
     }
 
-    VkBuffer vertexBuffer = skyDataCollector->GetVertexBuffer();
-    VkBuffer indexBuffer = skyDataCollector->GetIndexBuffer();
+    VkBuffer vertexBuffer = skyDataCollector->GetVertexBuffer(frameIndex);
+    VkBuffer indexBuffer = skyDataCollector->GetIndexBuffer(frameIndex);
 
     VkDescriptorSet descSets[] =
     {
@@ -322,7 +322,7 @@ void RTGL1::RenderCubemap::CreateRenderPass()
     SET_DEBUG_NAME(device, multiviewRenderPass, VK_OBJECT_TYPE_RENDER_PASS, "Render cubemap multiview render pass");
 }
 
-void RTGL1::RenderCubemap::InitPipelines(const std::shared_ptr<ShaderManager> &shaderManager, uint32_t sideSize, bool applyVertexColorGamma)
+void RTGL1::RenderCubemap::InitPipelines(const std::shared_ptr<ShaderManager> &shaderManager, uint32_t sideSize, bool applyVertexColorGamma, bool textureUsageTracking)
 {
     VkViewport viewport = {};
     viewport.x = viewport.y = 0;
@@ -335,7 +335,7 @@ void RTGL1::RenderCubemap::InitPipelines(const std::shared_ptr<ShaderManager> &s
     scissors.extent = { sideSize, sideSize };
 
 
-    pipelines = std::make_shared<RasterizerPipelines>(device, pipelineLayout, multiviewRenderPass, applyVertexColorGamma);
+    pipelines = std::make_shared<RasterizerPipelines>(device, pipelineLayout, multiviewRenderPass, applyVertexColorGamma, textureUsageTracking);
     pipelines->SetShaders(shaderManager.get(), "VertRasterizerMultiview", "FragRasterizer");
     pipelines->DisableDynamicState(viewport, scissors);
 }
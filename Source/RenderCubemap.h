@@ -71,7 +71,7 @@ private:
 private:
     void CreatePipelineLayout(VkDescriptorSetLayout texturesSetLayout, VkDescriptorSetLayout uniformSetLayout);
     void CreateRenderPass();
-    void InitPipelines(const std::shared_ptr<ShaderManager> &shaderManager, uint32_t sideSize, bool applyVertexColorGamma);
+    void InitPipelines(const std::shared_ptr<ShaderManager> &shaderManager, uint32_t sideSize, bool applyVertexColorGamma, bool textureUsageTracking);
     void CreateAttch(const std::shared_ptr<MemoryAllocator> &allocator, VkCommandBuffer cmd, uint32_t sideSize, Attachment &result, bool isDepth);
     void CreateFramebuffer(uint32_t sideSize);
     void CreateDescriptors(const std::shared_ptr<SamplerManager> &samplerManager);
@@ -32,18 +32,20 @@ Scene::Scene(
     std::shared_ptr<TextureManager> &_textureManager,
     const std::shared_ptr<const GlobalUniform> &_uniform,
     const std::shared_ptr<const ShaderManager> &_shaderManager,
-    const VertexBufferProperties &_properties)
+    const VertexBufferProperties &_properties,
+    uint32_t _framesInFlight,
+    uint32_t _dynamicRecordingContextCount,
+    uint32_t _maxStaticClusterCount)
 :
-    toResubmitMovable(false),
     isRecordingStatic(false),
     submittedStaticInCurrentFrame(false)
 {
     VertexCollectorFilterTypeFlags_Init();
 
-    lightManager = std::make_shared<LightManager>(_device, _allocator);
-    geomInfoMgr = std::make_shared<GeomInfoManager>(_device, _allocator);
+    lightManager = std::make_shared<LightManager>(_device, _allocator, _framesInFlight);
+    geomInfoMgr = std::make_shared<GeomInfoManager>(_device, _allocator, _framesInFlight);
 
-    asManager = std::make_shared<ASManager>(_device, _allocator, _cmdManager, _textureManager, geomInfoMgr, _properties);
+    asManager = std::make_shared<ASManager>(_device, _allocator, _cmdManager, _textureManager, geomInfoMgr, _properties, _framesInFlight, _dynamicRecordingContextCount, _maxStaticClusterCount);
   
     vertPreproc = std::make_shared<VertexPreprocessing>(_device, _uniform, asManager, _shaderManager);
 }
@@ -54,18 +56,54 @@ Scene::~Scene()
 void Scene::PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex)
 {
     dynamicUniqueIDToSimpleIndex.clear();
+    meshInstanceUniqueIDs.clear();
 
     geomInfoMgr->PrepareForFrame(frameIndex);
     lightManager->PrepareForFrame(frameIndex);
 
     // dynamic geomtry
     asManager->BeginDynamicGeometry(cmd, frameIndex);
+
+    // if the submitted static scene is built, start using it
+    if (asManager->TrySwapStaticScene(cmd, frameIndex))
+    {
+        staticUniqueIDToSimpleIndex = std::move(pendingStaticUniqueIDToSimpleIndex);
+        movableGeomIndices = std::move(pendingMovableGeomIndices);
+        pendingStaticUniqueIDToSimpleIndex.clear();
+        pendingMovableGeomIndices.clear();
+
+        recordedStaticUniqueIDs.clear();
+
+        // static vertices of the new scene must be preprocessed
+        submittedStaticInCurrentFrame = true;
+    }
+
+    // apply static geometry edits, dynamic geometry is not added yet,
+    // so static simple indices can be reused
+    asManager->SubmitStaticGeometryEdits(cmd, frameIndex, addedStaticGeoms);
+
+    for (const auto &a : addedStaticGeoms)
+    {
+        recordedStaticUniqueIDs.erase(a.uniqueID);
+
+        if (a.simpleIndex == UINT32_MAX)
+        {
+            continue;
+        }
+
+        staticUniqueIDToSimpleIndex[a.uniqueID] = a.simpleIndex;
+
+        if (a.isMovable)
+        {
+            movableGeomIndices.push_back(a.simpleIndex);
+        }
+    }
 }
 
-bool Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform)
+bool Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform, FrameStatistics &statistics)
 {
+    // movable geometries are not preprocessed, their transforms are in TLAS instances
     uint32_t preprocMode = submittedStaticInCurrentFrame ? VERT_PREPROC_MODE_ALL : 
-                           toResubmitMovable             ? VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE : 
                                                            VERT_PREPROC_MODE_ONLY_DYNAMIC;
     submittedStaticInCurrentFrame = false;
 
@@ -76,26 +114,25 @@ bool Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::
     // copy to device-local, if there were any tex coords change for static geometry
     asManager->ResubmitStaticTexCoords(cmd);
 
-    if (toResubmitMovable)
-    {
-        // at least one transform of static movable geometry was changed
-        asManager->ResubmitStaticMovable(cmd);
-        toResubmitMovable = false;
-    }
-
     // always submit dynamic geomtetry on the frame ending
     asManager->SubmitDynamicGeometry(cmd, frameIndex);
 
 
     // copy geom infos to device-local
-    geomInfoMgr->CopyFromStaging(cmd, frameIndex);
+    {
+        FrameStatistics::ScopedStage stage(statistics, FrameStatistics::Stage::GeomInfoCopy);
+        geomInfoMgr->CopyFromStaging(cmd, frameIndex);
+    }
 
 
     ShVertPreprocessing push = {};
     ASManager::TLASPrepareResult prepare = {};
 
     // prepare for building and fill uniform data
-    asManager->PrepareForBuildingTLAS(frameIndex, *uniform->GetData(), &push, &prepare);
+    {
+        FrameStatistics::ScopedStage stage(statistics, FrameStatistics::Stage::TLASPrepare);
+        asManager->PrepareForBuildingTLAS(frameIndex, *uniform->GetData(), &push, &prepare);
+    }
 
     // upload uniform data
     uniform->Upload(cmd, frameIndex);
@@ -104,6 +141,7 @@ bool Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::
     vertPreproc->Preprocess(cmd, frameIndex, preprocMode, uniform, asManager, push);
 
 
+    FrameStatistics::ScopedStage stage(statistics, FrameStatistics::Stage::TLASBuild);
     return asManager->TryBuildTLAS(cmd, frameIndex, prepare);
 }
 
@@ -138,11 +176,11 @@ bool Scene::Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
 
         if (simpleIndex != UINT32_MAX)
         {
-            staticUniqueIDToSimpleIndex[uploadInfo.uniqueID] = simpleIndex;
+            pendingStaticUniqueIDToSimpleIndex[uploadInfo.uniqueID] = simpleIndex;
 
             if (uploadInfo.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
             {
-                movableGeomIndices.push_back(simpleIndex);
+                pendingMovableGeomIndices.push_back(simpleIndex);
             }
 
             return true;
@@ -152,6 +190,152 @@ bool Scene::Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
     return false;
 }
 
+uint32_t Scene::Upload(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pUploadInfos, uint32_t *pOutVertexCount, uint32_t *pOutIndexCount)
+{
+    *pOutVertexCount = 0;
+    *pOutIndexCount = 0;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const bool isDynamic = pUploadInfos[0].geomType == RG_GEOMETRY_TYPE_DYNAMIC;
+
+    if (isDynamic && isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (!isDynamic && !isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Submitting static geometry is only allowed between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    // static geometries are uploaded to the pending static scene
+    auto &uniqueIDToSimpleIndex = isDynamic ? dynamicUniqueIDToSimpleIndex : pendingStaticUniqueIDToSimpleIndex;
+    const auto &otherUniqueIDToSimpleIndex = isDynamic ? staticUniqueIDToSimpleIndex : dynamicUniqueIDToSimpleIndex;
+
+    // so iterators are not invalidated while inserting
+    uniqueIDToSimpleIndex.reserve(uniqueIDToSimpleIndex.size() + count);
+
+    // insert all IDs before uploading, to not leave the batch half-uploaded
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const RgGeometryUploadInfo &info = pUploadInfos[i];
+        const char *pError = nullptr;
+
+        if ((info.geomType == RG_GEOMETRY_TYPE_DYNAMIC) != isDynamic)
+        {
+            pError = "Geometries in a batch must be either all dynamic or all static";
+        }
+        else if (otherUniqueIDToSimpleIndex.find(info.uniqueID) != otherUniqueIDToSimpleIndex.end() ||
+                 !uniqueIDToSimpleIndex.emplace(info.uniqueID, UINT32_MAX).second)
+        {
+            pError = "Geometry with such ID already exists";
+        }
+
+        if (pError != nullptr)
+        {
+            // revert
+            for (uint32_t k = 0; k < i; k++)
+            {
+                uniqueIDToSimpleIndex.erase(pUploadInfos[k].uniqueID);
+            }
+
+            throw RgException(RG_WRONG_ARGUMENT, std::string(pError) + ", ID=" + std::to_string(info.uniqueID));
+        }
+    }
+
+    batchSimpleIndices.resize(count);
+
+    if (isDynamic)
+    {
+        asManager->AddDynamicGeometries(frameIndex, count, pUploadInfos, batchSimpleIndices.data());
+    }
+    else
+    {
+        asManager->AddStaticGeometries(frameIndex, count, pUploadInfos, batchSimpleIndices.data());
+    }
+
+    uint32_t uploadedCount = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t simpleIndex = batchSimpleIndices[i];
+
+        if (simpleIndex == UINT32_MAX)
+        {
+            uniqueIDToSimpleIndex.erase(pUploadInfos[i].uniqueID);
+            continue;
+        }
+
+        uniqueIDToSimpleIndex[pUploadInfos[i].uniqueID] = simpleIndex;
+
+        if (pUploadInfos[i].geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
+        {
+            pendingMovableGeomIndices.push_back(simpleIndex);
+        }
+
+        uploadedCount++;
+        *pOutVertexCount += pUploadInfos[i].vertexCount;
+        *pOutIndexCount += pUploadInfos[i].indexCount;
+    }
+
+    return uploadedCount;
+}
+
+bool Scene::RecordDynamic(uint32_t frameIndex, uint32_t contextIndex, const RgGeometryUploadInfo &uploadInfo)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    return asManager->RecordDynamicGeometry(frameIndex, contextIndex, uploadInfo);
+}
+
+bool Scene::MapDynamic(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo, RgGeometryUploadInfo &outMappedInfo)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (DoesUniqueIDExist(uploadInfo.uniqueID))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Geometry with such ID already exists, ID=" + std::to_string(uploadInfo.uniqueID));
+    }
+
+    if (!asManager->MapDynamicGeometry(frameIndex, uploadInfo, outMappedInfo))
+    {
+        return false;
+    }
+
+    // reserve ID until the geometry is committed
+    dynamicUniqueIDToSimpleIndex[uploadInfo.uniqueID] = UINT32_MAX;
+    return true;
+}
+
+bool Scene::CommitMappedDynamic(uint32_t frameIndex, uint64_t uniqueID, RgGeometryUploadInfo &outMappedInfo)
+{
+    if (!asManager->IsDynamicGeometryMapped(uniqueID))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID=" + std::to_string(uniqueID) + " is not mapped or already committed");
+    }
+
+    const uint32_t simpleIndex = asManager->CommitMappedDynamicGeometry(frameIndex, uniqueID, outMappedInfo);
+
+    if (simpleIndex == UINT32_MAX)
+    {
+        dynamicUniqueIDToSimpleIndex.erase(uniqueID);
+        return false;
+    }
+
+    dynamicUniqueIDToSimpleIndex[uniqueID] = simpleIndex;
+    return true;
+}
+
 bool Scene::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
 {
     uint32_t simpleIndex;
@@ -166,15 +350,9 @@ bool Scene::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
         throw RgException(RG_CANT_UPDATE_TRANSFORM, "Static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID) + " isn't movable");
     }
 
+    // only TLAS instance is changed, it's rebuilt every frame anyway
     asManager->UpdateStaticMovableTransform(simpleIndex, updateInfo);
 
-    // if not recording, then static geometries were already submitted,
-    // as some movable transform was changed AS must be rebuilt
-    if (!isRecordingStatic)
-    {
-        toResubmitMovable = true;
-    }
-
     return true;
 }
 
@@ -190,6 +368,44 @@ bool RTGL1::Scene::UpdateTexCoords(const RgUpdateTexCoordsInfo &texCoordsInfo)
     return true;
 }
 
+RgMesh Scene::CreateMesh(const RgMeshCreateInfo &createInfo)
+{
+    if (!isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Meshes can be created only between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    uint32_t meshIndex = asManager->AddMesh(createInfo);
+
+    if (meshIndex == UINT32_MAX)
+    {
+        return RG_NO_MESH;
+    }
+
+    // 0 is reserved for RG_NO_MESH
+    return meshIndex + 1;
+}
+
+bool Scene::UploadMeshInstance(uint32_t frameIndex, const RgMeshInstanceUploadInfo &uploadInfo)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Mesh instances must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (uploadInfo.mesh == RG_NO_MESH || uploadInfo.mesh > asManager->GetMeshCount())
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Mesh instance has an invalid mesh, ID=" + std::to_string(uploadInfo.uniqueID));
+    }
+
+    if (!meshInstanceUniqueIDs.insert(uploadInfo.uniqueID).second)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Mesh instance with such ID already exists, ID=" + std::to_string(uploadInfo.uniqueID));
+    }
+
+    return asManager->AddMeshInstance(frameIndex, uploadInfo.mesh - 1, uploadInfo);
+}
+
 void Scene::SubmitStatic()
 {
     // submit even if nothing was recorded, 
@@ -197,12 +413,15 @@ void Scene::SubmitStatic()
     if (!isRecordingStatic)
     {
         asManager->BeginStaticGeometry();
+
+        pendingStaticUniqueIDToSimpleIndex.clear();
+        pendingMovableGeomIndices.clear();
+        recordedStaticUniqueIDs.clear();
     }
 
+    // the scene is swapped on the frame start, when its building is finished
     asManager->SubmitStaticGeometry();
     isRecordingStatic = false;
-
-    submittedStaticInCurrentFrame = true;
 }
 
 void Scene::StartNewStatic()
@@ -216,8 +435,73 @@ void Scene::StartNewStatic()
     asManager->BeginStaticGeometry();
     lightManager->Reset();
 
-    staticUniqueIDToSimpleIndex.clear();
-    movableGeomIndices.clear();
+    // the current static scene is used until the new one is built
+    pendingStaticUniqueIDToSimpleIndex.clear();
+    pendingMovableGeomIndices.clear();
+    recordedStaticUniqueIDs.clear();
+}
+
+bool Scene::AddStatic(const RgGeometryUploadInfo &uploadInfo)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Static geometry must not be added between rgStartNewScene and rgSubmitStaticGeometries calls, upload it instead");
+    }
+
+    if (asManager->IsStaticSceneSwapPending())
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Static geometry must not be added while the submitted static scene is being built");
+    }
+
+    if (DoesUniqueIDExist(uploadInfo.uniqueID))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Geometry with such ID already exists, ID=" + std::to_string(uploadInfo.uniqueID));
+    }
+
+    if (!asManager->RecordStaticGeometry(uploadInfo))
+    {
+        return false;
+    }
+
+    recordedStaticUniqueIDs.insert(uploadInfo.uniqueID);
+    return true;
+}
+
+void Scene::RemoveStatic(uint64_t uniqueID)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Static geometry must not be removed between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (asManager->IsStaticSceneSwapPending())
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Static geometry must not be removed while the submitted static scene is being built");
+    }
+
+    // if it wasn't added yet
+    if (recordedStaticUniqueIDs.erase(uniqueID) > 0)
+    {
+        asManager->CancelRecordedStaticGeometry(uniqueID);
+        return;
+    }
+
+    uint32_t simpleIndex;
+    if (!TryGetStaticSimpleIndex(uniqueID, &simpleIndex))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Can't find static geometry with unique ID=" + std::to_string(uniqueID));
+    }
+
+    staticUniqueIDToSimpleIndex.erase(uniqueID);
+
+    auto m = std::find(movableGeomIndices.begin(), movableGeomIndices.end(), simpleIndex);
+
+    if (m != movableGeomIndices.end())
+    {
+        movableGeomIndices.erase(m);
+    }
+
+    asManager->RemoveStaticGeometry(simpleIndex);
 }
 
 const std::shared_ptr<ASManager> &Scene::GetASManager()
@@ -235,11 +519,20 @@ const std::shared_ptr<VertexPreprocessing> &RTGL1::Scene::GetVertexPreprocessing
     return vertPreproc;
 }
 
+bool Scene::IsStaticSceneSwapPending() const
+{
+    return asManager->IsStaticSceneSwapPending();
+}
+
 bool Scene::DoesUniqueIDExist(uint64_t uniqueID) const
 {
+    // while recording, static IDs are checked only in the new scene
+    const auto &staticIDs = isRecordingStatic ? pendingStaticUniqueIDToSimpleIndex : staticUniqueIDToSimpleIndex;
+
     return
-        staticUniqueIDToSimpleIndex.find(uniqueID) != staticUniqueIDToSimpleIndex.end() ||
-        dynamicUniqueIDToSimpleIndex.find(uniqueID) != dynamicUniqueIDToSimpleIndex.end();
+        staticIDs.find(uniqueID) != staticIDs.end() ||
+        dynamicUniqueIDToSimpleIndex.find(uniqueID) != dynamicUniqueIDToSimpleIndex.end() ||
+        recordedStaticUniqueIDs.find(uniqueID) != recordedStaticUniqueIDs.end();
 }
 
 bool Scene::TryGetStaticSimpleIndex(uint64_t uniqueID, uint32_t *result) const
@@ -21,8 +21,10 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
 
 #include "ASManager.h"
+#include "FrameStatistics.h"
 #include "LightManager.h"
 #include "VertexPreprocessing.h"
 
@@ -39,7 +41,10 @@ public:
         std::shared_ptr<TextureManager> &textureManager,
         const std::shared_ptr<const GlobalUniform> &uniform,
         const std::shared_ptr<const ShaderManager> &shaderManager,
-        const VertexBufferProperties &properties);
+        const VertexBufferProperties &properties,
+        uint32_t framesInFlight,
+        uint32_t dynamicRecordingContextCount,
+        uint32_t maxStaticClusterCount);
 
     ~Scene();
 
@@ -50,18 +55,41 @@ public:
 
     void PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex);
     // Return true if TLAS was built
-    bool SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform);
+    bool SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform, FrameStatistics &statistics);
 
     bool Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo);
+    // Upload geometries that are either all dynamic or all static.
+    // Unique IDs are checked and inserted for the whole batch before uploading.
+    // Returns the amount of uploaded geometries, their vertex and index counts are summed to the out params.
+    uint32_t Upload(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pUploadInfos, uint32_t *pOutVertexCount, uint32_t *pOutIndexCount);
+    // Thread-safe, if each thread uses its own context. Unique ID is not checked.
+    bool RecordDynamic(uint32_t frameIndex, uint32_t contextIndex, const RgGeometryUploadInfo &uploadInfo);
+    // Reserve unique ID and ranges for the geometry, which data will be written by the user.
+    // Returns false, if there's no space for the geometry.
+    bool MapDynamic(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo, RgGeometryUploadInfo &outMappedInfo);
+    // Returns false, if the geometry wasn't added
+    bool CommitMappedDynamic(uint32_t frameIndex, uint64_t uniqueID, RgGeometryUploadInfo &outMappedInfo);
     bool UpdateTransform(const RgUpdateTransformInfo &updateInfo);
     bool UpdateTexCoords(const RgUpdateTexCoordsInfo &texCoordsInfo);
 
+    // Returns RG_NO_MESH, if mesh wasn't created
+    RgMesh CreateMesh(const RgMeshCreateInfo &createInfo);
+    bool UploadMeshInstance(uint32_t frameIndex, const RgMeshInstanceUploadInfo &uploadInfo);
+
     void UploadLight(uint32_t frameIndex, const RgDirectionalLightUploadInfo &lightInfo);
     void UploadLight(uint32_t frameIndex, const RgSphericalLightUploadInfo &lightInfo);
     void UploadLight(uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform, const RgSpotlightUploadInfo &lightInfo);
 
+    // Static scene is built asynchronously, it replaces the current one
+    // on the first frame start after its building is finished.
     void SubmitStatic();
     void StartNewStatic();
+    bool IsStaticSceneSwapPending() const;
+
+    // Edit the submitted static scene, changes are applied on the next frame start.
+    // Returns false, if there's no space for the geometry.
+    bool AddStatic(const RgGeometryUploadInfo &uploadInfo);
+    void RemoveStatic(uint64_t uniqueID);
 
     const std::shared_ptr<ASManager> &GetASManager();
     const std::shared_ptr<LightManager> &GetLightManager();
@@ -81,13 +109,25 @@ private:
     // Dynamic indices are cleared every frame
     std::unordered_map<uint64_t, uint32_t> dynamicUniqueIDToSimpleIndex;
     std::unordered_map<uint64_t, uint32_t> staticUniqueIDToSimpleIndex;
+    // IDs of the static scene that is being recorded or built
+    std::unordered_map<uint64_t, uint32_t> pendingStaticUniqueIDToSimpleIndex;
+    // Mesh instance IDs are cleared every frame
+    std::unordered_set<uint64_t> meshInstanceUniqueIDs;
 
     // Movable geometry IDs
     std::vector<uint32_t> movableGeomIndices;
-    bool toResubmitMovable;
+    std::vector<uint32_t> pendingMovableGeomIndices;
+
+    // IDs of static geometries that are added on the next frame start
+    std::unordered_set<uint64_t> recordedStaticUniqueIDs;
+    // temporary storage for the results of static geometry edits
+    std::vector<ASManager::AddedStaticGeometry> addedStaticGeoms;
 
     bool isRecordingStatic;
     bool submittedStaticInCurrentFrame;
+
+    // temporary storage for batched upload
+    std::vector<uint32_t> batchSimpleIndices;
 };
 
 }
\ No newline at end of file
@@ -119,6 +119,7 @@ DerivativeSet getTriangleUVDerivativesFromRayCone(
 
 vec4 getTextureSampleDerivU(uint textureIndex, const vec2 texCoord, const float uDeriv)
 {
+    markTextureUsed(textureIndex);
     return textureGrad(globalTextures[nonuniformEXT(textureIndex)], texCoord, vec2(uDeriv, 0), vec2(0, uDeriv));
 }
 
@@ -62,23 +62,54 @@ layout(
     binding = BINDING_TEXTURES)
     uniform sampler2D globalTextures[];
 
+// Non-zero, if a texture was sampled in the frame. It's read
+// on CPU to find out what textures can be evicted or must be reloaded.
+layout(
+    set = DESC_SET_TEXTURES,
+    binding = BINDING_TEXTURE_USAGE)
+    buffer TextureUsage_BT
+{
+    uint textureUsage[];
+};
+
+// Non-zero, if the usage must be written, i.e. if there's a texture memory budget.
+layout(constant_id = CONSTANT_ID_TEXTURE_USAGE_TRACKING) const uint textureUsageTracking = 0;
+
+void markTextureUsed(uint textureIndex)
+{
+    if (textureUsageTracking == 0)
+    {
+        return;
+    }
+
+    // read first to not write the same value from each invocation
+    if (textureUsage[textureIndex] == 0)
+    {
+        textureUsage[textureIndex] = 1;
+    }
+}
+
 sampler2D getTexture(uint textureIndex)
 {
+    markTextureUsed(textureIndex);
     return globalTextures[nonuniformEXT(textureIndex)];
 }
 
 vec4 getTextureSample(uint textureIndex, const vec2 texCoord)
 {
+    markTextureUsed(textureIndex);
     return texture(globalTextures[nonuniformEXT(textureIndex)], texCoord);
 }
 
 vec4 getTextureSampleLod(uint textureIndex, const vec2 texCoord, float lod)
 {
+    markTextureUsed(textureIndex);
     return textureLod(globalTextures[nonuniformEXT(textureIndex)], texCoord, lod);
 }
 
 vec4 getTextureSampleGrad(uint textureIndex, const vec2 texCoord, const vec2 dPdx, const vec2 dPdy)
 {
+    markTextureUsed(textureIndex);
     return textureGrad(globalTextures[nonuniformEXT(textureIndex)], texCoord, dPdx, dPdy);
 }
 #endif // DESC_SET_TEXTURES
@@ -86,7 +117,9 @@ vec4 getTextureSampleGrad(uint textureIndex, const vec2 texCoord, const vec2 dPd
 
 
 // instanceID is assumed to be < 256 (i.e. 8 bits ) and 
-// instanceCustomIndexEXT is 24 bits by Vulkan spec
+// instanceCustomIndexEXT is 24 bits by Vulkan spec;
+// instanceID of mesh instances and movable geometries can be larger, but it's not used for them
+// as their geometry index is in instanceCustomIndexEXT
 uint packInstanceIdAndCustomIndex(int instanceID, int instanceCustomIndexEXT)
 {
     return (instanceID << 24) | instanceCustomIndexEXT;
@@ -140,6 +173,49 @@ void unpackGeometryAndPrimitiveIndex(uint geomAndPrimIndex, out int geometryInde
 
 
 
+// Vertex attributes of the compact layout (globalUniform.vertexDataCompact),
+// must match the encoders in VertexEncoding.cpp
+vec2 signNotZero(const vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+uint encodeVertexNormalOct(const vec3 n)
+{
+    vec2 p = n.xy / max(abs(n.x) + abs(n.y) + abs(n.z), 0.000001);
+
+    if (n.z < 0.0)
+    {
+        p = (1.0 - abs(p.yx)) * signNotZero(p);
+    }
+
+    return packSnorm2x16(p);
+}
+
+vec3 decodeVertexNormalOct(uint encoded)
+{
+    const vec2 p = unpackSnorm2x16(encoded);
+    vec3 n = vec3(p.x, p.y, 1.0 - abs(p.x) - abs(p.y));
+
+    // unfold the lower hemisphere
+    const float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+
+    return normalize(n);
+}
+
+uint encodeVertexTexCoord(const vec2 t)
+{
+    return packHalf2x16(t);
+}
+
+vec2 decodeVertexTexCoord(uint encoded)
+{
+    return unpackHalf2x16(encoded);
+}
+
+
+
 #ifdef DESC_SET_GLOBAL_UNIFORM
 #ifdef DESC_SET_VERTEX_DATA
     #include "VertexData.inl"
@@ -20,6 +20,8 @@
 
 #ifdef DESC_SET_GLOBAL_UNIFORM
 #ifdef DESC_SET_VERTEX_DATA
+// Vertex streams are stored one after another: positions are at the beginning,
+// offsets of the others are in the global uniform, as they depend on the buffer capacity.
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_VERTEX_BUFFER_STATIC)
@@ -28,7 +30,7 @@ layout(
     #endif
     buffer VertexBufferStatic_BT
 {
-    ShVertexBufferStatic staticVertices;
+    float staticVertexData[];
 };
 
 layout(
@@ -39,7 +41,30 @@ layout(
     #endif
     buffer VertexBufferDynamic_BT
 {
-    ShVertexBufferDynamic dynamicVertices;
+    float dynamicVertexData[];
+};
+
+// same buffers as above, for the packed normals and tex coords, if globalUniform.vertexDataCompact is not 0
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_VERTEX_BUFFER_STATIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer VertexBufferStaticUint_BT
+{
+    uint staticVertexDataUint[];
+};
+
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_VERTEX_BUFFER_DYNAMIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer VertexBufferDynamicUint_BT
+{
+    uint dynamicVertexDataUint[];
 };
 
 layout(
@@ -103,114 +128,204 @@ layout(
 vec3 getStaticVerticesPositions(uint index)
 {
     return vec3(
-        staticVertices.positions[index * globalUniform.positionsStride + 0],
-        staticVertices.positions[index * globalUniform.positionsStride + 1],
-        staticVertices.positions[index * globalUniform.positionsStride + 2]);
+        staticVertexData[index * globalUniform.positionsStride + 0],
+        staticVertexData[index * globalUniform.positionsStride + 1],
+        staticVertexData[index * globalUniform.positionsStride + 2]);
 }
 
 vec3 getStaticVerticesNormals(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexNormalOct(staticVertexDataUint[globalUniform.staticNormalsOffset + index]);
+    }
+
+    const uint base = globalUniform.staticNormalsOffset + index * globalUniform.normalsStride;
+
     return vec3(
-        staticVertices.normals[index * globalUniform.normalsStride + 0],
-        staticVertices.normals[index * globalUniform.normalsStride + 1],
-        staticVertices.normals[index * globalUniform.normalsStride + 2]);
+        staticVertexData[base + 0],
+        staticVertexData[base + 1],
+        staticVertexData[base + 2]);
 }
 
 vec2 getStaticVerticesTexCoords(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexTexCoord(staticVertexDataUint[globalUniform.staticTexCoordsOffset + index]);
+    }
+
+    const uint base = globalUniform.staticTexCoordsOffset + index * globalUniform.texCoordsStride;
+
     return vec2(
-        staticVertices.texCoords[index * globalUniform.texCoordsStride + 0],
-        staticVertices.texCoords[index * globalUniform.texCoordsStride + 1]);
+        staticVertexData[base + 0],
+        staticVertexData[base + 1]);
 }
 
 vec2 getStaticVerticesTexCoordsLayer1(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexTexCoord(staticVertexDataUint[globalUniform.staticTexCoordsLayer1Offset + index]);
+    }
+
+    const uint base = globalUniform.staticTexCoordsLayer1Offset + index * globalUniform.texCoordsStride;
+
     return vec2(
-        staticVertices.texCoordsLayer1[index * globalUniform.texCoordsStride + 0],
-        staticVertices.texCoordsLayer1[index * globalUniform.texCoordsStride + 1]);
+        staticVertexData[base + 0],
+        staticVertexData[base + 1]);
 }
 
 vec2 getStaticVerticesTexCoordsLayer2(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexTexCoord(staticVertexDataUint[globalUniform.staticTexCoordsLayer2Offset + index]);
+    }
+
+    const uint base = globalUniform.staticTexCoordsLayer2Offset + index * globalUniform.texCoordsStride;
+
     return vec2(
-        staticVertices.texCoordsLayer2[index * globalUniform.texCoordsStride + 0],
-        staticVertices.texCoordsLayer2[index * globalUniform.texCoordsStride + 1]);
+        staticVertexData[base + 0],
+        staticVertexData[base + 1]);
 }
 
 vec3 getDynamicVerticesPositions(uint index)
 {
     return vec3(
-        dynamicVertices.positions[index * globalUniform.positionsStride + 0],
-        dynamicVertices.positions[index * globalUniform.positionsStride + 1],
-        dynamicVertices.positions[index * globalUniform.positionsStride + 2]);
+        dynamicVertexData[index * globalUniform.positionsStride + 0],
+        dynamicVertexData[index * globalUniform.positionsStride + 1],
+        dynamicVertexData[index * globalUniform.positionsStride + 2]);
 }
 
 vec3 getDynamicVerticesNormals(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexNormalOct(dynamicVertexDataUint[globalUniform.dynamicNormalsOffset + index]);
+    }
+
+    const uint base = globalUniform.dynamicNormalsOffset + index * globalUniform.normalsStride;
+
     return vec3(
-        dynamicVertices.normals[index * globalUniform.normalsStride + 0],
-        dynamicVertices.normals[index * globalUniform.normalsStride + 1],
-        dynamicVertices.normals[index * globalUniform.normalsStride + 2]);
+        dynamicVertexData[base + 0],
+        dynamicVertexData[base + 1],
+        dynamicVertexData[base + 2]);
 }
 
 vec2 getDynamicVerticesTexCoords(uint index)
 {
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        return decodeVertexTexCoord(dynamicVertexDataUint[globalUniform.dynamicTexCoordsOffset + index]);
+    }
+
+    const uint base = globalUniform.dynamicTexCoordsOffset + index * globalUniform.texCoordsStride;
+
     return vec2(
-        dynamicVertices.texCoords[index * globalUniform.texCoordsStride + 0],
-        dynamicVertices.texCoords[index * globalUniform.texCoordsStride + 1]);
+        dynamicVertexData[base + 0],
+        dynamicVertexData[base + 1]);
 }
 
 #ifdef VERTEX_BUFFER_WRITEABLE
 void setStaticVerticesPositions(uint index, vec3 value)
 {
-    staticVertices.positions[index * globalUniform.positionsStride + 0] = value[0];
-    staticVertices.positions[index * globalUniform.positionsStride + 1] = value[1];
-    staticVertices.positions[index * globalUniform.positionsStride + 2] = value[2];
+    staticVertexData[index * globalUniform.positionsStride + 0] = value[0];
+    staticVertexData[index * globalUniform.positionsStride + 1] = value[1];
+    staticVertexData[index * globalUniform.positionsStride + 2] = value[2];
 }
 
 void setStaticVerticesNormals(uint index, vec3 value)
 {
-    staticVertices.normals[index * globalUniform.normalsStride + 0] = value[0];
-    staticVertices.normals[index * globalUniform.normalsStride + 1] = value[1];
-    staticVertices.normals[index * globalUniform.normalsStride + 2] = value[2];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        staticVertexDataUint[globalUniform.staticNormalsOffset + index] = encodeVertexNormalOct(value);
+        return;
+    }
+
+    const uint base = globalUniform.staticNormalsOffset + index * globalUniform.normalsStride;
+
+    staticVertexData[base + 0] = value[0];
+    staticVertexData[base + 1] = value[1];
+    staticVertexData[base + 2] = value[2];
 }
 
 void setStaticVerticesTexCoords(uint index, vec2 value)
 {
-    staticVertices.texCoords[index * globalUniform.texCoordsStride + 0] = value[0];
-    staticVertices.texCoords[index * globalUniform.texCoordsStride + 1] = value[1];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        staticVertexDataUint[globalUniform.staticTexCoordsOffset + index] = encodeVertexTexCoord(value);
+        return;
+    }
+
+    const uint base = globalUniform.staticTexCoordsOffset + index * globalUniform.texCoordsStride;
+
+    staticVertexData[base + 0] = value[0];
+    staticVertexData[base + 1] = value[1];
 }
 
 void setStaticVerticesTexCoordsLayer1(uint index, vec2 value)
 {
-    staticVertices.texCoordsLayer1[index * globalUniform.texCoordsStride + 0] = value[0];
-    staticVertices.texCoordsLayer1[index * globalUniform.texCoordsStride + 1] = value[1];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        staticVertexDataUint[globalUniform.staticTexCoordsLayer1Offset + index] = encodeVertexTexCoord(value);
+        return;
+    }
+
+    const uint base = globalUniform.staticTexCoordsLayer1Offset + index * globalUniform.texCoordsStride;
+
+    staticVertexData[base + 0] = value[0];
+    staticVertexData[base + 1] = value[1];
 }
 
 void setStaticVerticesTexCoordsLayer2(uint index, vec2 value)
 {
-    staticVertices.texCoordsLayer2[index * globalUniform.texCoordsStride + 0] = value[0];
-    staticVertices.texCoordsLayer2[index * globalUniform.texCoordsStride + 1] = value[1];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        staticVertexDataUint[globalUniform.staticTexCoordsLayer2Offset + index] = encodeVertexTexCoord(value);
+        return;
+    }
+
+    const uint base = globalUniform.staticTexCoordsLayer2Offset + index * globalUniform.texCoordsStride;
+
+    staticVertexData[base + 0] = value[0];
+    staticVertexData[base + 1] = value[1];
 }
 
 void setDynamicVerticesPositions(uint index, vec3 value)
 {
-    dynamicVertices.positions[index * globalUniform.positionsStride + 0] = value[0];
-    dynamicVertices.positions[index * globalUniform.positionsStride + 1] = value[1];
-    dynamicVertices.positions[index * globalUniform.positionsStride + 2] = value[2];
+    dynamicVertexData[index * globalUniform.positionsStride + 0] = value[0];
+    dynamicVertexData[index * globalUniform.positionsStride + 1] = value[1];
+    dynamicVertexData[index * globalUniform.positionsStride + 2] = value[2];
 }
 
 void setDynamicVerticesNormals(uint index, vec3 value)
 {
-    dynamicVertices.normals[index * globalUniform.normalsStride + 0] = value[0];
-    dynamicVertices.normals[index * globalUniform.normalsStride + 1] = value[1];
-    dynamicVertices.normals[index * globalUniform.normalsStride + 2] = value[2];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        dynamicVertexDataUint[globalUniform.dynamicNormalsOffset + index] = encodeVertexNormalOct(value);
+        return;
+    }
+
+    const uint base = globalUniform.dynamicNormalsOffset + index * globalUniform.normalsStride;
+
+    dynamicVertexData[base + 0] = value[0];
+    dynamicVertexData[base + 1] = value[1];
+    dynamicVertexData[base + 2] = value[2];
 }
 
 void setDynamicVerticesTexCoords(uint index, vec2 value)
 {
-    dynamicVertices.texCoords[index * globalUniform.texCoordsStride + 0] = value[0];
-    dynamicVertices.texCoords[index * globalUniform.texCoordsStride + 1] = value[1];
+    if (globalUniform.vertexDataCompact != 0)
+    {
+        dynamicVertexDataUint[globalUniform.dynamicTexCoordsOffset + index] = encodeVertexTexCoord(value);
+        return;
+    }
+
+    const uint base = globalUniform.dynamicTexCoordsOffset + index * globalUniform.texCoordsStride;
+
+    dynamicVertexData[base + 0] = value[0];
+    dynamicVertexData[base + 1] = value[1];
 }
 #endif // VERTEX_BUFFER_WRITEABLE
 
@@ -354,15 +469,23 @@ ShTriangle getTriangleDynamic(uvec3 vertIndices, uint baseVertexIndex, uint base
 }
 
 // Get geometry index in "geometryInstances" array by instanceID, localGeometryIndex.
-int getGeometryIndex(int instanceID, int localGeometryIndex)
+int getGeometryIndex(int instanceID, int instanceCustomIndex, int localGeometryIndex)
 {
+    // mesh instances and movable geometries store their global geometry index in the custom index
+    if ((instanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_OBJECT) != 0)
+    {
+        return (instanceCustomIndex >> INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET) + localGeometryIndex;
+    }
+
     return globalUniform.instanceGeomInfoOffset[instanceID / 4][instanceID % 4] + localGeometryIndex;
 }
 
-bool getCurrentGeometryIndexByPrev(int prevInstanceID, int prevLocalGeometryIndex, out int curFrameGlobalGeomIndex)
+bool getCurrentGeometryIndexByPrev(int prevInstanceID, int prevInstanceCustomIndex, int prevLocalGeometryIndex, out int curFrameGlobalGeomIndex)
 {
     // get previous frame's global geom index
-    const int prevFrameGeomIndex = globalUniform.instanceGeomInfoOffsetPrev[prevInstanceID / 4][prevInstanceID % 4] + prevLocalGeometryIndex;
+    const int prevFrameGeomIndex = (prevInstanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_OBJECT) != 0 ?
+        (prevInstanceCustomIndex >> INSTANCE_CUSTOM_INDEX_GEOM_INDEX_OFFSET) + prevLocalGeometryIndex :
+        globalUniform.instanceGeomInfoOffsetPrev[prevInstanceID / 4][prevInstanceID % 4] + prevLocalGeometryIndex;
     
     // try to find global geom index in current frame by it
     curFrameGlobalGeomIndex = geomIndexPrevToCur[prevFrameGeomIndex];
@@ -389,7 +512,7 @@ ShTriangle getTriangle(int instanceID, int instanceCustomIndex, int localGeometr
     ShTriangle tr;
 
     // get info about geometry by the index in pGeometries in BLAS with index "instanceID"
-    const int globalGeometryIndex = getGeometryIndex(instanceID, localGeometryIndex);
+    const int globalGeometryIndex = getGeometryIndex(instanceID, instanceCustomIndex, localGeometryIndex);
     const ShGeometryInstance inst = geometryInstances[globalGeometryIndex];
 
     const bool isDynamic = (instanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC) == INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC;
@@ -635,7 +758,7 @@ bool unpackPrevVisibilityBuffer(const vec4 v, out vec3 prevPos)
     unpackGeometryAndPrimitiveIndex(floatBitsToUint(v[1]), prevLocalGeomIndex, primIndex);
 
     int curFrameGlobalGeomIndex;
-    const bool matched = getCurrentGeometryIndexByPrev(prevInstanceID, prevLocalGeomIndex, curFrameGlobalGeomIndex);
+    const bool matched = getCurrentGeometryIndexByPrev(prevInstanceID, instCustomIndex, prevLocalGeomIndex, curFrameGlobalGeomIndex);
 
     if (!matched)
     {
@@ -650,9 +773,9 @@ bool unpackPrevVisibilityBuffer(const vec4 v, out vec3 prevPos)
     return true;
 }
 
-mat4 getModelMatrix(int instanceID, int localGeometryIndex)
+mat4 getModelMatrix(int instanceID, int instanceCustomIndex, int localGeometryIndex)
 {
-    int globalGeometryIndex = getGeometryIndex(instanceID, localGeometryIndex);
+    int globalGeometryIndex = getGeometryIndex(instanceID, instanceCustomIndex, localGeometryIndex);
     return geometryInstances[globalGeometryIndex].model;
 }
 #endif // DESC_SET_VERTEX_DATA
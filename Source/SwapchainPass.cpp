@@ -34,7 +34,7 @@ RTGL1::SwapchainPass::SwapchainPass(
 {
     CreateSwapchainRenderPass(_surfaceFormat);
 
-    swapchainPipelines = std::make_shared<RasterizerPipelines>(device, _pipelineLayout, swapchainRenderPass, _instanceInfo.rasterizedVertexColorGamma);
+    swapchainPipelines = std::make_shared<RasterizerPipelines>(device, _pipelineLayout, swapchainRenderPass, _instanceInfo.rasterizedVertexColorGamma, _instanceInfo.textureMemoryBudget > 0);
     swapchainPipelines->SetShaders(_shaderManager.get(), "VertRasterizer", "FragRasterizer");
 }
 
@@ -0,0 +1,155 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TextureDecoder.h"
+
+#include <zstd.h>
+
+using namespace RTGL1;
+
+TextureDecoder::TextureDecoder(uint32_t _threadCount) : stop(false)
+{
+    for (uint32_t i = 0; i < _threadCount; i++)
+    {
+        workers.emplace_back(&TextureDecoder::WorkerLoop, this);
+    }
+}
+
+TextureDecoder::~TextureDecoder()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stop = true;
+    }
+    queueCondition.notify_all();
+
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+
+    // all callers must be finished before destruction
+    assert(queue.empty());
+}
+
+bool TextureDecoder::InflateZstd(const Job *pJobs, uint32_t jobCount)
+{
+    if (jobCount == 0)
+    {
+        return true;
+    }
+
+    Batch batch = {};
+    batch.remaining = jobCount;
+    batch.failed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        for (uint32_t i = 0; i < jobCount; i++)
+        {
+            queue.push_back({ pJobs[i], &batch });
+        }
+    }
+    queueCondition.notify_all();
+
+    // help the workers instead of waiting, the jobs of other batches can be taken too
+    while (true)
+    {
+        Task task;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+
+            if (queue.empty())
+            {
+                break;
+            }
+
+            task = queue.front();
+            queue.pop_front();
+        }
+
+        Execute(task, nullptr);
+    }
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    finishedCondition.wait(lock, [&batch] { return batch.remaining == 0; });
+
+    return !batch.failed;
+}
+
+void TextureDecoder::WorkerLoop()
+{
+    // reuse the context, to not allocate it for each job
+    ZSTD_DCtx *zstdContext = ZSTD_createDCtx();
+
+    while (true)
+    {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stop || !queue.empty(); });
+
+            if (stop)
+            {
+                break;
+            }
+
+            task = queue.front();
+            queue.pop_front();
+        }
+
+        Execute(task, zstdContext);
+    }
+
+    ZSTD_freeDCtx(zstdContext);
+}
+
+void TextureDecoder::Execute(const Task &task, void *zstdContext)
+{
+    const Job &job = task.job;
+
+    size_t r = zstdContext != nullptr ?
+        ZSTD_decompressDCtx(static_cast<ZSTD_DCtx *>(zstdContext), job.pDst, job.dstSize, job.pSrc, job.srcSize) :
+        ZSTD_decompress(job.pDst, job.dstSize, job.pSrc, job.srcSize);
+
+    bool success = !ZSTD_isError(r) && r == job.dstSize;
+    bool isBatchFinished;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        if (!success)
+        {
+            task.batch->failed = true;
+        }
+
+        task.batch->remaining--;
+        isBatchFinished = task.batch->remaining == 0;
+    }
+
+    // the batch can be destroyed after unlocking, so only the condition is used
+    if (isBatchFinished)
+    {
+        finishedCondition.notify_all();
+    }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+
+namespace RTGL1
+{
+
+// Inflates supercompressed texture levels on worker threads.
+// Can be used from several threads at once, e.g. by AsyncTextureLoader workers.
+class TextureDecoder
+{
+public:
+    struct Job
+    {
+        const uint8_t   *pSrc;
+        size_t          srcSize;
+        uint8_t         *pDst;
+        // exact size of the inflated data
+        size_t          dstSize;
+    };
+
+public:
+    // If threadCount is 0, jobs are done on the calling thread.
+    explicit TextureDecoder(uint32_t threadCount);
+    ~TextureDecoder();
+
+    TextureDecoder(const TextureDecoder &other) = delete;
+    TextureDecoder(TextureDecoder &&other) noexcept = delete;
+    TextureDecoder &operator=(const TextureDecoder &other) = delete;
+    TextureDecoder &operator=(TextureDecoder &&other) noexcept = delete;
+
+    // Inflate zstd data of each job, jobs are done in parallel.
+    // The calling thread takes jobs too, until all of them are finished.
+    // Returns false, if any of the jobs failed.
+    bool InflateZstd(const Job *pJobs, uint32_t jobCount);
+
+private:
+    struct Batch
+    {
+        uint32_t    remaining;
+        bool        failed;
+    };
+
+    struct Task
+    {
+        Job         job;
+        Batch       *batch;
+    };
+
+private:
+    void WorkerLoop();
+    void Execute(const Task &task, void *zstdContext);
+
+private:
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::condition_variable finishedCondition;
+    std::deque<Task> queue;
+    bool stop;
+
+    std::vector<std::thread> workers;
+};
+
+}
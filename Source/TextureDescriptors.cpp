@@ -23,9 +23,11 @@
 
 using namespace RTGL1;
 
-TextureDescriptors::TextureDescriptors(VkDevice _device, uint32_t _maxTextureCount, uint32_t _bindingIndex) :
+TextureDescriptors::TextureDescriptors(VkDevice _device, uint32_t _maxTextureCount, uint32_t _bindingIndex, uint32_t _framesInFlight,
+                                       uint32_t _usageBindingIndex, const VkBuffer *_pUsageBuffers) :
     device(_device),
     bindingIndex(_bindingIndex),
+    framesInFlight(_framesInFlight),
     descPool(VK_NULL_HANDLE),
     descLayout(VK_NULL_HANDLE),
     descSets{},
@@ -35,12 +37,12 @@ TextureDescriptors::TextureDescriptors(VkDevice _device, uint32_t _maxTextureCou
     writeImageInfos.resize(_maxTextureCount);
     writeInfos.resize(_maxTextureCount);
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         writeCache[i].resize(_maxTextureCount);
     }
 
-    CreateDescriptors(_maxTextureCount);
+    CreateDescriptors(_maxTextureCount, _usageBindingIndex, _pUsageBuffers);
 }
 
 TextureDescriptors::~TextureDescriptors()
@@ -66,34 +68,43 @@ void TextureDescriptors::SetEmptyTextureInfo(VkImageView view, VkSampler sampler
     emptyTextureInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
-void TextureDescriptors::CreateDescriptors(uint32_t maxTextureCount)
+void TextureDescriptors::CreateDescriptors(uint32_t maxTextureCount, uint32_t usageBindingIndex, const VkBuffer *pUsageBuffers)
 {
-    VkDescriptorSetLayoutBinding binding = {};
+    const uint32_t bindingCount = pUsageBuffers != nullptr ? 2 : 1;
 
-    binding.binding = bindingIndex;
-    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    binding.descriptorCount = maxTextureCount;
-    binding.stageFlags = VK_SHADER_STAGE_ALL;
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+
+    bindings[0].binding = bindingIndex;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = maxTextureCount;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding = usageBindingIndex;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
 
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &binding;
+    layoutInfo.bindingCount = bindingCount;
+    layoutInfo.pBindings = bindings;
 
     VkResult r = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descLayout);
     VK_CHECKERROR(r);
 
     SET_DEBUG_NAME(device, descLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Textures Desc set layout");
 
-    VkDescriptorPoolSize poolSize = {};
-    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSize.descriptorCount = maxTextureCount * MAX_FRAMES_IN_FLIGHT;
+    VkDescriptorPoolSize poolSizes[2] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = maxTextureCount * framesInFlight;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = framesInFlight;
 
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = framesInFlight;
+    poolInfo.poolSizeCount = bindingCount;
+    poolInfo.pPoolSizes = poolSizes;
 
     r = vkCreateDescriptorPool(device, &poolInfo, nullptr, &descPool);
     VK_CHECKERROR(r);
@@ -106,13 +117,37 @@ void TextureDescriptors::CreateDescriptors(uint32_t maxTextureCount)
     setInfo.descriptorSetCount = 1;
     setInfo.pSetLayouts = &descLayout;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         r = vkAllocateDescriptorSets(device, &setInfo, &descSets[i]);
         VK_CHECKERROR(r);
 
         SET_DEBUG_NAME(device, descSets[i], VK_OBJECT_TYPE_DESCRIPTOR_SET, "Textures desc set");
     }
+
+    if (pUsageBuffers != nullptr)
+    {
+        // usage buffers are not changed, so write them once
+        VkDescriptorBufferInfo bufInfos[MAX_FRAMES_IN_FLIGHT] = {};
+        VkWriteDescriptorSet writes[MAX_FRAMES_IN_FLIGHT] = {};
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            bufInfos[i].buffer = pUsageBuffers[i];
+            bufInfos[i].offset = 0;
+            bufInfos[i].range = VK_WHOLE_SIZE;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descSets[i];
+            writes[i].dstBinding = usageBindingIndex;
+            writes[i].dstArrayElement = 0;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufInfos[i];
+        }
+
+        vkUpdateDescriptorSets(device, framesInFlight, writes, 0, nullptr);
+    }
 }
 
 bool TextureDescriptors::IsCached(uint32_t frameIndex, uint32_t textureIndex, VkImageView view, VkSampler sampler)
@@ -30,7 +30,10 @@ namespace RTGL1
 class TextureDescriptors
 {
 public:
-    explicit TextureDescriptors(VkDevice device, uint32_t maxTextureCount, uint32_t bindingIndex);
+    // If pUsageBuffers is not null, the set also contains a storage buffer
+    // binding with a buffer per frame, shaders mark sampled textures there.
+    explicit TextureDescriptors(VkDevice device, uint32_t maxTextureCount, uint32_t bindingIndex, uint32_t framesInFlight,
+                                uint32_t usageBindingIndex = 0, const VkBuffer *pUsageBuffers = nullptr);
     ~TextureDescriptors();
 
     TextureDescriptors(const TextureDescriptors &other) = delete;
@@ -52,7 +55,7 @@ public:
     void SetEmptyTextureInfo(VkImageView view, VkSampler sampler);
 
 private:
-    void CreateDescriptors(uint32_t maxTextureCount);
+    void CreateDescriptors(uint32_t maxTextureCount, uint32_t usageBindingIndex, const VkBuffer *pUsageBuffers);
 
     bool IsCached(uint32_t frameIndex, uint32_t textureIndex, VkImageView view, VkSampler sampler);
     void AddToCache(uint32_t frameIndex, uint32_t textureIndex, VkImageView view, VkSampler sampler);
@@ -69,6 +72,7 @@ private:
     VkDevice device;
 
     uint32_t bindingIndex;
+    uint32_t framesInFlight;
 
     VkDescriptorPool descPool;
     VkDescriptorSetLayout descLayout;
@@ -20,6 +20,7 @@
 
 #include "TextureManager.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include "Const.h"
@@ -39,10 +40,13 @@ TextureManager::TextureManager(
     std::shared_ptr<SamplerManager> _samplerMgr,
     const std::shared_ptr<CommandBufferManager> &_cmdManager,
     std::shared_ptr<UserFileLoad> _userFileLoad,
+    uint32_t _framesInFlight,
     const RgInstanceCreateInfo &_info)
 :
     device(_device),
-    samplerMgr(std::move(_samplerMgr))
+    samplerMgr(std::move(_samplerMgr)),
+    lastAsyncRequestId(0),
+    streamingBytesPerFrame(_info.textureStreamingBytesPerFrame)
 {
     this->defaultTexturesPath = _info.pOverridenTexturesFolderPath != nullptr ? _info.pOverridenTexturesFolderPath : DEFAULT_TEXTURES_PATH;
 
@@ -68,14 +72,27 @@ TextureManager::TextureManager(
 
     const uint32_t maxTextureCount = std::max<uint32_t>(TEXTURE_COUNT_MIN, std::min<uint32_t>(_info.maxTextureCount, TEXTURE_COUNT_MAX));
 
-    imageLoader = std::make_shared<ImageLoader>(std::move(_userFileLoad));
-    textureDesc = std::make_shared<TextureDescriptors>(device, maxTextureCount, BINDING_TEXTURES);
+    // supercompressed levels are inflated in parallel, even if textures are loaded synchronously
+    auto decoder = std::make_shared<TextureDecoder>(_info.textureDecodeThreadCount);
+
+    if (_info.textureLoadThreadCount > 0)
+    {
+        asyncLoader = std::make_unique<AsyncTextureLoader>(_userFileLoad, decoder, _info.textureLoadThreadCount, GetOverrideInfo(false));
+    }
+
+    // usage is tracked only if there's a budget
+    residency = std::make_unique<TextureResidency>(device, _memAllocator, maxTextureCount, _framesInFlight, _info.textureMemoryBudget);
+
+    imageLoader = std::make_shared<ImageLoader>(std::move(_userFileLoad), std::move(decoder));
+    textureDesc = std::make_shared<TextureDescriptors>(device, maxTextureCount, BINDING_TEXTURES, _framesInFlight,
+                                                       BINDING_TEXTURE_USAGE, residency->GetUsageBuffers());
     textureUploader = std::make_shared<TextureUploader>(device, std::move(_memAllocator));
 
     textures.resize(maxTextureCount);
 
     // submit cmd to create empty texture
     VkCommandBuffer cmd = _cmdManager->StartGraphicsCmd();
+    residency->RecordUsageClear(cmd);
     CreateEmptyTexture(cmd, 0);
     CreateWaterNormalTexture(cmd, 0, _info.pWaterNormalTexturePath);
     _cmdManager->Submit(cmd);
@@ -144,6 +161,10 @@ void RTGL1::TextureManager::CreateWaterNormalTexture(VkCommandBuffer cmd, uint32
 
 TextureManager::~TextureManager()
 {
+    // wait for the workers, and free the data that wasn't uploaded
+    asyncLoader.reset();
+    loadedResults.clear();
+
     for (auto &texture : textures)
     {
         assert((texture.image == VK_NULL_HANDLE && texture.view == VK_NULL_HANDLE) ||
@@ -175,6 +196,9 @@ void TextureManager::PrepareForFrame(uint32_t frameIndex)
 
     // clear staging buffer that are not in use
     textureUploader->ClearStaging(frameIndex);
+
+    // the frame is finished, so its texture usage can be read
+    residency->ReadUsage(frameIndex);
 }
 
 void TextureManager::SubmitDescriptors(uint32_t frameIndex)
@@ -208,8 +232,45 @@ uint32_t TextureManager::CreateStaticMaterial(VkCommandBuffer cmd, uint32_t fram
 
     VkSampler sampler = samplerMgr->GetSampler(createInfo.filter, createInfo.addressModeU, createInfo.addressModeV);
 
+    // only file loading is worth moving to the workers
+    if (asyncLoader && !createInfo.disableOverride && createInfo.pRelativePath != nullptr)
+    {
+        return CreateStaticMaterialAsync(createInfo, sampler);
+    }
+
+    // load additional textures, they'll be freed after leaving the scope
+    TextureOverrides ovrd(createInfo.pRelativePath, createInfo.textures, createInfo.size, GetOverrideInfo(createInfo.disableOverride), imageLoader);
+
+
+    MaterialTextures textures = {};
+    // if all textures are from files, they can be evicted and reloaded
+    bool isFromFiles = true;
+
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+    {
+        textures.indices[i] = PrepareStaticTexture(cmd, frameIndex, ovrd.GetResult(i), sampler, createInfo.useMipmaps, ovrd.GetDebugName());
+
+        if (textures.indices[i] != EMPTY_TEXTURE_INDEX && !ovrd.IsLoadedFromFile(i))
+        {
+            isFromFiles = false;
+        }
+    }
+
+
+    uint32_t matIndex = InsertMaterial(textures, false);
+
+    if (matIndex != RG_NO_MATERIAL && isFromFiles)
+    {
+        AddEvictableMaterial(matIndex, createInfo.pRelativePath, sampler, createInfo.useMipmaps);
+    }
+
+    return matIndex;
+}
+
+TextureOverrides::OverrideInfo TextureManager::GetOverrideInfo(bool disableOverride) const
+{
     TextureOverrides::OverrideInfo parseInfo = {};
-    parseInfo.disableOverride = createInfo.disableOverride;
+    parseInfo.disableOverride = disableOverride;
     parseInfo.texturesPath = defaultTexturesPath.c_str();
     for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
     {
@@ -217,19 +278,392 @@ uint32_t TextureManager::CreateStaticMaterial(VkCommandBuffer cmd, uint32_t fram
         parseInfo.overridenIsSRGB[i] = overridenIsSRGB[i];
     }
 
-    // load additional textures, they'll be freed after leaving the scope
-    TextureOverrides ovrd(createInfo.pRelativePath, createInfo.textures, createInfo.size, parseInfo, imageLoader);
+    return parseInfo;
+}
+
+uint32_t TextureManager::CreateStaticMaterialAsync(const RgStaticMaterialCreateInfo &createInfo, VkSampler sampler)
+{
+    const RgTextureData *tds[TEXTURES_PER_MATERIAL_COUNT] =
+    {
+        &createInfo.textures.albedoAlpha,
+        &createInfo.textures.roughnessMetallicEmission,
+        &createInfo.textures.normal,
+    };
 
+    const uint32_t bytesPerPixel = 4;
+    const uint32_t defaultDataSize = createInfo.size.width * createInfo.size.height * bytesPerPixel;
 
-    MaterialTextures textures = {};
+    auto request = std::make_unique<AsyncTextureLoader::Request>();
+    request->id = ++lastAsyncRequestId;
+    request->relativePath = createInfo.pRelativePath;
+    request->defaultSize = createInfo.size;
 
     for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
     {
-        textures.indices[i] = PrepareStaticTexture(cmd, frameIndex, ovrd.GetResult(i), sampler, createInfo.useMipmaps, ovrd.GetDebugName());
+        request->defaultIsSRGB[i] = !!tds[i]->isSRGB;
+
+        if (tds[i]->pData != nullptr)
+        {
+            // check it now, as there's no way to report an error on upload
+            if (defaultDataSize == 0)
+            {
+                throw RgException(RG_WRONG_MATERIAL_PARAMETER, "Incorrect size (" + 
+                                  std::to_string(createInfo.size.width) + ", " + 
+                                  std::to_string(createInfo.size.height) + ") of one of images in a material with name: " +
+                                  createInfo.pRelativePath);
+            }
+
+            // user's data is not valid after the call
+            const uint8_t *src = static_cast<const uint8_t *>(tds[i]->pData);
+            request->defaultData[i].assign(src, src + defaultDataSize);
+        }
+    }
+
+    // texture indices must be known now, as they're copied to the geometry
+    // info on upload, so the slots are reserved for all textures of the material,
+    // and they're shown as empty until the images are uploaded
+    MaterialTextures reserved = {};
+
+    // release the first "count" slots that were reserved for this material
+    auto releaseReserved = [this, &reserved] (uint32_t count)
+    {
+        for (uint32_t k = 0; k < count; k++)
+        {
+            textures[reserved.indices[k]].isReserved = false;
+        }
+    };
+
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+    {
+        reserved.indices[i] = ReserveTexture();
+
+        if (reserved.indices[i] == EMPTY_TEXTURE_INDEX)
+        {
+            releaseReserved(i);
+
+            throw RgException(RG_WRONG_MATERIAL_PARAMETER, "Too many textures, couldn't reserve texture slots for a material with name: " +
+                              std::string(createInfo.pRelativePath));
+        }
+    }
+
+    uint32_t matIndex = InsertMaterial(reserved, false);
+
+    if (matIndex == RG_NO_MATERIAL)
+    {
+        releaseReserved(TEXTURES_PER_MATERIAL_COUNT);
+        return RG_NO_MATERIAL;
     }
 
+    PendingMaterial pending = {};
+    pending.materialIndex = matIndex;
+    pending.textures = reserved;
+    pending.sampler = sampler;
+    pending.useMipmaps = !!createInfo.useMipmaps;
 
-    return InsertMaterial(textures, false);
+    pendingMaterials[request->id] = pending;
+    asyncLoader->Push(std::move(request));
+
+    return matIndex;
+}
+
+void TextureManager::UploadLoadedTextures(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!asyncLoader)
+    {
+        return;
+    }
+
+    asyncLoader->TakeFinished(loadedResults);
+
+    for (const auto &r : loadedResults)
+    {
+        const auto it = pendingMaterials.find(r.id);
+
+        // material was destroyed while loading
+        if (it == pendingMaterials.end())
+        {
+            continue;
+        }
+
+        const PendingMaterial &pending = it->second;
+        bool isFromFiles = true;
+        bool anyUploaded = false;
+
+        for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+        {
+            const uint32_t textureIndex = pending.textures.indices[i];
+            const ImageLoader::ResultInfo &imageInfo = r.overrides->GetResult(i);
+
+            if (textureIndex == EMPTY_TEXTURE_INDEX || imageInfo.pData == nullptr)
+            {
+                continue;
+            }
+
+            auto result = UploadStaticTexture(cmd, frameIndex, imageInfo, pending.useMipmaps, r.overrides->GetDebugName());
+
+            if (!result.wasUploaded)
+            {
+                continue;
+            }
+
+            // the upload is recorded to the frame's cmd, so the image
+            // is ready when the descriptor is used in the same frame
+            SetReservedTexture(textureIndex, result.image, result.view, pending.sampler);
+            anyUploaded = true;
+
+            if (!r.overrides->IsLoadedFromFile(i))
+            {
+                isFromFiles = false;
+            }
+        }
+
+        // reloaded materials are added again, with the flags reset
+        if (isFromFiles && anyUploaded)
+        {
+            AddEvictableMaterial(pending.materialIndex, r.request->relativePath.c_str(), pending.sampler, pending.useMipmaps);
+        }
+        else
+        {
+            evictableMaterials.erase(pending.materialIndex);
+        }
+
+        pendingMaterials.erase(it);
+    }
+
+    // free the loaded data, staging buffers have a copy
+    loadedResults.clear();
+}
+
+void TextureManager::StreamTextureLevels(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (streamingBytesPerFrame == 0)
+    {
+        return;
+    }
+
+    streamedViews.clear();
+    textureUploader->StreamLevels(cmd, frameIndex, streamingBytesPerFrame, streamedViews);
+
+    for (const auto &updated : streamedViews)
+    {
+        auto it = std::find_if(textures.begin(), textures.end(), [&updated] (const Texture &t)
+        {
+            return t.image == updated.image;
+        });
+
+        assert(it != textures.end());
+
+        if (it != textures.end())
+        {
+            // new view has more levels, descriptors will be updated in SubmitDescriptors
+            it->view = updated.view;
+        }
+    }
+}
+
+void TextureManager::RecordUsageReadback(VkCommandBuffer cmd, uint32_t frameIndex) const
+{
+    residency->RecordUsageReadback(cmd, frameIndex);
+}
+
+void TextureManager::AddEvictableMaterial(uint32_t materialIndex, const char *relativePath, VkSampler sampler, bool useMipmaps)
+{
+    if (!residency->IsEvictionEnabled())
+    {
+        return;
+    }
+
+    EvictableMaterial &evictable = evictableMaterials[materialIndex];
+    evictable.relativePath = relativePath;
+    evictable.sampler = sampler;
+    evictable.useMipmaps = useMipmaps;
+    evictable.isEvicted = false;
+    evictable.isReloading = false;
+}
+
+bool TextureManager::WasMaterialSampled(const MaterialTextures &materialTextures, uint64_t maxUnusedFrameCount) const
+{
+    for (uint32_t t : materialTextures.indices)
+    {
+        if (t != EMPTY_TEXTURE_INDEX && residency->GetUnusedFrameCount(t) <= maxUnusedFrameCount)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TextureManager::UpdateResidency(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!residency->IsEvictionEnabled())
+    {
+        return;
+    }
+
+    // evicted textures are shown as empty, but the shaders still mark their indices
+    for (auto &p : evictableMaterials)
+    {
+        EvictableMaterial &evictable = p.second;
+
+        if (evictable.isEvicted && !evictable.isReloading && WasMaterialSampled(materials[p.first].textures, 0))
+        {
+            ReloadMaterial(cmd, frameIndex, p.first, evictable);
+        }
+    }
+
+    const VkDeviceSize overBudget = residency->GetOverBudgetSize();
+
+    if (overBudget == 0)
+    {
+        return;
+    }
+
+    // unused frame count and material index
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+
+    for (const auto &p : evictableMaterials)
+    {
+        const EvictableMaterial &evictable = p.second;
+
+        if (evictable.isEvicted || evictable.isReloading)
+        {
+            continue;
+        }
+
+        const MaterialTextures &mt = materials[p.first].textures;
+
+        if (WasMaterialSampled(mt, TEXTURE_EVICTION_MIN_UNUSED_FRAMES))
+        {
+            continue;
+        }
+
+        uint64_t unusedFrameCount = UINT64_MAX;
+
+        for (uint32_t t : mt.indices)
+        {
+            if (t != EMPTY_TEXTURE_INDEX)
+            {
+                unusedFrameCount = std::min(unusedFrameCount, residency->GetUnusedFrameCount(t));
+            }
+        }
+
+        candidates.emplace_back(unusedFrameCount, p.first);
+    }
+
+    // least recently used first
+    std::sort(candidates.begin(), candidates.end(), [] (const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b)
+    {
+        return a.first > b.first;
+    });
+
+    VkDeviceSize evictedSize = 0;
+
+    for (const auto &c : candidates)
+    {
+        if (evictedSize >= overBudget)
+        {
+            break;
+        }
+
+        evictedSize += EvictMaterial(frameIndex, c.second);
+    }
+}
+
+VkDeviceSize TextureManager::EvictMaterial(uint32_t frameIndex, uint32_t materialIndex)
+{
+    VkDeviceSize evictedSize = 0;
+
+    for (uint32_t t : materials[materialIndex].textures.indices)
+    {
+        if (t == EMPTY_TEXTURE_INDEX)
+        {
+            continue;
+        }
+
+        Texture &texture = textures[t];
+
+        if (texture.image == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        evictedSize += residency->GetResidentSize(t);
+        residency->OnTextureDestroyed(frameIndex, t);
+
+        AddToBeDestroyed(frameIndex, texture);
+
+        // keep the slot, as the index is used by the geometry
+        texture.image = VK_NULL_HANDLE;
+        texture.view = VK_NULL_HANDLE;
+        texture.sampler = VK_NULL_HANDLE;
+        texture.isReserved = true;
+    }
+
+    evictableMaterials[materialIndex].isEvicted = true;
+
+    return evictedSize;
+}
+
+void TextureManager::ReloadMaterial(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t materialIndex, EvictableMaterial &evictable)
+{
+    const MaterialTextures &mt = materials[materialIndex].textures;
+
+    if (asyncLoader)
+    {
+        // no default data, as only materials with textures from files are evicted
+        auto request = std::make_unique<AsyncTextureLoader::Request>();
+        request->id = ++lastAsyncRequestId;
+        request->relativePath = evictable.relativePath;
+        request->defaultSize = {};
+
+        PendingMaterial pending = {};
+        pending.materialIndex = materialIndex;
+        pending.textures = mt;
+        pending.sampler = evictable.sampler;
+        pending.useMipmaps = evictable.useMipmaps;
+
+        pendingMaterials[request->id] = pending;
+        asyncLoader->Push(std::move(request));
+
+        evictable.isReloading = true;
+        return;
+    }
+
+    TextureOverrides ovrd(evictable.relativePath.c_str(), RgTextureSet{}, RgExtent2D{}, GetOverrideInfo(false), imageLoader);
+
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
+    {
+        const uint32_t textureIndex = mt.indices[i];
+        const ImageLoader::ResultInfo &imageInfo = ovrd.GetResult(i);
+
+        if (textureIndex == EMPTY_TEXTURE_INDEX || imageInfo.pData == nullptr)
+        {
+            continue;
+        }
+
+        auto result = UploadStaticTexture(cmd, frameIndex, imageInfo, evictable.useMipmaps, ovrd.GetDebugName());
+
+        if (result.wasUploaded)
+        {
+            SetReservedTexture(textureIndex, result.image, result.view, evictable.sampler);
+        }
+    }
+
+    evictable.isEvicted = false;
+}
+
+void TextureManager::CancelPendingMaterial(uint32_t materialIndex)
+{
+    for (auto it = pendingMaterials.begin(); it != pendingMaterials.end(); ++it)
+    {
+        if (it->second.materialIndex == materialIndex)
+        {
+            asyncLoader->Cancel(it->first);
+            pendingMaterials.erase(it);
+            return;
+        }
+    }
 }
 
 uint32_t TextureManager::CreateDynamicMaterial(VkCommandBuffer cmd, uint32_t frameIndex, const RgDynamicMaterialCreateInfo &createInfo)
@@ -338,6 +772,23 @@ uint32_t TextureManager::PrepareStaticTexture(
                           (debugName != nullptr ? " with name: "s + debugName : ""s));
     }
 
+    auto result = UploadStaticTexture(cmd, frameIndex, imageInfo, useMipmaps, debugName);
+
+    if (!result.wasUploaded)
+    {
+        return EMPTY_TEXTURE_INDEX;
+    }
+
+    return InsertTexture(frameIndex, result.image, result.view, sampler);
+}
+
+TextureUploader::UploadResult TextureManager::UploadStaticTexture(
+    VkCommandBuffer cmd, uint32_t frameIndex,
+    const ImageLoader::ResultInfo &imageInfo,
+    bool useMipmaps,
+    const char *debugName)
+{
+    assert(imageInfo.pData != nullptr);
     assert(imageInfo.dataSize > 0);
     assert(imageInfo.levelCount > 0 && imageInfo.levelSizes[0] > 0);
 
@@ -355,15 +806,9 @@ uint32_t TextureManager::PrepareStaticTexture(
     info.pregeneratedLevelCount = imageInfo.isPregenerated ? imageInfo.levelCount : 0;
     info.pLevelDataOffsets = imageInfo.levelOffsets;
     info.pLevelDataSizes = imageInfo.levelSizes;
+    info.isStreamed = streamingBytesPerFrame > 0;
 
-    auto result = textureUploader->UploadImage(info);
-
-    if (!result.wasUploaded)
-    {
-        return EMPTY_TEXTURE_INDEX;
-    }
-
-    return InsertTexture(frameIndex, result.image, result.view, sampler);
+    return textureUploader->UploadImage(info);
 }
 
 uint32_t TextureManager::PrepareDynamicTexture(
@@ -554,6 +999,8 @@ void TextureManager::DestroyMaterialTextures(uint32_t frameIndex, uint32_t mater
 
     if (it != materials.end())
     {
+        CancelPendingMaterial(materialIndex);
+        evictableMaterials.erase(materialIndex);
         DestroyMaterialTextures(frameIndex, it->second);
     }
 }
@@ -566,12 +1013,18 @@ void TextureManager::DestroyMaterialTextures(uint32_t frameIndex, const Material
         {
             Texture &texture = textures[t];
 
-            AddToBeDestroyed(frameIndex, texture);
+            // reserved texture might not be loaded yet or evicted
+            if (texture.image != VK_NULL_HANDLE)
+            {
+                residency->OnTextureDestroyed(frameIndex, t);
+                AddToBeDestroyed(frameIndex, texture);
+            }
 
             // null data
             texture.image = VK_NULL_HANDLE;
             texture.view = VK_NULL_HANDLE;
             texture.sampler = VK_NULL_HANDLE;
+            texture.isReserved = false;
         }
     }
 }
@@ -604,6 +1057,8 @@ void TextureManager::DestroyMaterial(uint32_t currentFrameIndex, uint32_t materi
 
         if (it != materials.end())
         {
+            CancelPendingMaterial(materialIndex);
+            evictableMaterials.erase(materialIndex);
             DestroyMaterialTextures(currentFrameIndex, it->second);
             materials.erase(it);
         }
@@ -624,7 +1079,7 @@ uint32_t TextureManager::InsertTexture(uint32_t frameIndex, VkImage image, VkIma
 {
     auto texture = std::find_if(textures.begin(), textures.end(), [] (const Texture &t)
     {
-        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE;
+        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE && !t.isReserved;
     });
 
     // if coudn't find empty space, use empty texture
@@ -646,9 +1101,41 @@ uint32_t TextureManager::InsertTexture(uint32_t frameIndex, VkImage image, VkIma
     texture->view = view;
     texture->sampler = sampler;
 
+    const uint32_t textureIndex = (uint32_t)std::distance(textures.begin(), texture);
+    residency->OnTextureCreated(textureIndex, image);
+
+    return textureIndex;
+}
+
+uint32_t TextureManager::ReserveTexture()
+{
+    auto texture = std::find_if(textures.begin(), textures.end(), [] (const Texture &t)
+    {
+        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE && !t.isReserved;
+    });
+
+    if (texture == textures.end())
+    {
+        return EMPTY_TEXTURE_INDEX;
+    }
+
+    texture->isReserved = true;
+
     return (uint32_t)std::distance(textures.begin(), texture);
 }
 
+void TextureManager::SetReservedTexture(uint32_t textureIndex, VkImage image, VkImageView view, VkSampler sampler)
+{
+    Texture &texture = textures[textureIndex];
+    assert(texture.isReserved && texture.image == VK_NULL_HANDLE);
+
+    texture.image = image;
+    texture.view = view;
+    texture.sampler = sampler;
+
+    residency->OnTextureCreated(textureIndex, image);
+}
+
 void TextureManager::DestroyTexture(const Texture &texture)
 {
     assert(texture.image != VK_NULL_HANDLE && texture.view != VK_NULL_HANDLE);
@@ -659,6 +1146,9 @@ void TextureManager::AddToBeDestroyed(uint32_t frameIndex, const Texture &textur
 {
     assert(texture.image != VK_NULL_HANDLE && texture.view != VK_NULL_HANDLE);
 
+    // the view must not be replaced after this point
+    textureUploader->StopStreaming(texture.image);
+
     texturesToDestroy[frameIndex].push_back(texture);
 }
 
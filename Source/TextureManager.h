@@ -23,6 +23,7 @@
 #include <list>
 #include <string>
 
+#include "AsyncTextureLoader.h"
 #include "Common.h"
 #include "CommandBufferManager.h"
 #include "Material.h"
@@ -31,6 +32,7 @@
 #include "MemoryAllocator.h"
 #include "SamplerManager.h"
 #include "TextureDescriptors.h"
+#include "TextureResidency.h"
 #include "TextureUploader.h"
 
 namespace RTGL1
@@ -45,6 +47,7 @@ public:
         std::shared_ptr<SamplerManager> samplerManager,
         const std::shared_ptr<CommandBufferManager> &cmdManager,
         std::shared_ptr<UserFileLoad> userFileLoad,
+        uint32_t framesInFlight,
         const RgInstanceCreateInfo &info);
     ~TextureManager();
 
@@ -54,6 +57,15 @@ public:
     TextureManager &operator=(TextureManager &&other) noexcept = delete;
 
     void PrepareForFrame(uint32_t frameIndex);
+    // Evict the least recently used materials, if over the texture memory budget,
+    // and reload the evicted ones that were sampled.
+    void UpdateResidency(VkCommandBuffer cmd, uint32_t frameIndex);
+    // Upload the textures that were loaded asynchronously since the last call.
+    void UploadLoadedTextures(VkCommandBuffer cmd, uint32_t frameIndex);
+    // Upload the next mip levels of the streamed textures.
+    void StreamTextureLevels(VkCommandBuffer cmd, uint32_t frameIndex);
+    // Must be recorded at the end of the frame to read the texture usage on CPU.
+    void RecordUsageReadback(VkCommandBuffer cmd, uint32_t frameIndex) const;
     void SubmitDescriptors(uint32_t frameIndex);
 
     uint32_t CreateStaticMaterial(VkCommandBuffer cmd, uint32_t frameIndex, const RgStaticMaterialCreateInfo &createInfo);
@@ -79,19 +91,53 @@ public:
     void Subscribe(std::shared_ptr<IMaterialDependency> subscriber);
     void Unsubscribe(const IMaterialDependency *subscriber);
 
+private:
+    struct PendingMaterial
+    {
+        uint32_t            materialIndex;
+        MaterialTextures    textures;
+        VkSampler           sampler;
+        bool                useMipmaps;
+    };
+
+    // Material which textures are loaded from files, so they can be reloaded
+    struct EvictableMaterial
+    {
+        std::string         relativePath;
+        VkSampler           sampler;
+        bool                useMipmaps;
+        bool                isEvicted;
+        bool                isReloading;
+    };
+
 private:
     void CreateEmptyTexture(VkCommandBuffer cmd, uint32_t frameIndex);
     void CreateWaterNormalTexture(VkCommandBuffer cmd, uint32_t frameIndex, const char *pFilePath);
 
+    TextureOverrides::OverrideInfo GetOverrideInfo(bool disableOverride) const;
+    uint32_t CreateStaticMaterialAsync(const RgStaticMaterialCreateInfo &createInfo, VkSampler sampler);
+    void CancelPendingMaterial(uint32_t materialIndex);
+
+    void AddEvictableMaterial(uint32_t materialIndex, const char *relativePath, VkSampler sampler, bool useMipmaps);
+    VkDeviceSize EvictMaterial(uint32_t frameIndex, uint32_t materialIndex);
+    void ReloadMaterial(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t materialIndex, EvictableMaterial &evictable);
+    bool WasMaterialSampled(const MaterialTextures &materialTextures, uint64_t maxUnusedFrameCount) const;
+
     uint32_t PrepareStaticTexture(
         VkCommandBuffer cmd, uint32_t frameIndex, const ImageLoader::ResultInfo &info,
         VkSampler sampler, bool useMipmaps, const char *debugName);
+    TextureUploader::UploadResult UploadStaticTexture(
+        VkCommandBuffer cmd, uint32_t frameIndex, const ImageLoader::ResultInfo &info,
+        bool useMipmaps, const char *debugName);
 
     uint32_t PrepareDynamicTexture(
         VkCommandBuffer cmd, uint32_t frameIndex, const void *data, uint32_t dataSize, const RgExtent2D &size,
         VkSampler sampler, VkFormat format, bool generateMipmaps, const char *debugName);
 
     uint32_t InsertTexture(uint32_t frameIndex, VkImage image, VkImageView view, VkSampler sampler);
+    // Returns EMPTY_TEXTURE_INDEX, if there are no free slots
+    uint32_t ReserveTexture();
+    void SetReservedTexture(uint32_t textureIndex, VkImage image, VkImageView view, VkSampler sampler);
     void DestroyTexture(const Texture &texture);
     void AddToBeDestroyed(uint32_t frameIndex, const Texture &texture);
 
@@ -128,6 +174,19 @@ private:
     bool overridenIsSRGB[TEXTURES_PER_MATERIAL_COUNT];
 
     std::list<std::weak_ptr<IMaterialDependency>> subscribers;
+
+    // null, if materials are created synchronously
+    std::unique_ptr<AsyncTextureLoader> asyncLoader;
+    std::map<uint64_t, PendingMaterial> pendingMaterials;
+    uint64_t lastAsyncRequestId;
+    std::vector<AsyncTextureLoader::Result> loadedResults;
+
+    std::unique_ptr<TextureResidency> residency;
+    std::map<uint32_t, EvictableMaterial> evictableMaterials;
+
+    // if 0, textures are not streamed
+    uint32_t streamingBytesPerFrame;
+    std::vector<TextureUploader::UploadResult> streamedViews;
 };
 
 inline constexpr uint32_t TextureManager::GetEmptyTextureIndex()
@@ -86,6 +86,7 @@ TextureOverrides::TextureOverrides(
     std::shared_ptr<ImageLoader> _imageLoader) 
 :
     results{},
+    loadedFromFile{},
     debugName{},
     imageLoader(_imageLoader)
 {
@@ -110,7 +111,7 @@ TextureOverrides::TextureOverrides(
         {
             for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++)
             {
-                _imageLoader->Load(paths[i], &results[i]);
+                loadedFromFile[i] = _imageLoader->Load(paths[i], &results[i]);
 
                 // fix format, if needed
                 results[i].format = _overrideInfo.overridenIsSRGB[i] ?
@@ -239,6 +240,12 @@ const char *RTGL1::TextureOverrides::GetDebugName() const
     return debugName;
 }
 
+bool TextureOverrides::IsLoadedFromFile(uint32_t index) const
+{
+    assert(index < TEXTURES_PER_MATERIAL_COUNT);
+    return loadedFromFile[index];
+}
+
 bool TextureOverrides::ParseOverrideTexturePaths(
     char paths[TEXTURES_PER_MATERIAL_COUNT][TEXTURE_FILE_PATH_MAX_LENGTH],
     const char *relativePath,
@@ -68,6 +68,8 @@ public:
 
     const ImageLoader::ResultInfo &GetResult(uint32_t index) const;
     const char *GetDebugName() const;
+    // False, if the result is null or the default data.
+    bool IsLoadedFromFile(uint32_t index) const;
 
 private:
     bool ParseOverrideTexturePaths(
@@ -77,6 +79,7 @@ private:
 
 private:
     ImageLoader::ResultInfo results[TEXTURES_PER_MATERIAL_COUNT];
+    bool loadedFromFile[TEXTURES_PER_MATERIAL_COUNT];
     char debugName[TEXTURE_DEBUG_NAME_MAX_LENGTH];
 
     std::weak_ptr<ImageLoader> imageLoader;
@@ -0,0 +1,276 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace RTGL1;
+
+TextureResidency::TextureResidency(
+    VkDevice _device,
+    std::shared_ptr<MemoryAllocator> _allocator,
+    uint32_t _maxTextureCount,
+    uint32_t _framesInFlight,
+    VkDeviceSize _budget)
+:
+    device(_device),
+    allocator(std::move(_allocator)),
+    framesInFlight(_framesInFlight),
+    budget(_budget),
+    usageBufferHandles{},
+    mappedReadback{},
+    lastUsed(_maxTextureCount, 0),
+    residentSizes(_maxTextureCount, 0),
+    totalResidentSize(0),
+    destroyedSizes{},
+    finishedFrameCount(0)
+{
+    // if the usage is not tracked, the shaders don't access the buffer
+    const VkDeviceSize size = IsEvictionEnabled() ? _maxTextureCount * sizeof(uint32_t) : sizeof(uint32_t);
+
+    usageBuffer.Init(allocator, size,
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                     "Texture usage buffer");
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        usageBufferHandles[i] = usageBuffer.GetBuffer();
+    }
+
+    if (!IsEvictionEnabled())
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        readbackBuffers[i].Init(allocator, size,
+                                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                "Texture usage readback buffer");
+
+        void *mapped = readbackBuffers[i].Map();
+        memset(mapped, 0, size);
+
+        mappedReadback[i] = static_cast<const uint32_t *>(mapped);
+    }
+}
+
+TextureResidency::~TextureResidency()
+{
+    if (!IsEvictionEnabled())
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        readbackBuffers[i].Unmap();
+    }
+}
+
+const VkBuffer *TextureResidency::GetUsageBuffers() const
+{
+    return usageBufferHandles;
+}
+
+void TextureResidency::RecordUsageClear(VkCommandBuffer cmd) const
+{
+    if (!IsEvictionEnabled())
+    {
+        return;
+    }
+
+    vkCmdFillBuffer(cmd, usageBuffer.GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+}
+
+void TextureResidency::RecordUsageReadback(VkCommandBuffer cmd, uint32_t frameIndex) const
+{
+    if (!IsEvictionEnabled())
+    {
+        return;
+    }
+
+    VkBuffer usage = usageBuffer.GetBuffer();
+
+    {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    VkBufferCopy copy = {};
+    copy.srcOffset = 0;
+    copy.dstOffset = 0;
+    copy.size = usageBuffer.GetSize();
+
+    vkCmdCopyBuffer(cmd, usage, readbackBuffers[frameIndex].GetBuffer(), 1, &copy);
+
+    {
+        // fill must be after the copy
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    vkCmdFillBuffer(cmd, usage, 0, VK_WHOLE_SIZE, 0);
+
+    {
+        // the readback is read on the host, and the reset usage is written by the next frame
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+}
+
+void TextureResidency::ReadUsage(uint32_t frameIndex)
+{
+    finishedFrameCount++;
+
+    // the textures that were destroyed framesInFlight frames ago are freed now
+    destroyedSizes[frameIndex] = 0;
+
+    if (!IsEvictionEnabled())
+    {
+        return;
+    }
+
+    const uint32_t *usage = mappedReadback[frameIndex];
+
+    for (uint32_t i = 0; i < (uint32_t)lastUsed.size(); i++)
+    {
+        if (usage[i] != 0)
+        {
+            lastUsed[i] = finishedFrameCount;
+        }
+    }
+}
+
+void TextureResidency::OnTextureCreated(uint32_t textureIndex, VkImage image)
+{
+    assert(residentSizes[textureIndex] == 0);
+
+    VkMemoryRequirements memReqs = {};
+    vkGetImageMemoryRequirements(device, image, &memReqs);
+
+    residentSizes[textureIndex] = memReqs.size;
+    totalResidentSize += memReqs.size;
+
+    // new texture is not evicted before it's shown
+    lastUsed[textureIndex] = finishedFrameCount;
+}
+
+void TextureResidency::OnTextureDestroyed(uint32_t frameIndex, uint32_t textureIndex)
+{
+    assert(totalResidentSize >= residentSizes[textureIndex]);
+
+    totalResidentSize -= residentSizes[textureIndex];
+    destroyedSizes[frameIndex] += residentSizes[textureIndex];
+
+    residentSizes[textureIndex] = 0;
+}
+
+bool TextureResidency::IsEvictionEnabled() const
+{
+    return budget > 0;
+}
+
+VkDeviceSize TextureResidency::GetOverBudgetSize() const
+{
+    if (!IsEvictionEnabled())
+    {
+        return 0;
+    }
+
+    VkDeviceSize overBudget = totalResidentSize > budget ? totalResidentSize - budget : 0;
+
+    // also check the heap, as other applications and resources use it too
+    VkDeviceSize heapUsage, heapBudget;
+    allocator->GetTextureHeapBudget(&heapUsage, &heapBudget);
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        heapUsage -= std::min(heapUsage, destroyedSizes[i]);
+    }
+
+    if (heapUsage > heapBudget)
+    {
+        overBudget = std::max(overBudget, heapUsage - heapBudget);
+    }
+
+    return overBudget;
+}
+
+VkDeviceSize TextureResidency::GetResidentSize(uint32_t textureIndex) const
+{
+    return residentSizes[textureIndex];
+}
+
+uint64_t TextureResidency::GetUnusedFrameCount(uint32_t textureIndex) const
+{
+    return finishedFrameCount - lastUsed[textureIndex];
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+
+#include "Buffer.h"
+#include "Common.h"
+#include "MemoryAllocator.h"
+
+namespace RTGL1
+{
+
+// Tracks what textures are sampled by the shaders and how much memory
+// they take, to find out if the least recently used ones must be evicted.
+// Shaders mark the sampled textures in a device-local buffer, which is copied
+// to a per-frame readback buffer at the end of the frame and read on CPU
+// when the frame is finished.
+class TextureResidency
+{
+public:
+    // If budget is 0, the usage is not tracked: the shaders don't write it
+    // and the usage buffer is only bound to keep the descriptor valid.
+    explicit TextureResidency(
+        VkDevice device,
+        std::shared_ptr<MemoryAllocator> allocator,
+        uint32_t maxTextureCount,
+        uint32_t framesInFlight,
+        VkDeviceSize budget);
+    ~TextureResidency();
+
+    TextureResidency(const TextureResidency &other) = delete;
+    TextureResidency(TextureResidency &&other) noexcept = delete;
+    TextureResidency &operator=(const TextureResidency &other) = delete;
+    TextureResidency &operator=(TextureResidency &&other) noexcept = delete;
+
+    // Array of framesInFlight buffers.
+    const VkBuffer *GetUsageBuffers() const;
+
+    // Must be recorded once, before the shaders write the usage.
+    void RecordUsageClear(VkCommandBuffer cmd) const;
+    // Copy the usage to the readback buffer of this frame and reset it.
+    // Must be recorded at the end of the frame.
+    void RecordUsageReadback(VkCommandBuffer cmd, uint32_t frameIndex) const;
+    // Read the usage that was copied in the frame with this index.
+    // Must be called when the frame is finished on GPU.
+    void ReadUsage(uint32_t frameIndex);
+
+    void OnTextureCreated(uint32_t textureIndex, VkImage image);
+    // The texture's memory is considered freed after framesInFlight frames.
+    void OnTextureDestroyed(uint32_t frameIndex, uint32_t textureIndex);
+
+    bool IsEvictionEnabled() const;
+    // How many bytes of textures must be evicted to be within the budget.
+    VkDeviceSize GetOverBudgetSize() const;
+    VkDeviceSize GetResidentSize(uint32_t textureIndex) const;
+    // Amount of finished frames since the texture was sampled last time.
+    uint64_t GetUnusedFrameCount(uint32_t textureIndex) const;
+
+private:
+    VkDevice device;
+    std::shared_ptr<MemoryAllocator> allocator;
+    uint32_t framesInFlight;
+    VkDeviceSize budget;
+
+    // the same buffer is used by all frames, as the readback
+    // and the reset are ordered with the next frame's writes
+    Buffer usageBuffer;
+    VkBuffer usageBufferHandles[MAX_FRAMES_IN_FLIGHT];
+    Buffer readbackBuffers[MAX_FRAMES_IN_FLIGHT];
+    const uint32_t *mappedReadback[MAX_FRAMES_IN_FLIGHT];
+
+    std::vector<uint64_t> lastUsed;
+    std::vector<VkDeviceSize> residentSizes;
+    VkDeviceSize totalResidentSize;
+    // sizes of destroyed textures that might still be allocated
+    VkDeviceSize destroyedSizes[MAX_FRAMES_IN_FLIGHT];
+    uint64_t finishedFrameCount;
+};
+
+}
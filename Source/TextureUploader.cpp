@@ -27,6 +27,26 @@
 
 using namespace RTGL1;
 
+namespace
+{
+
+VkExtent3D GetLevelExtent(const RgExtent2D &baseSize, uint32_t level)
+{
+    return
+    {
+        std::max(baseSize.width >> level, 1u),
+        std::max(baseSize.height >> level, 1u),
+        1
+    };
+}
+
+VkDeviceSize AlignLevelDataOffset(VkDeviceSize offset)
+{
+    return (offset + TEXTURE_LEVEL_DATA_ALIGNMENT - 1) / TEXTURE_LEVEL_DATA_ALIGNMENT * TEXTURE_LEVEL_DATA_ALIGNMENT;
+}
+
+}
+
 TextureUploader::TextureUploader(VkDevice _device, std::shared_ptr<MemoryAllocator> _memAllocator)
     : device(_device), memAllocator(std::move(_memAllocator))
 {}
@@ -45,6 +65,14 @@ TextureUploader::~TextureUploader()
     {
         memAllocator->DestroyStagingSrcTextureBuffer(p.second.stagingBuffer);
     }
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        for (VkImageView view : viewsToDestroy[i])
+        {
+            vkDestroyImageView(device, view, nullptr);
+        }
+    }
 }
 
 void TextureUploader::ClearStaging(uint32_t frameIndex)
@@ -57,6 +85,13 @@ void TextureUploader::ClearStaging(uint32_t frameIndex)
 
     stagingToFree[frameIndex].clear();
 
+    // clear views that were replaced by the views with more mip levels
+    for (VkImageView view : viewsToDestroy[frameIndex])
+    {
+        vkDestroyImageView(device, view, nullptr);
+    }
+
+    viewsToDestroy[frameIndex].clear();
 }
 
 bool TextureUploader::DoesFormatSupportBlit(VkFormat format) const
@@ -380,8 +415,10 @@ void TextureUploader::PrepareImage(VkImage image, VkBuffer staging[], const Uplo
     }
 }
 
-VkImageView TextureUploader::CreateImageView(VkImage image, VkFormat format, bool isCubemap, uint32_t mipmapCount)
+VkImageView TextureUploader::CreateImageView(VkImage image, VkFormat format, bool isCubemap, uint32_t mipmapCount, uint32_t baseMipLevel)
 {
+    assert(baseMipLevel < mipmapCount);
+
     VkImageView view;
 
     VkImageViewCreateInfo viewInfo = {};
@@ -391,8 +428,8 @@ VkImageView TextureUploader::CreateImageView(VkImage image, VkFormat format, boo
     viewInfo.format = format;
     viewInfo.components = {};
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = mipmapCount;
+    viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    viewInfo.subresourceRange.levelCount = mipmapCount - baseMipLevel;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = isCubemap ? 6 : 1;
 
@@ -421,6 +458,40 @@ TextureUploader::UploadResult TextureUploader::UploadImage(const UploadInfo &inf
     void *mappedData;
     VkImage image;
 
+    uint32_t firstResidentLevel = GetFirstStreamedResidentLevel(info);
+
+    // if only the smallest levels should be uploaded now
+    if (firstResidentLevel > 0)
+    {
+        if (!CreateImage(info, &image))
+        {
+            return result;
+        }
+
+        StreamedImageInfo streamed = {};
+
+        VkBuffer tailStaging = UploadStreamedImageTail(image, info, firstResidentLevel, streamed);
+        if (tailStaging == VK_NULL_HANDLE)
+        {
+            memAllocator->DestroyTextureImage(image);
+            return result;
+        }
+
+        stagingToFree[info.frameIndex].push_back(tailStaging);
+
+        // the view doesn't contain levels that are not uploaded yet,
+        // so they won't be sampled
+        streamed.view = CreateImageView(image, info.format, info.isCubemap, streamed.levelCount, firstResidentLevel);
+        SET_DEBUG_NAME(device, streamed.view, VK_OBJECT_TYPE_IMAGE_VIEW, info.pDebugName);
+
+        result.wasUploaded = true;
+        result.image = image;
+        result.view = streamed.view;
+
+        streamedImages.push_back(std::move(streamed));
+        return result;
+    }
+
     // 1. Allocate and fill buffer
 
     VkBufferCreateInfo stagingInfo = {};
@@ -529,6 +600,268 @@ void TextureUploader::DestroyImage(VkImage image, VkImageView view)
         dynamicImageInfos.erase(it);
     }
 
+    StopStreaming(image);
+
     memAllocator->DestroyTextureImage(image);
     vkDestroyImageView(device, view, nullptr);
 }
+
+uint32_t TextureUploader::GetFirstStreamedResidentLevel(const UploadInfo &info) const
+{
+    // only pregenerated levels can be uploaded separately
+    if (!info.isStreamed || info.isDynamic || info.isCubemap || !AreMipmapsPregenerated(info))
+    {
+        return 0;
+    }
+
+    uint32_t levelCount = GetMipmapCount(info.baseSize, info);
+
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        VkExtent3D extent = GetLevelExtent(info.baseSize, level);
+
+        if (std::max(extent.width, extent.height) <= TEXTURE_STREAMING_INITIAL_LEVEL_SIZE)
+        {
+            return level;
+        }
+    }
+
+    // if all levels are large, upload only the smallest one
+    return levelCount - 1;
+}
+
+VkBuffer TextureUploader::UploadStreamedImageTail(VkImage image, const UploadInfo &info, uint32_t firstResidentLevel, StreamedImageInfo &outStreamed)
+{
+    VkCommandBuffer cmd = info.cmd;
+    uint32_t levelCount = GetMipmapCount(info.baseSize, info);
+
+    assert(firstResidentLevel > 0 && firstResidentLevel < levelCount);
+
+    // levels that are uploaded now are packed in the staging buffer
+    VkDeviceSize tailSize = 0;
+
+    for (uint32_t level = firstResidentLevel; level < levelCount; level++)
+    {
+        tailSize = AlignLevelDataOffset(tailSize) + info.pLevelDataSizes[level];
+    }
+
+    VkBufferCreateInfo stagingInfo = {};
+    stagingInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    stagingInfo.size = tailSize;
+    stagingInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    void *mappedData;
+    VkBuffer staging = memAllocator->CreateStagingSrcTextureBuffer(&stagingInfo, &mappedData);
+    if (staging == VK_NULL_HANDLE)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    SET_DEBUG_NAME(device, staging, VK_OBJECT_TYPE_BUFFER, info.pDebugName);
+
+    VkBufferImageCopy copyRegions[MAX_PREGENERATED_MIPMAP_LEVELS];
+    VkDeviceSize offset = 0;
+
+    for (uint32_t level = firstResidentLevel; level < levelCount; level++)
+    {
+        offset = AlignLevelDataOffset(offset);
+
+        memcpy(
+            static_cast<uint8_t *>(mappedData) + offset,
+            static_cast<const uint8_t *>(info.pData) + info.pLevelDataOffsets[level],
+            info.pLevelDataSizes[level]);
+
+        auto &cr = copyRegions[level - firstResidentLevel];
+
+        cr = {};
+        cr.bufferOffset = offset;
+        cr.bufferRowLength = 0;
+        cr.bufferImageHeight = 0;
+        cr.imageExtent = GetLevelExtent(info.baseSize, level);
+        cr.imageOffset = { 0,0,0 };
+        cr.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        cr.imageSubresource.mipLevel = level;
+        cr.imageSubresource.baseArrayLayer = 0;
+        cr.imageSubresource.layerCount = 1;
+
+        offset += info.pLevelDataSizes[level];
+    }
+
+    VkImageSubresourceRange tailLevels = {};
+    tailLevels.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    tailLevels.baseMipLevel = firstResidentLevel;
+    tailLevels.levelCount = levelCount - firstResidentLevel;
+    tailLevels.baseArrayLayer = 0;
+    tailLevels.layerCount = 1;
+
+    Utils::BarrierImage(
+        cmd, image,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        tailLevels);
+
+    vkCmdCopyBufferToImage(
+        cmd, staging, image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount - firstResidentLevel, copyRegions);
+
+    Utils::BarrierImage(
+        cmd, image,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        tailLevels);
+
+
+    // keep the data of larger levels, as the source data will be freed
+    outStreamed.image = image;
+    outStreamed.format = info.format;
+    outStreamed.baseSize = info.baseSize;
+    outStreamed.levelCount = levelCount;
+    outStreamed.firstResidentLevel = firstResidentLevel;
+
+    uint32_t streamedSize = 0;
+
+    for (uint32_t level = 0; level < firstResidentLevel; level++)
+    {
+        outStreamed.levelDataOffsets[level] = streamedSize;
+        outStreamed.levelDataSizes[level] = info.pLevelDataSizes[level];
+
+        streamedSize += info.pLevelDataSizes[level];
+    }
+
+    outStreamed.data.resize(streamedSize);
+
+    for (uint32_t level = 0; level < firstResidentLevel; level++)
+    {
+        memcpy(
+            outStreamed.data.data() + outStreamed.levelDataOffsets[level],
+            static_cast<const uint8_t *>(info.pData) + info.pLevelDataOffsets[level],
+            info.pLevelDataSizes[level]);
+    }
+
+    return staging;
+}
+
+bool TextureUploader::UploadStreamedLevel(VkCommandBuffer cmd, uint32_t frameIndex, StreamedImageInfo &streamed)
+{
+    assert(streamed.firstResidentLevel > 0);
+
+    uint32_t level = streamed.firstResidentLevel - 1;
+    uint32_t levelSize = streamed.levelDataSizes[level];
+
+    VkBufferCreateInfo stagingInfo = {};
+    stagingInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    stagingInfo.size = levelSize;
+    stagingInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    void *mappedData;
+    VkBuffer staging = memAllocator->CreateStagingSrcTextureBuffer(&stagingInfo, &mappedData);
+    if (staging == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    memcpy(mappedData, streamed.data.data() + streamed.levelDataOffsets[level], levelSize);
+
+    VkImageSubresourceRange levelRange = {};
+    levelRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    levelRange.baseMipLevel = level;
+    levelRange.levelCount = 1;
+    levelRange.baseArrayLayer = 0;
+    levelRange.layerCount = 1;
+
+    VkBufferImageCopy copyRegion = {};
+    copyRegion.bufferOffset = 0;
+    copyRegion.bufferRowLength = 0;
+    copyRegion.bufferImageHeight = 0;
+    copyRegion.imageExtent = GetLevelExtent(streamed.baseSize, level);
+    copyRegion.imageOffset = { 0,0,0 };
+    copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.imageSubresource.mipLevel = level;
+    copyRegion.imageSubresource.baseArrayLayer = 0;
+    copyRegion.imageSubresource.layerCount = 1;
+
+    // the level wasn't used before, so its layout is undefined
+    Utils::BarrierImage(
+        cmd, streamed.image,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        levelRange);
+
+    vkCmdCopyBufferToImage(
+        cmd, staging, streamed.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+    Utils::BarrierImage(
+        cmd, streamed.image,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        levelRange);
+
+    stagingToFree[frameIndex].push_back(staging);
+
+    // previous view can be still in use by previous frames
+    viewsToDestroy[frameIndex].push_back(streamed.view);
+
+    streamed.firstResidentLevel = level;
+    streamed.view = CreateImageView(streamed.image, streamed.format, false, streamed.levelCount, level);
+
+    return true;
+}
+
+void TextureUploader::StreamLevels(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t maxByteCount, std::vector<UploadResult> &outUpdated)
+{
+    uint32_t uploadedByteCount = 0;
+
+    // finish the oldest image first, so it'll be fully resident as soon as possible
+    while (!streamedImages.empty())
+    {
+        StreamedImageInfo &streamed = streamedImages.front();
+
+        uint32_t levelSize = streamed.levelDataSizes[streamed.firstResidentLevel - 1];
+
+        // at least one level must be uploaded, even if it's larger than the budget
+        if (uploadedByteCount > 0 && uploadedByteCount + levelSize > maxByteCount)
+        {
+            break;
+        }
+
+        if (!UploadStreamedLevel(cmd, frameIndex, streamed))
+        {
+            break;
+        }
+
+        uploadedByteCount += levelSize;
+
+        // if several levels of the same image were uploaded, only the last view is needed
+        if (!outUpdated.empty() && outUpdated.back().image == streamed.image)
+        {
+            outUpdated.back().view = streamed.view;
+        }
+        else
+        {
+            UploadResult updated = {};
+            updated.wasUploaded = true;
+            updated.image = streamed.image;
+            updated.view = streamed.view;
+
+            outUpdated.push_back(updated);
+        }
+
+        if (streamed.firstResidentLevel == 0)
+        {
+            streamedImages.pop_front();
+        }
+    }
+}
+
+void TextureUploader::StopStreaming(VkImage image)
+{
+    streamedImages.remove_if([image] (const StreamedImageInfo &s)
+    {
+        return s.image == image;
+    });
+}
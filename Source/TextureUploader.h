@@ -20,9 +20,11 @@
 
 #pragma once
 
+#include <list>
 #include <vector>
 
 #include "Common.h"
+#include "Const.h"
 #include "MemoryAllocator.h"
 #include "RTGL1/RTGL1.h"
 
@@ -61,6 +63,9 @@ public:
         bool                isDynamic;
         const char          *pDebugName;
         bool                isCubemap;
+        // if true and mipmaps are pregenerated, only the smallest levels
+        // are uploaded at once, others are streamed in StreamLevels
+        bool                isStreamed;
     };
 
 public:
@@ -72,13 +77,22 @@ public:
     TextureUploader &operator=(const TextureUploader &other) = delete;
     TextureUploader &operator=(TextureUploader &&other) noexcept = delete;
 
-    // Clear staging buffer for given frame index.
+    // Clear staging buffer and unused image views for given frame index.
     void ClearStaging(uint32_t frameIndex);
 
     virtual UploadResult UploadImage(const UploadInfo &info);
     void UpdateDynamicImage(VkCommandBuffer cmd, VkImage dynamicImage, const void *data);
     void DestroyImage(VkImage image, VkImageView view);
 
+    // Upload next mip levels of streamed images, the larger levels are uploaded
+    // after the smaller ones. At most maxByteCount bytes are uploaded per call,
+    // but at least one level, if there is any. Images with new levels get new views
+    // that are returned in outUpdated; previous views are destroyed when they won't be in use.
+    void StreamLevels(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t maxByteCount, std::vector<UploadResult> &outUpdated);
+    // Stop uploading levels of the image, if it's streamed. Must be called before
+    // the image is scheduled for destruction, so its view won't be changed.
+    void StopStreaming(VkImage image);
+
 protected:
     enum class ImagePrepareType
     {
@@ -107,7 +121,7 @@ protected:
     bool CreateImage(const UploadInfo &info, VkImage *result);
     // Create mipmaps and prepare image for usage in shaders
     void PrepareImage(VkImage image, VkBuffer staging[], const UploadInfo &info, ImagePrepareType prepareType);
-    VkImageView CreateImageView(VkImage image, VkFormat format, bool isCubemap, uint32_t mipmapCount);
+    VkImageView CreateImageView(VkImage image, VkFormat format, bool isCubemap, uint32_t mipmapCount, uint32_t baseMipLevel = 0);
 
 private:
     struct DynamicImageInfo
@@ -119,6 +133,28 @@ private:
         bool        generateMipmaps;
     };
 
+    struct StreamedImageInfo
+    {
+        VkImage                 image;
+        VkImageView             view;
+        VkFormat                format;
+        RgExtent2D              baseSize;
+        uint32_t                levelCount;
+        // levels [firstResidentLevel, levelCount) are uploaded
+        // and visible through the view
+        uint32_t                firstResidentLevel;
+        // data of levels [0, firstResidentLevel)
+        std::vector<uint8_t>    data;
+        uint32_t                levelDataOffsets[MAX_PREGENERATED_MIPMAP_LEVELS];
+        uint32_t                levelDataSizes[MAX_PREGENERATED_MIPMAP_LEVELS];
+    };
+
+private:
+    uint32_t GetFirstStreamedResidentLevel(const UploadInfo &info) const;
+    VkBuffer UploadStreamedImageTail(VkImage image, const UploadInfo &info, uint32_t firstResidentLevel, StreamedImageInfo &outStreamed);
+    // Returns false, if staging buffer couldn't be allocated.
+    bool UploadStreamedLevel(VkCommandBuffer cmd, uint32_t frameIndex, StreamedImageInfo &streamed);
+
 protected:
     VkDevice device;
 
@@ -127,9 +163,15 @@ protected:
     // Staging buffers that were used for uploading must be destroyed
     // on the frame with same index when it'll be certainly not in use
     std::vector<VkBuffer> stagingToFree[MAX_FRAMES_IN_FLIGHT];
+    // Views of streamed images that were replaced by the views with more levels
+    std::vector<VkImageView> viewsToDestroy[MAX_FRAMES_IN_FLIGHT];
 
     // Each dynamic image has its pointer to HOST_VISIBLE data for updating.
     std::map<VkImage, DynamicImageInfo> dynamicImageInfos;
+
+    // Static images which larger mip levels are not uploaded yet,
+    // in the order of their creation.
+    std::list<StreamedImageInfo> streamedImages;
 };
 
 }
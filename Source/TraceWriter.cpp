@@ -0,0 +1,177 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TraceWriter.h"
+
+#include <cstring>
+#include <string>
+
+#include "Const.h"
+#include "RgException.h"
+
+using namespace RTGL1;
+
+TraceWriter::TraceWriter(const char *pFilePath) :
+    file(nullptr),
+    startTime(Clock::now()),
+    ring(TRACE_WRITER_RING_BUFFER_SIZE),
+    ringHead(0),
+    ringCount(0),
+    droppedCount(0),
+    stop(false)
+{
+    file = fopen(pFilePath, "w");
+
+    if (file == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, std::string("Can't open trace file: ") + pFilePath);
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RTGL1 CPU\"}},\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"RTGL1 GPU\"}}");
+
+    writerThread = std::thread(&TraceWriter::WriteLoop, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        stop = true;
+    }
+    bufferCondition.notify_one();
+
+    writerThread.join();
+
+    if (droppedCount > 0)
+    {
+        fprintf(file, ",\n{\"name\":\"Dropped events\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":0,\"args\":{\"count\":%llu}}",
+                (unsigned long long)droppedCount);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+}
+
+void TraceWriter::AddCpuScope(const char *pName, Clock::time_point begin, Clock::time_point end)
+{
+    AddEvent(pName, false, begin, std::chrono::duration<double, std::micro>(end - begin).count());
+}
+
+void TraceWriter::AddGpuScope(const char *pName, Clock::time_point begin, double durationMs)
+{
+    AddEvent(pName, true, begin, durationMs * 1000.0);
+}
+
+void TraceWriter::AddEvent(const char *pName, bool isGpu, Clock::time_point begin, double durationUs)
+{
+    Event e = {};
+    strncpy(e.name, pName != nullptr ? pName : "", sizeof(e.name) - 1);
+    e.isGpu = isGpu;
+    e.threadId = isGpu ? 0 : GetThreadId();
+    e.timestamp = std::chrono::duration<double, std::micro>(begin - startTime).count();
+    e.duration = durationUs;
+
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+
+        if (ringCount >= ring.size())
+        {
+            droppedCount++;
+            return;
+        }
+
+        ring[(ringHead + ringCount) % ring.size()] = e;
+
+        wasEmpty = ringCount == 0;
+        ringCount++;
+    }
+
+    if (wasEmpty)
+    {
+        bufferCondition.notify_one();
+    }
+}
+
+void TraceWriter::WriteLoop()
+{
+    std::vector<Event> toWrite;
+    toWrite.reserve(ring.size());
+
+    while (true)
+    {
+        bool toStop;
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex);
+            bufferCondition.wait(lock, [this] { return stop || ringCount > 0; });
+
+            // take all events at once, to not block producers while writing
+            for (; ringCount > 0; ringCount--)
+            {
+                toWrite.push_back(ring[ringHead]);
+                ringHead = (ringHead + 1) % ring.size();
+            }
+
+            toStop = stop;
+        }
+
+        for (const Event &e : toWrite)
+        {
+            WriteEvent(e);
+        }
+        toWrite.clear();
+
+        if (toStop)
+        {
+            break;
+        }
+    }
+
+    fflush(file);
+}
+
+void TraceWriter::WriteEvent(const Event &e)
+{
+    fprintf(file, ",\n{\"name\":\"");
+
+    // escape for JSON string
+    for (const char *c = e.name; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+        }
+
+        fputc((unsigned char)*c >= 0x20 ? *c : ' ', file);
+    }
+
+    fprintf(file, "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            e.isGpu ? 2 : 1, e.threadId, e.timestamp, e.duration);
+}
+
+uint32_t TraceWriter::GetThreadId()
+{
+    static std::atomic<uint32_t> G_NEXT_THREAD_ID(1);
+    static thread_local uint32_t threadId = G_NEXT_THREAD_ID++;
+
+    return threadId;
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Streams timings to a file in Chrome Trace Event format, it can be opened
+// in chrome://tracing or ui.perfetto.dev. Events are put to a bounded ring buffer
+// and written by a background thread; if the buffer is full, new events are dropped.
+// CPU scopes are placed on the tracks of the threads that produced them,
+// GPU scopes are placed on a separate process track.
+class TraceWriter
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Adds CPU scope on destruction. Does nothing, if writer is null.
+    class Scope
+    {
+    public:
+        explicit Scope(TraceWriter *_writer, const char *_pName) :
+            writer(_writer), pName(_pName), begin(_writer != nullptr ? Clock::now() : Clock::time_point())
+        {}
+
+        ~Scope()
+        {
+            if (writer != nullptr)
+            {
+                writer->AddCpuScope(pName, begin, Clock::now());
+            }
+        }
+
+        Scope(const Scope &other) = delete;
+        Scope(Scope &&other) noexcept = delete;
+        Scope &operator=(const Scope &other) = delete;
+        Scope &operator=(Scope &&other) noexcept = delete;
+
+    private:
+        TraceWriter *writer;
+        const char *pName;
+        Clock::time_point begin;
+    };
+
+public:
+    explicit TraceWriter(const char *pFilePath);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter &other) = delete;
+    TraceWriter(TraceWriter &&other) noexcept = delete;
+    TraceWriter &operator=(const TraceWriter &other) = delete;
+    TraceWriter &operator=(TraceWriter &&other) noexcept = delete;
+
+    // Can be called from several threads simultaneously
+    void AddCpuScope(const char *pName, Clock::time_point begin, Clock::time_point end);
+    void AddGpuScope(const char *pName, Clock::time_point begin, double durationMs);
+
+private:
+    struct Event
+    {
+        // name is copied, as GPU scope names are not persistent
+        char        name[64];
+        bool        isGpu;
+        uint32_t    threadId;
+        // in microseconds since the writer's creation
+        double      timestamp;
+        double      duration;
+    };
+
+private:
+    void AddEvent(const char *pName, bool isGpu, Clock::time_point begin, double durationUs);
+    void WriteLoop();
+    void WriteEvent(const Event &e);
+    static uint32_t GetThreadId();
+
+private:
+    FILE *file;
+    Clock::time_point startTime;
+
+    std::mutex bufferMutex;
+    std::condition_variable bufferCondition;
+    std::vector<Event> ring;
+    // index of the oldest event and the amount of events in the ring
+    size_t ringHead;
+    size_t ringCount;
+    uint64_t droppedCount;
+    bool stop;
+
+    std::thread writerThread;
+};
+
+}
@@ -31,6 +31,15 @@ struct VertexBufferProperties
     uint32_t normalStride;
     uint32_t texCoordStride;
     uint32_t colorStride;
+    // if true, normals and tex coords are stored packed in the vertex buffers
+    bool compactVertexData;
+    // initial capacities of the vertex collectors, their buffers are grown on demand
+    uint32_t staticVertexCapacity;
+    uint32_t staticIndexCapacity;
+    uint32_t dynamicVertexCapacity;
+    uint32_t dynamicIndexCapacity;
+    // vertex and index buffers are bound as a whole, so they can't be larger
+    VkDeviceSize maxBufferSize;
 };
 
 }
\ No newline at end of file
@@ -21,84 +21,174 @@
 #include "VertexCollector.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "Generated/ShaderCommonC.h"
 #include "Matrix.h"
+#include "VertexEncoding.h"
+#include "VertexIngest.h"
 
 using namespace RTGL1;
 
-constexpr uint32_t INDEX_BUFFER_SIZE        = MAX_INDEXED_PRIMITIVE_COUNT * 3 * sizeof(uint32_t);
 constexpr uint32_t TRANSFORM_BUFFER_SIZE    = MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT * sizeof(VkTransformMatrixKHR);
 
-constexpr uint64_t OFFSET_TEX_COORDS_STATIC[] =
+constexpr uint32_t TEXCOORD_LAYER_COUNT_STATIC = 3;
+constexpr uint32_t TEXCOORD_LAYER_COUNT_DYNAMIC = 1;
+
+// Alignment of each vertex attribute array in a vertex buffer, in bytes
+constexpr uint64_t VERTEX_STREAM_ALIGNMENT = 16;
+
+// Where vertex attributes are in a vertex buffer, and how many bytes one vertex takes in each array
+struct VertexBufferLayout
 {
-    offsetof(ShVertexBufferStatic, texCoords),
-    offsetof(ShVertexBufferStatic, texCoordsLayer1),
-    offsetof(ShVertexBufferStatic, texCoordsLayer2),
+    uint64_t wholeSize;
+    uint64_t offsetPositions;
+    uint64_t offsetNormals;
+    uint64_t offsetTexCoords[TEXCOORD_LAYER_COUNT_STATIC];
+    uint32_t texCoordLayerCount;
+
+    uint64_t positionStride;
+    uint64_t normalStride;
+    uint64_t texCoordStride;
 };
 
-constexpr uint64_t OFFSET_TEX_COORDS_DYNAMIC[] =
+static uint64_t AlignUpStream(uint64_t offset)
 {
-    offsetof(ShVertexBufferDynamic, texCoords),
-};
+    return (offset + VERTEX_STREAM_ALIGNMENT - 1) / VERTEX_STREAM_ALIGNMENT * VERTEX_STREAM_ALIGNMENT;
+}
+
+// Attribute arrays are placed one after another, so their offsets depend on the vertex capacity
+static VertexBufferLayout GetVertexBufferLayout(bool isStatic, const VertexBufferProperties &properties, uint32_t vertexCapacity)
+{
+    VertexBufferLayout l = {};
+    l.texCoordLayerCount = isStatic ? TEXCOORD_LAYER_COUNT_STATIC : TEXCOORD_LAYER_COUNT_DYNAMIC;
+
+    // user's strides are not used, as attributes are deinterleaved on copying;
+    // compact layout has packed normals and tex coords, positions are always the same
+    l.positionStride = VERTEX_POSITION_STRIDE;
+    l.normalStride = properties.compactVertexData ? sizeof(uint32_t) : VERTEX_NORMAL_STRIDE;
+    l.texCoordStride = properties.compactVertexData ? sizeof(uint32_t) : VERTEX_TEXCOORD_STRIDE;
+
+    // positions are always at the beginning, so AS geometries
+    // and previous frame's positions don't depend on the capacity
+    uint64_t offset = 0;
+
+    l.offsetPositions = offset;
+    offset = AlignUpStream(offset + vertexCapacity * l.positionStride);
+
+    l.offsetNormals = offset;
+    offset = AlignUpStream(offset + vertexCapacity * l.normalStride);
+
+    for (uint32_t i = 0; i < l.texCoordLayerCount; i++)
+    {
+        l.offsetTexCoords[i] = offset;
+        offset = AlignUpStream(offset + vertexCapacity * l.texCoordStride);
+    }
+
+    l.wholeSize = offset;
+
+    return l;
+}
+
+// Vertex buffer must be in the storage buffer range limit
+static uint32_t GetMaxVertexCapacity(bool isStatic, const VertexBufferProperties &properties)
+{
+    const VertexBufferLayout l = GetVertexBufferLayout(isStatic, properties, 0);
+
+    const uint64_t vertexSize = l.positionStride + l.normalStride + l.texCoordLayerCount * l.texCoordStride;
+    const uint64_t alignmentReserve = (2 + l.texCoordLayerCount) * VERTEX_STREAM_ALIGNMENT;
+
+    if (properties.maxBufferSize <= alignmentReserve)
+    {
+        return 0;
+    }
+
+    return (uint32_t)std::min<uint64_t>((properties.maxBufferSize - alignmentReserve) / vertexSize, UINT32_MAX);
+}
+
+static uint32_t GetMaxIndexCapacity(const VertexBufferProperties &properties)
+{
+    return (uint32_t)std::min<uint64_t>(properties.maxBufferSize / sizeof(uint32_t), UINT32_MAX);
+}
+
+// Ranges fit only if their end is less than the capacity, see ReserveRange.
+// Capacity is at least doubled, so the data is not copied too often.
+static uint32_t GetGrownCapacity(uint32_t capacity, uint32_t required, uint32_t maxCapacity)
+{
+    if (required < capacity)
+    {
+        return capacity;
+    }
+
+    const uint64_t grown = std::max<uint64_t>((uint64_t)required + 1, (uint64_t)capacity * 2);
 
-constexpr uint32_t TEXCOORD_LAYER_COUNT_STATIC = sizeof(OFFSET_TEX_COORDS_STATIC) / sizeof(OFFSET_TEX_COORDS_STATIC[0]);
-constexpr uint32_t TEXCOORD_LAYER_COUNT_DYNAMIC = sizeof(OFFSET_TEX_COORDS_DYNAMIC) / sizeof(OFFSET_TEX_COORDS_DYNAMIC[0]);
+    return (uint32_t)std::min<uint64_t>(grown, std::max(capacity, maxCapacity));
+}
+
+// With direct write, vertex and index staging buffers are read by the device
+static VkBufferUsageFlags GetStagingUsage(bool directWrite)
+{
+    return directWrite ?
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT :
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+}
+
+static VkMemoryPropertyFlags GetStagingMemoryProperties(bool directWrite)
+{
+    return directWrite ?
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT :
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
 
 
 VertexCollector::VertexCollector(
     VkDevice _device, 
     const std::shared_ptr<MemoryAllocator> &_allocator,
     std::shared_ptr<GeomInfoManager> _geomInfoManager,
-    VkDeviceSize _bufferSize,
     const VertexBufferProperties &_properties,
     VertexCollectorFilterTypeFlags _filters) 
 :
     device(_device),
+    allocator(_allocator),
     properties(_properties),
     filtersFlags(_filters),
+    directWrite(false),
+    vertexCapacity(0), indexCapacity(0),
+    deviceVertexCapacity(0), deviceIndexCapacity(0),
+    maxVertexCapacity(0), maxIndexCapacity(0),
+    requestedVertexCount(0), requestedIndexCount(0),
+    rebaseVertAddress{}, rebaseIndexAddress{},
     geomInfoMgr(std::move(_geomInfoManager)),
     curVertexCount(0), curIndexCount(0), curPrimitiveCount(0), curTransformCount(0),
     mappedVertexData(nullptr), mappedIndexData(nullptr), mappedTransformData(nullptr), 
-    texCoordsToCopyLowerBound(UINT64_MAX),
-    texCoordsToCopyUpperBound(0)
+    deferStaticGeomInfos(false)
 {
     assert(filtersFlags != 0);
 
-    bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
-
-    vertBuffer = std::make_shared<Buffer>();
-    indexBuffer = std::make_shared<Buffer>();
-    transformsBuffer = std::make_shared<Buffer>();
+    maxVertexCapacity = GetMaxVertexCapacity(IsStatic(), properties);
+    maxIndexCapacity = GetMaxIndexCapacity(properties);
 
-    // dynamic vertices need also be copied to previous frame buffer
-    VkBufferUsageFlags transferUsage = isDynamic ?
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT :
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    // initial capacities are only hints, the buffers are grown on demand
+    vertexCapacity = std::min(IsStatic() ? properties.staticVertexCapacity : properties.dynamicVertexCapacity, maxVertexCapacity);
+    indexCapacity = std::min(IsStatic() ? properties.staticIndexCapacity : properties.dynamicIndexCapacity, maxIndexCapacity);
 
-    // vertex buffers
-    vertBuffer->Init(
-        _allocator, _bufferSize,
-        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic Vertices data buffer" : "Static Vertices data buffer");
+    // dynamic data is rewritten each frame, so it can be written directly to device local memory
+    directWrite = !IsStatic() && allocator->IsDirectWriteAvailable();
 
-    // index buffers
-    indexBuffer->Init(
-        _allocator, INDEX_BUFFER_SIZE,
-        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic Index data buffer" : "Static Index data buffer");
+    // with direct write, device local buffers are the staging ones, see InitStagingBuffers
+    if (!directWrite)
+    {
+        InitDeviceBuffers(vertexCapacity, indexCapacity);
+    }
 
-    // transforms buffer
+    transformsBuffer = std::make_shared<Buffer>();
     transformsBuffer->Init(
-        _allocator, TRANSFORM_BUFFER_SIZE,
-        transferUsage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        allocator, TRANSFORM_BUFFER_SIZE,
+        (IsStatic() ? 0 : VK_BUFFER_USAGE_TRANSFER_SRC_BIT) | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic BLAS transforms buffer" : "Static BLAS transforms buffer");
+        IsStatic() ? "Static BLAS transforms buffer" : "Dynamic BLAS transforms buffer");
 
-    // device local buffers are 
-    InitStagingBuffers(_allocator);
+    InitStagingBuffers();
     InitFilters(filtersFlags);
 }
 
@@ -107,62 +197,124 @@ VertexCollector::VertexCollector(
     const std::shared_ptr<MemoryAllocator> &_allocator)
 :
     device(_src->device),
+    allocator(_allocator),
     properties(_src->properties),
     filtersFlags(_src->filtersFlags),
+    directWrite(_src->directWrite),
     vertBuffer(_src->vertBuffer),
     indexBuffer(_src->indexBuffer),
     transformsBuffer(_src->transformsBuffer),
+    vertexCapacity(_src->deviceVertexCapacity), indexCapacity(_src->deviceIndexCapacity),
+    deviceVertexCapacity(_src->deviceVertexCapacity), deviceIndexCapacity(_src->deviceIndexCapacity),
+    maxVertexCapacity(_src->maxVertexCapacity), maxIndexCapacity(_src->maxIndexCapacity),
+    requestedVertexCount(0), requestedIndexCount(0),
+    rebaseVertAddress{}, rebaseIndexAddress{},
     geomInfoMgr(_src->geomInfoMgr),
     curVertexCount(0), curIndexCount(0), curPrimitiveCount(0), curTransformCount(0),
     mappedVertexData(nullptr), mappedIndexData(nullptr), mappedTransformData(nullptr),
-    texCoordsToCopyLowerBound(UINT64_MAX),
-    texCoordsToCopyUpperBound(0)
+    deferStaticGeomInfos(false)
 {
-    // device local buffers are shared with the "src" vertex collector
-    InitStagingBuffers(_allocator);
+    // device local buffers are shared with the "src" vertex collector,
+    // so the staging buffers must have the same layout;
+    // with direct write, they're replaced by the own ones
+    InitStagingBuffers();
     InitFilters(filtersFlags);
 }
 
-void VertexCollector::InitStagingBuffers(const std::shared_ptr<MemoryAllocator> &allocator)
+bool VertexCollector::IsStatic() const
+{
+    return !(filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC);
+}
+
+void VertexCollector::InitDeviceBuffers(uint32_t _vertexCapacity, uint32_t _indexCapacity)
+{
+    if (directWrite)
+    {
+        assert(_vertexCapacity == vertexCapacity && _indexCapacity == indexCapacity);
+
+        vertBuffer = stagingVertBuffer;
+        indexBuffer = stagingIndexBuffer;
+
+        deviceVertexCapacity = _vertexCapacity;
+        deviceIndexCapacity = _indexCapacity;
+        return;
+    }
+
+    const bool isDynamic = !IsStatic();
+
+    // dynamic vertices need also be copied to previous frame buffer,
+    // static ones are copied to the grown buffers, see GrowSubmittedDeviceBuffers
+    VkBufferUsageFlags transferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    // vertex buffers
+    vertBuffer = std::make_shared<Buffer>();
+    vertBuffer->Init(
+        allocator, GetVertexBufferLayout(IsStatic(), properties, _vertexCapacity).wholeSize,
+        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        isDynamic ? "Dynamic Vertices data buffer" : "Static Vertices data buffer");
+
+    // index buffers
+    indexBuffer = std::make_shared<Buffer>();
+    indexBuffer->Init(
+        allocator, (VkDeviceSize)_indexCapacity * sizeof(uint32_t),
+        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        isDynamic ? "Dynamic Index data buffer" : "Static Index data buffer");
+
+    deviceVertexCapacity = _vertexCapacity;
+    deviceIndexCapacity = _indexCapacity;
+}
+
+void VertexCollector::InitStagingBuffers()
 {
     // device local buffers must not be empty
-    assert(vertBuffer       && vertBuffer->GetSize() > 0);
-    assert(indexBuffer      && indexBuffer->GetSize() > 0);
+    assert(directWrite || (vertBuffer  && vertBuffer->GetSize() > 0));
+    assert(directWrite || (indexBuffer && indexBuffer->GetSize() > 0));
     assert(transformsBuffer && transformsBuffer->GetSize() > 0);
     assert(geomInfoMgr);
 
+    stagingVertBuffer = std::make_shared<Buffer>();
+    stagingIndexBuffer = std::make_shared<Buffer>();
+    stagingTransformsBuffer = std::make_shared<Buffer>();
+
     // vertex buffers
-    stagingVertBuffer.Init(
-        allocator, vertBuffer->GetSize(),
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC ? "Dynamic Vertices data staging buffer" : "Static Vertices data staging buffer");
+    stagingVertBuffer->Init(
+        allocator, GetVertexBufferLayout(IsStatic(), properties, vertexCapacity).wholeSize,
+        GetStagingUsage(directWrite),
+        GetStagingMemoryProperties(directWrite),
+        IsStatic() ? "Static Vertices data staging buffer" : "Dynamic Vertices data staging buffer");
 
     // index buffers
-    stagingIndexBuffer.Init(
-        allocator, indexBuffer->GetSize(),
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC ? "Dynamic Index data staging buffer" : "Static Index data staging buffer");
+    stagingIndexBuffer->Init(
+        allocator, (VkDeviceSize)indexCapacity * sizeof(uint32_t),
+        GetStagingUsage(directWrite),
+        GetStagingMemoryProperties(directWrite),
+        IsStatic() ? "Static Index data staging buffer" : "Dynamic Index data staging buffer");
 
     // transforms buffer
-    stagingTransformsBuffer.Init(
+    stagingTransformsBuffer->Init(
         allocator, transformsBuffer->GetSize(),
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC ? "Dynamic BLAS transforms staging buffer" : "Static BLAS transforms staging buffer");
+        IsStatic() ? "Static BLAS transforms staging buffer" : "Dynamic BLAS transforms staging buffer");
+
+    mappedVertexData = static_cast<uint8_t *>(stagingVertBuffer->Map());
+    mappedIndexData = static_cast<uint32_t *>(stagingIndexBuffer->Map());
+    mappedTransformData = static_cast<VkTransformMatrixKHR *>(stagingTransformsBuffer->Map());
 
-    mappedVertexData = static_cast<uint8_t *>(stagingVertBuffer.Map());
-    mappedIndexData = static_cast<uint32_t *>(stagingIndexBuffer.Map());
-    mappedTransformData = static_cast<VkTransformMatrixKHR *>(stagingTransformsBuffer.Map());
+    if (directWrite)
+    {
+        InitDeviceBuffers(vertexCapacity, indexCapacity);
+    }
 }
 
 VertexCollector::~VertexCollector()
 {
     // unmap buffers to destroy them 
-    stagingVertBuffer.TryUnmap();
-    stagingIndexBuffer.TryUnmap();
-    stagingTransformsBuffer.TryUnmap();
+    stagingVertBuffer->TryUnmap();
+    stagingIndexBuffer->TryUnmap();
+    stagingTransformsBuffer->TryUnmap();
 }
 
 static uint32_t GetMaterialsBlendFlags(const RgGeometryMaterialBlendType blendingTypes[], uint32_t count)
@@ -191,8 +343,12 @@ static uint32_t GetMaterialsBlendFlags(const RgGeometryMaterialBlendType blendin
 void VertexCollector::BeginCollecting(bool isStatic)
 {
     assert(curVertexCount == 0 && curIndexCount == 0 && curPrimitiveCount == 0 );
-    assert((isStatic && geomInfoMgr->GetStaticCount() == 0) || (!isStatic && geomInfoMgr->GetDynamicCount() == 0));
+    assert(isStatic || geomInfoMgr->GetDynamicCount() == 0);
     assert(GetAllGeometryCount() == 0);
+    assert(deferredStaticGeomInfos.empty());
+
+    // previous static scene is in use until this one is built
+    deferStaticGeomInfos = isStatic;
 }
 
 static uint32_t AlignUpBy3(uint32_t x)
@@ -200,9 +356,73 @@ static uint32_t AlignUpBy3(uint32_t x)
     return ((x + 2) / 3) * 3;
 }
 
+// End of the range, if it's reserved right after "curCount"
+static uint32_t GetAlignedRangeEnd(uint32_t curCount, uint32_t count)
+{
+    return (uint32_t)std::min<uint64_t>((uint64_t)AlignUpBy3(curCount) + count, UINT32_MAX);
+}
+
+// Atomically bump "cur" by "count", returns false if the new value is not less than "maxCount"
+static bool ReserveRange(std::atomic<uint32_t> &cur, uint32_t count, uint32_t maxCount, bool alignBy3, uint32_t *outStart)
+{
+    uint32_t oldValue = cur.load(std::memory_order_relaxed);
+    uint32_t start;
+
+    do
+    {
+        start = alignBy3 ? AlignUpBy3(oldValue) : oldValue;
+
+        if ((uint64_t)start + count >= maxCount)
+        {
+            return false;
+        }
+    }
+    while (!cur.compare_exchange_weak(oldValue, start + count, std::memory_order_relaxed));
+
+    *outStart = start;
+    return true;
+}
+
+// Atomically set "dst" to "value", if it's greater
+static void AtomicMax(std::atomic<uint32_t> &dst, uint32_t value)
+{
+    uint32_t oldValue = dst.load(std::memory_order_relaxed);
+
+    while (oldValue < value && !dst.compare_exchange_weak(oldValue, value, std::memory_order_relaxed))
+    {}
+}
+
+bool VertexCollector::ReserveRanges(
+    uint32_t vertexCount, uint32_t indexCount, uint32_t transformCount,
+    uint32_t *outVertIndex, uint32_t *outIndIndex, uint32_t *outTransformIndex)
+{
+    // ends of the ranges, if they're reserved right after the current ones
+    const uint32_t vertexEnd = GetAlignedRangeEnd(curVertexCount, vertexCount);
+    const uint32_t indexEnd = GetAlignedRangeEnd(curIndexCount, indexCount);
+
+    // static geometry is collected only from the main thread, so its buffers can be grown right away;
+    // dynamic ranges are reserved from several threads, so their buffers are grown on the next frame
+    if (IsStatic())
+    {
+        ReserveCapacity(vertexEnd, indexEnd);
+    }
+
+    // if one of the ranges doesn't fit, already reserved ones are not returned,
+    // as other threads could reserve after them; they'll be freed on Reset()
+    if (!ReserveRange(curVertexCount, vertexCount, vertexCapacity, true, outVertIndex) ||
+        !ReserveRange(curIndexCount, indexCount, indexCapacity, true, outIndIndex))
+    {
+        AtomicMax(requestedVertexCount, vertexEnd);
+        AtomicMax(requestedIndexCount, indexEnd);
+
+        return false;
+    }
+
+    return ReserveRange(curTransformCount, transformCount, MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT, false, outTransformIndex);
+}
+
 uint32_t VertexCollector::AddGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT])
 {
-    typedef VertexCollectorFilterTypeFlagBits FT;
     const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(info);
 
 
@@ -214,299 +434,1238 @@ uint32_t VertexCollector::AddGeometry(uint32_t frameIndex, const RgGeometryUploa
     }
 
 
-    const bool collectStatic = geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE);
-
-    const uint32_t maxVertexCount = collectStatic ? MAX_STATIC_VERTEX_COUNT : MAX_DYNAMIC_VERTEX_COUNT;
-
-
-    const uint32_t vertIndex = AlignUpBy3(curVertexCount);
-    const uint32_t indIndex = AlignUpBy3(curIndexCount);
-    const uint32_t transformIndex = curTransformCount;
-
     const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
     const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
 
 
-    curVertexCount = vertIndex + info.vertexCount;
-    curIndexCount = indIndex + (useIndices ? info.indexCount : 0);
-    curPrimitiveCount += primitiveCount;
-    curTransformCount += 1;
-
-
     // check bounds
-    if (curVertexCount >= maxVertexCount ||
-        curIndexCount >= MAX_INDEXED_PRIMITIVE_COUNT * 3 ||
-        (geomInfoMgr->GetCount() + 1) >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT)
+    if ((GetGeomInfoCount() + 1) >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT)
     {
         assert(0);
         return UINT32_MAX;
     }
 
-    // copy data to buffer
-    assert(stagingVertBuffer.IsMapped());
-    CopyDataToStaging(info, vertIndex, collectStatic);
+    uint32_t vertIndex, indIndex, transformIndex;
 
-    if (useIndices)
+    if (!ReserveRanges(info.vertexCount, useIndices ? info.indexCount : 0, 1, &vertIndex, &indIndex, &transformIndex))
     {
-        assert(stagingIndexBuffer.IsMapped());
-        memcpy(mappedIndexData + indIndex, info.pIndexData, info.indexCount * sizeof(uint32_t));
+        // dynamic buffers are grown on the next frame, static ones are already at the limit
+        assert(!IsStatic());
+        return UINT32_MAX;
     }
 
-    static_assert(sizeof(RgTransform) == sizeof(VkTransformMatrixKHR), "RgTransform and VkTransformMatrixKHR must have the same structure to be used in AS building");
-    memcpy(mappedTransformData + transformIndex, &info.transform, sizeof(VkTransformMatrixKHR));
+    curPrimitiveCount += primitiveCount;
 
-    const uint32_t offsetPositions = collectStatic ?
-        offsetof(ShVertexBufferStatic, positions) :
-        offsetof(ShVertexBufferDynamic, positions);
+    return WriteGeometry(frameIndex, info, materials, geomFlags, vertIndex, indIndex, transformIndex);
+}
 
-    // use positions and index data in the device local buffers: AS shouldn't be built using staging buffers
-    const VkDeviceAddress vertexDataDeviceAddress =
-        vertBuffer->GetAddress() + offsetPositions + vertIndex * static_cast<uint64_t>(properties.positionStride);
+void VertexCollector::AddGeometries(uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos, const MaterialTextures *pMaterials, uint32_t *outSimpleIndices)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
 
-    // geometry info
-    VkAccelerationStructureGeometryKHR geom = {};
-    geom.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-    geom.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+    if (count == 0)
+    {
+        return;
+    }
 
-    geom.flags = geomFlags & FT::PT_OPAQUE ?
-        VK_GEOMETRY_OPAQUE_BIT_KHR :
-        VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+    const bool collectStatic = pInfos[0].geomType != RG_GEOMETRY_TYPE_DYNAMIC;
+    (void)collectStatic;
 
-    VkAccelerationStructureGeometryTrianglesDataKHR &trData = geom.geometry.triangles;
-    trData.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-    trData.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
-    trData.maxVertex = info.vertexCount;
-    trData.vertexData.deviceAddress = vertexDataDeviceAddress;
-    trData.vertexStride = properties.positionStride;
-    trData.transformData.deviceAddress = transformsBuffer->GetAddress() + transformIndex * sizeof(VkTransformMatrixKHR);
+    // sizes of the ranges for the whole batch; as batch ranges
+    // begin at the indices aligned by 3, relative offsets can be aligned
+    uint32_t batchVertexCount = 0;
+    uint32_t batchIndexCount = 0;
 
-    if (useIndices)
+    for (uint32_t i = 0; i < count; i++)
     {
-        const VkDeviceAddress indexDataDeviceAddress =
-            indexBuffer->GetAddress() + indIndex * sizeof(uint32_t);
+        const RgGeometryUploadInfo &info = pInfos[i];
+        const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
 
-        trData.indexType = VK_INDEX_TYPE_UINT32;
-        trData.indexData.deviceAddress = indexDataDeviceAddress;
+        batchVertexCount = AlignUpBy3(batchVertexCount) + info.vertexCount;
+        batchIndexCount = AlignUpBy3(batchIndexCount) + (useIndices ? info.indexCount : 0);
+    }
+
+    uint32_t batchVertIndex, batchIndIndex, batchTransformIndex;
+
+    if ((GetGeomInfoCount() + count) >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT ||
+        !ReserveRanges(batchVertexCount, batchIndexCount, count, &batchVertIndex, &batchIndIndex, &batchTransformIndex))
+    {
+        // whole batch doesn't fit, add one by one
+        // to check the bounds of each geometry
+        for (uint32_t i = 0; i < count; i++)
+        {
+            outSimpleIndices[i] = AddGeometry(frameIndex, pInfos[i], &pMaterials[i * MATERIALS_MAX_LAYER_COUNT]);
+        }
+
+        return;
+    }
+
+    if (deferStaticGeomInfos)
+    {
+        deferredStaticGeomInfos.reserve(deferredStaticGeomInfos.size() + count);
     }
     else
     {
-        trData.indexType = VK_INDEX_TYPE_NONE_KHR;
-        trData.indexData = {};
+        geomInfoMgr->Reserve(count);
     }
 
+    uint32_t relVertIndex = 0;
+    uint32_t relIndIndex = 0;
+    uint32_t batchPrimitiveCount = 0;
 
-    uint32_t localIndex = PushGeometry(geomFlags, geom);
+    // bounds were checked for the whole batch,
+    // so only the limits of the groups should be checked
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const RgGeometryUploadInfo &info = pInfos[i];
+        const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(info);
 
+        assert(collectStatic == !!(geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE)));
 
-    VkAccelerationStructureBuildRangeInfoKHR rangeInfo = {};
-    rangeInfo.primitiveCount = primitiveCount;
-    rangeInfo.primitiveOffset = 0;
-    rangeInfo.firstVertex = 0;
-    rangeInfo.transformOffset = 0;
-    PushRangeInfo(geomFlags, rangeInfo);
+        const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
 
+        relVertIndex = AlignUpBy3(relVertIndex);
+        relIndIndex = AlignUpBy3(relIndIndex);
 
-    PushPrimitiveCount(geomFlags, primitiveCount);
+        const uint32_t vertIndex = batchVertIndex + relVertIndex;
+        const uint32_t indIndex = batchIndIndex + relIndIndex;
+        const uint32_t transformIndex = batchTransformIndex + i;
 
+        relVertIndex += info.vertexCount;
+        relIndIndex += useIndices ? info.indexCount : 0;
 
-    ShGeometryInstance geomInfo = {};
-    geomInfo.baseVertexIndex = vertIndex;
-    geomInfo.baseIndexIndex = useIndices ? indIndex : UINT32_MAX;
-    geomInfo.vertexCount = info.vertexCount;
-    geomInfo.indexCount = useIndices ? info.indexCount : UINT32_MAX;
-    geomInfo.defaultRoughness = info.defaultRoughness;
-    geomInfo.defaultMetallicity = info.defaultMetallicity;
-    geomInfo.defaultEmission = info.defaultEmission;
+        if (GetGeometryCount(geomFlags) + 1 >= VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(geomFlags))
+        {
+            assert(false && "Too many geometries in a group");
+            outSimpleIndices[i] = UINT32_MAX;
+            continue;
+        }
 
-    Matrix::ToMat4Transposed(geomInfo.model, info.transform);
+        batchPrimitiveCount += useIndices ? info.indexCount / 3 : info.vertexCount / 3;
 
-    static_assert(sizeof(info.geomMaterial.layerMaterials) / sizeof(info.geomMaterial.layerMaterials[0]) == MATERIALS_MAX_LAYER_COUNT,
-                  "Layer count must be MATERIALS_MAX_LAYER_COUNT");
+        outSimpleIndices[i] = WriteGeometry(frameIndex, info, &pMaterials[i * MATERIALS_MAX_LAYER_COUNT], geomFlags, vertIndex, indIndex, transformIndex);
+    }
 
-    geomInfo.flags = GetMaterialsBlendFlags(info.layerBlendingTypes, MATERIALS_MAX_LAYER_COUNT);
+    curPrimitiveCount += batchPrimitiveCount;
+}
 
-    if (info.pNormalData == nullptr)
-    {
-        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
-    }
+bool VertexCollector::RecordDynamicGeometry(const RgGeometryUploadInfo &info, RecordedDynamicGeometry &outResult)
+{
+    const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(info);
+    assert(geomFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC);
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    uint32_t vertIndex, indIndex, transformIndex;
 
-    if (info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT)
+    if (!ReserveRanges(info.vertexCount, useIndices ? info.indexCount : 0, 1, &vertIndex, &indIndex, &transformIndex))
     {
-        geomInfo.flags |= GEOM_INST_FLAG_INVERTED_NORMALS;
+        return false;
     }
 
-    if (info.flags & RG_GEOMETRY_UPLOAD_NO_MEDIA_CHANGE_ON_REFRACT_BIT)
+    curPrimitiveCount += primitiveCount;
+
+    outResult.uniqueID = info.uniqueID;
+    outResult.geomFlags = geomFlags;
+    outResult.primitiveCount = primitiveCount;
+    // hash index data here, as recording can be done from several threads
+    outResult.topology = GetTopology(info);
+    outResult.geomMaterial = info.geomMaterial;
+    memcpy(outResult.layerBlendingTypes, info.layerBlendingTypes, sizeof(info.layerBlendingTypes));
+    memcpy(outResult.layerColors, info.layerColors, sizeof(info.layerColors));
+
+    PrepareGeometry(info, geomFlags, vertIndex, indIndex, transformIndex, outResult.asGeometry, outResult.geomInfo);
+
+    return true;
+}
+
+bool VertexCollector::MapDynamicGeometry(const RgGeometryUploadInfo &info, RecordedDynamicGeometry &outResult, RgGeometryUploadInfo &outMappedInfo)
+{
+    const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(info);
+    assert(geomFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC);
+
+    // indices are either copied from the info, or written by the user to the mapped range
+    const bool useIndices = info.indexCount != 0;
+    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    uint32_t vertIndex, indIndex, transformIndex;
+
+    if (!ReserveRanges(info.vertexCount, useIndices ? info.indexCount : 0, 1, &vertIndex, &indIndex, &transformIndex))
     {
-        geomInfo.flags |= GEOM_INST_FLAG_NO_MEDIA_CHANGE;
+        return false;
     }
 
-    if (geomFlags & FT::CF_STATIC_MOVABLE)
+    curPrimitiveCount += primitiveCount;
+
+    const VertexBufferLayout l = GetVertexBufferLayout(false, properties, vertexCapacity);
+    assert(stagingVertBuffer->IsMapped() && stagingIndexBuffer->IsMapped());
+
+    // same info, but its data pointers are the mapped ranges of the staging buffers
+    outMappedInfo = info;
+    outMappedInfo.pVertexData = mappedVertexData + l.offsetPositions + vertIndex * l.positionStride;
+    outMappedInfo.pNormalData = info.pNormalData != nullptr ? mappedVertexData + l.offsetNormals + vertIndex * l.normalStride : nullptr;
+    outMappedInfo.pIndexData = useIndices ? mappedIndexData + indIndex : nullptr;
+
+    for (uint32_t i = 0; i < 3; i++)
     {
-        geomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+        outMappedInfo.pTexCoordLayerData[i] = i < l.texCoordLayerCount && info.pTexCoordLayerData[i] != nullptr ?
+            mappedVertexData + l.offsetTexCoords[i] + vertIndex * l.texCoordStride :
+            nullptr;
     }
 
-    switch (info.passThroughType)
+    outResult.uniqueID = info.uniqueID;
+    outResult.geomFlags = geomFlags;
+    outResult.primitiveCount = primitiveCount;
+    outResult.geomMaterial = info.geomMaterial;
+    memcpy(outResult.layerBlendingTypes, info.layerBlendingTypes, sizeof(info.layerBlendingTypes));
+    memcpy(outResult.layerColors, info.layerColors, sizeof(info.layerColors));
+
+    if (useIndices && info.pIndexData != nullptr)
     {
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR:
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            break;
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL:
-            geomInfo.flags |= GEOM_INST_FLAG_PORTAL;
-            break;
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            break;
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
-            break;
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_GLASS;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
-            break;
-        default:
-            break;
+        memcpy(mappedIndexData + indIndex, info.pIndexData, info.indexCount * sizeof(uint32_t));
     }
 
-    for (int32_t layer = MATERIALS_MAX_LAYER_COUNT - 1; layer >= 0; layer--)
-    {
-        uint32_t *pMatArr = &geomInfo.materials0A;
+    // if indices are written by the user, they're not known yet, see UpdateMappedTopology
+    outResult.topology = GetTopology(info);
 
-        memcpy(&pMatArr[layer * TEXTURES_PER_MATERIAL_COUNT], materials[layer].indices, TEXTURES_PER_MATERIAL_COUNT * sizeof(uint32_t));
-        memcpy(geomInfo.materialColors[layer], info.layerColors[layer].data, sizeof(info.layerColors[layer].data));
+    PrepareASGeometry(outMappedInfo, geomFlags, vertIndex, indIndex, transformIndex, outResult.asGeometry, outResult.geomInfo);
 
-        // ignore lower level layers, if they won't be visible (i.e. current one is opaque) 
-        if (info.layerBlendingTypes[layer] == RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE &&
-            info.geomMaterial.layerMaterials[layer] != RG_NO_MATERIAL)
-        {
-            break;
-        }
+    return true;
+}
+
+void VertexCollector::UpdateMappedTopology(const RgGeometryUploadInfo &mappedInfo, RecordedDynamicGeometry &recorded)
+{
+    recorded.topology = GetTopology(mappedInfo);
+}
+
+uint32_t VertexCollector::AddRecordedDynamicGeometry(uint32_t frameIndex, RecordedDynamicGeometry &recorded, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT])
+{
+    const VertexCollectorFilterTypeFlags geomFlags = recorded.geomFlags;
+
+    // if exceeds a limit of geometries in a group with specified geomFlags
+    if (GetGeometryCount(geomFlags) + 1 >= VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(geomFlags))
+    {
+        assert(false && "Too many geometries in a group");
+        return UINT32_MAX;
+    }
+
+    if ((geomInfoMgr->GetCount() + 1) >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT)
+    {
+        assert(0);
+        return UINT32_MAX;
+    }
+
+    WriteGeomInfoMaterials(recorded.geomInfo, materials, recorded.geomMaterial, recorded.layerBlendingTypes, recorded.layerColors);
+
+    return PushPreparedGeometry(frameIndex, recorded.uniqueID, geomFlags, recorded.asGeometry, recorded.primitiveCount, recorded.topology, recorded.geomInfo);
+}
+
+bool VertexCollector::AddMesh(const RgMeshCreateInfo &info, MeshGeometry &outResult)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    assert(!(filtersFlags & FT::CF_DYNAMIC));
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    uint32_t vertIndex, indIndex, transformIndex;
+
+    // mesh doesn't need a transform, it's set per instance in TLAS
+    if (!ReserveRanges(info.vertexCount, useIndices ? info.indexCount : 0, 0, &vertIndex, &indIndex, &transformIndex))
+    {
+        return false;
+    }
+
+    curPrimitiveCount += primitiveCount;
+
+    RgGeometryUploadInfo geomInfo = {};
+    geomInfo.flags = info.flags;
+    geomInfo.geomType = RG_GEOMETRY_TYPE_STATIC;
+    // opacity is set per instance
+    geomInfo.passThroughType = RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED;
+    geomInfo.visibilityType = RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0;
+    geomInfo.vertexCount = info.vertexCount;
+    geomInfo.pVertexData = info.pVertexData;
+    geomInfo.pNormalData = info.pNormalData;
+    memcpy(geomInfo.pTexCoordLayerData, info.pTexCoordLayerData, sizeof(info.pTexCoordLayerData));
+    geomInfo.indexCount = info.indexCount;
+    geomInfo.pIndexData = info.pIndexData;
+
+    const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(geomInfo);
+
+    PrepareGeometry(geomInfo, geomFlags, vertIndex, indIndex, UINT32_MAX, outResult.asGeometry, outResult.geomInfo);
+
+    // mesh instances are not processed by vertex preprocessing,
+    // so generate normals once here
+    if (info.pNormalData == nullptr)
+    {
+        GenerateNormalsInStaging(
+            vertIndex, info.vertexCount, indIndex, info.indexCount, useIndices,
+            info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT);
+    }
+
+    outResult.range = {};
+    outResult.range.primitiveCount = primitiveCount;
+    outResult.primitiveCount = primitiveCount;
+
+    return true;
+}
+
+void VertexCollector::PrepareMeshInstanceGeomInfo(
+    const MeshGeometry &mesh, const RgMeshInstanceUploadInfo &info,
+    const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT], ShGeometryInstance &outGeomInfo)
+{
+    outGeomInfo = {};
+    outGeomInfo.baseVertexIndex = mesh.geomInfo.baseVertexIndex;
+    outGeomInfo.baseIndexIndex = mesh.geomInfo.baseIndexIndex;
+    outGeomInfo.vertexCount = mesh.geomInfo.vertexCount;
+    outGeomInfo.indexCount = mesh.geomInfo.indexCount;
+    outGeomInfo.defaultRoughness = info.defaultRoughness;
+    outGeomInfo.defaultMetallicity = info.defaultMetallicity;
+    outGeomInfo.defaultEmission = info.defaultEmission;
+
+    Matrix::ToMat4Transposed(outGeomInfo.model, info.transform);
+
+    // normals were already generated, so the flags for normal generation are not needed;
+    // instances are movable, as their transforms can be changed every frame
+    outGeomInfo.flags = GetGeomInfoFlags(info.flags & ~RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT, info.passThroughType, info.layerBlendingTypes);
+    outGeomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+
+    WriteGeomInfoMaterials(outGeomInfo, materials, info.geomMaterial, info.layerBlendingTypes, info.layerColors);
+}
+
+bool VertexCollector::RecordStaticGeometry(const RgGeometryUploadInfo &info, RecordedStaticGeometry &outResult)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    assert(!(filtersFlags & FT::CF_DYNAMIC));
+
+    const VertexCollectorFilterTypeFlags geomFlags = VertexCollectorFilterTypeFlags_GetForGeometry(info);
+    assert(geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE));
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    // movable geometry has its own BLAS, and its transform is set in TLAS instance
+    const bool isMovable = geomFlags & FT::CF_STATIC_MOVABLE;
+
+    StaticGeometryRanges &r = outResult.ranges;
+    r = {};
+    r.vertexCount = info.vertexCount;
+    r.indexCount = useIndices ? info.indexCount : 0;
+    r.transformIndex = UINT32_MAX;
+
+    // try the ranges of removed geometries first, then the ones after all geometries;
+    // vertex and index ranges must begin at the indices that are aligned by 3
+    if (!freeVertexRanges.Allocate(r.vertexCount, 3, &r.vertIndex))
+    {
+        // staging buffers are grown right away, device local ones when the edits are submitted
+        ReserveCapacity(GetAlignedRangeEnd(curVertexCount, r.vertexCount), 0);
+
+        if (!ReserveRange(curVertexCount, r.vertexCount, vertexCapacity, true, &r.vertIndex))
+        {
+            return false;
+        }
+    }
+
+    if (r.indexCount > 0)
+    {
+        bool indFound = freeIndexRanges.Allocate(r.indexCount, 3, &r.indIndex);
+
+        if (!indFound)
+        {
+            ReserveCapacity(0, GetAlignedRangeEnd(curIndexCount, r.indexCount));
+            indFound = ReserveRange(curIndexCount, r.indexCount, indexCapacity, true, &r.indIndex);
+        }
+
+        if (!indFound)
+        {
+            freeVertexRanges.Free(r.vertIndex, r.vertexCount);
+            return false;
+        }
+    }
+
+    if (!isMovable)
+    {
+        const bool trnFound =
+            freeTransformRanges.Allocate(1, 1, &r.transformIndex) ||
+            ReserveRange(curTransformCount, 1, MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT, false, &r.transformIndex);
+
+        if (!trnFound)
+        {
+            r.transformIndex = UINT32_MAX;
+            FreeStaticRanges(r);
+            return false;
+        }
+    }
+
+    outResult.uniqueID = info.uniqueID;
+    outResult.geomFlags = geomFlags;
+    outResult.primitiveCount = primitiveCount;
+    outResult.geomMaterial = info.geomMaterial;
+    memcpy(outResult.layerBlendingTypes, info.layerBlendingTypes, sizeof(info.layerBlendingTypes));
+    memcpy(outResult.layerColors, info.layerColors, sizeof(info.layerColors));
+    outResult.transform = info.transform;
+
+    PrepareGeometry(info, geomFlags, r.vertIndex, r.indIndex, r.transformIndex, outResult.asGeometry, outResult.geomInfo);
+
+    // vertex preprocessing is done only when the whole static scene is submitted
+    if (info.pNormalData == nullptr)
+    {
+        GenerateNormalsInStaging(
+            r.vertIndex, info.vertexCount, r.indIndex, info.indexCount, useIndices,
+            info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT);
+
+        outResult.geomInfo.flags &= ~GEOM_INST_FLAG_GENERATE_NORMALS;
+    }
+
+    return true;
+}
+
+uint32_t VertexCollector::AddRecordedStaticGeometry(RecordedStaticGeometry &recorded, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT])
+{
+    const VertexCollectorFilterTypeFlags geomFlags = recorded.geomFlags;
+
+    assert(filters.find(geomFlags) != filters.end());
+    VertexCollectorFilter &filter = *filters[geomFlags];
+
+    if (!geomInfoMgr->CanAddStaticGeomInfo())
+    {
+        assert(0);
+        CancelRecordedStaticGeometry(recorded);
+        return UINT32_MAX;
+    }
+
+    VkAccelerationStructureBuildRangeInfoKHR rangeInfo = {};
+    rangeInfo.primitiveCount = recorded.primitiveCount;
+
+    // reuse the slot of a removed geometry, so geometry indices in BLAS are not changed
+    uint32_t localIndex = filter.SetGeometryToFreeSlot(recorded.asGeometry, recorded.primitiveCount, rangeInfo, {});
+
+    if (localIndex == UINT32_MAX)
+    {
+        // if exceeds a limit of geometries in a group with specified geomFlags
+        if (GetGeometryCount(geomFlags) + 1 >= VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(geomFlags))
+        {
+            assert(false && "Too many geometries in a group");
+            CancelRecordedStaticGeometry(recorded);
+            return UINT32_MAX;
+        }
+
+        localIndex = PushGeometry(geomFlags, recorded.asGeometry);
+        PushRangeInfo(geomFlags, rangeInfo);
+        PushPrimitiveCount(geomFlags, recorded.primitiveCount);
+        PushTopology(geomFlags, {});
+    }
+
+    WriteGeomInfoMaterials(recorded.geomInfo, materials, recorded.geomMaterial, recorded.layerBlendingTypes, recorded.layerColors);
+
+    const uint32_t simpleIndex = geomInfoMgr->AddStaticGeomInfo(recorded.uniqueID, localIndex, geomFlags, recorded.geomInfo);
+
+    AddMaterialDependencies(simpleIndex, recorded.geomMaterial, recorded.geomInfo);
+    SaveStaticGeometryData(simpleIndex, recorded.uniqueID, geomFlags, localIndex, recorded.ranges, recorded.geomMaterial);
+
+    addedStaticRanges.push_back(recorded.ranges);
+    curPrimitiveCount += recorded.primitiveCount;
+
+    return simpleIndex;
+}
+
+void VertexCollector::CancelRecordedStaticGeometry(const RecordedStaticGeometry &recorded)
+{
+    FreeStaticRanges(recorded.ranges);
+}
+
+VertexCollectorFilterTypeFlags VertexCollector::RemoveStaticGeometry(uint32_t frameIndex, uint32_t simpleIndex)
+{
+    if (simpleIndex >= staticGeoms.size())
+    {
+        assert(0);
+        return 0;
+    }
+
+    const StaticGeometryData &g = staticGeoms[simpleIndex];
+
+    assert(filters.find(g.geomFlags) != filters.end());
+
+    const uint32_t localIndex = g.localIndex;
+
+    filters[g.geomFlags]->RemoveGeometry(localIndex);
+    geomInfoMgr->RemoveStaticGeomInfo(simpleIndex, g.uniqueID);
+
+    RemoveMaterialDependencies(simpleIndex);
+
+    // ranges can be reused only when GPU doesn't access them
+    removedStaticGeoms[frameIndex].push_back({ simpleIndex, localIndex, g.geomFlags, g.ranges });
+
+    return g.geomFlags;
+}
+
+void VertexCollector::ReleaseRemovedStaticGeometries(uint32_t frameIndex)
+{
+    for (const RemovedStaticGeometry &r : removedStaticGeoms[frameIndex])
+    {
+        FreeStaticRanges(r.ranges);
+
+        assert(filters.find(r.geomFlags) != filters.end());
+        filters[r.geomFlags]->ReleaseSlot(r.localIndex);
+
+        geomInfoMgr->ReleaseStaticSimpleIndex(r.simpleIndex);
+    }
+
+    removedStaticGeoms[frameIndex].clear();
+}
+
+void VertexCollector::FreeStaticRanges(const StaticGeometryRanges &ranges)
+{
+    freeVertexRanges.Free(ranges.vertIndex, ranges.vertexCount);
+    freeIndexRanges.Free(ranges.indIndex, ranges.indexCount);
+
+    if (ranges.transformIndex != UINT32_MAX)
+    {
+        freeTransformRanges.Free(ranges.transformIndex, 1);
+    }
+}
+
+void VertexCollector::SaveStaticGeometryData(
+    uint32_t simpleIndex, uint64_t uniqueID, VertexCollectorFilterTypeFlags geomFlags, uint32_t localIndex,
+    const StaticGeometryRanges &ranges, const RgLayeredMaterial &geomMaterial)
+{
+    if (simpleIndex >= staticGeoms.size())
+    {
+        staticGeoms.resize(simpleIndex + 1);
+    }
+
+    StaticGeometryData &g = staticGeoms[simpleIndex];
+    g.uniqueID = uniqueID;
+    g.geomFlags = geomFlags;
+    g.localIndex = localIndex;
+    g.ranges = ranges;
+    memcpy(g.layerMaterials, geomMaterial.layerMaterials, sizeof(g.layerMaterials));
+}
+
+uint32_t VertexCollector::WriteGeometry(
+    uint32_t frameIndex, const RgGeometryUploadInfo &info, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT],
+    VertexCollectorFilterTypeFlags geomFlags, uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    const bool collectStatic = geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE);
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    // movable geometry has its own BLAS, and its transform is set in TLAS instance
+    const bool isMovable = geomFlags & FT::CF_STATIC_MOVABLE;
+
+    VkAccelerationStructureGeometryKHR geom;
+    ShGeometryInstance geomInfo;
+
+    PrepareGeometry(info, geomFlags, vertIndex, indIndex, isMovable ? UINT32_MAX : transformIndex, geom, geomInfo);
+    WriteGeomInfoMaterials(geomInfo, materials, info.geomMaterial, info.layerBlendingTypes, info.layerColors);
+
+    // movable geometries are not processed by vertex preprocessing,
+    // as they're not in the filter instances, so generate normals once here
+    if (isMovable && info.pNormalData == nullptr)
+    {
+        GenerateNormalsInStaging(
+            vertIndex, info.vertexCount, indIndex, info.indexCount, useIndices,
+            info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT);
+
+        geomInfo.flags &= ~GEOM_INST_FLAG_GENERATE_NORMALS;
+    }
+
+    // only dynamic BLAS-es are refitted, so don't hash static index data
+    GeometryTopology topology = {};
+
+    if (!collectStatic)
+    {
+        topology = GetTopology(info);
+    }
+
+    uint32_t simpleIndex = PushPreparedGeometry(frameIndex, info.uniqueID, geomFlags, geom, primitiveCount, topology, geomInfo);
+
+    if (collectStatic)
+    {
+        // add material dependency but only for static geometry,
+        // dynamic is updated each frame, so their materials will be updated anyway
+        AddMaterialDependencies(simpleIndex, info.geomMaterial, geomInfo);
+
+        StaticGeometryRanges ranges = {};
+        ranges.vertIndex = vertIndex;
+        ranges.vertexCount = info.vertexCount;
+        ranges.indIndex = indIndex;
+        ranges.indexCount = useIndices ? info.indexCount : 0;
+        // transform range is reserved even for movable geometry
+        ranges.transformIndex = transformIndex;
+
+        // local index is the last one in the filter, as static geometries are only pushed while collecting
+        const uint32_t localIndex = GetGeometryCount(geomFlags) - 1;
+
+        SaveStaticGeometryData(simpleIndex, info.uniqueID, geomFlags, localIndex, ranges, info.geomMaterial);
+    }
+
+    return simpleIndex;
+}
+
+void VertexCollector::PrepareGeometry(
+    const RgGeometryUploadInfo &info, VertexCollectorFilterTypeFlags geomFlags,
+    uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex,
+    VkAccelerationStructureGeometryKHR &geom, ShGeometryInstance &geomInfo)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    const bool collectStatic = geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE);
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+
+    // copy data to buffer
+    assert(stagingVertBuffer->IsMapped());
+    CopyDataToStaging(info, vertIndex, collectStatic);
+
+    if (useIndices)
+    {
+        assert(stagingIndexBuffer->IsMapped());
+        memcpy(mappedIndexData + indIndex, info.pIndexData, info.indexCount * sizeof(uint32_t));
+    }
+
+    PrepareASGeometry(info, geomFlags, vertIndex, indIndex, transformIndex, geom, geomInfo);
+}
+
+void VertexCollector::PrepareASGeometry(
+    const RgGeometryUploadInfo &info, VertexCollectorFilterTypeFlags geomFlags,
+    uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex,
+    VkAccelerationStructureGeometryKHR &geom, ShGeometryInstance &geomInfo)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    const bool collectStatic = geomFlags & (FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE);
+
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+
+    static_assert(sizeof(RgTransform) == sizeof(VkTransformMatrixKHR), "RgTransform and VkTransformMatrixKHR must have the same structure to be used in AS building");
+
+    // UINT32_MAX if geometry doesn't have a transform in BLAS
+    const bool useTransform = transformIndex != UINT32_MAX;
+
+    if (useTransform)
+    {
+        memcpy(mappedTransformData + transformIndex, &info.transform, sizeof(VkTransformMatrixKHR));
+    }
+
+    const VertexBufferLayout l = GetVertexBufferLayout(collectStatic, properties, vertexCapacity);
+
+    // use positions and index data in the device local buffers: AS shouldn't be built using staging buffers
+    const VkDeviceAddress vertexDataDeviceAddress =
+        vertBuffer->GetAddress() + l.offsetPositions + vertIndex * l.positionStride;
+
+    // geometry info
+    geom = {};
+    geom.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+    geom.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+
+    geom.flags = geomFlags & FT::PT_OPAQUE ?
+        VK_GEOMETRY_OPAQUE_BIT_KHR :
+        VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+
+    VkAccelerationStructureGeometryTrianglesDataKHR &trData = geom.geometry.triangles;
+    trData.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+    trData.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+    trData.maxVertex = info.vertexCount;
+    trData.vertexData.deviceAddress = vertexDataDeviceAddress;
+    trData.vertexStride = l.positionStride;
+    trData.transformData.deviceAddress = useTransform ? 
+        transformsBuffer->GetAddress() + transformIndex * sizeof(VkTransformMatrixKHR) :
+        0;
+
+    if (useIndices)
+    {
+        const VkDeviceAddress indexDataDeviceAddress =
+            indexBuffer->GetAddress() + indIndex * sizeof(uint32_t);
+
+        trData.indexType = VK_INDEX_TYPE_UINT32;
+        trData.indexData.deviceAddress = indexDataDeviceAddress;
+    }
+    else
+    {
+        trData.indexType = VK_INDEX_TYPE_NONE_KHR;
+        trData.indexData = {};
+    }
+
+
+    geomInfo = {};
+    geomInfo.baseVertexIndex = vertIndex;
+    geomInfo.baseIndexIndex = useIndices ? indIndex : UINT32_MAX;
+    geomInfo.vertexCount = info.vertexCount;
+    geomInfo.indexCount = useIndices ? info.indexCount : UINT32_MAX;
+    geomInfo.defaultRoughness = info.defaultRoughness;
+    geomInfo.defaultMetallicity = info.defaultMetallicity;
+    geomInfo.defaultEmission = info.defaultEmission;
+
+    Matrix::ToMat4Transposed(geomInfo.model, info.transform);
+
+    static_assert(sizeof(info.geomMaterial.layerMaterials) / sizeof(info.geomMaterial.layerMaterials[0]) == MATERIALS_MAX_LAYER_COUNT,
+                  "Layer count must be MATERIALS_MAX_LAYER_COUNT");
+
+    geomInfo.flags = GetGeomInfoFlags(info.flags, info.passThroughType, info.layerBlendingTypes);
+
+    if (info.pNormalData == nullptr)
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
+    }
+
+    if (geomFlags & FT::CF_STATIC_MOVABLE)
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+    }
+}
+
+uint32_t VertexCollector::GetGeomInfoFlags(
+    RgGeometryUploadFlags flags, RgGeometryPassThroughType passThroughType,
+    const RgGeometryMaterialBlendType layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT])
+{
+    uint32_t r = GetMaterialsBlendFlags(layerBlendingTypes, MATERIALS_MAX_LAYER_COUNT);
+
+    if (flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT)
+    {
+        r |= GEOM_INST_FLAG_INVERTED_NORMALS;
+    }
+
+    if (flags & RG_GEOMETRY_UPLOAD_NO_MEDIA_CHANGE_ON_REFRACT_BIT)
+    {
+        r |= GEOM_INST_FLAG_NO_MEDIA_CHANGE;
+    }
+
+    switch (passThroughType)
+    {
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR:
+            r |= GEOM_INST_FLAG_REFLECT;
+            break;
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL:
+            r |= GEOM_INST_FLAG_PORTAL;
+            break;
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT:
+            r |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
+            r |= GEOM_INST_FLAG_REFLECT;
+            break;
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT:
+            r |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
+            r |= GEOM_INST_FLAG_REFLECT;
+            r |= GEOM_INST_FLAG_REFRACT;
+            break;
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT:
+            r |= GEOM_INST_FLAG_MEDIA_TYPE_GLASS;
+            r |= GEOM_INST_FLAG_REFLECT;
+            r |= GEOM_INST_FLAG_REFRACT;
+            break;
+        default:
+            break;
+    }
+
+    return r;
+}
+
+uint32_t VertexCollector::PushPreparedGeometry(
+    uint32_t frameIndex, uint64_t uniqueID, VertexCollectorFilterTypeFlags geomFlags,
+    const VkAccelerationStructureGeometryKHR &geom, uint32_t primitiveCount,
+    const GeometryTopology &topology, ShGeometryInstance &geomInfo)
+{
+    uint32_t localIndex = PushGeometry(geomFlags, geom);
+
+
+    VkAccelerationStructureBuildRangeInfoKHR rangeInfo = {};
+    rangeInfo.primitiveCount = primitiveCount;
+    rangeInfo.primitiveOffset = 0;
+    rangeInfo.firstVertex = 0;
+    rangeInfo.transformOffset = 0;
+    PushRangeInfo(geomFlags, rangeInfo);
+
+
+    PushPrimitiveCount(geomFlags, primitiveCount);
+
+
+    PushTopology(geomFlags, topology);
+
+
+    if (deferStaticGeomInfos)
+    {
+        assert(!(geomFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC));
+
+        // simple index is the same as it will be after flushing,
+        // as geom info manager is reset with static before that
+        deferredStaticGeomInfos.push_back({ uniqueID, localIndex, geomFlags, geomInfo });
+        return static_cast<uint32_t>(deferredStaticGeomInfos.size() - 1);
+    }
+
+    // simple index -- calculated as (global cur static count + global cur dynamic count)
+    // global geometry index -- for indexing in geom infos buffer
+    // local geometry index -- index of geometry in BLAS
+    return geomInfoMgr->WriteGeomInfo(frameIndex, uniqueID, localIndex, geomFlags, geomInfo);
+}
+
+GeometryTopology VertexCollector::GetTopology(const RgGeometryUploadInfo &info)
+{
+    const bool useIndices = info.indexCount != 0 && info.pIndexData != nullptr;
+
+    GeometryTopology t = {};
+    t.uniqueID = info.uniqueID;
+    t.vertexCount = info.vertexCount;
+    t.indexCount = useIndices ? info.indexCount : 0;
+    t.indexHash = 0;
+
+    if (useIndices)
+    {
+        // FNV-1a
+        uint64_t h = 14695981039346656037ull;
+
+        const uint32_t *indices = static_cast<const uint32_t *>(info.pIndexData);
+
+        for (uint32_t i = 0; i < info.indexCount; i++)
+        {
+            h ^= indices[i];
+            h *= 1099511628211ull;
+        }
+
+        t.indexHash = h;
+    }
+
+    return t;
+}
+
+void VertexCollector::WriteGeomInfoMaterials(
+    ShGeometryInstance &dst, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT],
+    const RgLayeredMaterial &geomMaterial,
+    const RgGeometryMaterialBlendType layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT],
+    const RgFloat4D layerColors[MATERIALS_MAX_LAYER_COUNT])
+{
+    for (int32_t layer = MATERIALS_MAX_LAYER_COUNT - 1; layer >= 0; layer--)
+    {
+        uint32_t *pMatArr = &dst.materials0A;
+
+        memcpy(&pMatArr[layer * TEXTURES_PER_MATERIAL_COUNT], materials[layer].indices, TEXTURES_PER_MATERIAL_COUNT * sizeof(uint32_t));
+        memcpy(dst.materialColors[layer], layerColors[layer].data, sizeof(layerColors[layer].data));
+
+        // ignore lower level layers, if they won't be visible (i.e. current one is opaque) 
+        if (layerBlendingTypes[layer] == RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE &&
+            geomMaterial.layerMaterials[layer] != RG_NO_MATERIAL)
+        {
+            break;
+        }
+    }
+}
+
+void VertexCollector::CopyDataToStaging(const RgGeometryUploadInfo &info, uint32_t vertIndex, bool isStatic)
+{
+    const VertexBufferLayout l = GetVertexBufferLayout(isStatic, properties, vertexCapacity);
+
+    // positions
+    void *positionsDst = mappedVertexData + l.offsetPositions + vertIndex * l.positionStride;
+    assert(l.offsetPositions + (vertIndex + info.vertexCount) * l.positionStride < l.wholeSize);
+
+    VertexIngest::CopyFloat3(static_cast<float *>(positionsDst), info.pVertexData, properties.positionStride, info.vertexCount);
+
+    // normals
+    void *normalsDst = mappedVertexData + l.offsetNormals + vertIndex * l.normalStride;
+    assert(l.offsetNormals + (vertIndex + info.vertexCount) * l.normalStride < l.wholeSize);
+
+    if (info.pNormalData != nullptr)
+    {
+        if (properties.compactVertexData)
+        {
+            VertexEncoding::EncodeNormalsOct(static_cast<uint32_t *>(normalsDst), info.pNormalData, properties.normalStride, info.vertexCount);
+        }
+        else
+        {
+            VertexIngest::CopyFloat3(static_cast<float *>(normalsDst), info.pNormalData, properties.normalStride, info.vertexCount);
+        }
+    }
+
+    //const bool useIndices = info.indexCount != 0 && info.indexData != nullptr;
+    //const uint32_t triangleCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+
+    CopyTexCoordsToStaging(isStatic, vertIndex, info.vertexCount, info.pTexCoordLayerData);
+}
+
+void VertexCollector::GenerateNormalsInStaging(
+    uint32_t vertIndex, uint32_t vertexCount, uint32_t indIndex, uint32_t indexCount, bool useIndices, bool inverted)
+{
+    assert(mappedVertexData != nullptr);
+
+    const VertexBufferLayout l = GetVertexBufferLayout(true, properties, vertexCapacity);
+
+    const uint64_t positionStride = l.positionStride;
+    const uint64_t normalStride = l.normalStride;
+
+    const uint8_t *positions = mappedVertexData + l.offsetPositions + vertIndex * positionStride;
+    uint8_t *normals = mappedVertexData + l.offsetNormals + vertIndex * normalStride;
+
+    const bool compact = properties.compactVertexData;
+
+    const float sign = inverted ? -1.0f : 1.0f;
+    const uint32_t triangleCount = useIndices ? indexCount / 3 : vertexCount / 3;
+
+    // same as in vertex preprocessing: each vertex gets the normal
+    // of the last triangle that references it
+    for (uint32_t tri = 0; tri < triangleCount; tri++)
+    {
+        uint32_t v[3];
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            v[k] = useIndices ? mappedIndexData[indIndex + tri * 3 + k] : tri * 3 + k;
+        }
+
+        if (v[0] >= vertexCount || v[1] >= vertexCount || v[2] >= vertexCount)
+        {
+            assert(0);
+            continue;
+        }
+
+        const float *a = reinterpret_cast<const float *>(positions + v[0] * positionStride);
+        const float *b = reinterpret_cast<const float *>(positions + v[1] * positionStride);
+        const float *c = reinterpret_cast<const float *>(positions + v[2] * positionStride);
+
+        const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+        float n[3] =
+        {
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0],
+        };
+
+        const float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        const float scale = len > 0.0f ? sign / len : 0.0f;
+
+        n[0] *= scale;
+        n[1] *= scale;
+        n[2] *= scale;
+
+        const uint32_t encoded = compact ? VertexEncoding::EncodeNormalOct(n) : 0;
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            if (compact)
+            {
+                memcpy(normals + v[k] * normalStride, &encoded, sizeof(encoded));
+            }
+            else
+            {
+                memcpy(normals + v[k] * normalStride, n, sizeof(n));
+            }
+        }
+    }
+}
+
+void RTGL1::VertexCollector::CopyTexCoordsToStaging(bool isStatic, uint32_t globalVertIndex, uint32_t vertexCount, const void *const texCoordLayerData[3], bool addToCopy)
+{
+    assert(mappedVertexData != nullptr);
+
+    // additional tex coords for static geometry
+    const VertexBufferLayout l = GetVertexBufferLayout(isStatic, properties, vertexCapacity);
+
+    const uint64_t texCoordDataSize = vertexCount * l.texCoordStride;
+
+
+    for (uint32_t i = 0; i < l.texCoordLayerCount; i++)
+    {
+        if (texCoordLayerData[i] != nullptr)
+        {
+            uint64_t dstOffsetBegin = l.offsetTexCoords[i] + globalVertIndex * l.texCoordStride;
+            uint64_t dstOffsetEnd = dstOffsetBegin + texCoordDataSize;
+
+            void *texCoordDst = mappedVertexData + dstOffsetBegin;
+            assert(dstOffsetEnd < l.wholeSize);
+
+            if (properties.compactVertexData)
+            {
+                VertexEncoding::EncodeTexCoordsHalf(static_cast<uint32_t *>(texCoordDst), texCoordLayerData[i], properties.texCoordStride, vertexCount);
+            }
+            else
+            {
+                VertexIngest::CopyFloat2(static_cast<float *>(texCoordDst), texCoordLayerData[i], properties.texCoordStride, vertexCount);
+            }
+
+
+            if (addToCopy)
+            {
+                texCoordsToCopy.push_back({ i, globalVertIndex, vertexCount });
+            }
+        }
+    }
+}
+
+
+void VertexCollector::EndCollecting()
+{}
+
+void VertexCollector::ReserveCapacity(uint32_t vertexCount, uint32_t indexCount)
+{
+    const uint32_t newVertexCapacity = GetGrownCapacity(vertexCapacity, vertexCount, maxVertexCapacity);
+    const uint32_t newIndexCapacity = GetGrownCapacity(indexCapacity, indexCount, maxIndexCapacity);
+
+    if (newVertexCapacity != vertexCapacity || newIndexCapacity != indexCapacity)
+    {
+        GrowStagingBuffers(newVertexCapacity, newIndexCapacity);
+    }
+}
+
+void VertexCollector::GrowStagingBuffers(uint32_t newVertexCapacity, uint32_t newIndexCapacity)
+{
+    if (newVertexCapacity != vertexCapacity)
+    {
+        const VertexBufferLayout oldL = GetVertexBufferLayout(IsStatic(), properties, vertexCapacity);
+        const VertexBufferLayout newL = GetVertexBufferLayout(IsStatic(), properties, newVertexCapacity);
+
+        auto newBuffer = std::make_shared<Buffer>();
+        newBuffer->Init(
+            allocator, newL.wholeSize,
+            GetStagingUsage(directWrite),
+            GetStagingMemoryProperties(directWrite),
+            IsStatic() ? "Static Vertices data staging buffer" : "Dynamic Vertices data staging buffer");
+
+        uint8_t *newData = static_cast<uint8_t *>(newBuffer->Map());
+
+        // offsets of the attribute arrays depend on the capacity, so each array is moved separately
+        const uint64_t count = curVertexCount;
+
+        memcpy(newData + newL.offsetPositions, mappedVertexData + oldL.offsetPositions, count * oldL.positionStride);
+        memcpy(newData + newL.offsetNormals, mappedVertexData + oldL.offsetNormals, count * oldL.normalStride);
+
+        for (uint32_t i = 0; i < oldL.texCoordLayerCount; i++)
+        {
+            memcpy(newData + newL.offsetTexCoords[i], mappedVertexData + oldL.offsetTexCoords[i], count * oldL.texCoordStride);
+        }
+
+        // old buffer can be still in use, if it was copied in one of the frames in flight
+        stagingVertBuffer->Unmap();
+        retiredBuffers.push_back(std::move(stagingVertBuffer));
+
+        stagingVertBuffer = std::move(newBuffer);
+        mappedVertexData = newData;
+        vertexCapacity = newVertexCapacity;
+    }
+
+    if (newIndexCapacity != indexCapacity)
+    {
+        auto newBuffer = std::make_shared<Buffer>();
+        newBuffer->Init(
+            allocator, (VkDeviceSize)newIndexCapacity * sizeof(uint32_t),
+            GetStagingUsage(directWrite),
+            GetStagingMemoryProperties(directWrite),
+            IsStatic() ? "Static Index data staging buffer" : "Dynamic Index data staging buffer");
+
+        uint32_t *newData = static_cast<uint32_t *>(newBuffer->Map());
+
+        memcpy(newData, mappedIndexData, (uint64_t)curIndexCount * sizeof(uint32_t));
+
+        stagingIndexBuffer->Unmap();
+        retiredBuffers.push_back(std::move(stagingIndexBuffer));
+
+        stagingIndexBuffer = std::move(newBuffer);
+        mappedIndexData = newData;
+        indexCapacity = newIndexCapacity;
+    }
+}
+
+uint32_t VertexCollector::GetRequestedVertexCount() const
+{
+    return requestedVertexCount.load(std::memory_order_relaxed);
+}
+
+uint32_t VertexCollector::GetRequestedIndexCount() const
+{
+    return requestedIndexCount.load(std::memory_order_relaxed);
+}
+
+bool VertexCollector::ResizeDeviceBuffers()
+{
+    if (deviceVertexCapacity == vertexCapacity && deviceIndexCapacity == indexCapacity)
+    {
+        return false;
     }
 
+    rebaseVertAddress[0] = vertBuffer->GetAddress();
+    rebaseIndexAddress[0] = indexBuffer->GetAddress();
 
-    // simple index -- calculated as (global cur static count + global cur dynamic count)
-    // global geometry index -- for indexing in geom infos buffer
-    // local geometry index -- index of geometry in BLAS
-    uint32_t simpleIndex = geomInfoMgr->WriteGeomInfo(frameIndex, info.uniqueID, localIndex, geomFlags, geomInfo);
+    // old buffers can be in use by the frames in flight;
+    // their data is not copied, as the whole data is copied from staging after
+    // (with direct write, the new buffers are the grown staging ones)
+    retiredBuffers.push_back(std::move(vertBuffer));
+    retiredBuffers.push_back(std::move(indexBuffer));
 
-    if (collectStatic)
+    InitDeviceBuffers(vertexCapacity, indexCapacity);
+
+    rebaseVertAddress[1] = vertBuffer->GetAddress();
+    rebaseIndexAddress[1] = indexBuffer->GetAddress();
+
+    for (auto &f : filters)
     {
-        // add material dependency but only for static geometry,
-        // dynamic is updated each frame, so their materials will be updated anyway
-        for (int32_t layer = MATERIALS_MAX_LAYER_COUNT - 1; layer >= 0; layer--)
-        {
-            const uint32_t materialIndex = info.geomMaterial.layerMaterials[layer];
+        f.second->RebaseAddresses(rebaseVertAddress, rebaseIndexAddress);
+    }
 
-            for (uint32_t t = 0; t < TEXTURES_PER_MATERIAL_COUNT; t++)
-            {
-                uint32_t *pMatArr = &geomInfo.materials0A;
+    return true;
+}
 
-                // if at least one texture is not empty on this layer, add dependency 
-                if (pMatArr[layer * TEXTURES_PER_MATERIAL_COUNT + t] != EMPTY_TEXTURE_INDEX)
-                {
-                    AddMaterialDependency(simpleIndex, layer, materialIndex);
+bool VertexCollector::GrowSubmittedDeviceBuffers(VkCommandBuffer cmd)
+{
+    assert(IsStatic() && !directWrite);
 
-                    break;
-                }               
-            }
-        }
+    // old buffers are retired by ResizeDeviceBuffers, but they're read here
+    const std::shared_ptr<Buffer> oldVertBuffer = vertBuffer;
+    const std::shared_ptr<Buffer> oldIndexBuffer = indexBuffer;
+    const uint32_t oldVertexCapacity = deviceVertexCapacity;
+    const uint32_t oldIndexCapacity = deviceIndexCapacity;
 
-        // also, save transform index for updating static movable's transforms
-        simpleIndexToTransformIndex[simpleIndex] = transformIndex;
+    if (!ResizeDeviceBuffers())
+    {
+        return false;
     }
 
-    return simpleIndex;
-}
+    // old data could be written by the copies from staging or by vertex preprocessing
+    VkMemoryBarrier br = {};
+    br.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    br.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    br.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
-void VertexCollector::CopyDataToStaging(const RgGeometryUploadInfo &info, uint32_t vertIndex, bool isStatic)
-{
-    const uint64_t wholeBufferSize = isStatic ?
-        sizeof(ShVertexBufferStatic) :
-        sizeof(ShVertexBufferDynamic);
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &br,
+        0, nullptr,
+        0, nullptr);
 
-    const uint64_t offsetPositions = isStatic ?
-        offsetof(ShVertexBufferStatic, positions) :
-        offsetof(ShVertexBufferDynamic, positions);
-    const uint64_t offsetNormals = isStatic ?
-        offsetof(ShVertexBufferStatic, normals) :
-        offsetof(ShVertexBufferDynamic, normals);
+    // offsets of the attribute arrays depend on the capacity, so each array is copied separately;
+    // recorded geometries can be out of the old buffers, they're copied from staging after
+    const VertexBufferLayout oldL = GetVertexBufferLayout(true, properties, oldVertexCapacity);
+    const VertexBufferLayout newL = GetVertexBufferLayout(true, properties, deviceVertexCapacity);
 
-    const uint64_t positionStride = properties.positionStride;
-    const uint64_t normalStride = properties.normalStride;
+    const uint64_t vertexCount = std::min<uint32_t>(curVertexCount, oldVertexCapacity);
+    const uint64_t indexCount = std::min<uint32_t>(curIndexCount, oldIndexCapacity);
 
-    // positions
-    void *positionsDst = mappedVertexData + offsetPositions + vertIndex * positionStride;
-    assert(offsetPositions + (vertIndex + info.vertexCount) * positionStride < wholeBufferSize);
+    if (vertexCount > 0)
+    {
+        std::vector<VkBufferCopy> vertCopies;
 
-    memcpy(positionsDst, info.pVertexData, info.vertexCount * positionStride);
+        vertCopies.push_back({ oldL.offsetPositions, newL.offsetPositions, vertexCount * oldL.positionStride });
+        vertCopies.push_back({ oldL.offsetNormals, newL.offsetNormals, vertexCount * oldL.normalStride });
 
-    // normals
-    void *normalsDst = mappedVertexData + offsetNormals + vertIndex * normalStride;
-    assert(offsetNormals + (vertIndex + info.vertexCount) * normalStride < wholeBufferSize);
+        for (uint32_t i = 0; i < oldL.texCoordLayerCount; i++)
+        {
+            vertCopies.push_back({ oldL.offsetTexCoords[i], newL.offsetTexCoords[i], vertexCount * oldL.texCoordStride });
+        }
 
-    if (info.pNormalData != nullptr)
+        vkCmdCopyBuffer(cmd, oldVertBuffer->GetBuffer(), vertBuffer->GetBuffer(), vertCopies.size(), vertCopies.data());
+    }
+
+    if (indexCount > 0)
     {
-        memcpy(normalsDst, info.pNormalData, info.vertexCount * normalStride);
+        VkBufferCopy info = {};
+        info.srcOffset = 0;
+        info.dstOffset = 0;
+        info.size = indexCount * sizeof(uint32_t);
+
+        vkCmdCopyBuffer(cmd, oldIndexBuffer->GetBuffer(), indexBuffer->GetBuffer(), 1, &info);
     }
 
-    //const bool useIndices = info.indexCount != 0 && info.indexData != nullptr;
-    //const uint32_t triangleCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+    // added geometries are copied to the same buffers after
+    br.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    br.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
 
-    CopyTexCoordsToStaging(isStatic, vertIndex, info.vertexCount, info.pTexCoordLayerData);
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &br,
+        0, nullptr,
+        0, nullptr);
+
+    return true;
 }
 
-void RTGL1::VertexCollector::CopyTexCoordsToStaging(bool isStatic, uint32_t globalVertIndex, uint32_t vertexCount, const void *const texCoordLayerData[3], bool addToCopy)
+void VertexCollector::ShareDeviceBuffers(const VertexCollector &src)
 {
-    assert(mappedVertexData != nullptr);
+    assert(!directWrite && !src.directWrite);
+
+    // AS geometries of the filters are not rebased,
+    // as they're reset before this collector is used again
+    vertBuffer = src.vertBuffer;
+    indexBuffer = src.indexBuffer;
+    deviceVertexCapacity = src.deviceVertexCapacity;
+    deviceIndexCapacity = src.deviceIndexCapacity;
+}
 
-    const uint64_t texCoordStride = properties.texCoordStride;
-    const uint64_t wholeBufferSize = isStatic ?
-        sizeof(ShVertexBufferStatic) :
-        sizeof(ShVertexBufferDynamic);
+bool VertexCollector::IsDirectWrite() const
+{
+    return directWrite;
+}
 
-    const uint64_t texCoordDataSize = vertexCount * texCoordStride;
+void VertexCollector::RebaseASGeometry(VkAccelerationStructureGeometryKHR &geom) const
+{
+    VertexCollectorFilter::RebaseAddresses(geom, rebaseVertAddress, rebaseIndexAddress);
+}
 
+void VertexCollector::TakeRetiredBuffers(std::vector<std::shared_ptr<Buffer>> &outRetired)
+{
+    for (auto &b : retiredBuffers)
+    {
+        outRetired.push_back(std::move(b));
+    }
 
-    // additional tex coords for static geometry
-    const uint64_t *offsetTexCoords = isStatic ? OFFSET_TEX_COORDS_STATIC : OFFSET_TEX_COORDS_DYNAMIC;
-    uint32_t        offsetCount     = isStatic ? TEXCOORD_LAYER_COUNT_STATIC : TEXCOORD_LAYER_COUNT_DYNAMIC;
+    retiredBuffers.clear();
+}
 
+void VertexCollector::WriteVertexStreamOffsets(ShGlobalUniform &gu) const
+{
+    // shaders access the device local buffer, offsets are in 4-byte elements
+    const VertexBufferLayout l = GetVertexBufferLayout(IsStatic(), properties, deviceVertexCapacity);
 
-    for (uint32_t i = 0; i < offsetCount; i++)
+    if (IsStatic())
     {
-        if (texCoordLayerData[i] != nullptr)
-        {
-            uint64_t dstOffsetBegin = offsetTexCoords[i] + globalVertIndex * texCoordStride;
-            uint64_t dstOffsetEnd = dstOffsetBegin + texCoordDataSize;
-
-            void *texCoordDst = mappedVertexData + dstOffsetBegin;
-            assert(dstOffsetEnd < wholeBufferSize);
-
-            memcpy(texCoordDst, texCoordLayerData[i], texCoordDataSize);
+        gu.staticNormalsOffset = (uint32_t)(l.offsetNormals / sizeof(uint32_t));
+        gu.staticTexCoordsOffset = (uint32_t)(l.offsetTexCoords[0] / sizeof(uint32_t));
+        gu.staticTexCoordsLayer1Offset = (uint32_t)(l.offsetTexCoords[1] / sizeof(uint32_t));
+        gu.staticTexCoordsLayer2Offset = (uint32_t)(l.offsetTexCoords[2] / sizeof(uint32_t));
+    }
+    else
+    {
+        gu.dynamicNormalsOffset = (uint32_t)(l.offsetNormals / sizeof(uint32_t));
+        gu.dynamicTexCoordsOffset = (uint32_t)(l.offsetTexCoords[0] / sizeof(uint32_t));
+    }
+}
 
+void VertexCollector::FlushStaticGeomInfos(uint32_t frameIndex)
+{
+    assert(deferStaticGeomInfos);
+    assert(geomInfoMgr->GetCount() == 0);
 
-            if (addToCopy)
-            {
-                texCoordsToCopyLowerBound = std::min(dstOffsetBegin, texCoordsToCopyLowerBound);
-                texCoordsToCopyUpperBound = std::max(dstOffsetEnd, texCoordsToCopyUpperBound);
+    geomInfoMgr->Reserve(static_cast<uint32_t>(deferredStaticGeomInfos.size()));
 
-                VkBufferCopy cp = {};
-                cp.srcOffset = dstOffsetBegin;
-                cp.dstOffset = dstOffsetBegin;
-                cp.size = texCoordDataSize;
+    for (uint32_t i = 0; i < deferredStaticGeomInfos.size(); i++)
+    {
+        DeferredStaticGeomInfo &d = deferredStaticGeomInfos[i];
 
-                texCoordsToCopy.push_back(cp);
-            }
-        }
+        const uint32_t simpleIndex = geomInfoMgr->WriteGeomInfo(frameIndex, d.uniqueID, d.localIndex, d.geomFlags, d.geomInfo);
+        assert(simpleIndex == i);
+        (void)simpleIndex;
     }
-}
 
+    deferredStaticGeomInfos.clear();
+    deferStaticGeomInfos = false;
+}
 
-void VertexCollector::EndCollecting()
-{}
+uint32_t VertexCollector::GetStaticGeomLocalIndex(uint32_t simpleIndex) const
+{
+    assert(simpleIndex < staticGeoms.size());
+    return staticGeoms[simpleIndex].localIndex;
+}
 
 void VertexCollector::Reset()
 {
@@ -515,14 +1674,29 @@ void VertexCollector::Reset()
     curPrimitiveCount = 0;
     curTransformCount = 0;
 
-    simpleIndexToTransformIndex.clear();
-
     materialDependencies.clear();
 
     for (auto &f : filters)
     {
         f.second->Reset();
     }
+
+    staticGeoms.clear();
+    addedStaticRanges.clear();
+
+    texCoordsToCopy.clear();
+
+    deferStaticGeomInfos = false;
+    deferredStaticGeomInfos.clear();
+
+    for (auto &r : removedStaticGeoms)
+    {
+        r.clear();
+    }
+
+    freeVertexRanges.Reset();
+    freeIndexRanges.Reset();
+    freeTransformRanges.Reset();
 }
 
 std::vector<VkBufferCopy> VertexCollector::CopyVertexDataFromStaging(VkCommandBuffer cmd, bool isStatic)
@@ -536,9 +1710,14 @@ std::vector<VkBufferCopy> VertexCollector::CopyVertexDataFromStaging(VkCommandBu
 
     vkCmdCopyBuffer(
         cmd,
-        stagingVertBuffer.GetBuffer(), vertBuffer->GetBuffer(),
+        stagingVertBuffer->GetBuffer(), vertBuffer->GetBuffer(),
         vertCopyInfos.size(), vertCopyInfos.data());
 
+    for (const auto &cp : vertCopyInfos)
+    {
+        allocator->RegisterStagingCopy(cp.size);
+    }
+
     return vertCopyInfos;
 }
 
@@ -556,9 +1735,11 @@ bool VertexCollector::CopyIndexDataFromStaging(VkCommandBuffer cmd)
 
     vkCmdCopyBuffer(
         cmd,
-        stagingIndexBuffer.GetBuffer(), indexBuffer->GetBuffer(),
+        stagingIndexBuffer->GetBuffer(), indexBuffer->GetBuffer(),
         1, &info);
 
+    allocator->RegisterStagingCopy(info.size);
+
     return true;
 }
 
@@ -576,9 +1757,11 @@ bool VertexCollector::CopyTransformsFromStaging(VkCommandBuffer cmd, bool insert
 
     vkCmdCopyBuffer(
         cmd,
-        stagingTransformsBuffer.GetBuffer(), transformsBuffer->GetBuffer(),
+        stagingTransformsBuffer->GetBuffer(), transformsBuffer->GetBuffer(),
         1, &info);
 
+    allocator->RegisterStagingCopy(info.size);
+
     if (insertMemBarrier)
     {
         VkBufferMemoryBarrier trnBr = {};
@@ -602,11 +1785,6 @@ bool VertexCollector::CopyTransformsFromStaging(VkCommandBuffer cmd, bool insert
     return true;
 }
 
-bool VertexCollector::RecopyTransformsFromStaging(VkCommandBuffer cmd)
-{
-    return CopyTransformsFromStaging(cmd, true);
-}
-
 bool RTGL1::VertexCollector::RecopyTexCoordsFromStaging(VkCommandBuffer cmd)
 {
     if (curTransformCount == 0 || texCoordsToCopy.empty())
@@ -614,10 +1792,42 @@ bool RTGL1::VertexCollector::RecopyTexCoordsFromStaging(VkCommandBuffer cmd)
         return false;
     }
 
+    // staging buffers could be grown by the recorded static geometry,
+    // device local ones are grown only when the edits are submitted
+    const VertexBufferLayout srcL = GetVertexBufferLayout(true, properties, vertexCapacity);
+    const VertexBufferLayout dstL = GetVertexBufferLayout(true, properties, deviceVertexCapacity);
+
+    std::vector<VkBufferCopy> copies;
+    copies.reserve(texCoordsToCopy.size());
+
+    VkDeviceSize texCoordsToCopyLowerBound = UINT64_MAX;
+    VkDeviceSize texCoordsToCopyUpperBound = 0;
+
+    for (const TexCoordsRange &r : texCoordsToCopy)
+    {
+        // only geometries that are already in the device local buffers can be updated
+        assert(r.vertIndex + r.vertexCount <= deviceVertexCapacity);
+
+        VkBufferCopy cp = {};
+        cp.srcOffset = srcL.offsetTexCoords[r.layer] + (uint64_t)r.vertIndex * srcL.texCoordStride;
+        cp.dstOffset = dstL.offsetTexCoords[r.layer] + (uint64_t)r.vertIndex * dstL.texCoordStride;
+        cp.size = (uint64_t)r.vertexCount * dstL.texCoordStride;
+
+        texCoordsToCopyLowerBound = std::min(cp.dstOffset, texCoordsToCopyLowerBound);
+        texCoordsToCopyUpperBound = std::max(cp.dstOffset + cp.size, texCoordsToCopyUpperBound);
+
+        copies.push_back(cp);
+    }
+
     vkCmdCopyBuffer(
         cmd,
-        stagingVertBuffer.GetBuffer(), vertBuffer->GetBuffer(),
-        texCoordsToCopy.size(), texCoordsToCopy.data());
+        stagingVertBuffer->GetBuffer(), vertBuffer->GetBuffer(),
+        copies.size(), copies.data());
+
+    for (const auto &cp : copies)
+    {
+        allocator->RegisterStagingCopy(cp.size);
+    }
 
     VkBufferMemoryBarrier txcBr = {};
     txcBr.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -638,16 +1848,117 @@ bool RTGL1::VertexCollector::RecopyTexCoordsFromStaging(VkCommandBuffer cmd)
         0, nullptr);
 
     texCoordsToCopy.clear();
-    texCoordsToCopyLowerBound = UINT64_MAX;
-    texCoordsToCopyUpperBound = 0;
+
+    return true;
+}
+
+bool VertexCollector::CopyAddedStaticGeometriesFromStaging(VkCommandBuffer cmd)
+{
+    if (addedStaticRanges.empty())
+    {
+        return false;
+    }
+
+    std::vector<VkBufferCopy> vertCopies;
+    std::vector<VkBufferCopy> indCopies;
+    std::vector<VkBufferCopy> trnCopies;
+
+    vertCopies.reserve(addedStaticRanges.size() * (2 + TEXCOORD_LAYER_COUNT_STATIC));
+
+    // device local buffers must be grown before, see GrowSubmittedDeviceBuffers
+    assert(vertexCapacity == deviceVertexCapacity && indexCapacity == deviceIndexCapacity);
+
+    const VertexBufferLayout l = GetVertexBufferLayout(true, properties, vertexCapacity);
+
+    for (const StaticGeometryRanges &r : addedStaticRanges)
+    {
+        const uint64_t vertOffsets[] =
+        {
+            l.offsetPositions,
+            l.offsetNormals,
+        };
+        const uint64_t vertStrides[] =
+        {
+            l.positionStride,
+            l.normalStride,
+        };
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            const uint64_t offset = vertOffsets[i] + r.vertIndex * vertStrides[i];
+            vertCopies.push_back({ offset, offset, r.vertexCount * vertStrides[i] });
+        }
+
+        for (uint32_t i = 0; i < l.texCoordLayerCount; i++)
+        {
+            const uint64_t offset = l.offsetTexCoords[i] + r.vertIndex * l.texCoordStride;
+            vertCopies.push_back({ offset, offset, r.vertexCount * l.texCoordStride });
+        }
+
+        if (r.indexCount > 0)
+        {
+            const uint64_t offset = r.indIndex * sizeof(uint32_t);
+            indCopies.push_back({ offset, offset, r.indexCount * sizeof(uint32_t) });
+        }
+
+        if (r.transformIndex != UINT32_MAX)
+        {
+            const uint64_t offset = r.transformIndex * sizeof(VkTransformMatrixKHR);
+            trnCopies.push_back({ offset, offset, sizeof(VkTransformMatrixKHR) });
+        }
+    }
+
+    vkCmdCopyBuffer(cmd, stagingVertBuffer->GetBuffer(), vertBuffer->GetBuffer(), vertCopies.size(), vertCopies.data());
+
+    if (!indCopies.empty())
+    {
+        vkCmdCopyBuffer(cmd, stagingIndexBuffer->GetBuffer(), indexBuffer->GetBuffer(), indCopies.size(), indCopies.data());
+    }
+
+    if (!trnCopies.empty())
+    {
+        vkCmdCopyBuffer(cmd, stagingTransformsBuffer->GetBuffer(), transformsBuffer->GetBuffer(), trnCopies.size(), trnCopies.data());
+    }
+
+    for (const auto *copies : { &vertCopies, &indCopies, &trnCopies })
+    {
+        for (const auto &cp : *copies)
+        {
+            allocator->RegisterStagingCopy(cp.size);
+        }
+    }
+
+    // ranges are scattered, so use one global barrier instead of per-range ones
+    VkMemoryBarrier br = {};
+    br.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    br.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    br.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &br,
+        0, nullptr,
+        0, nullptr);
+
+    addedStaticRanges.clear();
 
     return true;
 }
 
 bool VertexCollector::CopyFromStaging(VkCommandBuffer cmd, bool isStaticVertexData)
 {
-    const auto vrtCopied = CopyVertexDataFromStaging(cmd, isStaticVertexData);
-    bool indCopied = CopyIndexDataFromStaging(cmd);
+    // device local buffers must have the same layout, see ResizeDeviceBuffers
+    assert(vertexCapacity == deviceVertexCapacity && indexCapacity == deviceIndexCapacity);
+
+    // with direct write, vertex and index data is already in the device local buffers,
+    // and host writes to coherent memory are visible to the device on the submission,
+    // so only transforms are copied
+    const auto vrtCopied = directWrite ? std::vector<VkBufferCopy>() : CopyVertexDataFromStaging(cmd, isStaticVertexData);
+    bool indCopied = !directWrite && CopyIndexDataFromStaging(cmd);
     bool trnCopied = CopyTransformsFromStaging(cmd, false);
 
     VkBufferMemoryBarrier barriers[9];
@@ -731,58 +2042,32 @@ bool VertexCollector::GetVertBufferCopyInfos(bool isStatic, std::vector<VkBuffer
         return false;
     }
 
-    const uint32_t offsetPositions = isStatic ?
-        offsetof(ShVertexBufferStatic, positions) :
-        offsetof(ShVertexBufferDynamic, positions);
-
-    const uint32_t offsetNormals = isStatic ?
-        offsetof(ShVertexBufferStatic, normals) :
-        offsetof(ShVertexBufferDynamic, normals);
-
-    const uint64_t *offsetTexCoords = isStatic ? OFFSET_TEX_COORDS_STATIC : OFFSET_TEX_COORDS_DYNAMIC;
-    uint32_t        offsetCount     = isStatic ? TEXCOORD_LAYER_COUNT_STATIC : TEXCOORD_LAYER_COUNT_DYNAMIC;
+    const VertexBufferLayout l = GetVertexBufferLayout(isStatic, properties, vertexCapacity);
     
     // positions, normals + texCoords
-    uint32_t count = 2 + offsetCount;
+    uint32_t count = 2 + l.texCoordLayerCount;
     outInfos.reserve(count);
 
-    outInfos.push_back({ offsetPositions,    offsetPositions,    (uint64_t)curVertexCount * properties.positionStride });
-    outInfos.push_back({ offsetNormals,      offsetNormals,      (uint64_t)curVertexCount * properties.normalStride   });
+    outInfos.push_back({ l.offsetPositions,  l.offsetPositions,  (uint64_t)curVertexCount * l.positionStride });
+    outInfos.push_back({ l.offsetNormals,    l.offsetNormals,    (uint64_t)curVertexCount * l.normalStride   });
 
-    for (uint32_t i = 0; i < offsetCount; i++)
+    for (uint32_t i = 0; i < l.texCoordLayerCount; i++)
     {
-        outInfos.push_back({ offsetTexCoords[i], offsetTexCoords[i], (uint64_t)curVertexCount * properties.texCoordStride });
+        outInfos.push_back({ l.offsetTexCoords[i], l.offsetTexCoords[i], (uint64_t)curVertexCount * l.texCoordStride });
     }
 
     return true;
 }
 
-void VertexCollector::UpdateTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo)
-{
-    if (simpleIndex >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT)
-    {
-        assert(0);
-        return;
-    }
-
-    assert(mappedTransformData != nullptr);
-
-    static_assert(sizeof(RgTransform) == sizeof(VkTransformMatrixKHR), "RgTransform and VkTransformMatrixKHR must have the same structure to be used in AS building");
-    memcpy(mappedTransformData + simpleIndexToTransformIndex[simpleIndex], &updateInfo.transform, sizeof(VkTransformMatrixKHR));
-
-    geomInfoMgr->WriteStaticGeomInfoTransform(simpleIndex, updateInfo.movableStaticUniqueID, updateInfo.transform);
-}
-
 void RTGL1::VertexCollector::UpdateTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo)
 {
     const bool isStatic = true;
-    const uint32_t maxVertexCount = isStatic ? MAX_STATIC_VERTEX_COUNT : MAX_DYNAMIC_VERTEX_COUNT;
 
     // base vertex index is saved in geometry instance info
     uint32_t globalVertIndex = geomInfoMgr->GetStaticGeomBaseVertexIndex(simpleIndex);
     uint32_t dstVertIndex = globalVertIndex + texCoordsInfo.vertexOffset;
 
-    if (dstVertIndex + texCoordsInfo.vertexCount >= maxVertexCount)
+    if ((uint64_t)dstVertIndex + texCoordsInfo.vertexCount >= vertexCapacity)
     {
         assert(0);
         return;
@@ -807,12 +2092,64 @@ void VertexCollector::AddMaterialDependency(uint32_t simpleIndex, uint32_t layer
         it->second.push_back({ simpleIndex, layer });
     }
 }
+void VertexCollector::AddMaterialDependencies(uint32_t simpleIndex, const RgLayeredMaterial &geomMaterial, const ShGeometryInstance &geomInfo)
+{
+    for (int32_t layer = MATERIALS_MAX_LAYER_COUNT - 1; layer >= 0; layer--)
+    {
+        const uint32_t materialIndex = geomMaterial.layerMaterials[layer];
+
+        for (uint32_t t = 0; t < TEXTURES_PER_MATERIAL_COUNT; t++)
+        {
+            const uint32_t *pMatArr = &geomInfo.materials0A;
+
+            // if at least one texture is not empty on this layer, add dependency 
+            if (pMatArr[layer * TEXTURES_PER_MATERIAL_COUNT + t] != EMPTY_TEXTURE_INDEX)
+            {
+                AddMaterialDependency(simpleIndex, layer, materialIndex);
+
+                break;
+            }               
+        }
+    }
+}
+
+void VertexCollector::RemoveMaterialDependencies(uint32_t simpleIndex)
+{
+    assert(simpleIndex < staticGeoms.size());
+
+    for (uint32_t materialIndex : staticGeoms[simpleIndex].layerMaterials)
+    {
+        auto it = materialDependencies.find(materialIndex);
+
+        if (it == materialDependencies.end())
+        {
+            continue;
+        }
+
+        auto &refs = it->second;
+
+        refs.erase(
+            std::remove_if(refs.begin(), refs.end(), [simpleIndex] (const MaterialRef &r) { return r.simpleIndex == simpleIndex; }),
+            refs.end());
+    }
+}
+
 void VertexCollector::OnMaterialChange(uint32_t materialIndex, const MaterialTextures &newInfo)
 {
     // for each geom index that has this material, update geometry instance infos
     for (const auto &p : materialDependencies[materialIndex])
     {    
-        geomInfoMgr->WriteStaticGeomInfoMaterials(p.simpleIndex, p.layer, newInfo);
+        if (deferStaticGeomInfos)
+        {
+            assert(p.simpleIndex < deferredStaticGeomInfos.size());
+            uint32_t *pMatArr = &deferredStaticGeomInfos[p.simpleIndex].geomInfo.materials0A;
+
+            memcpy(&pMatArr[p.layer * TEXTURES_PER_MATERIAL_COUNT], newInfo.indices, TEXTURES_PER_MATERIAL_COUNT * sizeof(uint32_t));
+        }
+        else
+        {
+            geomInfoMgr->WriteStaticGeomInfoMaterials(p.simpleIndex, p.layer, newInfo);
+        }
     }
 }
 
@@ -854,6 +2191,75 @@ const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &VertexCollector::Ge
     return f->second->GetASBuildRangeInfos();
 }
 
+const std::vector<GeometryTopology> &VertexCollector::GetGeometryTopologies(
+    VertexCollectorFilterTypeFlags filter) const
+{
+    auto f = filters.find(filter);
+    assert(f != filters.end());
+
+    return f->second->GetGeometryTopologies();
+}
+
+void VertexCollector::GetStaticGeometryBounds(VertexCollectorFilterTypeFlags filter, std::vector<GeometryBounds> &outBounds) const
+{
+    assert(mappedVertexData != nullptr && mappedTransformData != nullptr);
+
+    const std::vector<uint32_t> &primCounts = GetPrimitiveCounts(filter);
+
+    outBounds.assign(primCounts.size(), GeometryBounds::Empty());
+
+    const VertexBufferLayout l = GetVertexBufferLayout(true, properties, vertexCapacity);
+    const uint64_t positionStride = l.positionStride;
+    const uint64_t offsetPositions = l.offsetPositions;
+
+    for (const StaticGeometryData &g : staticGeoms)
+    {
+        if (g.geomFlags != filter)
+        {
+            continue;
+        }
+
+        assert(g.localIndex < outBounds.size());
+
+        // removed geometries are empty in the filter
+        if (primCounts[g.localIndex] == 0)
+        {
+            continue;
+        }
+
+        const uint8_t *positions = mappedVertexData + offsetPositions + g.ranges.vertIndex * positionStride;
+
+        const VkTransformMatrixKHR *transform = g.ranges.transformIndex != UINT32_MAX ?
+            &mappedTransformData[g.ranges.transformIndex] :
+            nullptr;
+
+        GeometryBounds &b = outBounds[g.localIndex];
+
+        for (uint32_t v = 0; v < g.ranges.vertexCount; v++)
+        {
+            const float *p = reinterpret_cast<const float *>(positions + v * positionStride);
+
+            if (transform != nullptr)
+            {
+                const float (&m)[3][4] = transform->matrix;
+
+                const float world[3] =
+                {
+                    m[0][0] * p[0] + m[0][1] * p[1] + m[0][2] * p[2] + m[0][3],
+                    m[1][0] * p[0] + m[1][1] * p[1] + m[1][2] * p[2] + m[1][3],
+                    m[2][0] * p[0] + m[2][1] * p[1] + m[2][2] * p[2] + m[2][3],
+                };
+
+                b.Extend(world);
+            }
+            else
+            {
+                b.Extend(p);
+            }
+        }
+    }
+}
+
 bool VertexCollector::AreGeometriesEmpty(VertexCollectorFilterTypeFlags flags) const
 {
     for (const auto &p : filters)
@@ -962,6 +2368,13 @@ void VertexCollector::PushRangeInfo(VertexCollectorFilterTypeFlags type,
     filters[type]->PushRangeInfo(type, rangeInfo);
 }
 
+void VertexCollector::PushTopology(VertexCollectorFilterTypeFlags type, const GeometryTopology &topology)
+{
+    assert(filters.find(type) != filters.end());
+
+    filters[type]->PushTopology(type, topology);
+}
+
 uint32_t RTGL1::VertexCollector::GetGeometryCount(VertexCollectorFilterTypeFlags type)
 {
     assert(filters.find(type) != filters.end());
@@ -969,6 +2382,12 @@ uint32_t RTGL1::VertexCollector::GetGeometryCount(VertexCollectorFilterTypeFlags
     return filters[type]->GetGeometryCount();
 }
 
+uint32_t VertexCollector::GetGeomInfoCount() const
+{
+    // only deferred ones will be in the geom info manager after flushing
+    return deferStaticGeomInfos ? static_cast<uint32_t>(deferredStaticGeomInfos.size()) : geomInfoMgr->GetCount();
+}
+
 uint32_t VertexCollector::GetAllGeometryCount() const
 {
     uint32_t count = 0;
@@ -991,6 +2410,16 @@ uint32_t VertexCollector::GetCurrentIndexCount() const
     return curIndexCount;
 }
 
+uint32_t VertexCollector::GetVertexCapacity() const
+{
+    return vertexCapacity;
+}
+
+uint32_t VertexCollector::GetIndexCapacity() const
+{
+    return indexCapacity;
+}
+
 void VertexCollector::AddFilter(VertexCollectorFilterTypeFlags filterGroup)
 {
     if (filterGroup == (VertexCollectorFilterTypeFlags)0)
@@ -19,22 +19,65 @@
 // SOFTWARE.
 
 #pragma once
+#include <atomic>
 #include <map>
 #include <vector>
 
 #include "Buffer.h"
 #include "Common.h"
+#include "DynamicRecordingContext.h"
+#include "GeometryClusterizer.h"
 #include "GeomInfoManager.h"
 #include "IMaterialDependency.h"
 #include "Material.h"
+#include "RangeAllocator.h"
 #include "VertexBufferProperties.h"
 #include "VertexCollectorFilter.h"
+#include "Generated/ShaderCommonC.h"
 #include "RTGL1/RTGL1.h"
 
 namespace RTGL1
 {
 
-struct ShGeometryInstance;
+// Geometry of a mesh that was created with rgCreateMesh.
+// Its vertices are in the static vertex buffer, and it has its own BLAS.
+struct MeshGeometry
+{
+    VkAccelerationStructureGeometryKHR  asGeometry;
+    VkAccelerationStructureBuildRangeInfoKHR range;
+    uint32_t                            primitiveCount;
+    // vertex and index ranges, per-instance data is not set
+    ShGeometryInstance                  geomInfo;
+};
+
+// Ranges in the static buffers that are occupied by a static geometry
+struct StaticGeometryRanges
+{
+    uint32_t                            vertIndex;
+    uint32_t                            vertexCount;
+    uint32_t                            indIndex;
+    // 0, if geometry is not indexed
+    uint32_t                            indexCount;
+    // UINT32_MAX, if geometry doesn't have a transform in BLAS
+    uint32_t                            transformIndex;
+};
+
+// Static geometry which data is already in the staging buffers, but it's not
+// added to the filters yet, as the static scene is edited only at the frame start.
+struct RecordedStaticGeometry
+{
+    uint64_t                            uniqueID;
+    VertexCollectorFilterTypeFlags      geomFlags;
+    VkAccelerationStructureGeometryKHR  asGeometry;
+    uint32_t                            primitiveCount;
+    // material indices are filled on adding to the filters
+    ShGeometryInstance                  geomInfo;
+    RgLayeredMaterial                   geomMaterial;
+    RgGeometryMaterialBlendType         layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT];
+    RgFloat4D                           layerColors[MATERIALS_MAX_LAYER_COUNT];
+    StaticGeometryRanges                ranges;
+    RgTransform                         transform;
+};
 
 // The class collects vertex data to buffers with shader struct types.
 // Geometries are passed to the class by chunks and the result of collecting
@@ -46,11 +89,11 @@ public:
         VkDevice device, 
         const std::shared_ptr<MemoryAllocator> &allocator,
         std::shared_ptr<GeomInfoManager> geomInfoManager,
-        VkDeviceSize bufferSize, 
         const VertexBufferProperties &properties,
         VertexCollectorFilterTypeFlags filters);
 
-    // Create new vertex collector, but with shared device local buffers
+    // Create new vertex collector, but with shared device local buffers,
+    // if it's not direct write; otherwise, only the layout is shared
     explicit VertexCollector(
         const std::shared_ptr<const VertexCollector> &src,
         const std::shared_ptr<MemoryAllocator> &allocator);
@@ -65,23 +108,105 @@ public:
 
     void BeginCollecting(bool isStatic);
     uint32_t AddGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT]);
+    // Add geometries of the same change frequency (all static or all dynamic).
+    // Vertex, index and transform ranges are reserved for the whole batch at once.
+    // "pMaterials" contains MATERIALS_MAX_LAYER_COUNT elements for each geometry.
+    // UINT32_MAX is written to "outSimpleIndices" for geometries that weren't added.
+    void AddGeometries(
+        uint32_t frameIndex, uint32_t count, const RgGeometryUploadInfo *pInfos,
+        const MaterialTextures *pMaterials, uint32_t *outSimpleIndices);
+    // Copy dynamic geometry data to the staging buffers and fill "outResult",
+    // but don't add it to the filters. Can be called from several threads simultaneously,
+    // as only the ranges of the staging buffers are reserved here.
+    // Returns false, if there's not enough space for the geometry.
+    bool RecordDynamicGeometry(const RgGeometryUploadInfo &info, RecordedDynamicGeometry &outResult);
+    // Reserve ranges for dynamic geometry, so its data can be written directly to the staging buffers.
+    // Data pointers of "info" are only checked for null to know which streams are used,
+    // except "pIndexData": if it's not null, indices are copied from it.
+    // "outMappedInfo" is a copy of "info" with data pointers set to the mapped ranges.
+    // Returns false, if there's not enough space for the geometry.
+    bool MapDynamicGeometry(const RgGeometryUploadInfo &info, RecordedDynamicGeometry &outResult, RgGeometryUploadInfo &outMappedInfo);
+    // Hash the indices that were written by the user to the mapped range
+    static void UpdateMappedTopology(const RgGeometryUploadInfo &mappedInfo, RecordedDynamicGeometry &recorded);
+    // Add geometry that was recorded by RecordDynamicGeometry or MapDynamicGeometry. Returns simple index.
+    uint32_t AddRecordedDynamicGeometry(uint32_t frameIndex, RecordedDynamicGeometry &recorded, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT]);
+    // Copy mesh data to the staging buffers, but don't add it to the filters,
+    // as a mesh has its own BLAS. Only for static vertex collector.
+    // If normals are not provided, they're generated here.
+    // Returns false, if there's not enough space for the mesh.
+    bool AddMesh(const RgMeshCreateInfo &info, MeshGeometry &outResult);
+    // Fill geometry instance for an instance of the mesh.
+    static void PrepareMeshInstanceGeomInfo(
+        const MeshGeometry &mesh, const RgMeshInstanceUploadInfo &info,
+        const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT], ShGeometryInstance &outGeomInfo);
+    // Copy static geometry data to the staging buffers, when the static scene is already submitted.
+    // Ranges of the removed geometries are reused, if possible. Normals are generated here,
+    // as vertex preprocessing is not done for the whole static scene again.
+    // Staging buffers are grown, if there's not enough space, device local ones are grown
+    // in GrowSubmittedDeviceBuffers. Returns false, if the geometry exceeds the limits.
+    bool RecordStaticGeometry(const RgGeometryUploadInfo &info, RecordedStaticGeometry &outResult);
+    // Add geometry that was recorded by RecordStaticGeometry to the filters.
+    // Returns simple index, or UINT32_MAX if it wasn't added; in that case, its ranges are freed.
+    uint32_t AddRecordedStaticGeometry(RecordedStaticGeometry &recorded, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT]);
+    // Free ranges of the geometry that was recorded, but is not going to be added
+    void CancelRecordedStaticGeometry(const RecordedStaticGeometry &recorded);
+    // Make static geometry empty in its filter. Its ranges and indices are freed
+    // by ReleaseRemovedStaticGeometries, when the frame with "frameIndex" is finished.
+    // Returns filter of the removed geometry.
+    VertexCollectorFilterTypeFlags RemoveStaticGeometry(uint32_t frameIndex, uint32_t simpleIndex);
+    void ReleaseRemovedStaticGeometries(uint32_t frameIndex);
     void EndCollecting();
 
 
+    // Grow staging buffers, so ranges that end at "vertexCount" and "indexCount" fit in them.
+    // Static collector grows on its own while collecting, dynamic ones must be grown explicitly,
+    // as their ranges are reserved from several threads.
+    void ReserveCapacity(uint32_t vertexCount, uint32_t indexCount);
+    // Max ends of the vertex and index ranges that didn't fit in the staging buffers
+    uint32_t GetRequestedVertexCount() const;
+    uint32_t GetRequestedIndexCount() const;
+    // Recreate device local vertex and index buffers, if they're smaller than the staging ones.
+    // Addresses in the AS geometries of the filters are rebased to the new buffers.
+    // Returns true, if the buffers were recreated.
+    bool ResizeDeviceBuffers();
+    // Same as ResizeDeviceBuffers, but for the already submitted static scene: its data
+    // was preprocessed in the device local buffers, so it's copied from the old buffers to the new ones.
+    // Must be called before CopyAddedStaticGeometriesFromStaging.
+    bool GrowSubmittedDeviceBuffers(VkCommandBuffer cmd);
+    // Use device local buffers of "src", e.g. after it resized the shared ones.
+    // Not available, if this collector writes directly to its own device local buffers.
+    void ShareDeviceBuffers(const VertexCollector &src);
+    // If true, vertex and index data is not copied from staging,
+    // so each dynamic collector has its own device local buffers
+    bool IsDirectWrite() const;
+    // Rebase AS geometry that was prepared before the last ResizeDeviceBuffers call
+    void RebaseASGeometry(VkAccelerationStructureGeometryKHR &geom) const;
+    // Move out the buffers that were replaced by the grown ones,
+    // they must be kept alive until the frames that could use them are finished
+    void TakeRetiredBuffers(std::vector<std::shared_ptr<Buffer>> &outRetired);
+    // Write offsets of the normals and tex coords in the device local vertex buffer
+    void WriteVertexStreamOffsets(ShGlobalUniform &gu) const;
+
+    // Static geometry instances are not written to the geom info manager while collecting,
+    // as it contains the instances of the currently used static scene.
+    // Write them, when the static scene of this collector starts to be used.
+    void FlushStaticGeomInfos(uint32_t frameIndex);
+    uint32_t GetStaticGeomLocalIndex(uint32_t simpleIndex) const;
+
+
     // Clear data that was generated while collecting.
     // Should be called when blasGeometries is not needed anymore
     virtual void Reset();
     // Copy buffer from staging and set barrier for processing in compute shader
-    // "isStaticVertexData" is required to determine what GLSL struct to use for copying
+    // "isStaticVertexData" is required to determine the layout of the vertex buffer
     bool CopyFromStaging(VkCommandBuffer cmd, bool isStaticVertexData);
     // Returns false, if wasn't copied
-    bool RecopyTransformsFromStaging(VkCommandBuffer cmd);
     bool RecopyTexCoordsFromStaging(VkCommandBuffer cmd);
+    // Copy only the data of geometries that were added by AddRecordedStaticGeometry.
+    // Returns false, if wasn't copied
+    bool CopyAddedStaticGeometriesFromStaging(VkCommandBuffer cmd);
 
 
-    // Update transform, only for movable static geometry as dynamic geometry
-    // will be updated every frame and thus their transforms.
-    void UpdateTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo);
     // Update texture coordinates 
     void UpdateTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo);
 
@@ -94,6 +219,9 @@ public:
     VkBuffer GetIndexBuffer() const;
     uint32_t GetCurrentVertexCount() const;
     uint32_t GetCurrentIndexCount() const;
+    // Vertex and index counts that fit in the staging buffers
+    uint32_t GetVertexCapacity() const;
+    uint32_t GetIndexCapacity() const;
 
 
     // Get primitive counts from filters. Null if corresponding filter wasn't found.
@@ -105,6 +233,14 @@ public:
     // Get AS build range infos from filters. Null if corresponding filter wasn't found.
     const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &GetASBuildRangeInfos(VertexCollectorFilterTypeFlags filter) const;
 
+    // Get topologies of geometries from filters, only dynamic geometries have their index hashes.
+    const std::vector<GeometryTopology> &GetGeometryTopologies(VertexCollectorFilterTypeFlags filter) const;
+
+
+    // Get world space bounds of static geometries of the filter from the staging buffers,
+    // indexed by local geometry index. Empty geometries have invalid bounds.
+    void GetStaticGeometryBounds(VertexCollectorFilterTypeFlags filter, std::vector<GeometryBounds> &outBounds) const;
+
 
     // Are all geometries for each filter type in "flags" empty?
     bool AreGeometriesEmpty(VertexCollectorFilterTypeFlags flags) const;
@@ -118,9 +254,56 @@ public:
     void InsertVertexPreprocessFinishBarrier(VkCommandBuffer cmd);
 
 private:
-    void InitStagingBuffers(const std::shared_ptr<MemoryAllocator> &allocator);
+    bool IsStatic() const;
+
+    void InitDeviceBuffers(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void InitStagingBuffers();
+    // Create bigger staging buffers and copy the collected data to them, old buffers are retired
+    void GrowStagingBuffers(uint32_t newVertexCapacity, uint32_t newIndexCapacity);
+
+    // Atomically reserve ranges in vertex, index and transform staging buffers.
+    // Vertex and index ranges begin at the indices that are aligned by 3.
+    // Returns false, if any of the ranges doesn't fit.
+    bool ReserveRanges(
+        uint32_t vertexCount, uint32_t indexCount, uint32_t transformCount,
+        uint32_t *outVertIndex, uint32_t *outIndIndex, uint32_t *outTransformIndex);
+
+    // Write geometry data to the already reserved ranges, returns simple index
+    uint32_t WriteGeometry(
+        uint32_t frameIndex, const RgGeometryUploadInfo &info, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT],
+        VertexCollectorFilterTypeFlags geomFlags, uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex);
+    // Copy data to the reserved ranges of staging buffers and fill AS geometry and geometry instance,
+    // except its materials. Doesn't change the state of the collector.
+    void PrepareGeometry(
+        const RgGeometryUploadInfo &info, VertexCollectorFilterTypeFlags geomFlags,
+        uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex,
+        VkAccelerationStructureGeometryKHR &outGeom, ShGeometryInstance &outGeomInfo);
+    // Same as PrepareGeometry, but the data must be already in the staging buffers
+    void PrepareASGeometry(
+        const RgGeometryUploadInfo &info, VertexCollectorFilterTypeFlags geomFlags,
+        uint32_t vertIndex, uint32_t indIndex, uint32_t transformIndex,
+        VkAccelerationStructureGeometryKHR &outGeom, ShGeometryInstance &outGeomInfo);
+    // Add prepared geometry to the filters and geometry instance to the geom info manager.
+    // Returns simple index.
+    uint32_t PushPreparedGeometry(
+        uint32_t frameIndex, uint64_t uniqueID, VertexCollectorFilterTypeFlags geomFlags,
+        const VkAccelerationStructureGeometryKHR &geom, uint32_t primitiveCount,
+        const GeometryTopology &topology, ShGeometryInstance &geomInfo);
+    // Get topology of a geometry to check if BLAS can be refitted
+    static GeometryTopology GetTopology(const RgGeometryUploadInfo &info);
+    static uint32_t GetGeomInfoFlags(
+        RgGeometryUploadFlags flags, RgGeometryPassThroughType passThroughType,
+        const RgGeometryMaterialBlendType layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT]);
+    static void WriteGeomInfoMaterials(
+        ShGeometryInstance &dst, const MaterialTextures materials[MATERIALS_MAX_LAYER_COUNT],
+        const RgLayeredMaterial &geomMaterial,
+        const RgGeometryMaterialBlendType layerBlendingTypes[MATERIALS_MAX_LAYER_COUNT],
+        const RgFloat4D layerColors[MATERIALS_MAX_LAYER_COUNT]);
 
     void CopyDataToStaging(const RgGeometryUploadInfo &info, uint32_t vertIndex, bool isStatic);
+    // Generate flat normals in the static staging buffer
+    void GenerateNormalsInStaging(
+        uint32_t vertIndex, uint32_t vertexCount, uint32_t indIndex, uint32_t indexCount, bool useIndices, bool inverted);
     void CopyTexCoordsToStaging(
         bool isStatic, uint32_t globalVertIndex, uint32_t vertexCount, 
         const void *const texCoordLayerData[3], bool addToCopy = false);
@@ -132,6 +315,12 @@ private:
     bool CopyTransformsFromStaging(VkCommandBuffer cmd, bool insertMemBarrier);
 
     void AddMaterialDependency(uint32_t simpleIndex, uint32_t layer, uint32_t materialIndex);
+    // Add dependencies for each layer that has at least one non-empty texture
+    void AddMaterialDependencies(uint32_t simpleIndex, const RgLayeredMaterial &geomMaterial, const ShGeometryInstance &geomInfo);
+    void RemoveMaterialDependencies(uint32_t simpleIndex);
+    void FreeStaticRanges(const StaticGeometryRanges &ranges);
+    void SaveStaticGeometryData(uint32_t simpleIndex, uint64_t uniqueID, VertexCollectorFilterTypeFlags geomFlags, uint32_t localIndex,
+                                const StaticGeometryRanges &ranges, const RgLayeredMaterial &geomMaterial);
 
     // Parse flags to flag bit pairs and create instances of
     // VertexCollectorFilter. Flag bit pair contains one bit from
@@ -142,9 +331,12 @@ private:
     uint32_t PushGeometry(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureGeometryKHR &geom);
     void PushPrimitiveCount(VertexCollectorFilterTypeFlags type, uint32_t primCount);
     void PushRangeInfo(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo);
+    void PushTopology(VertexCollectorFilterTypeFlags type, const GeometryTopology &topology);
    
     uint32_t GetGeometryCount(VertexCollectorFilterTypeFlags type);
     uint32_t GetAllGeometryCount() const;
+    // Count of geometry instances in the geom info manager, including deferred ones
+    uint32_t GetGeomInfoCount() const;
 
 private:
     struct MaterialRef
@@ -153,26 +345,77 @@ private:
         uint32_t layer;
     };
 
+    // Data that is needed to remove a static geometry
+    struct StaticGeometryData
+    {
+        uint64_t uniqueID;
+        VertexCollectorFilterTypeFlags geomFlags;
+        uint32_t localIndex;
+        StaticGeometryRanges ranges;
+        uint32_t layerMaterials[MATERIALS_MAX_LAYER_COUNT];
+    };
+
+    struct DeferredStaticGeomInfo
+    {
+        uint64_t uniqueID;
+        uint32_t localIndex;
+        VertexCollectorFilterTypeFlags geomFlags;
+        ShGeometryInstance geomInfo;
+    };
+
+    struct RemovedStaticGeometry
+    {
+        uint32_t simpleIndex;
+        uint32_t localIndex;
+        VertexCollectorFilterTypeFlags geomFlags;
+        StaticGeometryRanges ranges;
+    };
+
 private:
     VkDevice device;
+    std::shared_ptr<MemoryAllocator> allocator;
     VertexBufferProperties properties;
     VertexCollectorFilterTypeFlags filtersFlags;
+    // only for dynamic collectors: if true, vertex and index staging buffers are
+    // in device-local host-visible memory and they're used as the device local ones
+    bool directWrite;
 
-    Buffer stagingVertBuffer;
+    std::shared_ptr<Buffer> stagingVertBuffer;
     std::shared_ptr<Buffer> vertBuffer;
 
-    Buffer stagingIndexBuffer;
+    std::shared_ptr<Buffer> stagingIndexBuffer;
     std::shared_ptr<Buffer> indexBuffer;
 
-    Buffer stagingTransformsBuffer;
+    std::shared_ptr<Buffer> stagingTransformsBuffer;
     std::shared_ptr<Buffer> transformsBuffer;
 
+    // vertex and index counts that fit in the staging buffers
+    uint32_t vertexCapacity;
+    uint32_t indexCapacity;
+    // capacities of the device local buffers, they're grown on copying from staging
+    uint32_t deviceVertexCapacity;
+    uint32_t deviceIndexCapacity;
+    uint32_t maxVertexCapacity;
+    uint32_t maxIndexCapacity;
+
+    // ends of the ranges that didn't fit, to grow the buffers for the next frames
+    std::atomic<uint32_t> requestedVertexCount;
+    std::atomic<uint32_t> requestedIndexCount;
+
+    // base addresses of the device local buffers before and after the last resize
+    VkDeviceAddress rebaseVertAddress[2];
+    VkDeviceAddress rebaseIndexAddress[2];
+
+    // buffers that were replaced by the grown ones
+    std::vector<std::shared_ptr<Buffer>> retiredBuffers;
+
     std::shared_ptr<GeomInfoManager> geomInfoMgr;
 
-    uint32_t curVertexCount;
-    uint32_t curIndexCount;
-    uint32_t curPrimitiveCount;
-    uint32_t curTransformCount;
+    // atomic, as ranges can be reserved by recording contexts from different threads
+    std::atomic<uint32_t> curVertexCount;
+    std::atomic<uint32_t> curIndexCount;
+    std::atomic<uint32_t> curPrimitiveCount;
+    std::atomic<uint32_t> curTransformCount;
 
     uint8_t *mappedVertexData;
     uint32_t *mappedIndexData;
@@ -183,13 +426,34 @@ private:
 
     std::map<VertexCollectorFilterTypeFlags, std::shared_ptr<VertexCollectorFilter>> filters;
 
-    // if some static geometries changed their tex coords, then they should be copied 
-    // from staging to device-local; this array holds copy ranges; freed after vkCmdCopy call
-    std::vector<VkBufferCopy> texCoordsToCopy;
-    VkDeviceSize texCoordsToCopyLowerBound;
-    VkDeviceSize texCoordsToCopyUpperBound;
+    struct TexCoordsRange
+    {
+        uint32_t layer;
+        uint32_t vertIndex;
+        uint32_t vertexCount;
+    };
 
-    std::map<uint32_t, uint32_t> simpleIndexToTransformIndex;
+    // if some static geometries changed their tex coords, then they should be copied 
+    // from staging to device-local; this array holds copy ranges; freed after vkCmdCopy call.
+    // Byte offsets are not stored, as the staging and device local buffers can have different layouts
+    std::vector<TexCoordsRange> texCoordsToCopy;
+
+    // indexed by simple index, only for static geometry
+    std::vector<StaticGeometryData> staticGeoms;
+    // ranges of static geometries that were added after the static scene submission
+    std::vector<StaticGeometryRanges> addedStaticRanges;
+    // removed static geometries are released when the frame that removed them is finished
+    std::vector<RemovedStaticGeometry> removedStaticGeoms[MAX_FRAMES_IN_FLIGHT];
+
+    // static geometry instances that are written on FlushStaticGeomInfos,
+    // indexed by simple index
+    bool deferStaticGeomInfos;
+    std::vector<DeferredStaticGeomInfo> deferredStaticGeomInfos;
+
+    // ranges that were freed by removed static geometries
+    RangeAllocator freeVertexRanges;
+    RangeAllocator freeIndexRanges;
+    RangeAllocator freeTransformRanges;
 };
 
 }
\ No newline at end of file
@@ -45,11 +45,18 @@ const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &VertexCollectorFilt
     return asBuildRangeInfos;
 }
 
+const std::vector<GeometryTopology> &VertexCollectorFilter::GetGeometryTopologies() const
+{
+    return topologies;
+}
+
 void VertexCollectorFilter::Reset()
 {
     asGeometries.clear();
     primitiveCounts.clear();
     asBuildRangeInfos.clear();
+    topologies.clear();
+    freeSlots.clear();
 }
 
 uint32_t VertexCollectorFilter::PushGeometry(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureGeometryKHR &geom)
@@ -76,6 +83,80 @@ void VertexCollectorFilter::PushRangeInfo(VertexCollectorFilterTypeFlags type, c
     asBuildRangeInfos.push_back(rangeInfo);
 }
 
+void VertexCollectorFilter::PushTopology(VertexCollectorFilterTypeFlags type, const GeometryTopology &topology)
+{
+    assert((type & filter) == filter);
+    topologies.push_back(topology);
+}
+
+uint32_t VertexCollectorFilter::SetGeometryToFreeSlot(
+    const VkAccelerationStructureGeometryKHR &geom, uint32_t primCount,
+    const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo, const GeometryTopology &topology)
+{
+    if (freeSlots.empty())
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t localIndex = freeSlots.back();
+    freeSlots.pop_back();
+
+    assert(localIndex < asGeometries.size());
+
+    asGeometries[localIndex] = geom;
+    primitiveCounts[localIndex] = primCount;
+    asBuildRangeInfos[localIndex] = rangeInfo;
+    topologies[localIndex] = topology;
+
+    return localIndex;
+}
+
+void VertexCollectorFilter::RemoveGeometry(uint32_t localIndex)
+{
+    assert(localIndex < asGeometries.size());
+
+    // geometry can't be erased, as the geometry index in BLAS is used
+    // for accessing geometry instance info, so just make it empty
+    primitiveCounts[localIndex] = 0;
+    asBuildRangeInfos[localIndex].primitiveCount = 0;
+    topologies[localIndex] = {};
+}
+
+void VertexCollectorFilter::ReleaseSlot(uint32_t localIndex)
+{
+    assert(localIndex < asGeometries.size());
+    assert(primitiveCounts[localIndex] == 0);
+
+    freeSlots.push_back(localIndex);
+}
+
+void VertexCollectorFilter::RebaseAddresses(const VkDeviceAddress vertBases[2], const VkDeviceAddress indexBases[2])
+{
+    for (auto &geom : asGeometries)
+    {
+        RebaseAddresses(geom, vertBases, indexBases);
+    }
+}
+
+void VertexCollectorFilter::RebaseAddresses(
+    VkAccelerationStructureGeometryKHR &geom, const VkDeviceAddress vertBases[2], const VkDeviceAddress indexBases[2])
+{
+    VkAccelerationStructureGeometryTrianglesDataKHR &trData = geom.geometry.triangles;
+
+    // empty addresses are not rebased, e.g. if geometry is not indexed
+    if (trData.vertexData.deviceAddress != 0)
+    {
+        assert(trData.vertexData.deviceAddress >= vertBases[0]);
+        trData.vertexData.deviceAddress = trData.vertexData.deviceAddress - vertBases[0] + vertBases[1];
+    }
+
+    if (trData.indexData.deviceAddress != 0)
+    {
+        assert(trData.indexData.deviceAddress >= indexBases[0]);
+        trData.indexData.deviceAddress = trData.indexData.deviceAddress - indexBases[0] + indexBases[1];
+    }
+}
+
 VertexCollectorFilterTypeFlags VertexCollectorFilter::GetFilter() const
 {
     return filter;
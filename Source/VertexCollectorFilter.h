@@ -28,6 +28,26 @@
 namespace RTGL1
 {
 
+// Structure of a geometry in BLAS. If all geometries of a BLAS have the same
+// topology as on its last build, BLAS can be refitted instead of rebuilding.
+struct GeometryTopology
+{
+    uint64_t uniqueID;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    // hash of index data, 0 if geometry is not indexed
+    uint64_t indexHash;
+};
+
+inline bool operator==(const GeometryTopology &a, const GeometryTopology &b)
+{
+    return
+        a.uniqueID == b.uniqueID &&
+        a.vertexCount == b.vertexCount &&
+        a.indexCount == b.indexCount &&
+        a.indexHash == b.indexHash;
+}
+
 // Instances of this class are added to VertexCollector to
 // collect AS data separately for specific filter types.
 class VertexCollectorFilter
@@ -47,12 +67,30 @@ public:
         &GetASGeometries() const;
     const std::vector<VkAccelerationStructureBuildRangeInfoKHR>
         &GetASBuildRangeInfos() const;
+    const std::vector<GeometryTopology>
+        &GetGeometryTopologies() const;
 
     void Reset();
 
     uint32_t PushGeometry(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureGeometryKHR& geom);
     void PushPrimitiveCount(VertexCollectorFilterTypeFlags type, uint32_t primCount);
     void PushRangeInfo(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo);
+    void PushTopology(VertexCollectorFilterTypeFlags type, const GeometryTopology &topology);
+
+    // Put geometry to the slot of a removed one, so local indices of other geometries are not changed.
+    // Returns local index, or UINT32_MAX if there are no free slots.
+    uint32_t SetGeometryToFreeSlot(
+        const VkAccelerationStructureGeometryKHR &geom, uint32_t primCount,
+        const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo, const GeometryTopology &topology);
+    // Make geometry empty, its slot can be reused only after ReleaseSlot call
+    void RemoveGeometry(uint32_t localIndex);
+    void ReleaseSlot(uint32_t localIndex);
+
+    // Move vertex and index addresses of all AS geometries from the old buffers to the new ones.
+    // "vertBases" and "indexBases" contain old and new base addresses.
+    void RebaseAddresses(const VkDeviceAddress vertBases[2], const VkDeviceAddress indexBases[2]);
+    static void RebaseAddresses(
+        VkAccelerationStructureGeometryKHR &geom, const VkDeviceAddress vertBases[2], const VkDeviceAddress indexBases[2]);
 
     VertexCollectorFilterTypeFlags GetFilter() const;
     uint32_t GetGeometryCount() const;
@@ -63,6 +101,10 @@ private:
     std::vector<uint32_t> primitiveCounts;
     std::vector<VkAccelerationStructureGeometryKHR> asGeometries;
     std::vector<VkAccelerationStructureBuildRangeInfoKHR> asBuildRangeInfos;
+    std::vector<GeometryTopology> topologies;
+
+    // local indices of removed geometries
+    std::vector<uint32_t> freeSlots;
 };
 
 }
\ No newline at end of file
@@ -209,10 +209,15 @@ const char *RTGL1::VertexCollectorFilterTypeFlags_GetNameForBLAS(FL flags)
 }
 
 FL RTGL1::VertexCollectorFilterTypeFlags_GetForGeometry(const RgGeometryUploadInfo &info)
+{
+    return VertexCollectorFilterTypeFlags_Get(info.geomType, info.passThroughType, info.visibilityType);
+}
+
+FL RTGL1::VertexCollectorFilterTypeFlags_Get(RgGeometryType geomType, RgGeometryPassThroughType passThroughType, RgGeometryPrimaryVisibilityType visibilityType)
 {
     FL flags = 0;
 
-    switch (info.geomType)
+    switch (geomType)
     {
         case RG_GEOMETRY_TYPE_STATIC:
         {
@@ -232,7 +237,7 @@ FL RTGL1::VertexCollectorFilterTypeFlags_GetForGeometry(const RgGeometryUploadIn
         default: assert(0);
     }
 
-    switch (info.passThroughType)
+    switch (passThroughType)
     {
         case RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE:
         {
@@ -256,7 +261,7 @@ FL RTGL1::VertexCollectorFilterTypeFlags_GetForGeometry(const RgGeometryUploadIn
         default: assert(0);
     }
 
-    switch (info.visibilityType)
+    switch (visibilityType)
     {
         case RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0:
         {
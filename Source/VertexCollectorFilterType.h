@@ -125,6 +125,7 @@ uint32_t                        VertexCollectorFilterTypeFlags_GetOffsetInGlobal
 uint32_t                        VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(VertexCollectorFilterTypeFlags flags);
 const char*                     VertexCollectorFilterTypeFlags_GetNameForBLAS(VertexCollectorFilterTypeFlags flags);
 VertexCollectorFilterTypeFlags  VertexCollectorFilterTypeFlags_GetForGeometry(const RgGeometryUploadInfo &info);
+VertexCollectorFilterTypeFlags  VertexCollectorFilterTypeFlags_Get(RgGeometryType geomType, RgGeometryPassThroughType passThroughType, RgGeometryPrimaryVisibilityType visibilityType);
 void                            VertexCollectorFilterTypeFlags_IterateOverFlags(std::function<void(VertexCollectorFilterTypeFlags)> f);
 
 }
\ No newline at end of file
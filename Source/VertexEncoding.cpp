@@ -0,0 +1,249 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "VertexEncoding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RG_VERTEX_ENCODING_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace RTGL1;
+
+namespace
+{
+
+uint32_t AsUint(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+float AsFloat(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Round to nearest even, NaN is converted to quiet NaN, overflow to infinity.
+// Based on float_to_half_fast3_rtne by Fabian Giesen (public domain).
+uint16_t FloatToHalf(float value)
+{
+    const uint32_t f32Infinity = 255 << 23;
+    const uint32_t f16Max = (127 + 16) << 23;
+    const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+    const uint32_t minNormal = (127 - 14) << 23;
+
+    uint32_t f = AsUint(value);
+
+    const uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint32_t h;
+
+    if (f >= f16Max)
+    {
+        h = f > f32Infinity ? 0x7E00 : 0x7C00;
+    }
+    else if (f < minNormal)
+    {
+        // align mantissa bits with float addition that rounds to nearest even
+        h = AsUint(AsFloat(f) + AsFloat(denormMagic)) - denormMagic;
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (f >> 13) & 1;
+
+        f -= (127 - 15) << 23;
+        f += 0xFFF;
+        f += mantissaOdd;
+
+        h = f >> 13;
+    }
+
+    return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+// Same as GLSL's packSnorm2x16 for one component
+uint32_t ToSnorm16(float v)
+{
+    v = std::min(std::max(v, -1.0f), 1.0f);
+    return static_cast<uint32_t>(static_cast<int32_t>(std::lrint(v * 32767.0f))) & 0xFFFF;
+}
+
+const float *GetElement(const void *src, uint32_t stride, uint32_t index)
+{
+    return reinterpret_cast<const float *>(static_cast<const uint8_t *>(src) + (uint64_t)index * stride);
+}
+
+#ifdef RG_VERTEX_ENCODING_SSE2
+
+// 4 values of the component "c" of strided elements starting from "index"
+__m128 LoadComponent4(const void *src, uint32_t stride, uint32_t index, uint32_t c)
+{
+    return _mm_setr_ps(
+        GetElement(src, stride, index + 0)[c],
+        GetElement(src, stride, index + 1)[c],
+        GetElement(src, stride, index + 2)[c],
+        GetElement(src, stride, index + 3)[c]);
+}
+
+__m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128i ToSnorm16x4(__m128 v)
+{
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+
+    // default MXCSR rounding is to nearest even, same as std::lrint
+    return _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(32767.0f))), _mm_set1_epi32(0xFFFF));
+}
+
+// Vectorized FloatToHalf, upper 16 bits of the results are undefined.
+// Based on float_to_half_SSE2 by Fabian Giesen (public domain).
+__m128i FloatToHalf4(__m128 f)
+{
+    const __m128i f16Max         = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i nanBit         = _mm_set1_epi32(0x200);
+    const __m128i infinityHalf   = _mm_set1_epi32(0x7C00);
+    const __m128i minNormal      = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i denormMagic    = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias     = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+    const __m128 sign            = _mm_and_ps(_mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u)), f);
+    const __m128 absF            = _mm_xor_ps(f, sign);
+    const __m128i absI           = _mm_castps_si128(absF);
+
+    const __m128i isRegular      = _mm_cmpgt_epi32(f16Max, absI);
+    const __m128i isSubnormal    = _mm_cmpgt_epi32(minNormal, absI);
+    const __m128i infOrNan       = _mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmpunord_ps(absF, absF)), nanBit), infinityHalf);
+
+    const __m128i subnormal      = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(denormMagic))), denormMagic);
+
+    // -1, if mantissa of the result is odd
+    const __m128i mantissaOdd    = _mm_srai_epi32(_mm_slli_epi32(absI, 31 - 13), 31);
+    const __m128i normal         = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absI, normalBias), mantissaOdd), 13);
+
+    const __m128i nonSpecial     = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    const __m128i joined         = _mm_or_si128(_mm_and_si128(isRegular, nonSpecial), _mm_andnot_si128(isRegular, infOrNan));
+
+    return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+#endif // RG_VERTEX_ENCODING_SSE2
+
+}
+
+uint32_t VertexEncoding::EncodeNormalOct(const float n[3])
+{
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    const float invL1 = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+
+    float x = n[0] * invL1;
+    float y = n[1] * invL1;
+
+    // fold the lower hemisphere
+    if (n[2] < 0.0f)
+    {
+        const float fx = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+        const float fy = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+
+        x = fx;
+        y = fy;
+    }
+
+    return ToSnorm16(x) | (ToSnorm16(y) << 16);
+}
+
+uint32_t VertexEncoding::EncodeTexCoordHalf(const float t[2])
+{
+    return (uint32_t)FloatToHalf(t[0]) | ((uint32_t)FloatToHalf(t[1]) << 16);
+}
+
+void VertexEncoding::EncodeNormalsOct(uint32_t *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    uint32_t i = 0;
+
+#ifdef RG_VERTEX_ENCODING_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000u));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 nx = LoadComponent4(src, srcStride, i, 0);
+        const __m128 ny = LoadComponent4(src, srcStride, i, 1);
+        const __m128 nz = LoadComponent4(src, srcStride, i, 2);
+
+        const __m128 l1 = _mm_add_ps(_mm_add_ps(_mm_and_ps(nx, absMask), _mm_and_ps(ny, absMask)), _mm_and_ps(nz, absMask));
+        // division by zero is masked out
+        const __m128 invL1 = _mm_and_ps(_mm_cmpgt_ps(l1, zero), _mm_div_ps(one, l1));
+
+        const __m128 x = _mm_mul_ps(nx, invL1);
+        const __m128 y = _mm_mul_ps(ny, invL1);
+
+        const __m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(y, absMask)), _mm_or_ps(_mm_and_ps(x, signMask), one));
+        const __m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(x, absMask)), _mm_or_ps(_mm_and_ps(y, signMask), one));
+
+        const __m128 isLower = _mm_cmplt_ps(nz, zero);
+
+        const __m128i ex = ToSnorm16x4(Select(isLower, fx, x));
+        const __m128i ey = ToSnorm16x4(Select(isLower, fy, y));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(ex, _mm_slli_epi32(ey, 16)));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        dst[i] = EncodeNormalOct(GetElement(src, srcStride, i));
+    }
+}
+
+void VertexEncoding::EncodeTexCoordsHalf(uint32_t *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    uint32_t i = 0;
+
+#ifdef RG_VERTEX_ENCODING_SSE2
+    const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i hu = FloatToHalf4(LoadComponent4(src, srcStride, i, 0));
+        const __m128i hv = FloatToHalf4(LoadComponent4(src, srcStride, i, 1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(_mm_and_si128(hu, lowMask), _mm_slli_epi32(hv, 16)));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        dst[i] = EncodeTexCoordHalf(GetElement(src, srcStride, i));
+    }
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace RTGL1
+{
+
+// Encoders of vertex attributes for the compact vertex buffer layout,
+// see RgInstanceCreateInfo::compactVertexData. Source arrays can be strided,
+// destination arrays are tightly packed. Results must match the GLSL decoders
+// in ShaderCommonGLSLFunc.h.
+class VertexEncoding
+{
+public:
+    // Octahedral encoding of a normal: x and y are snorm16, x is in the lower bits;
+    // decoded with unpackSnorm2x16. Normal doesn't need to be normalized.
+    static uint32_t EncodeNormalOct(const float n[3]);
+    // Tex coords as two float16 values, u is in the lower bits; decoded with unpackHalf2x16.
+    static uint32_t EncodeTexCoordHalf(const float t[2]);
+
+    // Encode "count" normals, each one is 3 floats, with "srcStride" bytes between them
+    static void EncodeNormalsOct(uint32_t *dst, const void *src, uint32_t srcStride, uint32_t count);
+    // Encode "count" tex coords, each one is 2 floats, with "srcStride" bytes between them
+    static void EncodeTexCoordsHalf(uint32_t *dst, const void *src, uint32_t srcStride, uint32_t count);
+};
+
+}
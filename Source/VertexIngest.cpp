@@ -0,0 +1,165 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "VertexIngest.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RG_VERTEX_INGEST_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define RG_VERTEX_INGEST_NEON
+    #include <arm_neon.h>
+#endif
+
+using namespace RTGL1;
+
+namespace
+{
+
+constexpr uint32_t FLOAT3_SIZE = 3 * sizeof(float);
+constexpr uint32_t FLOAT2_SIZE = 2 * sizeof(float);
+
+}
+
+void VertexIngest::CopyFloat3Scalar(float *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memcpy(dst + i * 3, s + (uint64_t)i * srcStride, FLOAT3_SIZE);
+    }
+}
+
+void VertexIngest::CopyFloat2Scalar(float *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memcpy(dst + i * 2, s + (uint64_t)i * srcStride, FLOAT2_SIZE);
+    }
+}
+
+void VertexIngest::CopyFloat3(float *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    assert(srcStride >= FLOAT3_SIZE);
+
+    if (srcStride == FLOAT3_SIZE)
+    {
+        memcpy(dst, src, (uint64_t)count * FLOAT3_SIZE);
+        return;
+    }
+
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    uint32_t i = 0;
+
+#if defined(RG_VERTEX_INGEST_SSE2) || defined(RG_VERTEX_INGEST_NEON)
+    // 4 floats are loaded for each element, the 4th one belongs to the next element,
+    // so the last element is not loaded this way to not read out of the source array;
+    // 4 elements are packed into 3 registers with shuffles
+    for (; i + 4 < count; i += 4)
+    {
+        const uint8_t *p = s + (uint64_t)i * srcStride;
+        float *d = dst + i * 3;
+
+    #ifdef RG_VERTEX_INGEST_SSE2
+        const __m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(p));
+        const __m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(p + srcStride));
+        const __m128 c = _mm_loadu_ps(reinterpret_cast<const float *>(p + 2 * srcStride));
+        const __m128 e = _mm_loadu_ps(reinterpret_cast<const float *>(p + 3 * srcStride));
+
+        // a0 a1 a2 b0
+        const __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 2, 2));
+        _mm_storeu_ps(d + 0, _mm_shuffle_ps(a, ab, _MM_SHUFFLE(2, 0, 1, 0)));
+        // b1 b2 c0 c1
+        _mm_storeu_ps(d + 4, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 2, 1)));
+        // c2 e0 e1 e2
+        const __m128 ce = _mm_shuffle_ps(c, e, _MM_SHUFFLE(0, 0, 2, 2));
+        _mm_storeu_ps(d + 8, _mm_shuffle_ps(ce, e, _MM_SHUFFLE(2, 1, 2, 0)));
+    #else
+        const float32x4_t a = vld1q_f32(reinterpret_cast<const float *>(p));
+        const float32x4_t b = vld1q_f32(reinterpret_cast<const float *>(p + srcStride));
+        const float32x4_t c = vld1q_f32(reinterpret_cast<const float *>(p + 2 * srcStride));
+        const float32x4_t e = vld1q_f32(reinterpret_cast<const float *>(p + 3 * srcStride));
+
+        // a0 a1 a2 b0
+        vst1q_f32(d + 0, vextq_f32(vextq_f32(a, a, 3), b, 1));
+        // b1 b2 c0 c1
+        vst1q_f32(d + 4, vextq_f32(vextq_f32(b, b, 3), c, 2));
+        // c2 e0 e1 e2
+        vst1q_f32(d + 8, vextq_f32(vextq_f32(c, c, 3), e, 3));
+    #endif
+    }
+#endif
+
+    CopyFloat3Scalar(dst + i * 3, s + (uint64_t)i * srcStride, srcStride, count - i);
+}
+
+void VertexIngest::CopyFloat2(float *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    assert(srcStride >= FLOAT2_SIZE);
+
+    if (srcStride == FLOAT2_SIZE)
+    {
+        memcpy(dst, src, (uint64_t)count * FLOAT2_SIZE);
+        return;
+    }
+
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+    uint32_t i = 0;
+
+#if defined(RG_VERTEX_INGEST_SSE2) || defined(RG_VERTEX_INGEST_NEON)
+    // 2 elements are combined in one register
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8_t *p = s + (uint64_t)i * srcStride;
+        float *d = dst + i * 2;
+
+    #ifdef RG_VERTEX_INGEST_SSE2
+        __m128 ab = _mm_setzero_ps();
+        ab = _mm_loadl_pi(ab, reinterpret_cast<const __m64 *>(p));
+        ab = _mm_loadh_pi(ab, reinterpret_cast<const __m64 *>(p + srcStride));
+
+        __m128 ce = _mm_setzero_ps();
+        ce = _mm_loadl_pi(ce, reinterpret_cast<const __m64 *>(p + 2 * srcStride));
+        ce = _mm_loadh_pi(ce, reinterpret_cast<const __m64 *>(p + 3 * srcStride));
+
+        _mm_storeu_ps(d + 0, ab);
+        _mm_storeu_ps(d + 4, ce);
+    #else
+        const float32x4_t ab = vcombine_f32(
+            vld1_f32(reinterpret_cast<const float *>(p)),
+            vld1_f32(reinterpret_cast<const float *>(p + srcStride)));
+        const float32x4_t ce = vcombine_f32(
+            vld1_f32(reinterpret_cast<const float *>(p + 2 * srcStride)),
+            vld1_f32(reinterpret_cast<const float *>(p + 3 * srcStride)));
+
+        vst1q_f32(d + 0, ab);
+        vst1q_f32(d + 4, ce);
+    #endif
+    }
+#endif
+
+    CopyFloat2Scalar(dst + i * 2, s + (uint64_t)i * srcStride, srcStride, count - i);
+}
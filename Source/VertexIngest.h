@@ -0,0 +1,46 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace RTGL1
+{
+
+// Deinterleaving of vertex attributes: user's arrays can be strided
+// (e.g. array of structs), but the vertex buffers have a tightly packed
+// array for each attribute, so only the attribute values are copied.
+class VertexIngest
+{
+public:
+    // Copy "count" elements of 3 floats, with "srcStride" bytes between them,
+    // to the tightly packed "dst". "srcStride" must be at least 12 bytes.
+    static void CopyFloat3(float *dst, const void *src, uint32_t srcStride, uint32_t count);
+    // Copy "count" elements of 2 floats, with "srcStride" bytes between them,
+    // to the tightly packed "dst". "srcStride" must be at least 8 bytes.
+    static void CopyFloat2(float *dst, const void *src, uint32_t srcStride, uint32_t count);
+
+    // Reference implementations without SIMD
+    static void CopyFloat3Scalar(float *dst, const void *src, uint32_t srcStride, uint32_t count);
+    static void CopyFloat2Scalar(float *dst, const void *src, uint32_t srcStride, uint32_t count);
+};
+
+}
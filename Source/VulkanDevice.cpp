@@ -34,7 +34,8 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
     instance(VK_NULL_HANDLE),
     device(VK_NULL_HANDLE),
     surface(VK_NULL_HANDLE),
-    currentFrameState(),
+    framesInFlight(info->framesInFlightCount != 0 ? info->framesInFlightCount : MIN_FRAMES_IN_FLIGHT),
+    currentFrameState(framesInFlight),
     frameId(1),
     waitForOutOfFrameFence(false),
     enableValidationLayer(info->enableValidationLayer == RG_TRUE),
@@ -46,6 +47,11 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
 {
     ValidateCreateInfo(info);
 
+    if (info->pTraceFilePath != nullptr)
+    {
+        traceWriter = std::make_shared<TraceWriter>(info->pTraceFilePath);
+        frameStatistics.SetTraceWriter(traceWriter);
+    }
 
 
     vbProperties.vertexArrayOfStructs = info->vertexArrayOfStructs == RG_TRUE;
@@ -53,6 +59,11 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
     vbProperties.normalStride = info->vertexNormalStride;
     vbProperties.texCoordStride = info->vertexTexCoordStride;
     vbProperties.colorStride = info->vertexColorStride;
+    vbProperties.compactVertexData = info->compactVertexData == RG_TRUE;
+    vbProperties.staticVertexCapacity = info->staticVertexCapacity != 0 ? info->staticVertexCapacity : DEFAULT_STATIC_VERTEX_CAPACITY;
+    vbProperties.staticIndexCapacity = info->staticIndexCapacity != 0 ? info->staticIndexCapacity : DEFAULT_STATIC_INDEX_CAPACITY;
+    vbProperties.dynamicVertexCapacity = info->dynamicVertexCapacity != 0 ? info->dynamicVertexCapacity : DEFAULT_DYNAMIC_VERTEX_CAPACITY;
+    vbProperties.dynamicIndexCapacity = info->dynamicIndexCapacity != 0 ? info->dynamicIndexCapacity : DEFAULT_DYNAMIC_INDEX_CAPACITY;
 
 
 
@@ -68,6 +79,8 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
     physDevice          = std::make_shared<PhysicalDevice>(instance);
     queues              = std::make_shared<Queues>(physDevice->Get(), surface);
 
+    vbProperties.maxBufferSize = physDevice->GetLimits().maxStorageBufferRange;
+
     // create vulkan device and set extension function pointers
     CreateDevice();
 
@@ -77,11 +90,16 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
     queues->SetDevice(device);
 
 
-    memAllocator        = std::make_shared<MemoryAllocator>(instance, device, physDevice);
+    memAllocator        = std::make_shared<MemoryAllocator>(instance, device, physDevice, framesInFlight);
+
+    cmdManager          = std::make_shared<CommandBufferManager>(device, queues, framesInFlight);
 
-    cmdManager          = std::make_shared<CommandBufferManager>(device, queues);
+    if (info->enableGpuProfiling)
+    {
+        gpuProfiler     = std::make_shared<GpuProfiler>(device, physDevice->Get(), queues->GetIndexGraphics(), framesInFlight);
+    }
 
-    uniform             = std::make_shared<GlobalUniform>(device, memAllocator);
+    uniform             = std::make_shared<GlobalUniform>(device, memAllocator, framesInFlight);
 
     swapchain           = std::make_shared<Swapchain>(device, surface, physDevice, cmdManager);
 
@@ -107,6 +125,7 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
         samplerManager, 
         cmdManager,
         userFileLoad,
+        framesInFlight,
         *info);
 
     cubemapManager      = std::make_shared<CubemapManager>(
@@ -115,6 +134,7 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
         samplerManager,
         cmdManager,
         userFileLoad,
+        framesInFlight,
         info->pOverridenTexturesFolderPath,
         info->pOverridenAlbedoAlphaTexturePostfix);
 
@@ -130,7 +150,10 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
         textureManager,
         uniform,
         shaderManager,
-        vbProperties);
+        vbProperties,
+        framesInFlight,
+        info->dynamicRecordingContextCount,
+        info->maxStaticGeometryClusterCount);
    
     rasterizer          = std::make_shared<Rasterizer>(
         device,
@@ -143,6 +166,7 @@ VulkanDevice::VulkanDevice(const RgInstanceCreateInfo *info) :
         framebuffers,
         cmdManager,
         swapchain->GetSurfaceFormat(),
+        framesInFlight,
         *info);
 
     rtPipeline          = std::make_shared<RayTracingPipeline>(
@@ -226,6 +250,8 @@ VulkanDevice::~VulkanDevice()
     textureManager.reset();
     cubemapManager.reset();
     memAllocator.reset();
+    gpuProfiler.reset();
+    traceWriter.reset();
 
     vkDestroySurfaceKHR(instance, surface, nullptr);
     DestroySyncPrimitives();
@@ -238,19 +264,36 @@ VkCommandBuffer VulkanDevice::BeginFrame(const RgStartFrameInfo &startInfo)
 {
     uint32_t frameIndex = currentFrameState.IncrementFrameIndexAndGet();
 
-    if (!waitForOutOfFrameFence)
     {
-        // wait for previous cmd with the same frame index
-        Utils::WaitAndResetFence(device, frameFences[frameIndex]);
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::FenceWait);
+
+        if (!waitForOutOfFrameFence)
+        {
+            // wait for previous cmd with the same frame index
+            Utils::WaitAndResetFence(device, frameFences[frameIndex]);
+        }
+        else
+        {
+            Utils::WaitAndResetFences(device, frameFences[frameIndex], outOfFrameFences[frameIndex]);
+        }
     }
-    else
+
+    if (gpuProfiler)
     {
-        Utils::WaitAndResetFences(device, frameFences[frameIndex], outOfFrameFences[frameIndex]);
+        // the frame with the same index is finished, its timestamps can be read
+        if (gpuProfiler->ResolveFrame(frameIndex) && traceWriter)
+        {
+            gpuProfiler->WriteResultsToTrace(*traceWriter);
+        }
     }
 
-    swapchain->RequestNewSize(startInfo.surfaceSize.width, startInfo.surfaceSize.height);
-    swapchain->RequestVsync(startInfo.requestVSync);
-    swapchain->AcquireImage(imageAvailableSemaphores[frameIndex]);
+    {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::SwapchainAcquire);
+
+        swapchain->RequestNewSize(startInfo.surfaceSize.width, startInfo.surfaceSize.height);
+        swapchain->RequestVsync(startInfo.requestVSync);
+        swapchain->AcquireImage(imageAvailableSemaphores[frameIndex]);
+    }
 
     VkSemaphore semaphoreToWaitOnSubmit = imageAvailableSemaphores[frameIndex];
 
@@ -267,7 +310,7 @@ VkCommandBuffer VulkanDevice::BeginFrame(const RgStartFrameInfo &startInfo)
             cmdManager->Submit(preFrameCmd,
                                semaphoreToWaitOnSubmit, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
                                inFrameSemaphores[frameIndex],
-                               outOfFrameFences[(frameIndex + 1) % MAX_FRAMES_IN_FLIGHT]);
+                               outOfFrameFences[(frameIndex + 1) % framesInFlight]);
 
             // should wait other semaphore in this case
             semaphoreToWaitOnSubmit = inFrameSemaphores[frameIndex];
@@ -291,15 +334,29 @@ VkCommandBuffer VulkanDevice::BeginFrame(const RgStartFrameInfo &startInfo)
     // reset cmds for current frame index
     cmdManager->PrepareForFrame(frameIndex);
 
-    // clear the data that were created MAX_FRAMES_IN_FLIGHT ago
+    framebuffers->PrepareForFrame(frameIndex);
+
+    // clear the data that were created framesInFlight frames ago
     textureManager->PrepareForFrame(frameIndex);
     cubemapManager->PrepareForFrame(frameIndex);
     rasterizer->PrepareForFrame(frameIndex, startInfo.requestRasterizedSkyGeometryReuse);
 
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
 
+    if (gpuProfiler)
+    {
+        gpuProfiler->BeginFrame(cmd, frameIndex, frameId);
+    }
+
     BeginCmdLabel(cmd, "Prepare for frame");
 
+    // evict unused textures, if over the budget, and reload the requested ones
+    textureManager->UpdateResidency(cmd, frameIndex);
+    // swap in the textures that were loaded on the worker threads
+    textureManager->UploadLoadedTextures(cmd, frameIndex);
+    // upload next mip levels of the streamed textures, under the per-frame budget
+    textureManager->StreamTextureLevels(cmd, frameIndex);
+
     // start dynamic geometry recording to current frame
     scene->PrepareForFrame(cmd, frameIndex);
 
@@ -337,10 +394,12 @@ void VulkanDevice::FillUniform(ShGlobalUniform *gu, const RgDrawFrameInfo &drawI
     }
 
     { 
-        // to remove additional division by 4 bytes in shaders
-        gu->positionsStride = vbProperties.positionStride / 4;
-        gu->normalsStride = vbProperties.normalStride / 4;
-        gu->texCoordsStride = vbProperties.texCoordStride / 4;
+        // to remove additional division by 4 bytes in shaders;
+        // attribute arrays in the vertex buffers are tightly packed
+        gu->positionsStride = VERTEX_POSITION_STRIDE / 4;
+        gu->normalsStride = VERTEX_NORMAL_STRIDE / 4;
+        gu->texCoordsStride = VERTEX_TEXCOORD_STRIDE / 4;
+        gu->vertexDataCompact = vbProperties.compactVertexData ? 1 : 0;
     }
 
     {
@@ -609,15 +668,23 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
     const uint32_t frameIndex = currentFrameState.GetFrameIndex();
 
-    textureManager->SubmitDescriptors(frameIndex);
-    cubemapManager->SubmitDescriptors(frameIndex);
+    {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::TextureDescriptorsSubmit);
+
+        textureManager->SubmitDescriptors(frameIndex);
+        cubemapManager->SubmitDescriptors(frameIndex);
+    }
 
     const uint32_t renderWidth  = drawInfo.renderSize.width;
     const uint32_t renderHeight = drawInfo.renderSize.height;
     assert(renderWidth > 0 && renderHeight > 0);
 
     // submit geometry and upload uniform after getting data from a scene
-    const bool sceneNotEmpty = scene->SubmitForFrame(cmd, frameIndex, uniform);
+    bool sceneNotEmpty;
+    {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::SceneSubmit);
+        sceneNotEmpty = scene->SubmitForFrame(cmd, frameIndex, uniform, frameStatistics);
+    }
 
     framebuffers->PrepareForSize(renderWidth, renderHeight);
 
@@ -625,6 +692,8 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
     if (!drawInfo.disableRasterization)
     {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::Rasterizer);
+
         rasterizer->SubmitForFrame(cmd, frameIndex);
 
         // draw rasterized sky to albedo before tracing primary rays
@@ -675,6 +744,8 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
     if (!drawInfo.disableRasterization)
     {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::Rasterizer);
+
         // draw rasterized geometry into the final image
         rasterizer->DrawToFinalImage(cmd, frameIndex, textureManager,
                                      uniform->GetData()->view, uniform->GetData()->projection,
@@ -688,6 +759,8 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
     if (!drawInfo.disableRasterization)
     {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::Rasterizer);
+
         rasterizer->DrawToSwapchain(cmd, frameIndex, swapchain->GetCurrentImageIndex(), textureManager, 
                                     uniform->GetData()->view, uniform->GetData()->projection);
     }
@@ -698,16 +771,37 @@ void VulkanDevice::EndFrame(VkCommandBuffer cmd)
     uint32_t frameIndex = currentFrameState.GetFrameIndex();
     VkSemaphore semaphoreToWait = currentFrameState.GetSemaphoreForWaitAndRemove();
 
-    // submit command buffer, but wait until presentation engine has completed using image
-    cmdManager->Submit(
-        cmd, 
-        semaphoreToWait,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-        renderFinishedSemaphores[frameIndex],
-        frameFences[frameIndex]);
+    textureManager->RecordUsageReadback(cmd, frameIndex);
 
-    // present on a surface when rendering will be finished
-    swapchain->Present(queues, renderFinishedSemaphores[frameIndex]);
+    if (gpuProfiler)
+    {
+        gpuProfiler->EndFrame();
+    }
+
+    {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::Submit);
+
+        // submit command buffer, but wait until presentation engine has completed using image
+        cmdManager->Submit(
+            cmd, 
+            semaphoreToWait,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
+            renderFinishedSemaphores[frameIndex],
+            frameFences[frameIndex]);
+    }
+
+    {
+        FrameStatistics::ScopedStage stage(frameStatistics, FrameStatistics::Stage::Present);
+
+        // present on a surface when rendering will be finished
+        swapchain->Present(queues, renderFinishedSemaphores[frameIndex]);
+    }
+
+    frameStatistics.OnFrameEnd(
+        frameId,
+        rasterizer->GetDrawCallCount(),
+        memAllocator->PopStagingCopiedBytes(),
+        scene->GetASManager()->GetStaticCompactionSavedBytes());
 
     frameId++;
 }
@@ -718,6 +812,8 @@ void VulkanDevice::EndFrame(VkCommandBuffer cmd)
 
 void VulkanDevice::StartFrame(const RgStartFrameInfo *startInfo)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgStartFrame");
+
     if (currentFrameState.WasFrameStarted())
     {
         throw RgException(RG_FRAME_WASNT_ENDED);
@@ -734,6 +830,8 @@ void VulkanDevice::StartFrame(const RgStartFrameInfo *startInfo)
 
 void VulkanDevice::DrawFrame(const RgDrawFrameInfo *drawInfo)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgDrawFrame");
+
     if (!currentFrameState.WasFrameStarted())
     {
         throw RgException(RG_FRAME_WASNT_STARTED);
@@ -759,6 +857,31 @@ void VulkanDevice::DrawFrame(const RgDrawFrameInfo *drawInfo)
     currentFrameState.OnEndFrame();
 }
 
+void VulkanDevice::GetFrameStatistics(uint32_t count, RgFrameStatistics *pResults, uint32_t *pResultCount) const
+{
+    if (pResultCount == nullptr || (count > 0 && pResults == nullptr))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    *pResultCount = frameStatistics.GetLast(count, pResults);
+}
+
+void VulkanDevice::GetGpuTimings(uint64_t *pFrameId, uint32_t *pScopeCount, RgGpuTimingScope *pScopes) const
+{
+    if (!gpuProfiler)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "GPU profiling must be enabled with RgInstanceCreateInfo::enableGpuProfiling");
+    }
+
+    if (pScopeCount == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    gpuProfiler->GetResults(pFrameId, pScopeCount, pScopes);
+}
+
 void VulkanDevice::Print(const char *pMessage) const
 {
     userPrint->Print(pMessage);
@@ -767,6 +890,8 @@ void VulkanDevice::Print(const char *pMessage) const
 
 void VulkanDevice::UploadGeometry(const RgGeometryUploadInfo *uploadInfo)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgUploadGeometry");
+
     using namespace std::string_literals;
 
     if (uploadInfo == nullptr)
@@ -774,44 +899,166 @@ void VulkanDevice::UploadGeometry(const RgGeometryUploadInfo *uploadInfo)
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
     }
 
-    if (uploadInfo->pVertexData == nullptr || uploadInfo->vertexCount == 0)
+    ValidateUploadInfo(*uploadInfo);
+
+    if (scene->DoesUniqueIDExist(uploadInfo->uniqueID))
     {
-        throw RgException(RG_WRONG_ARGUMENT, "Incorrect vertex data");
+        throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID="s + std::to_string(uploadInfo->uniqueID) + " already exists");
     }
 
-    if ((uploadInfo->pIndexData == nullptr && uploadInfo->indexCount != 0) ||
-        (uploadInfo->pIndexData != nullptr && uploadInfo->indexCount == 0))
+    if (scene->Upload(currentFrameState.GetFrameIndex(), *uploadInfo))
     {
-        throw RgException(RG_WRONG_ARGUMENT, "Incorrect index data");
+        frameStatistics.AddGeometries(1, uploadInfo->vertexCount, uploadInfo->indexCount);
     }
+}
 
-    if (uploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC &&
-        uploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC_MOVABLE &&
-        uploadInfo->geomType != RG_GEOMETRY_TYPE_DYNAMIC &&
+void VulkanDevice::UploadGeometries(uint32_t count, const RgGeometryUploadInfo *pUploadInfos)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgUploadGeometries");
 
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT &&
+    if (count == 0)
+    {
+        return;
+    }
 
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_1 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON_VIEWER)
+    if (pUploadInfos == nullptr)
     {
-        throw RgException(RG_WRONG_ARGUMENT, "Incorrect type of ray traced geometry");
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
     }
 
-    if (scene->DoesUniqueIDExist(uploadInfo->uniqueID))
+    for (uint32_t i = 0; i < count; i++)
     {
-        throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID="s + std::to_string(uploadInfo->uniqueID) + " already exists");
+        ValidateUploadInfo(pUploadInfos[i]);
+    }
+
+    uint32_t vertexCount = 0, indexCount = 0;
+
+    // unique IDs are checked by the scene
+    uint32_t uploadedCount = scene->Upload(currentFrameState.GetFrameIndex(), count, pUploadInfos, &vertexCount, &indexCount);
+
+    frameStatistics.AddGeometries(uploadedCount, vertexCount, indexCount);
+}
+
+void VulkanDevice::RecordDynamicGeometry(uint32_t contextIndex, const RgGeometryUploadInfo *pUploadInfo)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgRecordDynamicGeometry");
+
+    using namespace std::string_literals;
+
+    if (pUploadInfo == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (contextIndex >= scene->GetASManager()->GetDynamicRecordingContextCount())
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Recording context index must be less than dynamicRecordingContextCount, index="s + std::to_string(contextIndex));
+    }
+
+    if (pUploadInfo->geomType != RG_GEOMETRY_TYPE_DYNAMIC)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Only dynamic geometry can be recorded through a recording context");
+    }
+
+    ValidateUploadInfo(*pUploadInfo);
+
+    if (scene->RecordDynamic(currentFrameState.GetFrameIndex(), contextIndex, *pUploadInfo))
+    {
+        frameStatistics.AddGeometries(1, pUploadInfo->vertexCount, pUploadInfo->indexCount);
+    }
+}
+
+void VulkanDevice::MapGeometry(const RgGeometryUploadInfo *pUploadInfo, RgMappedGeometry *pResult)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgMapGeometry");
+
+    if (pUploadInfo == nullptr || pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (pUploadInfo->geomType != RG_GEOMETRY_TYPE_DYNAMIC)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Only dynamic geometry can be mapped");
     }
 
-    scene->Upload(currentFrameState.GetFrameIndex(), *uploadInfo);
+    ValidateUploadInfo(*pUploadInfo, true);
+
+    *pResult = {};
+
+    RgGeometryUploadInfo mappedInfo = {};
+
+    // if there's no space, pointers are null; buffers will be grown on the next frame
+    if (!scene->MapDynamic(currentFrameState.GetFrameIndex(), *pUploadInfo, mappedInfo))
+    {
+        return;
+    }
+
+    pResult->pVertexData = const_cast<void *>(mappedInfo.pVertexData);
+    pResult->pNormalData = const_cast<void *>(mappedInfo.pNormalData);
+    pResult->pTexCoordData = const_cast<void *>(mappedInfo.pTexCoordLayerData[0]);
+    // indices are mapped only if they're not provided
+    pResult->pIndexData = pUploadInfo->pIndexData == nullptr ? static_cast<uint32_t *>(const_cast<void *>(mappedInfo.pIndexData)) : nullptr;
+    pResult->vertexStride = VERTEX_POSITION_STRIDE;
+    pResult->normalStride = vbProperties.compactVertexData ? sizeof(uint32_t) : VERTEX_NORMAL_STRIDE;
+    pResult->texCoordStride = vbProperties.compactVertexData ? sizeof(uint32_t) : VERTEX_TEXCOORD_STRIDE;
+}
+
+bool VulkanDevice::CommitMappedGeometry(uint64_t uniqueID, RgGeometryUploadInfo &outCommittedInfo)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCommitMappedGeometry");
+
+    outCommittedInfo = {};
+
+    if (!scene->CommitMappedDynamic(currentFrameState.GetFrameIndex(), uniqueID, outCommittedInfo))
+    {
+        return false;
+    }
+
+    frameStatistics.AddGeometries(1, outCommittedInfo.vertexCount, outCommittedInfo.indexCount);
+
+    // mapped data is tightly packed, so it's in the API format, only
+    // if the user's strides are the same; packed normals and tex coords are never
+    return
+        !vbProperties.compactVertexData &&
+        vbProperties.positionStride == VERTEX_POSITION_STRIDE &&
+        vbProperties.normalStride == VERTEX_NORMAL_STRIDE &&
+        vbProperties.texCoordStride == VERTEX_TEXCOORD_STRIDE;
+}
+
+void VulkanDevice::ValidateUploadInfo(const RgGeometryUploadInfo &uploadInfo, bool isMapped)
+{
+    if ((uploadInfo.pVertexData == nullptr && !isMapped) || uploadInfo.vertexCount == 0)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect vertex data");
+    }
+
+    if ((uploadInfo.pIndexData == nullptr && uploadInfo.indexCount != 0 && !isMapped) ||
+        (uploadInfo.pIndexData != nullptr && uploadInfo.indexCount == 0))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect index data");
+    }
+
+    if (uploadInfo.geomType != RG_GEOMETRY_TYPE_STATIC &&
+        uploadInfo.geomType != RG_GEOMETRY_TYPE_STATIC_MOVABLE &&
+        uploadInfo.geomType != RG_GEOMETRY_TYPE_DYNAMIC &&
+
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT &&
+        uploadInfo.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT &&
+
+        uploadInfo.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0 &&
+        uploadInfo.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_1 &&
+        uploadInfo.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 &&
+        uploadInfo.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON &&
+        uploadInfo.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON_VIEWER)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect type of ray traced geometry");
+    }
 }
 
 void VulkanDevice::UpdateGeometryTransform(const RgUpdateTransformInfo *updateInfo)
@@ -834,9 +1081,103 @@ void RTGL1::VulkanDevice::UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo *u
     scene->UpdateTexCoords(*updateInfo);
 }
 
+void VulkanDevice::CreateMesh(const RgMeshCreateInfo *pCreateInfo, RgMesh *pResult)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCreateMesh");
+
+    if (pCreateInfo == nullptr || pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (pCreateInfo->pVertexData == nullptr || pCreateInfo->vertexCount == 0)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect vertex data");
+    }
+
+    if ((pCreateInfo->pIndexData == nullptr && pCreateInfo->indexCount != 0) ||
+        (pCreateInfo->pIndexData != nullptr && pCreateInfo->indexCount == 0))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect index data");
+    }
+
+    *pResult = scene->CreateMesh(*pCreateInfo);
+
+    frameStatistics.AddGeometries(1, pCreateInfo->vertexCount, pCreateInfo->indexCount);
+}
+
+void VulkanDevice::UploadMeshInstance(const RgMeshInstanceUploadInfo *pUploadInfo)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgUploadMeshInstance");
+
+    if (pUploadInfo == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT &&
+        pUploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect pass through type of mesh instance");
+    }
+
+    if (pUploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0 &&
+        pUploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_1 &&
+        pUploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 &&
+        pUploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON &&
+        pUploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON_VIEWER)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Incorrect visibility type of mesh instance");
+    }
+
+    if (scene->UploadMeshInstance(currentFrameState.GetFrameIndex(), *pUploadInfo))
+    {
+        // vertices of a mesh are not uploaded per instance
+        frameStatistics.AddGeometries(1, 0, 0);
+    }
+}
+
+void VulkanDevice::AddStaticGeometry(const RgGeometryUploadInfo *pUploadInfo)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgAddStaticGeometry");
+
+    if (pUploadInfo == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (pUploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC &&
+        pUploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC_MOVABLE)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Only static geometry can be added with rgAddStaticGeometry");
+    }
+
+    ValidateUploadInfo(*pUploadInfo);
+
+    // unique ID is checked by the scene
+    if (scene->AddStatic(*pUploadInfo))
+    {
+        frameStatistics.AddGeometries(1, pUploadInfo->vertexCount, pUploadInfo->indexCount);
+    }
+}
+
+void VulkanDevice::RemoveStaticGeometry(uint64_t uniqueID)
+{
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgRemoveStaticGeometry");
+
+    scene->RemoveStatic(uniqueID);
+}
+
 void VulkanDevice::UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo *uploadInfo,
                                                 const float *viewProjection, const RgViewport *viewport)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgUploadRasterizedGeometry");
+
     if (uploadInfo == nullptr)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
@@ -866,14 +1207,28 @@ void VulkanDevice::UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo
 
 void VulkanDevice::SubmitStaticGeometries()
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgSubmitStaticGeometries");
+
     scene->SubmitStatic();
 }
 
 void VulkanDevice::StartNewStaticScene()
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgStartNewScene");
+
     scene->StartNewStatic();
 }
 
+void VulkanDevice::IsStaticSceneSwapPending(RgBool32 *pResult) const
+{
+    if (pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    *pResult = scene->IsStaticSceneSwapPending() ? RG_TRUE : RG_FALSE;
+}
+
 void VulkanDevice::UploadLight(const RgDirectionalLightUploadInfo *pLightInfo)
 {
     if (pLightInfo == nullptr)
@@ -882,6 +1237,8 @@ void VulkanDevice::UploadLight(const RgDirectionalLightUploadInfo *pLightInfo)
     }
 
     scene->UploadLight(currentFrameState.GetFrameIndex(), *pLightInfo);
+
+    frameStatistics.AddLight();
 }
 
 void VulkanDevice::UploadLight(const RgSphericalLightUploadInfo *pLightInfo)
@@ -892,6 +1249,8 @@ void VulkanDevice::UploadLight(const RgSphericalLightUploadInfo *pLightInfo)
     }
 
     scene->UploadLight(currentFrameState.GetFrameIndex(), *pLightInfo);
+
+    frameStatistics.AddLight();
 }
 
 void VulkanDevice::UploadLight(const RgSpotlightUploadInfo *pLightInfo)
@@ -902,10 +1261,14 @@ void VulkanDevice::UploadLight(const RgSpotlightUploadInfo *pLightInfo)
     }
 
     scene->UploadLight(currentFrameState.GetFrameIndex(), uniform, *pLightInfo);
+
+    frameStatistics.AddLight();
 }
 
 void VulkanDevice::CreateStaticMaterial(const RgStaticMaterialCreateInfo *createInfo, RgMaterial *result)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCreateStaticMaterial");
+
     if (createInfo == nullptr)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
@@ -918,6 +1281,8 @@ void VulkanDevice::CreateStaticMaterial(const RgStaticMaterialCreateInfo *create
 
 void VulkanDevice::CreateAnimatedMaterial(const RgAnimatedMaterialCreateInfo *createInfo, RgMaterial *result)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCreateAnimatedMaterial");
+
     if (createInfo == nullptr)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
@@ -945,6 +1310,8 @@ void VulkanDevice::ChangeAnimatedMaterialFrame(RgMaterial animatedMaterial, uint
 
 void VulkanDevice::CreateDynamicMaterial(const RgDynamicMaterialCreateInfo *createInfo, RgMaterial *result)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCreateDynamicMaterial");
+
     if (createInfo == nullptr)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
@@ -963,6 +1330,8 @@ void VulkanDevice::CreateDynamicMaterial(const RgDynamicMaterialCreateInfo *crea
 
 void VulkanDevice::UpdateDynamicMaterial(const RgDynamicMaterialUpdateInfo *updateInfo)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgUpdateDynamicMaterial");
+
     if (!currentFrameState.WasFrameStarted())
     {
         throw RgException(RG_FRAME_WASNT_STARTED);
@@ -982,6 +1351,8 @@ void VulkanDevice::DestroyMaterial(RgMaterial material)
 }
 void VulkanDevice::CreateSkyboxCubemap(const RgCubemapCreateInfo *createInfo, RgCubemap *result)
 {
+    TraceWriter::Scope traceScope(traceWriter.get(), "rgCreateCubemap");
+
     *result = cubemapManager->CreateCubemap(currentFrameState.GetCmdBufferForMaterials(cmdManager), currentFrameState.GetFrameIndex(), *createInfo);
 }
 void VulkanDevice::DestroyCubemap(RgCubemap cubemap)
@@ -1074,6 +1445,11 @@ void VulkanDevice::CreateInstance(const RgInstanceCreateInfo &info)
     #endif // RG_USE_SURFACE_XLIB
     };
 
+    if (info.useNullDevice)
+    {
+        extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+    }
+
     if (enableValidationLayer)
     {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -1247,7 +1623,7 @@ void VulkanDevice::CreateSyncPrimitives()
     VkFenceCreateInfo nonSignaledFenceInfo = {};
     nonSignaledFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         r = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]);
         VK_CHECKERROR(r);
@@ -1275,6 +1651,29 @@ VkSurfaceKHR VulkanDevice::GetSurfaceFromUser(VkInstance instance, const RgInsta
     VkResult r;
 
 
+#ifdef RG_USE_NULL_DEVICE
+    if (info.useNullDevice)
+    {
+        VkHeadlessSurfaceCreateInfoEXT headlessInfo = {};
+        headlessInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        r = vkCreateHeadlessSurfaceEXT(instance, &headlessInfo, nullptr, &surface);
+        VK_CHECKERROR(r);
+
+        return surface;
+    }
+    else
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "The library was built with RG_WITH_NULL_DEVICE option, so useNullDevice must be true");
+    }
+#else
+    if (info.useNullDevice)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "useNullDevice is true, but the library wasn't built with RG_WITH_NULL_DEVICE option");
+    }
+#endif // RG_USE_NULL_DEVICE
+
+
 #ifdef RG_USE_SURFACE_WIN32
     if (info.pWin32SurfaceInfo != nullptr)
     {
@@ -1399,7 +1798,7 @@ void VulkanDevice::DestroyDevice()
 
 void VulkanDevice::DestroySyncPrimitives()
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < framesInFlight; i++)
     {
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
@@ -1427,7 +1826,14 @@ void RTGL1::VulkanDevice::ValidateCreateInfo(const RgInstanceCreateInfo *pInfo)
             !!pInfo->pXcbSurfaceCreateInfo +
             !!pInfo->pXlibSurfaceCreateInfo;
 
-        if (count != 1)
+        if (pInfo->useNullDevice)
+        {
+            if (count != 0)
+            {
+                throw RgException(RG_WRONG_ARGUMENT, "Surface infos must be null, if useNullDevice is true");
+            }
+        }
+        else if (count != 1)
         {
             throw RgException(RG_WRONG_ARGUMENT, "Exactly one of the surface infos must be not null");
         }
@@ -1447,6 +1853,40 @@ void RTGL1::VulkanDevice::ValidateCreateInfo(const RgInstanceCreateInfo *pInfo)
     {
         throw RgException(RG_WRONG_ARGUMENT, "indirectIlluminationMaxAlbedoLayers must be <="s + std::to_string(MATERIALS_MAX_LAYER_COUNT));
     }
+
+    if (pInfo->dynamicRecordingContextCount > DYNAMIC_RECORDING_CONTEXT_COUNT_MAX)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "dynamicRecordingContextCount must be <="s + std::to_string(DYNAMIC_RECORDING_CONTEXT_COUNT_MAX));
+    }
+
+    if (pInfo->framesInFlightCount != 0 &&
+        (pInfo->framesInFlightCount < MIN_FRAMES_IN_FLIGHT || pInfo->framesInFlightCount > MAX_FRAMES_IN_FLIGHT))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "framesInFlightCount must be 0 or in ["s + std::to_string(MIN_FRAMES_IN_FLIGHT) + ".." + std::to_string(MAX_FRAMES_IN_FLIGHT) + "]");
+    }
+
+    if (pInfo->maxStaticGeometryClusterCount > STATIC_GEOMETRY_CLUSTER_COUNT_MAX)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "maxStaticGeometryClusterCount must be <="s + std::to_string(STATIC_GEOMETRY_CLUSTER_COUNT_MAX));
+    }
+
+    if (pInfo->textureLoadThreadCount > TEXTURE_LOAD_THREAD_COUNT_MAX)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "textureLoadThreadCount must be <="s + std::to_string(TEXTURE_LOAD_THREAD_COUNT_MAX));
+    }
+
+    if (pInfo->textureDecodeThreadCount > TEXTURE_DECODE_THREAD_COUNT_MAX)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "textureDecodeThreadCount must be <="s + std::to_string(TEXTURE_DECODE_THREAD_COUNT_MAX));
+    }
+
+    // attribute values are gathered from the strided arrays
+    if (pInfo->vertexPositionStride < 3 * sizeof(float) ||
+        pInfo->vertexNormalStride < 3 * sizeof(float) ||
+        pInfo->vertexTexCoordStride < 2 * sizeof(float))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Vertex strides must be not less than the sizes of the attributes");
+    }
 }
 
 #pragma endregion 
@@ -44,6 +44,9 @@
 #include "Denoiser.h"
 #include "UserFunction.h"
 #include "Bloom.h"
+#include "FrameStatistics.h"
+#include "GpuProfiler.h"
+#include "TraceWriter.h"
 
 namespace RTGL1
 {
@@ -60,14 +63,25 @@ public:
     VulkanDevice& operator=(VulkanDevice&& other) noexcept = delete;
 
     void UploadGeometry(const RgGeometryUploadInfo *pUploadInfo);
+    void UploadGeometries(uint32_t count, const RgGeometryUploadInfo *pUploadInfos);
+    void RecordDynamicGeometry(uint32_t contextIndex, const RgGeometryUploadInfo *pUploadInfo);
+    void MapGeometry(const RgGeometryUploadInfo *pUploadInfo, RgMappedGeometry *pResult);
+    // Returns true, if "outCommittedInfo" points to the data in the API format, so it can be captured
+    bool CommitMappedGeometry(uint64_t uniqueID, RgGeometryUploadInfo &outCommittedInfo);
     void UpdateGeometryTransform(const RgUpdateTransformInfo *pUpdateInfo);
     void UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo *pUpdateInfo);
 
+    void CreateMesh(const RgMeshCreateInfo *pCreateInfo, RgMesh *pResult);
+    void UploadMeshInstance(const RgMeshInstanceUploadInfo *pUploadInfo);
+    void AddStaticGeometry(const RgGeometryUploadInfo *pUploadInfo);
+    void RemoveStaticGeometry(uint64_t uniqueID);
+
     void UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo *pUploadInfo,
                                       const float *pViewProjection, const RgViewport *pViewport);
 
     void SubmitStaticGeometries();
     void StartNewStaticScene();
+    void IsStaticSceneSwapPending(RgBool32 *pResult) const;
 
     void UploadLight(const RgDirectionalLightUploadInfo *pLightInfo);
     void UploadLight(const RgSphericalLightUploadInfo *pLightInfo);
@@ -87,6 +101,9 @@ public:
     void StartFrame(const RgStartFrameInfo *pStartInfo);
     void DrawFrame(const RgDrawFrameInfo *pFrameInfo);
 
+    void GetFrameStatistics(uint32_t count, RgFrameStatistics *pResults, uint32_t *pResultCount) const;
+    void GetGpuTimings(uint64_t *pFrameId, uint32_t *pScopeCount, RgGpuTimingScope *pScopes) const;
+
 
     void Print(const char *pMessage) const;
 
@@ -96,6 +113,8 @@ private:
     void CreateSyncPrimitives();
     static VkSurfaceKHR GetSurfaceFromUser(VkInstance instance, const RgInstanceCreateInfo &info);
     void ValidateCreateInfo(const RgInstanceCreateInfo *pInfo);
+    // If "isMapped", data pointers are not required, as the data is written to the mapped memory
+    static void ValidateUploadInfo(const RgGeometryUploadInfo &uploadInfo, bool isMapped = false);
 
     void DestroyInstance();
     void DestroyDevice();
@@ -111,7 +130,8 @@ private:
     struct FrameState
     {
     private:
-        // [0..MAX_FRAMES_IN_FLIGHT-1]
+        uint32_t            framesInFlight;
+        // [0..framesInFlight-1]
         uint32_t            frameIndex;
         VkCommandBuffer     frameCmd;
         VkSemaphore         semaphoreToWait;
@@ -121,8 +141,9 @@ private:
         VkCommandBuffer     preFrameCmd;
 
     public:
-        FrameState() : 
-            frameIndex(MAX_FRAMES_IN_FLIGHT - 1), 
+        explicit FrameState(uint32_t _framesInFlight) : 
+            framesInFlight(_framesInFlight),
+            frameIndex(_framesInFlight - 1), 
             frameCmd(VK_NULL_HANDLE), 
             semaphoreToWait(VK_NULL_HANDLE),
             preFrameCmd(VK_NULL_HANDLE)
@@ -135,20 +156,20 @@ private:
 
         uint32_t IncrementFrameIndexAndGet()
         {
-            frameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+            frameIndex = (frameIndex + 1) % framesInFlight;
             return frameIndex;
         }
 
         uint32_t GetFrameIndex() const
         {
-            assert(frameIndex >= 0 && frameIndex < MAX_FRAMES_IN_FLIGHT);
+            assert(frameIndex >= 0 && frameIndex < framesInFlight);
             return frameIndex;
         }
 
-        static uint32_t GetPrevFrameIndex(uint32_t frameIndex)
+        uint32_t GetPrevFrameIndex(uint32_t frameIndex) const
         {
-            assert(frameIndex >= 0 && frameIndex < MAX_FRAMES_IN_FLIGHT);
-            return (frameIndex + (MAX_FRAMES_IN_FLIGHT - 1)) % MAX_FRAMES_IN_FLIGHT;
+            assert(frameIndex >= 0 && frameIndex < framesInFlight);
+            return (frameIndex + (framesInFlight - 1)) % framesInFlight;
         }
 
         void OnBeginFrame(VkCommandBuffer cmd)
@@ -222,6 +243,7 @@ private:
     VkDevice            device;
     VkSurfaceKHR        surface;
 
+    uint32_t            framesInFlight;
     FrameState          currentFrameState;
 
     // incremented every frame
@@ -262,6 +284,10 @@ private:
     std::shared_ptr<TextureManager>         textureManager;
     std::shared_ptr<CubemapManager>         cubemapManager;
 
+    // null, if GPU profiling is disabled
+    std::shared_ptr<GpuProfiler>            gpuProfiler;
+    std::shared_ptr<TraceWriter>            traceWriter;
+
     bool                                    enableValidationLayer;
     VkDebugUtilsMessengerEXT                debugMessenger;
     std::unique_ptr<UserPrint>              userPrint;
@@ -271,6 +297,8 @@ private:
 
     double                                  previousFrameTime;
     double                                  currentFrameTime;
+
+    FrameStatistics                         frameStatistics;
 };
 
 }
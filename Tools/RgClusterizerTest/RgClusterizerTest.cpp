@@ -0,0 +1,275 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Checks of GeometryClusterizer on known inputs: disjoint groups of geometries
+// must be in separate clusters, the cluster count must not exceed the maximum,
+// and each geometry with valid bounds must be in exactly one cluster.
+//
+// Usage:
+//   RgClusterizerTest
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "GeometryClusterizer.h"
+
+using namespace RTGL1;
+
+static uint32_t failedCount = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);\
+            failedCount++;                                                      \
+        }                                                                       \
+    } while (0)
+
+static GeometryBounds MakeBox(float x, float y, float z, float halfSize)
+{
+    return
+    {
+        { x - halfSize, y - halfSize, z - halfSize },
+        { x + halfSize, y + halfSize, z + halfSize },
+    };
+}
+
+// Deterministic pseudo-random number in [0, 1)
+static float Random(uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (float)(state >> 8) / (float)(1u << 24);
+}
+
+// Returns the index of the cluster for each geometry, UINT32_MAX if it's not in any,
+// and checks that no geometry is in several clusters
+static std::vector<uint32_t> GetClusterOfEach(const std::vector<std::vector<uint32_t>> &clusters, uint32_t count)
+{
+    std::vector<uint32_t> clusterOf(count, UINT32_MAX);
+
+    for (uint32_t c = 0; c < clusters.size(); c++)
+    {
+        for (uint32_t index : clusters[c])
+        {
+            CHECK(index < count);
+
+            if (index < count)
+            {
+                CHECK(clusterOf[index] == UINT32_MAX);
+                clusterOf[index] = c;
+            }
+        }
+    }
+
+    return clusterOf;
+}
+
+static void TestEmpty()
+{
+    GeometryClusterizer clusterizer(8, 1);
+    std::vector<std::vector<uint32_t>> clusters(3);
+
+    clusterizer.Clusterize(nullptr, 0, clusters);
+    CHECK(clusters.empty());
+
+    const GeometryBounds invalid[] = { GeometryBounds::Empty(), GeometryBounds::Empty() };
+
+    clusterizer.Clusterize(invalid, 2, clusters);
+    CHECK(clusters.empty());
+}
+
+static void TestDisjointGroups()
+{
+    const uint32_t groupCount = 4;
+    const uint32_t perGroup = 16;
+
+    std::vector<GeometryBounds> bounds;
+    uint32_t state = 1;
+
+    // small boxes around corners of a large square
+    const float groupCenters[groupCount][2] = { { 0, 0 }, { 1000, 0 }, { 0, 1000 }, { 1000, 1000 } };
+
+    for (uint32_t g = 0; g < groupCount; g++)
+    {
+        for (uint32_t i = 0; i < perGroup; i++)
+        {
+            bounds.push_back(MakeBox(
+                groupCenters[g][0] + Random(state) * 10.0f,
+                groupCenters[g][1] + Random(state) * 10.0f,
+                Random(state) * 10.0f,
+                1.0f));
+        }
+    }
+
+    const uint32_t count = (uint32_t)bounds.size();
+
+    GeometryClusterizer clusterizer(groupCount, 1);
+    std::vector<std::vector<uint32_t>> clusters;
+
+    clusterizer.Clusterize(bounds.data(), count, clusters);
+    CHECK(clusters.size() == groupCount);
+
+    const std::vector<uint32_t> clusterOf = GetClusterOfEach(clusters, count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t group = i / perGroup;
+
+        // same group -- same cluster, different groups -- different clusters
+        CHECK(clusterOf[i] != UINT32_MAX);
+        CHECK(clusterOf[i] == clusterOf[group * perGroup]);
+
+        for (uint32_t g = 0; g < group; g++)
+        {
+            CHECK(clusterOf[i] != clusterOf[g * perGroup]);
+        }
+    }
+
+    // with more allowed clusters, the groups still must not be mixed
+    GeometryClusterizer finer(groupCount * 4, 1);
+
+    finer.Clusterize(bounds.data(), count, clusters);
+    CHECK(clusters.size() >= groupCount);
+
+    for (const auto &cluster : clusters)
+    {
+        CHECK(!cluster.empty());
+
+        for (uint32_t index : cluster)
+        {
+            CHECK(index / perGroup == cluster[0] / perGroup);
+        }
+    }
+}
+
+static void TestMaxClusterCount()
+{
+    const uint32_t count = 500;
+
+    std::vector<GeometryBounds> bounds;
+    uint32_t state = 7;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        bounds.push_back(MakeBox(Random(state) * 100.0f, Random(state) * 100.0f, Random(state) * 100.0f, 0.5f));
+    }
+
+    std::vector<std::vector<uint32_t>> clusters;
+
+    for (uint32_t maxClusterCount : { 0u, 1u, 2u, 3u, 7u, 16u, 64u })
+    {
+        GeometryClusterizer clusterizer(maxClusterCount, 1);
+        clusterizer.Clusterize(bounds.data(), count, clusters);
+
+        // 0 is treated as 1
+        CHECK(!clusters.empty());
+        CHECK(clusters.size() <= (maxClusterCount > 0 ? maxClusterCount : 1));
+
+        // uniformly scattered small boxes are always worth splitting
+        if (maxClusterCount > 1)
+        {
+            CHECK(clusters.size() > 1);
+        }
+    }
+}
+
+static void TestEachAssignedOnce()
+{
+    const uint32_t count = 300;
+
+    std::vector<GeometryBounds> bounds;
+    uint32_t state = 42;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i % 13 == 0)
+        {
+            // empty geometries must be skipped
+            bounds.push_back(GeometryBounds::Empty());
+        }
+        else
+        {
+            bounds.push_back(MakeBox(Random(state) * 50.0f, Random(state) * 5.0f, Random(state) * 50.0f, Random(state) * 3.0f));
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> clusters;
+
+    for (uint32_t minClusterSize : { 1u, 4u, 32u })
+    {
+        GeometryClusterizer clusterizer(16, minClusterSize);
+        clusterizer.Clusterize(bounds.data(), count, clusters);
+
+        const std::vector<uint32_t> clusterOf = GetClusterOfEach(clusters, count);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CHECK((clusterOf[i] != UINT32_MAX) == bounds[i].IsValid());
+        }
+
+        if (clusters.size() > 1)
+        {
+            for (const auto &cluster : clusters)
+            {
+                CHECK(cluster.size() >= minClusterSize);
+            }
+        }
+    }
+}
+
+static void TestSameCentroids()
+{
+    // nested boxes can't be separated by a plane between their centroids
+    std::vector<GeometryBounds> bounds;
+
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        bounds.push_back(MakeBox(5.0f, 5.0f, 5.0f, 1.0f + (float)i));
+    }
+
+    GeometryClusterizer clusterizer(4, 1);
+    std::vector<std::vector<uint32_t>> clusters;
+
+    clusterizer.Clusterize(bounds.data(), (uint32_t)bounds.size(), clusters);
+
+    CHECK(clusters.size() == 1);
+    CHECK(clusters[0].size() == bounds.size());
+}
+
+int main()
+{
+    TestEmpty();
+    TestDisjointGroups();
+    TestMaxClusterCount();
+    TestEachAssignedOnce();
+    TestSameCentroids();
+
+    if (failedCount > 0)
+    {
+        printf("%u checks failed\n", failedCount);
+        return EXIT_FAILURE;
+    }
+
+    printf("All checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,831 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Replays a file that was captured with RgInstanceCreateInfo::pCaptureFilePath.
+// The whole file is loaded to the memory before the replay, and the calls
+// are executed one after another without any waiting, so the measured
+// time is spent only in the library.
+//
+// Usage:
+//   RgTraceReplay <capture file> [-n <loop count>] [-shaders <folder>]
+//                 [-bluenoise <file>] [-textures <folder>] [-v]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef RG_USE_SURFACE_WIN32
+    #include <windows.h>
+#endif
+
+#include <RTGL1/RTGL1.h>
+
+#include "ApiCapture.h"
+
+using namespace RTGL1;
+
+constexpr uint32_t CALL_TYPE_COUNT = (uint32_t)ApiCallType::RemoveStaticGeometry + 1;
+
+static const char *GetCallName(ApiCallType call)
+{
+    switch (call)
+    {
+        case ApiCallType::CreateInstance: return "rgCreateInstance";
+        case ApiCallType::DestroyInstance: return "rgDestroyInstance";
+        case ApiCallType::UploadGeometry: return "rgUploadGeometry";
+        case ApiCallType::UpdateGeometryTransform: return "rgUpdateGeometryTransform";
+        case ApiCallType::UpdateGeometryTexCoords: return "rgUpdateGeometryTexCoords";
+        case ApiCallType::UploadRasterizedGeometry: return "rgUploadRasterizedGeometry";
+        case ApiCallType::SubmitStaticGeometries: return "rgSubmitStaticGeometries";
+        case ApiCallType::StartNewScene: return "rgStartNewScene";
+        case ApiCallType::UploadDirectionalLight: return "rgUploadDirectionalLight";
+        case ApiCallType::UploadSphericalLight: return "rgUploadSphericalLight";
+        case ApiCallType::UploadSpotlightLight: return "rgUploadSpotlightLight";
+        case ApiCallType::CreateStaticMaterial: return "rgCreateStaticMaterial";
+        case ApiCallType::CreateAnimatedMaterial: return "rgCreateAnimatedMaterial";
+        case ApiCallType::ChangeAnimatedMaterialFrame: return "rgChangeAnimatedMaterialFrame";
+        case ApiCallType::CreateDynamicMaterial: return "rgCreateDynamicMaterial";
+        case ApiCallType::UpdateDynamicMaterial: return "rgUpdateDynamicMaterial";
+        case ApiCallType::DestroyMaterial: return "rgDestroyMaterial";
+        case ApiCallType::CreateCubemap: return "rgCreateCubemap";
+        case ApiCallType::DestroyCubemap: return "rgDestroyCubemap";
+        case ApiCallType::StartFrame: return "rgStartFrame";
+        case ApiCallType::DrawFrame: return "rgDrawFrame";
+        case ApiCallType::UploadGeometries: return "rgUploadGeometries";
+        case ApiCallType::CreateMesh: return "rgCreateMesh";
+        case ApiCallType::UploadMeshInstance: return "rgUploadMeshInstance";
+        case ApiCallType::AddStaticGeometry: return "rgAddStaticGeometry";
+        case ApiCallType::RemoveStaticGeometry: return "rgRemoveStaticGeometry";
+    }
+
+    return "Unknown";
+}
+
+struct ReplayOptions
+{
+    const char  *pCaptureFilePath   = nullptr;
+    uint32_t    loopCount           = 1;
+    const char  *pShaderFolderPath  = nullptr;
+    const char  *pBlueNoiseFilePath = nullptr;
+    const char  *pTexturesFolderPath = nullptr;
+    bool        verbose             = false;
+};
+
+// Reads chunks of a record payload, see ApiCapture.h for the format.
+class RecordReader
+{
+public:
+    RecordReader(const uint8_t *_pBegin, const uint8_t *_pEnd) : pCur(_pBegin), pEnd(_pEnd)
+    {}
+
+    // Structs are copied, as handles in them might be remapped
+    template <typename T>
+    T ReadStruct()
+    {
+        T s;
+        memcpy(&s, Advance(sizeof(T)), sizeof(T));
+        return s;
+    }
+
+    const void *ReadArray()
+    {
+        uint64_t byteCount;
+        memcpy(&byteCount, Advance(sizeof(byteCount)), sizeof(byteCount));
+
+        return byteCount != API_CAPTURE_NULL_ARRAY ? Advance(byteCount) : nullptr;
+    }
+
+    const char *ReadString()
+    {
+        return static_cast<const char *>(ReadArray());
+    }
+
+    template <typename T>
+    const T *ReadOptionalStruct()
+    {
+        return static_cast<const T *>(ReadArray());
+    }
+
+private:
+    const uint8_t *Advance(uint64_t size)
+    {
+        const uint64_t alignedSize = (size + API_CAPTURE_ALIGNMENT - 1) & ~(API_CAPTURE_ALIGNMENT - 1);
+
+        if (alignedSize > (uint64_t)(pEnd - pCur))
+        {
+            fprintf(stderr, "Capture record is corrupted\n");
+            exit(EXIT_FAILURE);
+        }
+
+        const uint8_t *p = pCur;
+        pCur += alignedSize;
+        return p;
+    }
+
+private:
+    const uint8_t *pCur;
+    const uint8_t *pEnd;
+};
+
+class Replayer
+{
+public:
+    explicit Replayer(const ReplayOptions &_options) : options(_options), instance(RG_NULL_HANDLE), frameCount(0)
+    {
+        memset(callCount, 0, sizeof(callCount));
+        memset(callTime, 0, sizeof(callTime));
+
+    #ifdef RG_USE_SURFACE_WIN32
+        CreateWin32Window();
+    #endif
+    }
+
+    bool Replay(const std::vector<uint8_t> &data)
+    {
+        const uint8_t *pCur = data.data() + sizeof(ApiCaptureFileHeader);
+        const uint8_t *pEnd = data.data() + data.size();
+
+        while (pCur < pEnd)
+        {
+            if ((uint64_t)(pEnd - pCur) < sizeof(ApiCaptureRecordHeader))
+            {
+                fprintf(stderr, "Capture file is truncated\n");
+                return false;
+            }
+
+            ApiCaptureRecordHeader header;
+            memcpy(&header, pCur, sizeof(header));
+            pCur += sizeof(header);
+
+            if (header.payloadSize > (uint64_t)(pEnd - pCur))
+            {
+                fprintf(stderr, "Capture file is truncated\n");
+                return false;
+            }
+
+            RecordReader reader(pCur, pCur + header.payloadSize);
+            pCur += header.payloadSize;
+
+            if (!ReplayRecord(header.call, reader))
+            {
+                return false;
+            }
+        }
+
+        // capture might be stopped without rgDestroyInstance
+        if (instance != RG_NULL_HANDLE)
+        {
+            rgDestroyInstance(instance);
+            instance = RG_NULL_HANDLE;
+        }
+
+        return true;
+    }
+
+    void PrintStatistics(double totalSeconds) const
+    {
+        printf("%-32s %10s %14s %12s\n", "Call", "Count", "Total, ms", "Avg, us");
+
+        for (uint32_t i = 0; i < CALL_TYPE_COUNT; i++)
+        {
+            if (callCount[i] == 0)
+            {
+                continue;
+            }
+
+            const double totalMs = callTime[i] * 1e3;
+            const double avgUs = callTime[i] * 1e6 / callCount[i];
+
+            printf("%-32s %10llu %14.3f %12.3f\n", GetCallName((ApiCallType)i), (unsigned long long)callCount[i], totalMs, avgUs);
+        }
+
+        printf("\nFrames: %llu, total: %.3f s", (unsigned long long)frameCount, totalSeconds);
+
+        if (frameCount > 0)
+        {
+            printf(", avg frame: %.3f ms", totalSeconds * 1e3 / frameCount);
+        }
+
+        printf("\n");
+    }
+
+private:
+    bool ReplayRecord(ApiCallType call, RecordReader &reader)
+    {
+        if ((uint32_t)call >= CALL_TYPE_COUNT)
+        {
+            if (options.verbose)
+            {
+                printf("Skipping unknown call type %u\n", (uint32_t)call);
+            }
+
+            return true;
+        }
+
+        if (call != ApiCallType::CreateInstance && instance == RG_NULL_HANDLE)
+        {
+            fprintf(stderr, "%s is called before rgCreateInstance\n", GetCallName(call));
+            return false;
+        }
+
+        RgResult r = RG_SUCCESS;
+
+        switch (call)
+        {
+            case ApiCallType::CreateInstance:
+            {
+                RgInstanceCreateInfo info = reader.ReadStruct<RgInstanceCreateInfo>();
+                info.pName = reader.ReadString();
+                info.pShaderFolderPath = reader.ReadString();
+                info.pBlueNoiseFilePath = reader.ReadString();
+                info.pOverridenTexturesFolderPath = reader.ReadString();
+                info.pOverridenAlbedoAlphaTexturePostfix = reader.ReadString();
+                info.pOverridenRoughnessMetallicEmissionTexturePostfix = reader.ReadString();
+                info.pOverridenNormalTexturePostfix = reader.ReadString();
+                info.pWaterNormalTexturePath = reader.ReadString();
+
+                if (options.pShaderFolderPath != nullptr)
+                {
+                    info.pShaderFolderPath = options.pShaderFolderPath;
+                }
+                if (options.pBlueNoiseFilePath != nullptr)
+                {
+                    info.pBlueNoiseFilePath = options.pBlueNoiseFilePath;
+                }
+                if (options.pTexturesFolderPath != nullptr)
+                {
+                    info.pOverridenTexturesFolderPath = options.pTexturesFolderPath;
+                }
+
+                info.pWin32SurfaceInfo = nullptr;
+                info.pMetalSurfaceCreateInfo = nullptr;
+                info.pWaylandSurfaceCreateInfo = nullptr;
+                info.pXcbSurfaceCreateInfo = nullptr;
+                info.pXlibSurfaceCreateInfo = nullptr;
+                info.useNullDevice = RG_FALSE;
+            #ifdef RG_USE_NULL_DEVICE
+                info.useNullDevice = RG_TRUE;
+            #elif defined(RG_USE_SURFACE_WIN32)
+                info.pWin32SurfaceInfo = &win32SurfaceInfo;
+            #endif
+
+                info.enableValidationLayer = RG_FALSE;
+                info.pCaptureFilePath = nullptr;
+                info.pTraceFilePath = nullptr;
+                info.pfnPrint = options.verbose ? &Print : nullptr;
+                info.pUserPrintData = nullptr;
+                info.pfnOpenFile = nullptr;
+                info.pfnCloseFile = nullptr;
+                info.pUserLoadFileData = nullptr;
+
+                materials.clear();
+                cubemaps.clear();
+                meshes.clear();
+
+                r = Measure(call, [&] { return rgCreateInstance(&info, &instance); });
+                break;
+            }
+            case ApiCallType::DestroyInstance:
+            {
+                r = Measure(call, [&] { return rgDestroyInstance(instance); });
+                instance = RG_NULL_HANDLE;
+                break;
+            }
+            case ApiCallType::UploadGeometry:
+            {
+                RgGeometryUploadInfo info = ReadGeometry(reader);
+
+                r = Measure(call, [&] { return rgUploadGeometry(instance, &info); });
+                break;
+            }
+            case ApiCallType::UploadGeometries:
+            {
+                const uint32_t count = reader.ReadStruct<uint32_t>();
+
+                batchInfos.resize(count);
+                for (auto &info : batchInfos)
+                {
+                    info = ReadGeometry(reader);
+                }
+
+                r = Measure(call, [&] { return rgUploadGeometries(instance, count, batchInfos.data()); });
+                break;
+            }
+            case ApiCallType::CreateMesh:
+            {
+                const RgMesh captured = reader.ReadStruct<RgMesh>();
+                RgMeshCreateInfo info = reader.ReadStruct<RgMeshCreateInfo>();
+                info.pVertexData = reader.ReadArray();
+                info.pNormalData = reader.ReadArray();
+                info.pTexCoordLayerData[0] = reader.ReadArray();
+                info.pTexCoordLayerData[1] = reader.ReadArray();
+                info.pTexCoordLayerData[2] = reader.ReadArray();
+                info.pIndexData = reader.ReadArray();
+                RgMesh result = RG_NO_MESH;
+
+                r = Measure(call, [&] { return rgCreateMesh(instance, &info, &result); });
+                meshes[captured] = result;
+                break;
+            }
+            case ApiCallType::UploadMeshInstance:
+            {
+                RgMeshInstanceUploadInfo info = reader.ReadStruct<RgMeshInstanceUploadInfo>();
+
+                auto it = meshes.find(info.mesh);
+                info.mesh = it != meshes.end() ? it->second : info.mesh;
+
+                for (RgMaterial &m : info.geomMaterial.layerMaterials)
+                {
+                    m = RemapMaterial(m);
+                }
+
+                r = Measure(call, [&] { return rgUploadMeshInstance(instance, &info); });
+                break;
+            }
+            case ApiCallType::AddStaticGeometry:
+            {
+                RgGeometryUploadInfo info = ReadGeometry(reader);
+
+                r = Measure(call, [&] { return rgAddStaticGeometry(instance, &info); });
+                break;
+            }
+            case ApiCallType::RemoveStaticGeometry:
+            {
+                const uint64_t uniqueID = reader.ReadStruct<uint64_t>();
+
+                r = Measure(call, [&] { return rgRemoveStaticGeometry(instance, uniqueID); });
+                break;
+            }
+            case ApiCallType::UpdateGeometryTransform:
+            {
+                RgUpdateTransformInfo info = reader.ReadStruct<RgUpdateTransformInfo>();
+
+                r = Measure(call, [&] { return rgUpdateGeometryTransform(instance, &info); });
+                break;
+            }
+            case ApiCallType::UpdateGeometryTexCoords:
+            {
+                RgUpdateTexCoordsInfo info = reader.ReadStruct<RgUpdateTexCoordsInfo>();
+                info.pTexCoordLayerData[0] = reader.ReadArray();
+                info.pTexCoordLayerData[1] = reader.ReadArray();
+                info.pTexCoordLayerData[2] = reader.ReadArray();
+
+                r = Measure(call, [&] { return rgUpdateGeometryTexCoords(instance, &info); });
+                break;
+            }
+            case ApiCallType::UploadRasterizedGeometry:
+            {
+                RgRasterizedGeometryUploadInfo info = reader.ReadStruct<RgRasterizedGeometryUploadInfo>();
+                RgRasterizedGeometryVertexArrays arrays = {};
+
+                const auto *pArrays = reader.ReadOptionalStruct<RgRasterizedGeometryVertexArrays>();
+                if (pArrays != nullptr)
+                {
+                    arrays = *pArrays;
+                    arrays.pVertexData = reader.ReadArray();
+                    arrays.pTexCoordData = reader.ReadArray();
+                    arrays.pColorData = reader.ReadArray();
+                }
+
+                info.pArrays = pArrays != nullptr ? &arrays : nullptr;
+                info.pStructs = static_cast<const RgRasterizedGeometryVertexStruct *>(reader.ReadArray());
+                info.pIndexData = reader.ReadArray();
+                info.material = RemapMaterial(info.material);
+
+                const auto *pViewProjection = static_cast<const float *>(reader.ReadArray());
+                const auto *pViewport = reader.ReadOptionalStruct<RgViewport>();
+
+                r = Measure(call, [&] { return rgUploadRasterizedGeometry(instance, &info, pViewProjection, pViewport); });
+                break;
+            }
+            case ApiCallType::SubmitStaticGeometries:
+            {
+                r = Measure(call, [&] { return rgSubmitStaticGeometries(instance); });
+                break;
+            }
+            case ApiCallType::StartNewScene:
+            {
+                r = Measure(call, [&] { return rgStartNewScene(instance); });
+                break;
+            }
+            case ApiCallType::UploadDirectionalLight:
+            {
+                RgDirectionalLightUploadInfo info = reader.ReadStruct<RgDirectionalLightUploadInfo>();
+
+                r = Measure(call, [&] { return rgUploadDirectionalLight(instance, &info); });
+                break;
+            }
+            case ApiCallType::UploadSphericalLight:
+            {
+                RgSphericalLightUploadInfo info = reader.ReadStruct<RgSphericalLightUploadInfo>();
+
+                r = Measure(call, [&] { return rgUploadSphericalLight(instance, &info); });
+                break;
+            }
+            case ApiCallType::UploadSpotlightLight:
+            {
+                RgSpotlightUploadInfo info = reader.ReadStruct<RgSpotlightUploadInfo>();
+
+                r = Measure(call, [&] { return rgUploadSpotlightLight(instance, &info); });
+                break;
+            }
+            case ApiCallType::CreateStaticMaterial:
+            {
+                const RgMaterial captured = reader.ReadStruct<RgMaterial>();
+                RgStaticMaterialCreateInfo info = ReadStaticMaterial(reader);
+                RgMaterial result = RG_NO_MATERIAL;
+
+                r = Measure(call, [&] { return rgCreateStaticMaterial(instance, &info, &result); });
+                materials[captured] = result;
+                break;
+            }
+            case ApiCallType::CreateAnimatedMaterial:
+            {
+                const RgMaterial captured = reader.ReadStruct<RgMaterial>();
+                RgAnimatedMaterialCreateInfo info = reader.ReadStruct<RgAnimatedMaterialCreateInfo>();
+
+                std::vector<RgStaticMaterialCreateInfo> frames(info.frameCount);
+                for (auto &f : frames)
+                {
+                    f = ReadStaticMaterial(reader);
+                }
+                info.pFrames = frames.data();
+
+                RgMaterial result = RG_NO_MATERIAL;
+
+                r = Measure(call, [&] { return rgCreateAnimatedMaterial(instance, &info, &result); });
+                materials[captured] = result;
+                break;
+            }
+            case ApiCallType::ChangeAnimatedMaterialFrame:
+            {
+                const RgMaterial material = RemapMaterial(reader.ReadStruct<RgMaterial>());
+                const uint32_t frameIndex = reader.ReadStruct<uint32_t>();
+
+                r = Measure(call, [&] { return rgChangeAnimatedMaterialFrame(instance, material, frameIndex); });
+                break;
+            }
+            case ApiCallType::CreateDynamicMaterial:
+            {
+                const RgMaterial captured = reader.ReadStruct<RgMaterial>();
+                RgDynamicMaterialCreateInfo info = reader.ReadStruct<RgDynamicMaterialCreateInfo>();
+                ReadTextureSet(reader, info.textures);
+
+                RgMaterial result = RG_NO_MATERIAL;
+
+                r = Measure(call, [&] { return rgCreateDynamicMaterial(instance, &info, &result); });
+                materials[captured] = result;
+                break;
+            }
+            case ApiCallType::UpdateDynamicMaterial:
+            {
+                RgDynamicMaterialUpdateInfo info = reader.ReadStruct<RgDynamicMaterialUpdateInfo>();
+                ReadTextureSet(reader, info.textures);
+                info.dynamicMaterial = RemapMaterial(info.dynamicMaterial);
+
+                r = Measure(call, [&] { return rgUpdateDynamicMaterial(instance, &info); });
+                break;
+            }
+            case ApiCallType::DestroyMaterial:
+            {
+                const RgMaterial captured = reader.ReadStruct<RgMaterial>();
+                const RgMaterial material = RemapMaterial(captured);
+                materials.erase(captured);
+
+                r = Measure(call, [&] { return rgDestroyMaterial(instance, material); });
+                break;
+            }
+            case ApiCallType::CreateCubemap:
+            {
+                const RgCubemap captured = reader.ReadStruct<RgCubemap>();
+                RgCubemapCreateInfo info = reader.ReadStruct<RgCubemapCreateInfo>();
+
+                for (uint32_t i = 0; i < 6; i++)
+                {
+                    info.pData[i] = reader.ReadArray();
+                }
+
+                for (uint32_t i = 0; i < 6; i++)
+                {
+                    info.pRelativePaths[i] = reader.ReadString();
+                }
+
+                RgCubemap result = RG_EMPTY_CUBEMAP;
+
+                r = Measure(call, [&] { return rgCreateCubemap(instance, &info, &result); });
+                cubemaps[captured] = result;
+                break;
+            }
+            case ApiCallType::DestroyCubemap:
+            {
+                const RgCubemap captured = reader.ReadStruct<RgCubemap>();
+                const RgCubemap cubemap = RemapCubemap(captured);
+                cubemaps.erase(captured);
+
+                r = Measure(call, [&] { return rgDestroyCubemap(instance, cubemap); });
+                break;
+            }
+            case ApiCallType::StartFrame:
+            {
+                RgStartFrameInfo info = reader.ReadStruct<RgStartFrameInfo>();
+
+                // the captured frames must be reproduced exactly
+                info.requestShaderReload = RG_FALSE;
+                info.requestVSync = RG_FALSE;
+
+                r = Measure(call, [&] { return rgStartFrame(instance, &info); });
+                break;
+            }
+            case ApiCallType::DrawFrame:
+            {
+                RgDrawFrameInfo info = reader.ReadStruct<RgDrawFrameInfo>();
+                info.pShadowParams = reader.ReadOptionalStruct<RgDrawFrameShadowParams>();
+                info.pTonemappingParams = reader.ReadOptionalStruct<RgDrawFrameTonemappingParams>();
+                info.pBloomParams = reader.ReadOptionalStruct<RgDrawFrameBloomParams>();
+                info.pReflectRefractParams = reader.ReadOptionalStruct<RgDrawFrameReflectRefractParams>();
+
+                RgDrawFrameSkyParams skyParams = {};
+                const auto *pSkyParams = reader.ReadOptionalStruct<RgDrawFrameSkyParams>();
+                if (pSkyParams != nullptr)
+                {
+                    skyParams = *pSkyParams;
+                    skyParams.skyCubemap = RemapCubemap(skyParams.skyCubemap);
+                }
+                info.pSkyParams = pSkyParams != nullptr ? &skyParams : nullptr;
+
+                info.pOverridenTexturesParams = reader.ReadOptionalStruct<RgDrawFrameOverridenTexturesParams>();
+                info.pDebugParams = reader.ReadOptionalStruct<RgDrawFrameDebugParams>();
+
+                r = Measure(call, [&] { return rgDrawFrame(instance, &info); });
+                frameCount++;
+
+            #ifdef RG_USE_SURFACE_WIN32
+                PumpWin32Messages();
+            #endif
+                break;
+            }
+        }
+
+        if (r != RG_SUCCESS)
+        {
+            // calls were successful on capture, so replay must be identical
+            fprintf(stderr, "%s failed on replay with error code %d\n", GetCallName(call), (int)r);
+            return call != ApiCallType::CreateInstance;
+        }
+
+        return true;
+    }
+
+    template <typename F>
+    RgResult Measure(ApiCallType call, F f)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        const RgResult r = f();
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        callCount[(uint32_t)call]++;
+        callTime[(uint32_t)call] += std::chrono::duration<double>(end - start).count();
+
+        return r;
+    }
+
+    RgGeometryUploadInfo ReadGeometry(RecordReader &reader) const
+    {
+        RgGeometryUploadInfo info = reader.ReadStruct<RgGeometryUploadInfo>();
+        info.pVertexData = reader.ReadArray();
+        info.pNormalData = reader.ReadArray();
+        info.pTexCoordLayerData[0] = reader.ReadArray();
+        info.pTexCoordLayerData[1] = reader.ReadArray();
+        info.pTexCoordLayerData[2] = reader.ReadArray();
+        info.pIndexData = reader.ReadArray();
+
+        for (RgMaterial &m : info.geomMaterial.layerMaterials)
+        {
+            m = RemapMaterial(m);
+        }
+
+        return info;
+    }
+
+    static void ReadTextureSet(RecordReader &reader, RgTextureSet &textures)
+    {
+        textures.albedoAlpha.pData = reader.ReadArray();
+        textures.roughnessMetallicEmission.pData = reader.ReadArray();
+        textures.normal.pData = reader.ReadArray();
+    }
+
+    static RgStaticMaterialCreateInfo ReadStaticMaterial(RecordReader &reader)
+    {
+        RgStaticMaterialCreateInfo info = reader.ReadStruct<RgStaticMaterialCreateInfo>();
+        ReadTextureSet(reader, info.textures);
+        info.pRelativePath = reader.ReadString();
+
+        return info;
+    }
+
+    RgMaterial RemapMaterial(RgMaterial captured) const
+    {
+        auto it = materials.find(captured);
+        return it != materials.end() ? it->second : captured;
+    }
+
+    RgCubemap RemapCubemap(RgCubemap captured) const
+    {
+        auto it = cubemaps.find(captured);
+        return it != cubemaps.end() ? it->second : captured;
+    }
+
+    static void Print(const char *pMessage, void *pUserData)
+    {
+        printf("%s\n", pMessage);
+    }
+
+#ifdef RG_USE_SURFACE_WIN32
+    void CreateWin32Window()
+    {
+        WNDCLASSEXA wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = DefWindowProcA;
+        wc.hInstance = GetModuleHandleA(nullptr);
+        wc.lpszClassName = "RgTraceReplay";
+        RegisterClassExA(&wc);
+
+        const HWND hwnd = CreateWindowExA(0, wc.lpszClassName, "RgTraceReplay", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+                                          CW_USEDEFAULT, CW_USEDEFAULT, 1600, 900, nullptr, nullptr, wc.hInstance, nullptr);
+
+        win32SurfaceInfo.hinstance = wc.hInstance;
+        win32SurfaceInfo.hwnd = hwnd;
+    }
+
+    static void PumpWin32Messages()
+    {
+        MSG msg;
+        while (PeekMessageA(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessageA(&msg);
+        }
+    }
+#endif
+
+private:
+    ReplayOptions options;
+    RgInstance instance;
+
+    // captured handle to the replayed one
+    std::unordered_map<RgMaterial, RgMaterial> materials;
+    std::unordered_map<RgCubemap, RgCubemap> cubemaps;
+    std::unordered_map<RgMesh, RgMesh> meshes;
+
+    std::vector<RgGeometryUploadInfo> batchInfos;
+
+    uint64_t callCount[CALL_TYPE_COUNT];
+    double callTime[CALL_TYPE_COUNT];
+    uint64_t frameCount;
+
+#ifdef RG_USE_SURFACE_WIN32
+    RgWin32SurfaceCreateInfo win32SurfaceInfo = {};
+#endif
+};
+
+static bool LoadCaptureFile(const char *pPath, std::vector<uint8_t> &data)
+{
+    FILE *f = fopen(pPath, "rb");
+
+    if (f == nullptr)
+    {
+        fprintf(stderr, "Can't open %s\n", pPath);
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data.resize(size > 0 ? (size_t)size : 0);
+    const size_t read = fread(data.data(), 1, data.size(), f);
+    fclose(f);
+
+    if (read != data.size() || data.size() < sizeof(ApiCaptureFileHeader))
+    {
+        fprintf(stderr, "Can't read %s\n", pPath);
+        return false;
+    }
+
+    ApiCaptureFileHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != API_CAPTURE_MAGIC)
+    {
+        fprintf(stderr, "%s is not an RTGL1 capture file\n", pPath);
+        return false;
+    }
+
+    if (header.version != API_CAPTURE_VERSION ||
+        header.pointerSize != sizeof(void *) ||
+        header.geometryUploadInfoSize != sizeof(RgGeometryUploadInfo) ||
+        header.drawFrameInfoSize != sizeof(RgDrawFrameInfo))
+    {
+        fprintf(stderr, "%s was captured with an incompatible version of the library\n", pPath);
+        return false;
+    }
+
+    return true;
+}
+
+static bool ParseOptions(int argc, char **argv, ReplayOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasNext = i + 1 < argc;
+
+        if (strcmp(argv[i], "-n") == 0 && hasNext)
+        {
+            options.loopCount = (uint32_t)std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-shaders") == 0 && hasNext)
+        {
+            options.pShaderFolderPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-bluenoise") == 0 && hasNext)
+        {
+            options.pBlueNoiseFilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-textures") == 0 && hasNext)
+        {
+            options.pTexturesFolderPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            options.verbose = true;
+        }
+        else if (argv[i][0] != '-' && options.pCaptureFilePath == nullptr)
+        {
+            options.pCaptureFilePath = argv[i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.pCaptureFilePath != nullptr;
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        printf("Usage: RgTraceReplay <capture file> [-n <loop count>] [-shaders <folder>] "
+               "[-bluenoise <file>] [-textures <folder>] [-v]\n");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint8_t> data;
+
+    if (!LoadCaptureFile(options.pCaptureFilePath, data))
+    {
+        return EXIT_FAILURE;
+    }
+
+    Replayer replayer(options);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < options.loopCount; i++)
+    {
+        if (!replayer.Replay(data))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    replayer.PrintStatistics(std::chrono::duration<double>(end - start).count());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Measures deinterleaving of vertex attributes, see VertexIngest.
+// For each source stride, positions and tex coords are copied from an array
+// of structs to the tightly packed arrays with SIMD and scalar versions,
+// and, for comparison, with one memcpy of the whole strided array,
+// as it was done before. Results of the versions are checked to be equal.
+//
+// Usage:
+//   RgVertexIngestBench [-n <vertex count>] [-i <iteration count>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "VertexIngest.h"
+
+using namespace RTGL1;
+
+typedef void (*PFN_Copy)(float *dst, const void *src, uint32_t srcStride, uint32_t count);
+
+// Copy with the padding between the elements
+static void CopyStridedArray(float *dst, const void *src, uint32_t srcStride, uint32_t count)
+{
+    memcpy(dst, src, (size_t)count * srcStride);
+}
+
+// Returns the best time of one copy in microseconds
+static double Measure(PFN_Copy pfnCopy, float *dst, const void *src, uint32_t srcStride, uint32_t count, uint32_t iterations)
+{
+    double best = 1e30;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        pfnCopy(dst, src, srcStride, count);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    return best;
+}
+
+static bool ParseOptions(int argc, char **argv, uint32_t &outVertexCount, uint32_t &outIterations)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const long value = strtol(argv[i + 1], nullptr, 10);
+
+        if (value <= 0)
+        {
+            return false;
+        }
+
+        if (strcmp(argv[i], "-n") == 0)
+        {
+            outVertexCount = (uint32_t)value;
+        }
+        else if (strcmp(argv[i], "-i") == 0)
+        {
+            outIterations = (uint32_t)value;
+        }
+        else
+        {
+            return false;
+        }
+
+        i++;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t vertexCount = 1 << 16;
+    uint32_t iterations = 200;
+
+    if (!ParseOptions(argc, argv, vertexCount, iterations))
+    {
+        printf("Usage: RgVertexIngestBench [-n <vertex count>] [-i <iteration count>]\n");
+        return EXIT_FAILURE;
+    }
+
+    // tight arrays, and typical vertex structs: position+normal, +tex coords, +color, +tangent
+    const uint32_t strides[] = { 12, 16, 24, 32, 36, 48, 64 };
+    const uint32_t maxStride = 64;
+
+    std::vector<uint8_t> src((size_t)vertexCount * maxStride);
+
+    for (size_t i = 0; i < src.size(); i++)
+    {
+        src[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    // memcpy of the strided array needs the whole source size
+    std::vector<float> dst(src.size() / sizeof(float));
+    std::vector<float> reference(src.size() / sizeof(float));
+
+    printf("%u vertices, best of %u iterations, microseconds\n", vertexCount, iterations);
+    printf("%-10s %-8s %12s %12s %12s %10s\n", "attribute", "stride", "memcpy", "scalar", "simd", "speedup");
+
+    struct Attribute
+    {
+        const char *pName;
+        uint32_t    size;
+        PFN_Copy    pfnMemcpy;
+        PFN_Copy    pfnScalar;
+        PFN_Copy    pfnSimd;
+    };
+
+    const Attribute attributes[] =
+    {
+        { "float3", 12, CopyStridedArray, VertexIngest::CopyFloat3Scalar, VertexIngest::CopyFloat3 },
+        { "float2", 8,  CopyStridedArray, VertexIngest::CopyFloat2Scalar, VertexIngest::CopyFloat2 },
+    };
+
+    for (const Attribute &a : attributes)
+    {
+        for (uint32_t stride : strides)
+        {
+            if (stride < a.size)
+            {
+                continue;
+            }
+
+            const double tMemcpy = Measure(a.pfnMemcpy, dst.data(), src.data(), stride, vertexCount, iterations);
+
+            const double tScalar = Measure(a.pfnScalar, reference.data(), src.data(), stride, vertexCount, iterations);
+            const double tSimd = Measure(a.pfnSimd, dst.data(), src.data(), stride, vertexCount, iterations);
+
+            if (memcmp(dst.data(), reference.data(), (size_t)vertexCount * a.size) != 0)
+            {
+                printf("Mismatch of SIMD and scalar results: %s, stride %u\n", a.pName, stride);
+                return EXIT_FAILURE;
+            }
+
+            printf("%-10s %-8u %12.1f %12.1f %12.1f %9.2fx\n", a.pName, stride, tMemcpy, tScalar, tSimd, tScalar / tSimd);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}